@@ -0,0 +1,131 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/Configuration/ConfigDiff.hh"
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include <google/protobuf/util/message_differencer.h>
+
+namespace claid
+{
+    static bool isSameModule(const ModuleDescription& a, const ModuleDescription& b)
+    {
+        return a.moduleClass == b.moduleClass && a.host == b.host &&
+            a.inputChannels == b.inputChannels && a.outputChannels == b.outputChannels &&
+            google::protobuf::util::MessageDifferencer::Equals(a.properties, b.properties);
+    }
+
+    static bool isSameChannel(ChannelDescription a, ChannelDescription b)
+    {
+        // The order of publishers and subscribers depends on the order of the Modules in the config file.
+        std::sort(a.publisherModules.begin(), a.publisherModules.end());
+        std::sort(b.publisherModules.begin(), b.publisherModules.end());
+        std::sort(a.subscriberModules.begin(), a.subscriberModules.end());
+        std::sort(b.subscriberModules.begin(), b.subscriberModules.end());
+        return a.publisherModules == b.publisherModules && a.subscriberModules == b.subscriberModules;
+    }
+
+    template<typename T, typename IsSame>
+    static void diffMaps(const UniqueKeyMap<T>& oldMap, const UniqueKeyMap<T>& newMap, IsSame isSame,
+        std::set<std::string>& added, std::set<std::string>& removed, std::set<std::string>& changed, std::set<std::string>* unchanged)
+    {
+        for(const auto& entry : newMap)
+        {
+            auto it = oldMap.find(entry.first);
+            if(it == oldMap.end())
+            {
+                added.insert(entry.first);
+            }
+            else if(!isSame(it->second, entry.second))
+            {
+                changed.insert(entry.first);
+            }
+            else if(unchanged != nullptr)
+            {
+                unchanged->insert(entry.first);
+            }
+        }
+
+        for(const auto& entry : oldMap)
+        {
+            if(!newMap.exists(entry.first))
+            {
+                removed.insert(entry.first);
+            }
+        }
+    }
+
+    ConfigDiff ConfigDiff::compute(const ModuleDescriptionMap& oldModules, const ChannelDescriptionMap& oldChannels,
+            const ModuleDescriptionMap& newModules, const ChannelDescriptionMap& newChannels)
+    {
+        ConfigDiff diff;
+        diffMaps(oldModules, newModules, isSameModule, 
+            diff.addedModules, diff.removedModules, diff.changedModules, &diff.unchangedModules);
+        diffMaps(oldChannels, newChannels, isSameChannel,
+            diff.addedChannels, diff.removedChannels, diff.changedChannels, nullptr);
+        return diff;
+    }
+
+    bool ConfigDiff::empty() const
+    {
+        return addedModules.empty() && removedModules.empty() && changedModules.empty() &&
+            addedChannels.empty() && removedChannels.empty() && changedChannels.empty();
+    }
+
+    std::set<std::string> ConfigDiff::getAffectedModules() const
+    {
+        std::set<std::string> affectedModules(addedModules);
+        affectedModules.insert(removedModules.begin(), removedModules.end());
+        affectedModules.insert(changedModules.begin(), changedModules.end());
+        return affectedModules;
+    }
+
+    std::set<std::string> ConfigDiff::getAffectedModulesOfHost(const std::string& host, 
+            const ModuleDescriptionMap& oldModules, const ModuleDescriptionMap& newModules) const
+    {
+        std::set<std::string> affectedModules;
+        for(const std::string& module : getAffectedModules())
+        {
+            auto oldIt = oldModules.find(module);
+            auto newIt = newModules.find(module);
+            if((oldIt != oldModules.end() && oldIt->second.host == host) ||
+                (newIt != newModules.end() && newIt->second.host == host))
+            {
+                affectedModules.insert(module);
+            }
+        }
+        return affectedModules;
+    }
+
+    std::string ConfigDiff::toString() const
+    {
+        return absl::StrCat(
+            "added Modules: [", absl::StrJoin(addedModules, ", "), "], ",
+            "removed Modules: [", absl::StrJoin(removedModules, ", "), "], ",
+            "changed Modules: [", absl::StrJoin(changedModules, ", "), "], ",
+            "added Channels: [", absl::StrJoin(addedChannels, ", "), "], ",
+            "removed Channels: [", absl::StrJoin(removedChannels, ", "), "], ",
+            "changed Channels: [", absl::StrJoin(changedChannels, ", "), "]");
+    }
+}
@@ -0,0 +1,61 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <set>
+#include <string>
+
+#include "dispatch/core/Configuration/ModuleDescription.hh"
+#include "dispatch/core/Configuration/ChannelDescription.hh"
+
+namespace claid
+{
+    // Differences between two configurations, used to reload a config incrementally.
+    // Modules are compared by id. A Module counts as changed if its class, host, properties or
+    // channel mappings differ. Channels are derived from the channel mappings of the Modules,
+    // hence every changed channel also shows up as changed publisher or subscriber Module.
+    struct ConfigDiff
+    {
+        std::set<std::string> addedModules;
+        std::set<std::string> removedModules;
+        std::set<std::string> changedModules;
+        std::set<std::string> unchangedModules;
+
+        std::set<std::string> addedChannels;
+        std::set<std::string> removedChannels;
+        std::set<std::string> changedChannels;
+
+        static ConfigDiff compute(const ModuleDescriptionMap& oldModules, const ChannelDescriptionMap& oldChannels,
+            const ModuleDescriptionMap& newModules, const ChannelDescriptionMap& newChannels);
+
+        bool empty() const;
+
+        // Added, removed and changed Modules.
+        std::set<std::string> getAffectedModules() const;
+
+        // Added, removed and changed Modules that run on the given host, either in the old or in the new configuration.
+        std::set<std::string> getAffectedModulesOfHost(const std::string& host, 
+            const ModuleDescriptionMap& oldModules, const ModuleDescriptionMap& newModules) const;
+
+        std::string toString() const;
+    };
+}
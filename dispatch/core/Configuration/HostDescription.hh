@@ -21,11 +21,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <map>
 #include "dispatch/core/Configuration/UniqueKeyMap.hh"
 #include "dispatch/core/RemoteDispatching/TLSServerKeyStore.hh"
 #include "dispatch/core/RemoteDispatching/TLSClientKeyStore.hh"
+#include "dispatch/core/Utilities/Time.hh"
 #include "dispatch/proto/claidservice.pb.h"
 
 using namespace claidservice;
@@ -75,6 +77,46 @@ namespace claid
             return hostConfig.server_config().host_server_address();
         }
 
+        /**
+         * @brief Retrieves how the RemoteDispatcherServer of this host serves connected clients.
+         * 
+         * @return RemoteServerThreadingModel The threading model specified in the server configuration.
+         */
+        claidservice::RemoteServerThreadingModel getServerThreadingModel() const
+        {
+            return hostConfig.server_config().threading_model();
+        }
+
+        /**
+         * @brief Retrieves the number of completion queue threads of the asynchronous RemoteDispatcherServer.
+         * 
+         * @return size_t The number of threads, 0 means one thread per hardware thread.
+         */
+        size_t getNumAsyncServerThreads() const
+        {
+            return std::max(0, hostConfig.server_config().num_async_server_threads());
+        }
+
+        /**
+         * @brief Retrieves the number of shards (routing threads) the MasterRouter of this host uses.
+         * 
+         * @return size_t The number of shards, at least 1.
+         */
+        size_t getNumRouterShards() const
+        {
+            return std::max(1, hostConfig.num_router_shards());
+        }
+
+        /**
+         * @brief Retrieves the limits for the queues of clients connected to the server of this host.
+         * 
+         * @return const claidservice::ClientQueueLimits& The limits, all fields 0 means unlimited.
+         */
+        const claidservice::ClientQueueLimits& getClientQueueLimits() const
+        {
+            return hostConfig.server_config().client_queue_limits();
+        }
+
         /**
          * @brief Retrieves the the name of the host that this host should connect to.
          * 
@@ -87,6 +129,28 @@ namespace claid
             return hostConfig.connect_to().host();
         }
 
+        /**
+         * @brief Retrieves the initial delay between reconnect attempts to the server this host connects to.
+         * 
+         * @return Duration The initial backoff, 100 ms if not specified.
+         */
+        Duration getInitialReconnectBackoff() const
+        {
+            const int32_t backoffMs = hostConfig.connect_to().reconnect_initial_backoff_ms();
+            return Duration::milliseconds(backoffMs > 0 ? backoffMs : 100);
+        }
+
+        /**
+         * @brief Retrieves the maximum delay between reconnect attempts to the server this host connects to.
+         * 
+         * @return Duration The maximum backoff, 30 seconds if not specified.
+         */
+        Duration getMaxReconnectBackoff() const
+        {
+            const int32_t backoffMs = hostConfig.connect_to().reconnect_max_backoff_ms();
+            return Duration::milliseconds(backoffMs > 0 ? backoffMs : 30 * 1000);
+        }
+
         /**
          * @brief Checks if a security configuration for the server was specified in the config.
          * 
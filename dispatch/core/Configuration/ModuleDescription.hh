@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "dispatch/core/Configuration/UniqueKeyMap.hh"
+#include "dispatch/proto/claidservice.pb.h"
 
 namespace claid
 {
@@ -30,6 +30,7 @@ namespace claid
         std::string storagePath;
         std::string fileNameFormat;
         std::string fileType;
+        std::string tmpStoragePath;
         bool overrideExistingFiles;
 
 
@@ -37,6 +38,7 @@ namespace claid
         properties.getStringProperty("fileNameFormat", fileNameFormat);
         properties.getStringProperty("fileType", fileType);
         properties.getBoolProperty("overrideExistingFiles", overrideExistingFiles, false);
+        properties.getStringProperty("tmpStoragePath", tmpStoragePath, "");
 
         Logger::logInfo("DataSaver override existing files: %d", overrideExistingFiles);
 
@@ -53,7 +55,7 @@ namespace claid
         // Defaults to /sdcard/Android/media/app.package.name/ on Android
         // and to App Documents on iOS.
         // Same location where EventTracker stores event logs.
-        absl::Status status = this->fileSaver.initialize("DataChannel", storagePath, fileNameFormat, fileType, overrideExistingFiles, this->getCommonDataPath());
+        absl::Status status = this->fileSaver.initialize("DataChannel", storagePath, fileNameFormat, fileType, overrideExistingFiles, this->getCommonDataPath(), tmpStoragePath);
         
         if(!status.ok())
         {
@@ -47,6 +47,8 @@ namespace claid
                
                 annotator.describeProperty("fileType", "Data format for storing the data. Typically available are json, binary, batch_json and batch_binary.", annotator.makeEnumProperty({"json", "binary"}));
                 annotator.describeProperty("overrideExistingFiles", "If set to \"true\", an existing output file will be written whenever there is new data which would be stored in that file.", annotator.makeEnumProperty({"false", "true"}));
+                annotator.describeProperty("tmpStoragePath", "Optional path to a folder where files are stored while they are being written. "
+                "Once a file is finished, it is moved to the storagePath. Leave empty to write files to the storagePath directly.", annotator.makePathProperty());
                 annotator.describeSubscribeChannel<int>("DataChannel", "Input channel for the data");
             }
         private:
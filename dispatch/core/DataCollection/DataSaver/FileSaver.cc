@@ -25,14 +25,16 @@
 
 namespace claid
 {
+    const std::string FileSaver::MANIFEST_FILE_NAME = ".claid_file_saver_manifest";
+
     FileSaver::FileSaver()
     {
 
     }
 
     absl::Status FileSaver::initialize(const std::string& what, const std::string& storagePath, 
-        const std::string& fileNameFomat, const std::string& fileType, bool overrideExistingFiles = false,
-        std::string defaultMediaPath = "")
+        const std::string& fileNameFomat, const std::string& fileType, bool overrideExistingFiles,
+        std::string defaultMediaPath, const std::string& tmpStoragePath)
     {  
         if(this->initialized)
         {
@@ -45,6 +47,7 @@ namespace claid
         this->fileType = fileType;
         this->overrideExistingFiles = overrideExistingFiles;
         this->defaultMediaPath = defaultMediaPath;
+        this->tmpStoragePath = tmpStoragePath;
 
         if(this->storagePath.size() > 0 && this->storagePath[this->storagePath.size() - 1] != '/')
         {
@@ -54,6 +57,7 @@ namespace claid
         if(this->defaultMediaPath != "")
         {
             claid::StringUtils::stringReplaceAll(this->storagePath, "\%media_dir", this->defaultMediaPath);
+            claid::StringUtils::stringReplaceAll(this->tmpStoragePath, "\%media_dir", this->defaultMediaPath);
         }
         else
         {
@@ -88,6 +92,16 @@ namespace claid
             return status;
         }
 
+        if(this->tmpStoragePath != "")
+        {
+            this->manifestPath = Path::join(this->tmpStoragePath, MANIFEST_FILE_NAME).toString();
+            status = this->recoverTemporaryFiles();
+            if(!status.ok())
+            {
+                return status;
+            }
+        }
+
         this->initialized = true;
 
         return absl::OkStatus();
@@ -114,8 +128,8 @@ namespace claid
 
         pathStr = strftime_advanced(pathStr, timestamp);
 
-        Path path(pathStr);
-        path = Path::join(this->storagePath, path);
+        Path relativePath(pathStr);
+        Path path = Path::join(this->storagePath, relativePath);
 
         uint64_t timestampMs = timestamp.toUnixTimestampMilliseconds();
 
@@ -124,7 +138,7 @@ namespace claid
         if(path != this->currentPath)
         {
             this->currentPath = path;
-            status = beginNewFile(this->currentPath);
+            status = beginNewFile(relativePath);
             if(!status.ok())
             {
                 return status;
@@ -136,40 +150,52 @@ namespace claid
         return status;
     }
 
-    absl::Status FileSaver::beginNewFile(const Path& path)
-    {        absl::Status status = this->createStorageFolder(path);
+    absl::Status FileSaver::beginNewFile(const Path& relativePath)
+    {
+        Path destinationPath = Path::join(this->storagePath, relativePath);
+        absl::Status status = this->createStorageFolder(destinationPath);
         if(!status.ok())
         {
             return status;
         }
 
-        Logger::logInfo("Beginning new file %s", path.toString().c_str());
-        status = this->createTmpFolderIfRequired(path);
+        Logger::logInfo("Beginning new file %s", destinationPath.toString().c_str());
+        status = this->createTmpFolderIfRequired(relativePath);
         if(!status.ok())
         {
             return status;
         }
 
-        if(this->tmpStoragePath != "")
-        {
-            this->moveTemporaryFilesToStorageDestination();
-            this->currentFilePath = Path::join(this->tmpStoragePath, path).toString();
-        }
-        else
+        if(hasReceivedData)
         {
-            this->currentFilePath = (Path::join(this->storagePath, path).toString());
+            status = this->serializer->finishFile();
+            if(!status.ok())
+            {
+                return status;
+            }
         }
 
-        if(hasReceivedData)
+        if(this->tmpStoragePath != "")
         {
-            status = this->serializer->finishFile();
+            // Only the file that was just closed (and files whose promotion failed previously) have to be moved.
+            this->moveTemporaryFilesToStorageDestination();
+            this->currentFilePath = Path::join(this->tmpStoragePath, relativePath).toString();
+            this->currentDestinationPath = destinationPath.toString();
+            this->pendingTmpFiles[this->currentFilePath] = this->currentDestinationPath;
+
+            status = this->storeManifest();
             if(!status.ok())
             {
                 return status;
             }
         }
+        else
+        {
+            this->currentFilePath = destinationPath.toString();
+            this->currentDestinationPath = this->currentFilePath;
+        }
         
-        status = this->serializer->beginNewFile(path.toString());
+        status = this->serializer->beginNewFile(this->currentFilePath);
         if(!status.ok())
         {
             return status;
@@ -192,21 +218,21 @@ namespace claid
      
     absl::Status FileSaver::createDirectoriesRecursively(const std::string& path)
     {
-        if(FileUtils::dirExists(path))
+        if(this->knownDirectories.find(path) != this->knownDirectories.end())
         {
             return absl::OkStatus();
         }
-        if(!FileUtils::createDirectoriesRecursively(path))
+        if(!FileUtils::dirExists(path) && !FileUtils::createDirectoriesRecursively(path))
         {
             return absl::UnavailableError(absl::StrCat("Error in FileSaver of DataSaverModule: Failed to create one or more directories of the following path: \"", path, "\""));
         }
 
+        this->knownDirectories.insert(path);
         return absl::OkStatus();
     }
 
     absl::Status FileSaver::createStorageFolder(const Path& currentSavePath)
     {
-        Logger::logInfo("Getting currentSavePath: %s %s", currentSavePath.toString().c_str(), currentSavePath.getFolderPath().c_str());
         std::string folderPath = currentSavePath.getFolderPath();
         return this->createDirectoriesRecursively(folderPath);
     }
@@ -221,34 +247,132 @@ namespace claid
         return this->createDirectoriesRecursively(folderPath);
     }
 
-    // In some cases, it might be benefical to first store files in a temporary location,
-    // and only moving them to the final storage destination when writing to the file has been finished.
-    // The user can choose to do that by specifying tmpFolderPath.
-    // Whenever a new file is opened, all files in the tmp folder will be moved to their actual destination.
-    void FileSaver::moveTemporaryFilesToStorageDestination()
+    // The manifest contains one line per file in the tmp folder that has not yet been moved to the storage folder.
+    // Each line has the format "<path in tmp folder>\t<destination path>".
+    absl::Status FileSaver::loadManifest()
     {
-        std::vector<std::string> files;
-        FileUtils::getAllFilesInDirectoryRecursively(this->tmpStoragePath, files);
+        this->pendingTmpFiles.clear();
+        if(!FileUtils::fileExists(this->manifestPath))
+        {
+            return absl::NotFoundError(absl::StrCat("FileSaver: Manifest \"", this->manifestPath, "\" does not exist."));
+        }
 
-        Logger::logInfo("querying tmp folder %s\n", tmpStoragePath.c_str());
-        for(const std::string& filePath : files)
+        std::ifstream manifestFile(this->manifestPath);
+        if(!manifestFile.is_open())
         {
-            Path path(filePath);
-            
-            std::string relativePath = path.getPathRelativeTo(this->tmpStoragePath);
+            return absl::UnavailableError(absl::StrCat("FileSaver: Failed to open manifest \"", this->manifestPath, "\" for reading."));
+        }
 
-            // Don't move the currently active file.
-            Logger::logInfo("Current path : %s Relative path: %s", currentPath.toString().c_str(), relativePath.c_str());
-            if(relativePath == this->currentPath.toString())
+        std::string line;
+        while(std::getline(manifestFile, line))
+        {
+            size_t separator = line.find('\t');
+            if(separator == std::string::npos)
             {
-                Logger::logInfo("Current path is relative path, not moving.");
+                Logger::logWarning("FileSaver: Ignoring invalid line \"%s\" in manifest \"%s\".", line.c_str(), this->manifestPath.c_str());
                 continue;
             }
-            // If a file already exists at storage path (which it shoudln't!), then it will not be overriden but appended.
-            if(!FileUtils::moveFileTo(Path::join(this->tmpStoragePath, relativePath), Path::join(this->storagePath, relativePath), true))
+            this->pendingTmpFiles[line.substr(0, separator)] = line.substr(separator + 1);
+        }
+        return absl::OkStatus();
+    }
+
+    // The manifest is written to a temporary file first, which then is renamed.
+    // Hence, the manifest always is in a consistent state, even if the process gets killed while writing.
+    absl::Status FileSaver::storeManifest()
+    {
+        const std::string tmpManifestPath = this->manifestPath + ".tmp";
+        {
+            std::ofstream manifestFile(tmpManifestPath, std::ios::out | std::ios::trunc);
+            if(!manifestFile.is_open())
+            {
+                return absl::UnavailableError(absl::StrCat("FileSaver: Failed to open manifest \"", tmpManifestPath, "\" for writing."));
+            }
+
+            for(const auto& entry : this->pendingTmpFiles)
+            {
+                manifestFile << entry.first << "\t" << entry.second << "\n";
+            }
+        }
+
+        if(!FileUtils::renameFile(tmpManifestPath, this->manifestPath))
+        {
+            return absl::UnavailableError(absl::StrCat("FileSaver: Failed to commit manifest \"", this->manifestPath, "\"."));
+        }
+        return absl::OkStatus();
+    }
+
+    // Called once upon initialization. All files listed in the manifest were written by a previous instance
+    // of the FileSaver (e.g., before the app was restarted) and are not open anymore, hence they can be promoted.
+    // If there is no manifest yet (e.g., tmp folder was used by an older version), the tmp folder is scanned once.
+    absl::Status FileSaver::recoverTemporaryFiles()
+    {
+        absl::Status status = this->loadManifest();
+        if(absl::IsNotFound(status))
+        {
+            std::vector<std::string> files;
+            FileUtils::getAllFilesInDirectoryRecursively(this->tmpStoragePath, files);
+
+            for(const std::string& filePath : files)
+            {
+                std::string relativePath = Path(filePath).getPathRelativeTo(this->tmpStoragePath);
+                if(Path(relativePath).getFileNameFromPath().find(MANIFEST_FILE_NAME) == 0)
+                {
+                    continue;
+                }
+                this->pendingTmpFiles[filePath] = Path::join(this->storagePath, relativePath).toString();
+            }
+        }
+        else if(!status.ok())
+        {
+            return status;
+        }
+
+        Logger::logInfo("FileSaver: Recovering %lu file(s) from tmp folder %s", this->pendingTmpFiles.size(), this->tmpStoragePath.c_str());
+        this->moveTemporaryFilesToStorageDestination();
+        return this->storeManifest();
+    }
+
+    bool FileSaver::promoteTemporaryFile(const std::string& tmpFilePath, const std::string& destinationPath)
+    {
+        if(!FileUtils::fileExists(tmpFilePath))
+        {
+            // Nothing was written to the file (or it was promoted already).
+            return true;
+        }
+
+        if(!this->createDirectoriesRecursively(Path(destinationPath).getFolderPath()).ok())
+        {
+            return false;
+        }
+
+        // A rename is atomic, i.e., the file either is completely visible at the destination or not at all.
+        // If a file already exists at storage path (which it shoudln't!), then it will not be overriden but appended.
+        // Rename also fails if tmp and storage folder are located on different file systems, in which case we fall back to copying.
+        if(!FileUtils::fileExists(destinationPath) && FileUtils::renameFile(tmpFilePath, destinationPath))
+        {
+            return true;
+        }
+        return FileUtils::moveFileTo(tmpFilePath, destinationPath, true);
+    }
+
+    // In some cases, it might be benefical to first store files in a temporary location,
+    // and only moving them to the final storage destination when writing to the file has been finished.
+    // The user can choose to do that by specifying tmpStoragePath.
+    // Whenever a new file is opened, the file that was just closed (and any file whose promotion failed before)
+    // will be moved to its actual destination. The currently open file is never moved.
+    void FileSaver::moveTemporaryFilesToStorageDestination()
+    {
+        auto it = this->pendingTmpFiles.begin();
+        while(it != this->pendingTmpFiles.end())
+        {
+            if(!this->promoteTemporaryFile(it->first, it->second))
             {
-                Logger::logInfo("Moving file %s to %s failed.", Path::join(this->tmpStoragePath, relativePath).toString().c_str(), Path::join(this->storagePath, relativePath).toString().c_str());
+                Logger::logWarning("Moving file %s to %s failed, will retry when the next file is begun.", it->first.c_str(), it->second.c_str());
+                it++;
+                continue;
             }
+            it = this->pendingTmpFiles.erase(it);
         }
     }
 
@@ -265,6 +389,16 @@ namespace claid
             return status;
         }
 
+        if(this->tmpStoragePath != "")
+        {
+            this->moveTemporaryFilesToStorageDestination();
+            status = this->storeManifest();
+            if(!status.ok())
+            {
+                return status;
+            }
+        }
+
         this->initialized = false;
 
 
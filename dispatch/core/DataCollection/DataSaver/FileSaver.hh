@@ -26,6 +26,8 @@
 #include "dispatch/core/Module/ChannelData.hh"
 
 #include <fstream>
+#include <map>
+#include <set>
 
 namespace claid
 {
@@ -43,18 +45,33 @@ namespace claid
             
             std::string tmpStoragePath;
             std::string currentFilePath;
+            std::string currentDestinationPath;
 
             std::string defaultMediaPath = "";
 
+            // If a tmpStoragePath is used, the FileSaver keeps track of the files it has written to the tmp folder.
+            // Maps path of the file in the tmp folder to its final destination in the storage folder.
+            // Contains the currently open file and files whose promotion to the storage folder failed.
+            // The map is persisted in a small manifest file within the tmp folder, which allows to recover
+            // files that were left in the tmp folder (e.g., if the app was killed) without scanning the whole folder.
+            std::map<std::string, std::string> pendingTmpFiles;
+            std::string manifestPath;
+
+            // Directories which are known to exist, so we do not have to check them again each time a new file is begun.
+            std::set<std::string> knownDirectories;
 
             Path currentPath;
 
             std::string getCurrentFilePath();
             void getCurrentPathRelativeToStorageFolder(Path& path, const Time timestamp);
             absl::Status createDirectoriesRecursively(const std::string& path);
-            absl::Status beginNewFile(const Path& path);
+            absl::Status beginNewFile(const Path& relativePath);
             
 
+            absl::Status loadManifest();
+            absl::Status storeManifest();
+            absl::Status recoverTemporaryFiles();
+            bool promoteTemporaryFile(const std::string& tmpFilePath, const std::string& destinationPath);
             void moveTemporaryFilesToStorageDestination();
 
             absl::Status createStorageFolder(const Path& currentSavePath);
@@ -70,11 +87,13 @@ namespace claid
 
         public:           
 
+            static const std::string MANIFEST_FILE_NAME;
+
             FileSaver();
 
             absl::Status initialize(const std::string& what, const std::string& storagePath, 
                 const std::string& fileNameFomat, const std::string& fileType, bool overrideExistingFiles,
-                std::string defaultMediaPath);
+                std::string defaultMediaPath, const std::string& tmpStoragePath = "");
             absl::Status onNewData(ChannelData<google::protobuf::Message>& data);
             absl::Status onNewData(std::shared_ptr<const google::protobuf::Message> data, const Time& timestamp);
 
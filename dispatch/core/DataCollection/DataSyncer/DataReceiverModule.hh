@@ -24,7 +24,7 @@
 #include "dispatch/core/Module/Module.hh"
 #include "dispatch/core/Utilities/FileUtils.hh"
 #include "dispatch/core/Utilities/StringUtils.hh"
-#include "dispatch/core/Utilities/Path.hh"
+#include "dispatch/core/DataCollection/DataSyncer/DataReceiverShard.hh"
 #include "dispatch/proto/sensor_data_types.pb.h"
 #include "dispatch/proto/claidservice.pb.h"
 
@@ -36,9 +36,9 @@
 // #endif
 
 #include "absl/strings/str_split.h"
+#include "absl/strings/ascii.h"
 #include "absl/status/status.h"
-#include <queue>
-#include <map>
+#include <thread>
 
 using namespace claidservice;
 
@@ -48,6 +48,14 @@ namespace claid
     // Receives a list of files and compares it with files available in a specified directory.
     // All files that are missing are requested from the DataSyncModule, which will then be received
     // and stored in the path.
+    // Files are requested in chunks, which are written to a partial file directly as they arrive.
+    // Once all chunks have been received, the partial file is renamed to the actual file.
+    // If the connection is lost during a transfer, the transfer is resumed from the partial file during the next sync.
+    // The DataSyncModule only sends files that changed since the version of its manifest which we acknowledged last.
+    // A manifest version is acknowledged once all missing files of that version have been received successfully.
+    // Multiple files are requested concurrently (pipelined), both per user and in total. Free transfer slots are
+    // assigned to users in a round-robin fashion, so that a single user with a large backlog cannot monopolize the receiver.
+    // Users are distributed over numWorkerThreads DataReceiverShards, which process the packages of their users in parallel.
     class DataReceiverModule : public Module
     {
         public:
@@ -71,91 +79,12 @@ namespace claid
 
             std::string filePath;
 
-            // bool storeArrivalTimePerFile = false;
-
-            // One queue per user that has a DataSyncModule connected.
-            // Indicates which files of the user we are missing.
-            std::map<std::string, std::queue<std::string>> missingFilesQueuePerUser;
-
-            template<typename T>
-            bool isElementContainedInVector(const std::vector<T>& vector, const T& element)
-            {
-                return std::find(vector.begin(), vector.end(), element) != vector.end();
-            }
-
-            // Get elements that are contained in both lists.
-            void getMissingFilesOfUser(
-                    const std::string& userId, 
-                    const DataSyncFileDescriptorList& descriptorList, 
-                    std::vector<std::string>& missingList)
-            {
-                missingList.clear();
-                std::string path;
-                for(const DataSyncFileDescriptor& descriptor : descriptorList.descriptors())
-                {   
-                    const std::string& relativePath = descriptor.relative_file_path();
-                    path = getUserStoragePath(userId) + std::string("/") + relativePath;
-                    // If the file doesnt exist yet, we add it to the list of missing files.
-                    if(!FileUtils::fileExists(path))
-                    {
-                        missingList.push_back(relativePath);
-                        continue;
-                    }
-
-                    uint64_t fileSize;
-                    if(!FileUtils::getFileSize(path, fileSize))
-                    {
-                        moduleError(absl::StrCat("Unable to get file size of file \"", path, "\""));
-                        continue;
-                    }
+            // Number of threads processing the packages of users. Each user is assigned to one of the threads.
+            int numWorkerThreads;
 
-                    // If the file exists, but has a different file size, we also request it again.
-                    // The current file will then be replaced.
-                    if(fileSize != descriptor.file_size())
-                    {
-                        missingList.push_back(relativePath);
-                        continue;
-                    }
-                }
-            }
-
-            std::string getUserStoragePath(const std::string& userId)
-            {
-                return this->filePath + "/" + userId;
-            }
-
-            void makePathRelative(std::string& path)
-            {
-                std::string basePath = this->filePath;
-                if(this->filePath[this->filePath.size() - 1] != '/')
-                {
-                    basePath += '/';
-                }
+            DataReceiverShardPool shardPool;
 
-                if(StringUtils::startsWith(path, basePath))
-                {
-                    path = path.substr(basePath.size(), path.size());   
-                }
-            }
-
-            void getListOfFilesInTargetDirectory(std::vector<std::string>& output)
-            {
-                output.clear();
-                if(!FileUtils::getAllFilesInDirectoryRecursively(this->filePath, output))
-                {
-                    printf("Error in DataReceiverModule, cannot determine missing files.\n"
-                        "Cannot retrieve list of files available in directory \"%s\".\n"
-                        "Either the directory does not exist or we do not have permissions to access it.\n",
-                        this->filePath.c_str());
-
-                    return;
-                }
-
-                for(std::string& path : output)
-                {
-                    makePathRelative(path);
-                }
-            }
+            // bool storeArrivalTimePerFile = false;
 
             void onDataFromDataSyncModule(ChannelData<DataSyncPackage> data)
             {
@@ -164,100 +93,14 @@ namespace claid
                     "DataReceiverModule received data from DataSyncModule, package type is: %s",
                      DataSyncPackageType_Name(pkg.package_type()).c_str()
                 );
-                if(pkg.package_type() == DataSyncPackageType::ALL_AVAILABLE_FILES_LIST)
-                {
-                    this->onCompleteFileListReceivedFromUser(pkg.file_descriptors(), data.getUserId());
-                }
-                else if(pkg.package_type() == DataSyncPackageType::FILES_DATA)
-                {
-                    this->onFileReceivedFromUser(pkg.file_descriptors(), data.getUserId());
-                }
+                // Processing (including writing files) happens on the worker thread of the user's shard,
+                // hence the thread of the Module is free to receive packages of other users meanwhile.
+                this->shardPool.enqueuePackage(std::make_shared<const DataSyncPackage>(pkg), data.getUserId());
             }
 
-            void onCompleteFileListReceivedFromUser(const DataSyncFileDescriptorList& descriptorList, const std::string& userId)
+            void sendToUser(const DataSyncPackage& pkg, const std::string& userId)
             {
-                Logger::logInfo("Received complete file list from user %s", userId.c_str());
- 
-                std::vector<std::string> missingFiles;
-                getMissingFilesOfUser(userId, descriptorList, missingFiles);
-
-                this->missingFilesQueuePerUser[userId] = std::queue<std::string>();
-
-                for(const std::string& value : missingFiles)
-                {
-                    this->missingFilesQueuePerUser[userId].push(value);
-                    Logger::logInfo("Missing %s", value.c_str());
-                }
-                
-                this->requestNextFileFromUser(userId);
-            }
-
-            void requestNextFileFromUser(const std::string& userId)
-            {
-                std::queue<std::string>& filesQueue = this->missingFilesQueuePerUser[userId]; 
-                printf("Requesting next file %lu\n", filesQueue.size());
-                if(filesQueue.empty())
-                {
-                    return;
-                }
-
-                std::string file = filesQueue.front();
-                printf("Requesting file %s\n", file.c_str());
-                filesQueue.pop();
-
-                DataSyncPackage dataSyncPackage;
-                dataSyncPackage.set_package_type(DataSyncPackageType::REQUESTED_FILES_LIST);
-
-                DataSyncFileDescriptorList* descriptors = dataSyncPackage.mutable_file_descriptors();
-                descriptors->add_descriptors()->set_relative_file_path(file);
-
-                this->toDataSyncModuleChannel.postToUser(dataSyncPackage, userId);
-            }
-
-            void onFileReceivedFromUser(const DataSyncFileDescriptorList& descriptorList, const std::string& userId)
-            {
-                this->requestNextFileFromUser(userId);
-
-                for(const DataSyncFileDescriptor& fileDescriptor : descriptorList.descriptors())
-                {
-                    const std::string& relativePath = fileDescriptor.relative_file_path();
-                    std::string folderPath;
-                    std::string filePath;
-                    Path::splitPathIntoFolderAndFileName(relativePath, folderPath, filePath);
-                    printf("folder file %s %s %s\n", relativePath.c_str(), folderPath.c_str(), filePath.c_str());
-                    
-                 
-                    std::string targetFolderPath = getUserStoragePath(userId) + std::string("/");
-                    if(folderPath != "")
-                    {
-                        targetFolderPath += std::string("/") + folderPath;
-                    }
-                    if(!FileUtils::dirExists(targetFolderPath))
-                    {
-                        if(!FileUtils::createDirectoriesRecursively(targetFolderPath))
-                        {
-                            moduleError(absl::StrCat("Error in DataReceiverModule, cannot create target folder \"", targetFolderPath, "\"."));
-                            return;
-                        }
-                    }
-                
-
-                    std::string targetFilePath = 
-                        getUserStoragePath(userId) + std::string("/") + folderPath + std::string("/") + filePath;
-                    
-                    if(!saveDataFileToPath(fileDescriptor, targetFilePath))
-                    {
-                        return;
-                    }
-
-                    // Send acknowledgement.
-                    DataSyncPackage dataSyncPackage;
-                    dataSyncPackage.set_package_type(DataSyncPackageType::ACKNOWLEDGED_FILES);
-
-                    DataSyncFileDescriptorList* descriptors = dataSyncPackage.mutable_file_descriptors();
-                    descriptors->add_descriptors()->set_relative_file_path(relativePath);
-                    this->toDataSyncModuleChannel.postToUser(dataSyncPackage, userId);
-                }
+                this->toDataSyncModuleChannel.postToUser(pkg, userId);
             }
 
             bool setupStorageFolder()
@@ -281,11 +124,40 @@ namespace claid
                 return true;
             }
 
+        public:
             void initialize(Properties properties)
             {
                 Logger::logInfo("DataReceiverModule initialize");
 
+                DataReceiverShard::Config config;
                 properties.getStringProperty("storagePath", this->filePath);
+                properties.getNumberProperty("maxConcurrentFilesPerUser", config.maxConcurrentFilesPerUser, 4);
+                properties.getNumberProperty("maxConcurrentFiles", config.maxConcurrentFiles, 256);
+                properties.getNumberProperty("transferTimeoutSeconds", config.transferTimeoutSeconds, 120);
+                properties.getNumberProperty("resumeRequestRetryMilliseconds", config.resumeRequestRetryMilliseconds, 5000);
+                properties.getStringProperty("filePriority", config.filePriority, "fifo");
+                properties.getNumberProperty("numWorkerThreads", this->numWorkerThreads, 
+                    std::max(1, std::min(4, static_cast<int>(std::thread::hardware_concurrency()))));
+
+                // Comma separated list of path prefixes (e.g., folders of certain channels).
+                std::string prefixes;
+                properties.getStringProperty("priorityPathPrefixes", prefixes, "");
+                for(absl::string_view prefix : absl::StrSplit(prefixes, ',', absl::SkipWhitespace()))
+                {
+                    config.priorityPathPrefixes.push_back(std::string(absl::StripAsciiWhitespace(prefix)));
+                }
+
+                if(config.filePriority != "fifo" && config.filePriority != "newest_first" && config.filePriority != "oldest_first")
+                {
+                    moduleFatal(absl::StrCat("Invalid value \"", config.filePriority, "\" for property filePriority of DataReceiverModule. ", 
+                        "Expected one of \"fifo\", \"newest_first\" or \"oldest_first\"."));
+                    return;
+                }
+                if(config.maxConcurrentFilesPerUser <= 0 || config.maxConcurrentFiles <= 0 || config.transferTimeoutSeconds <= 0 || this->numWorkerThreads <= 0)
+                {
+                    moduleFatal("Properties maxConcurrentFilesPerUser, maxConcurrentFiles, transferTimeoutSeconds and numWorkerThreads of DataReceiverModule need to be greater than 0.");
+                    return;
+                }
 
                 if(this->getCommonDataPath() != "")
                 {
@@ -306,29 +178,21 @@ namespace claid
                 {
                     return;
                 }
-                // Check if we can access output directory, scan for existing files.
-                // Throws exception if we cannot access the directory.
-                std::vector<std::string> output;
-                getListOfFilesInTargetDirectory(output);
+                config.storagePath = this->filePath;
 
                 this->toDataSyncModuleChannel = this->publish<DataSyncPackage>("ToDataSyncModuleChannel");
                 this->fromDataSyncModuleChannel = this->subscribe<DataSyncPackage>("FromDataSyncModuleChannel", &DataReceiverModule::onDataFromDataSyncModule, this);
 
+                this->shardPool.start(config, static_cast<size_t>(this->numWorkerThreads), 
+                    std::bind(&DataReceiverModule::sendToUser, this, std::placeholders::_1, std::placeholders::_2));
+
                 Logger::logInfo("DataReceiverModule initialize done");
 
             }
 
-            bool saveDataFileToPath(const DataSyncFileDescriptor& dataFile, const std::string& path)
+            void terminate()
             {
-                std::fstream file(path, std::ios::out | std::ios::binary);
-                if(!file.is_open())
-                {
-                    moduleError(absl::StrCat("Error, cannot save binary data to \"", path, "\".\n. Could not open File for writing."));
-                    return false;
-                }
-
-                file.write(dataFile.file_data().data(), dataFile.file_data().size());
-                return true;
-            }    
+                this->shardPool.stop();
+            }
     };
-}
\ No newline at end of file
+}
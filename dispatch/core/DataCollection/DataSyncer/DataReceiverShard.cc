@@ -0,0 +1,725 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/DataCollection/DataSyncer/DataReceiverShard.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+#include "dispatch/core/Utilities/StringUtils.hh"
+#include "dispatch/core/Utilities/Path.hh"
+#include "dispatch/core/Utilities/XXHash64.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <algorithm>
+
+namespace claid
+{
+    DataReceiverShard::DataReceiverShard(const Config& config, SendFunction sendToUser) : config(config), sendToUser(sendToUser)
+    {
+
+    }
+
+    DataReceiverShard::~DataReceiverShard()
+    {
+        this->stop();
+    }
+
+    void DataReceiverShard::start()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(this->running)
+        {
+            return;
+        }
+        this->running = true;
+        this->thread = std::thread(&DataReceiverShard::run, this);
+    }
+
+    void DataReceiverShard::stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if(!this->running)
+            {
+                return;
+            }
+            this->running = false;
+        }
+        this->conditionVariable.notify_all();
+        if(this->thread.joinable())
+        {
+            this->thread.join();
+        }
+        // Closes all partial files, they will be resumed after a restart.
+        this->incomingFileTransfers.clear();
+    }
+
+    void DataReceiverShard::enqueuePackage(std::shared_ptr<const DataSyncPackage> package, const std::string& userId)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->packageQueue.push_back(std::make_pair(package, userId));
+        }
+        this->conditionVariable.notify_one();
+    }
+
+    void DataReceiverShard::run()
+    {
+        const std::chrono::seconds stalledTransferCheckInterval(std::max(1, this->config.transferTimeoutSeconds / 2));
+        Time nextStalledTransferCheck = Time::now() + stalledTransferCheckInterval;
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while(this->running)
+        {
+            this->conditionVariable.wait_until(lock, nextStalledTransferCheck, [&]{return !this->running || !this->packageQueue.empty();});
+
+            while(this->running && !this->packageQueue.empty())
+            {
+                auto entry = std::move(this->packageQueue.front());
+                this->packageQueue.pop_front();
+
+                // Writing files might take a while, other threads are allowed to enqueue packages meanwhile.
+                lock.unlock();
+                this->processPackage(*entry.first, entry.second);
+                lock.lock();
+            }
+
+            if(this->running && Time::now() >= nextStalledTransferCheck)
+            {
+                lock.unlock();
+                this->releaseStalledTransfers();
+                lock.lock();
+                nextStalledTransferCheck = Time::now() + stalledTransferCheckInterval;
+            }
+        }
+    }
+
+    void DataReceiverShard::processPackage(const DataSyncPackage& pkg, const std::string& userId)
+    {
+        this->syncStatePerUser[userId].lastActivity = Time::now();
+        if(pkg.package_type() == DataSyncPackageType::ALL_AVAILABLE_FILES_LIST)
+        {
+            this->onCompleteFileListReceivedFromUser(pkg, userId);
+        }
+        else if(pkg.package_type() == DataSyncPackageType::FILES_DATA)
+        {
+            this->onFileReceivedFromUser(pkg.file_descriptors(), userId);
+        }
+        else if(pkg.package_type() == DataSyncPackageType::FILE_CHUNK)
+        {
+            this->onFileChunkReceivedFromUser(pkg.file_descriptors(), userId);
+        }
+    }
+
+    std::string DataReceiverShard::getUserStoragePath(const std::string& userId) const
+    {
+        return this->config.storagePath + "/" + userId;
+    }
+
+    std::string DataReceiverShard::getTargetFilePath(const std::string& userId, const std::string& relativePath) const
+    {
+        std::string folderPath;
+        std::string fileName;
+        Path::splitPathIntoFolderAndFileName(relativePath, folderPath, fileName);
+        return getUserStoragePath(userId) + std::string("/") + folderPath + std::string("/") + fileName;
+    }
+
+    bool DataReceiverShard::createTargetFolder(const std::string& userId, const std::string& relativePath)
+    {
+        std::string folderPath;
+        std::string fileName;
+        Path::splitPathIntoFolderAndFileName(relativePath, folderPath, fileName);
+
+        std::string targetFolderPath = getUserStoragePath(userId) + std::string("/");
+        if(folderPath != "")
+        {
+            targetFolderPath += std::string("/") + folderPath;
+        }
+        if(!FileUtils::dirExists(targetFolderPath))
+        {
+            if(!FileUtils::createDirectoriesRecursively(targetFolderPath))
+            {
+                Logger::logError("Error in DataReceiverModule, cannot create target folder \"%s\".", targetFolderPath.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Files in the storage folder might be deleted or replaced by others (e.g., by a cleanup job), hence
+    // each lookup checks size and modification time of the file. The index only saves hashing files again.
+    DataReceiverShard::ReceivedFile* DataReceiverShard::lookupReceivedFile(const std::string& userId, const std::string& relativePath)
+    {
+        std::map<std::string, ReceivedFile>& receivedFiles = this->syncStatePerUser[userId].receivedFiles;
+        uint64_t fileSize;
+        uint64_t modificationTime;
+        if(!FileUtils::getFileSizeAndModificationTime(getTargetFilePath(userId, relativePath), fileSize, modificationTime))
+        {
+            receivedFiles.erase(relativePath);
+            return nullptr;
+        }
+
+        ReceivedFile& receivedFile = receivedFiles[relativePath];
+        if(receivedFile.fileSize != fileSize || receivedFile.modificationTime != modificationTime)
+        {
+            receivedFile.fileSize = fileSize;
+            receivedFile.modificationTime = modificationTime;
+            receivedFile.hashValid = false;
+        }
+        return &receivedFile;
+    }
+
+    void DataReceiverShard::indexReceivedFile(const std::string& userId, const std::string& relativePath, uint64_t hash)
+    {
+        ReceivedFile* receivedFile = this->lookupReceivedFile(userId, relativePath);
+        if(receivedFile != nullptr)
+        {
+            receivedFile->hash = hash;
+            receivedFile->hashValid = hash != 0;
+        }
+    }
+
+    void DataReceiverShard::getMissingFilesOfUser(
+            const std::string& userId, 
+            const DataSyncFileDescriptorList& descriptorList, 
+            std::vector<const DataSyncFileDescriptor*>& missingList)
+    {
+        missingList.clear();
+        for(const DataSyncFileDescriptor& descriptor : descriptorList.descriptors())
+        {   
+            ReceivedFile* receivedFile = this->lookupReceivedFile(userId, descriptor.relative_file_path());
+            // If the file doesnt exist yet or has a different file size, we request it (again).
+            // The current file will then be replaced.
+            if(receivedFile == nullptr || receivedFile->fileSize != descriptor.file_size())
+            {
+                missingList.push_back(&descriptor);
+                continue;
+            }
+
+            // Same size, but different content (e.g., file was corrupted or changed).
+            // A hash of 0 means that the DataSyncModule did not provide a hash.
+            if(descriptor.hash() == 0)
+            {
+                continue;
+            }
+            if(!receivedFile->hashValid)
+            {
+                receivedFile->hashValid = XXHash64::hashFile(getTargetFilePath(userId, descriptor.relative_file_path()), receivedFile->hash);
+            }
+            if(!receivedFile->hashValid || receivedFile->hash != descriptor.hash())
+            {
+                missingList.push_back(&descriptor);
+            }
+        }
+    }
+
+    // Sorts missing files according to filePriority and priorityPathPrefixes.
+    // The sort is stable, hence files keep the order of the file list if they have the same priority.
+    void DataReceiverShard::prioritizeMissingFiles(std::vector<const DataSyncFileDescriptor*>& missingFiles) const
+    {
+        const std::vector<std::string>& prefixes = this->config.priorityPathPrefixes;
+        auto getPrefixRank = [&prefixes](const std::string& relativePath)
+        {
+            for(size_t i = 0; i < prefixes.size(); i++)
+            {
+                if(StringUtils::startsWith(relativePath, prefixes[i]))
+                {
+                    return i;
+                }
+            }
+            return prefixes.size();
+        };
+
+        const std::string& filePriority = this->config.filePriority;
+        std::stable_sort(missingFiles.begin(), missingFiles.end(), 
+            [&](const DataSyncFileDescriptor* a, const DataSyncFileDescriptor* b)
+            {
+                size_t rankA = getPrefixRank(a->relative_file_path());
+                size_t rankB = getPrefixRank(b->relative_file_path());
+                if(rankA != rankB)
+                {
+                    return rankA < rankB;
+                }
+                if(filePriority == "newest_first")
+                {
+                    return a->modification_time() > b->modification_time();
+                }
+                if(filePriority == "oldest_first")
+                {
+                    return a->modification_time() < b->modification_time();
+                }
+                return false;
+            });
+    }
+
+    void DataReceiverShard::onCompleteFileListReceivedFromUser(const DataSyncPackage& pkg, const std::string& userId)
+    {
+        Logger::logInfo("Received complete file list from user %s", userId.c_str());
+        UserSyncState& state = this->syncStatePerUser[userId];
+
+        // The list only contains changes since base_manifest_version. If we have not processed that version
+        // (e.g., because we were restarted), we tell the DataSyncModule which version we know, and it will resend the list.
+        if(pkg.base_manifest_version() > state.acknowledgedManifestVersion)
+        {
+            Logger::logInfo("File list of user %s is based on manifest version %lu, but we only know version %lu.", 
+                userId.c_str(), pkg.base_manifest_version(), state.acknowledgedManifestVersion);
+            this->acknowledgeManifestVersion(state.acknowledgedManifestVersion, userId);
+            return;
+        }
+
+        std::vector<const DataSyncFileDescriptor*> missingFiles;
+        getMissingFilesOfUser(userId, pkg.file_descriptors(), missingFiles);
+        prioritizeMissingFiles(missingFiles);
+
+        // A new file list replaces the previous one, files that are still missing will be part of the new list.
+        this->releaseRequestedFilesOfUser(userId);
+        state.missingFiles = std::queue<std::string>();
+        state.pendingManifestVersion = pkg.manifest_version();
+        state.transferFailed = false;
+
+        for(const DataSyncFileDescriptor* descriptor : missingFiles)
+        {
+            state.missingFiles.push(descriptor->relative_file_path());
+        }
+        Logger::logInfo("Missing %lu files of user %s", state.missingFiles.size(), userId.c_str());
+
+        if(state.missingFiles.empty())
+        {
+            this->acknowledgeManifestIfComplete(userId);
+            return;
+        }
+        this->enqueueUserForTransferSlot(userId);
+        this->assignTransferSlots();
+    }
+
+    void DataReceiverShard::enqueueUserForTransferSlot(const std::string& userId)
+    {
+        UserSyncState& state = this->syncStatePerUser[userId];
+        if(state.waitingForTransferSlot)
+        {
+            return;
+        }
+        state.waitingForTransferSlot = true;
+        this->usersWaitingForTransferSlot.push_back(userId);
+    }
+
+    // Assigns free transfer slots to waiting users, one file at a time in round-robin order.
+    // Users that reached maxConcurrentFilesPerUser leave the queue and are added again once one of their transfers is done.
+    void DataReceiverShard::assignTransferSlots()
+    {
+        while(this->numFilesInFlight < static_cast<uint64_t>(this->config.maxConcurrentFiles) && !this->usersWaitingForTransferSlot.empty())
+        {
+            std::string userId = this->usersWaitingForTransferSlot.front();
+            this->usersWaitingForTransferSlot.pop_front();
+
+            UserSyncState& state = this->syncStatePerUser[userId];
+            state.waitingForTransferSlot = false;
+            if(state.missingFiles.empty() || state.requestedFiles.size() >= static_cast<size_t>(this->config.maxConcurrentFilesPerUser))
+            {
+                continue;
+            }
+
+            this->requestNextFileFromUser(userId);
+
+            if(!state.missingFiles.empty() && state.requestedFiles.size() < static_cast<size_t>(this->config.maxConcurrentFilesPerUser))
+            {
+                this->enqueueUserForTransferSlot(userId);
+            }
+        }
+    }
+
+    void DataReceiverShard::requestNextFileFromUser(const std::string& userId)
+    {
+        UserSyncState& state = this->syncStatePerUser[userId];
+        std::queue<std::string>& filesQueue = state.missingFiles; 
+
+        std::string file = filesQueue.front();
+        filesQueue.pop();
+        if(!state.requestedFiles.insert(file).second)
+        {
+            return;
+        }
+        this->numFilesInFlight++;
+        state.lastActivity = Time::now();
+
+        // If parts of the file have been received during a previous sync, we resume from there.
+        uint64_t resumeOffset = 0;
+        std::string partialFilePath = getTargetFilePath(userId, file) + PARTIAL_FILE_SUFFIX;
+        if(FileUtils::fileExists(partialFilePath) && !FileUtils::getFileSize(partialFilePath, resumeOffset))
+        {
+            resumeOffset = 0;
+        }
+
+        this->requestFileFromUser(file, resumeOffset, userId);
+    }
+
+    void DataReceiverShard::requestFileFromUser(const std::string& relativePath, uint64_t offset, const std::string& userId)
+    {
+        DataSyncPackage dataSyncPackage;
+        dataSyncPackage.set_package_type(DataSyncPackageType::REQUESTED_FILES_LIST);
+
+        DataSyncFileDescriptorList* descriptors = dataSyncPackage.mutable_file_descriptors();
+        DataSyncFileDescriptor* descriptor = descriptors->add_descriptors();
+        descriptor->set_relative_file_path(relativePath);
+        descriptor->set_chunked_transfer(true);
+        descriptor->set_chunk_offset(offset);
+
+        this->sendToUser(dataSyncPackage, userId);
+    }
+
+    void DataReceiverShard::onFileTransferDone(const std::string& relativePath, const std::string& userId, bool success)
+    {
+        UserSyncState& state = this->syncStatePerUser[userId];
+        if(state.requestedFiles.erase(relativePath) == 0)
+        {
+            return;
+        }
+        this->numFilesInFlight--;
+        if(!success)
+        {
+            state.transferFailed = true;
+        }
+
+        if(state.missingFiles.empty())
+        {
+            this->acknowledgeManifestIfComplete(userId);
+        }
+        else
+        {
+            this->enqueueUserForTransferSlot(userId);
+        }
+        this->assignTransferSlots();
+    }
+
+    // Gives up on all files currently requested from the user, freeing their transfer slots.
+    // Partial files are kept, so the transfers can be resumed later.
+    void DataReceiverShard::releaseRequestedFilesOfUser(const std::string& userId)
+    {
+        UserSyncState& state = this->syncStatePerUser[userId];
+        for(const std::string& relativePath : state.requestedFiles)
+        {
+            this->incomingFileTransfers.erase(std::make_pair(userId, relativePath));
+        }
+        this->numFilesInFlight -= state.requestedFiles.size();
+        state.requestedFiles.clear();
+    }
+
+    void DataReceiverShard::releaseStalledTransfers()
+    {
+        const Time now = Time::now();
+        bool released = false;
+        for(auto& entry : this->syncStatePerUser)
+        {
+            UserSyncState& state = entry.second;
+            if(state.requestedFiles.empty() || 
+                std::chrono::duration_cast<std::chrono::seconds>(now - state.lastActivity).count() < this->config.transferTimeoutSeconds)
+            {
+                continue;
+            }
+
+            Logger::logWarning("DataReceiverModule: No data received from user %s for %d seconds, aborting %lu file transfers.", 
+                entry.first.c_str(), this->config.transferTimeoutSeconds, state.requestedFiles.size());
+            this->releaseRequestedFilesOfUser(entry.first);
+            state.missingFiles = std::queue<std::string>();
+            state.pendingManifestVersion = 0;
+            state.transferFailed = false;
+            released = true;
+        }
+
+        if(released)
+        {
+            this->assignTransferSlots();
+        }
+    }
+
+    // Once all missing files of the current file list have been received, we acknowledge the manifest version,
+    // so the DataSyncModule will only send files that changed afterwards.
+    // If any transfer failed, we do not acknowledge, so the files will be part of the next file list again.
+    void DataReceiverShard::acknowledgeManifestIfComplete(const std::string& userId)
+    {
+        UserSyncState& state = this->syncStatePerUser[userId];
+        if(state.pendingManifestVersion == 0 || !state.missingFiles.empty() || !state.requestedFiles.empty())
+        {
+            return;
+        }
+
+        if(!state.transferFailed)
+        {
+            state.acknowledgedManifestVersion = state.pendingManifestVersion;
+            this->acknowledgeManifestVersion(state.acknowledgedManifestVersion, userId);
+        }
+        state.pendingManifestVersion = 0;
+        state.transferFailed = false;
+    }
+
+    void DataReceiverShard::acknowledgeManifestVersion(uint64_t version, const std::string& userId)
+    {
+        DataSyncPackage dataSyncPackage;
+        dataSyncPackage.set_package_type(DataSyncPackageType::MANIFEST_ACKNOWLEDGEMENT);
+        dataSyncPackage.set_manifest_version(version);
+        this->sendToUser(dataSyncPackage, userId);
+    }
+
+    void DataReceiverShard::acknowledgeFile(const std::string& relativePath, const std::string& userId)
+    {
+        DataSyncPackage dataSyncPackage;
+        dataSyncPackage.set_package_type(DataSyncPackageType::ACKNOWLEDGED_FILES);
+
+        DataSyncFileDescriptorList* descriptors = dataSyncPackage.mutable_file_descriptors();
+        descriptors->add_descriptors()->set_relative_file_path(relativePath);
+        this->sendToUser(dataSyncPackage, userId);
+    }
+
+    std::shared_ptr<DataReceiverShard::IncomingFileTransfer> DataReceiverShard::getOrCreateIncomingFileTransfer(const DataSyncFileDescriptor& chunk, const std::string& userId)
+    {
+        const std::string& relativePath = chunk.relative_file_path();
+        auto key = std::make_pair(userId, relativePath);
+        auto it = this->incomingFileTransfers.find(key);
+        if(it != this->incomingFileTransfers.end())
+        {
+            return it->second;
+        }
+
+        if(!createTargetFolder(userId, relativePath))
+        {
+            this->onFileTransferDone(relativePath, userId, false);
+            return nullptr;
+        }
+
+        std::shared_ptr<IncomingFileTransfer> transfer = std::make_shared<IncomingFileTransfer>();
+        transfer->targetFilePath = getTargetFilePath(userId, relativePath);
+        transfer->partialFilePath = transfer->targetFilePath + PARTIAL_FILE_SUFFIX;
+
+        uint64_t partialFileSize = 0;
+        if(FileUtils::fileExists(transfer->partialFilePath) && FileUtils::getFileSize(transfer->partialFilePath, partialFileSize))
+        {
+            if(partialFileSize > chunk.file_size())
+            {
+                // The partial file does not match the data we are receiving (e.g., file changed on the sender side).
+                // Other changes of the file are detected by the hash once the transfer is complete.
+                partialFileSize = 0;
+            }
+        }
+
+        if(partialFileSize == 0 && chunk.chunk_offset() != 0)
+        {
+            // We do not have the beginning of the file, restart the transfer.
+            this->requestFileFromUser(relativePath, 0, userId);
+            return nullptr;
+        }
+
+        transfer->file.open(transfer->partialFilePath, std::ios::binary | (partialFileSize > 0 ? (std::ios::out | std::ios::app) : (std::ios::out | std::ios::trunc)));
+        if(!transfer->file.is_open())
+        {
+            Logger::logError("Error, cannot save binary data to \"%s\". Could not open File for writing.", transfer->partialFilePath.c_str());
+            this->onFileTransferDone(relativePath, userId, false);
+            return nullptr;
+        }
+        transfer->receivedBytes = partialFileSize;
+
+        this->incomingFileTransfers[key] = transfer;
+        return transfer;
+    }
+
+    bool DataReceiverShard::shouldRequestResume(const IncomingFileTransfer& transfer) const
+    {
+        if(!transfer.resumeRequested || transfer.lastResumeRequestOffset != transfer.receivedBytes)
+        {
+            return true;
+        }
+        // The chunks after the gap might have been sent before the DataSyncModule received our request,
+        // hence we only ask again if the gap persists for a while.
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Time::now() - transfer.lastResumeRequestTime).count() 
+            >= this->config.resumeRequestRetryMilliseconds;
+    }
+
+    void DataReceiverShard::onFileChunkReceivedFromUser(const DataSyncFileDescriptorList& descriptorList, const std::string& userId)
+    {
+        const UserSyncState& state = this->syncStatePerUser[userId];
+        for(const DataSyncFileDescriptor& chunk : descriptorList.descriptors())
+        {
+            const std::string& relativePath = chunk.relative_file_path();
+            if(state.requestedFiles.find(relativePath) == state.requestedFiles.end())
+            {
+                // Late chunk of a file that was finished already or that belongs to a previous sync.
+                continue;
+            }
+
+            std::shared_ptr<IncomingFileTransfer> transfer = getOrCreateIncomingFileTransfer(chunk, userId);
+            if(transfer == nullptr)
+            {
+                continue;
+            }
+
+            if(chunk.chunk_offset() != transfer->receivedBytes)
+            {
+                // Chunks before this one got lost (e.g., due to a reconnect), ask the DataSyncModule to resume.
+                // Chunks we have received already are ignored.
+                if(chunk.chunk_offset() > transfer->receivedBytes && shouldRequestResume(*transfer))
+                {
+                    transfer->resumeRequested = true;
+                    transfer->lastResumeRequestOffset = transfer->receivedBytes;
+                    transfer->lastResumeRequestTime = Time::now();
+                    this->requestFileFromUser(relativePath, transfer->receivedBytes, userId);
+                }
+                continue;
+            }
+
+            // Chunks are streamed to the partial file as they arrive, the file is never held in memory as a whole.
+            transfer->file.write(chunk.file_data().data(), chunk.file_data().size());
+            if(!transfer->file)
+            {
+                Logger::logError("Error, failed to write binary data to \"%s\".", transfer->partialFilePath.c_str());
+                this->incomingFileTransfers.erase(std::make_pair(userId, relativePath));
+                this->onFileTransferDone(relativePath, userId, false);
+                continue;
+            }
+            transfer->receivedBytes += chunk.file_data().size();
+
+            if(!chunk.is_last_chunk())
+            {
+                DataSyncPackage dataSyncPackage;
+                dataSyncPackage.set_package_type(DataSyncPackageType::CHUNK_ACKNOWLEDGEMENT);
+                DataSyncFileDescriptor* acknowledgement = dataSyncPackage.mutable_file_descriptors()->add_descriptors();
+                acknowledgement->set_relative_file_path(relativePath);
+                acknowledgement->set_chunk_offset(transfer->receivedBytes);
+                this->sendToUser(dataSyncPackage, userId);
+                continue;
+            }
+
+            bool success = this->finishIncomingFileTransfer(*transfer, chunk, userId);
+            this->incomingFileTransfers.erase(std::make_pair(userId, relativePath));
+            this->onFileTransferDone(relativePath, userId, success);
+        }
+    }
+
+    bool DataReceiverShard::finishIncomingFileTransfer(IncomingFileTransfer& transfer, const DataSyncFileDescriptor& lastChunk, const std::string& userId)
+    {
+        transfer.file.close();
+        const std::string& relativePath = lastChunk.relative_file_path();
+        if(transfer.receivedBytes != lastChunk.file_size())
+        {
+            Logger::logError("Error in DataReceiverModule, received %lu bytes of file \"%s\", but expected %lu bytes. Discarding file.", 
+                transfer.receivedBytes, relativePath.c_str(), lastChunk.file_size());
+            FileUtils::removeFileIfExists(transfer.partialFilePath);
+            return false;
+        }
+
+        uint64_t hash;
+        if(lastChunk.hash() != 0 && (!XXHash64::hashFile(transfer.partialFilePath, hash) || hash != lastChunk.hash()))
+        {
+            Logger::logError("Error in DataReceiverModule, hash of received file \"%s\" does not match. Discarding file.", relativePath.c_str());
+            FileUtils::removeFileIfExists(transfer.partialFilePath);
+            return false;
+        }
+
+        // Rename is atomic, hence the file is either visible completely or not at all.
+        // Existing files are replaced, same as for non-chunked transfers.
+        FileUtils::removeFileIfExists(transfer.targetFilePath);
+        if(!FileUtils::renameFile(transfer.partialFilePath, transfer.targetFilePath))
+        {
+            Logger::logError("Error in DataReceiverModule, failed to rename \"%s\" to \"%s\".", transfer.partialFilePath.c_str(), transfer.targetFilePath.c_str());
+            this->syncStatePerUser[userId].receivedFiles.erase(relativePath);
+            return false;
+        }
+
+        this->indexReceivedFile(userId, relativePath, lastChunk.hash());
+
+        this->acknowledgeFile(relativePath, userId);
+        return true;
+    }
+
+    void DataReceiverShard::onFileReceivedFromUser(const DataSyncFileDescriptorList& descriptorList, const std::string& userId)
+    {
+        for(const DataSyncFileDescriptor& fileDescriptor : descriptorList.descriptors())
+        {
+            const std::string& relativePath = fileDescriptor.relative_file_path();
+            std::string targetFilePath = getTargetFilePath(userId, relativePath);
+            if(!createTargetFolder(userId, relativePath) || !saveDataFileToPath(fileDescriptor, targetFilePath))
+            {
+                this->syncStatePerUser[userId].receivedFiles.erase(relativePath);
+                this->onFileTransferDone(relativePath, userId, false);
+                continue;
+            }
+
+            this->indexReceivedFile(userId, relativePath, 0);
+
+            // Send acknowledgement.
+            this->acknowledgeFile(relativePath, userId);
+            this->onFileTransferDone(relativePath, userId, true);
+        }
+    }
+
+    bool DataReceiverShard::saveDataFileToPath(const DataSyncFileDescriptor& dataFile, const std::string& path)
+    {
+        std::fstream file(path, std::ios::out | std::ios::binary);
+        if(!file.is_open())
+        {
+            Logger::logError("Error, cannot save binary data to \"%s\". Could not open File for writing.", path.c_str());
+            return false;
+        }
+
+        file.write(dataFile.file_data().data(), dataFile.file_data().size());
+        return true;
+    }
+
+    DataReceiverShardPool::~DataReceiverShardPool()
+    {
+        this->stop();
+    }
+
+    void DataReceiverShardPool::start(const DataReceiverShard::Config& config, size_t numShards, DataReceiverShard::SendFunction sendToUser)
+    {
+        this->stop();
+        numShards = std::max<size_t>(1, numShards);
+
+        DataReceiverShard::Config shardConfig = config;
+        shardConfig.maxConcurrentFiles = std::max(1, static_cast<int>((config.maxConcurrentFiles + numShards - 1) / numShards));
+        for(size_t i = 0; i < numShards; i++)
+        {
+            this->shards.push_back(std::make_unique<DataReceiverShard>(shardConfig, sendToUser));
+            this->shards.back()->start();
+        }
+    }
+
+    void DataReceiverShardPool::stop()
+    {
+        for(std::unique_ptr<DataReceiverShard>& shard : this->shards)
+        {
+            shard->stop();
+        }
+        this->shards.clear();
+    }
+
+    void DataReceiverShardPool::enqueuePackage(std::shared_ptr<const DataSyncPackage> package, const std::string& userId)
+    {
+        if(this->shards.empty())
+        {
+            return;
+        }
+        // All packages of a user have to be processed by the same shard.
+        size_t shardIndex = std::hash<std::string>()(userId) % this->shards.size();
+        this->shards[shardIndex]->enqueuePackage(package, userId);
+    }
+
+    size_t DataReceiverShardPool::getNumShards() const
+    {
+        return this->shards.size();
+    }
+}
@@ -0,0 +1,213 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include "dispatch/proto/claidservice.pb.h"
+#include "dispatch/core/Utilities/Time.hh"
+#include "absl/status/status.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace claidservice;
+
+namespace claid
+{
+    // Receives the files of a subset of users on its own worker thread.
+    // The DataReceiverModule distributes users over multiple shards (by hashing the user id), so that
+    // packages of different users are processed in parallel, while all packages of one user are processed
+    // by the same thread in the order they arrived. Hence, the state of a user does not require any locking.
+    //
+    // For each user, the received file list is compared with the files available in the storage folder of the user.
+    // All files that are missing are requested from the user's DataSyncModule in chunks, which are written
+    // to a partial file directly as they arrive. Once all chunks have been received, the partial file is renamed.
+    // Multiple files are requested concurrently; free transfer slots are assigned to the users of the shard
+    // in a round-robin fashion, so that a single user with a large backlog cannot monopolize the shard.
+    class DataReceiverShard
+    {
+        public:
+            struct Config
+            {
+                std::string storagePath;
+                // Maximum number of files requested concurrently from a single user.
+                int maxConcurrentFilesPerUser = 4;
+                // Maximum number of files requested concurrently from all users of the shard.
+                int maxConcurrentFiles = 256;
+                // Order in which missing files of a user are requested: "fifo", "newest_first" or "oldest_first".
+                std::string filePriority = "fifo";
+                // Files matching an earlier prefix are requested before files matching a later or no prefix.
+                std::vector<std::string> priorityPathPrefixes;
+                // Requested files of a user are released if we did not receive anything from the user for this long.
+                int transferTimeoutSeconds = 120;
+                // A resume request is repeated if chunks after a gap still arrive this long after the request
+                // (e.g., because the request or the resumed chunks got lost).
+                int resumeRequestRetryMilliseconds = 5000;
+            };
+
+            // Sends a package (file requests and acknowledgements) to the DataSyncModule of the given user.
+            // Called from the worker thread of the shard.
+            typedef std::function<void(const DataSyncPackage&, const std::string&)> SendFunction;
+
+            static constexpr const char* PARTIAL_FILE_SUFFIX = ".claid_part";
+
+        private:
+            Config config;
+            SendFunction sendToUser;
+
+            // Files that are available in the storage folder of a user.
+            // Hashes of files are kept as long as size and modification time of the file do not change,
+            // so files do not need to be hashed again for each file list.
+            struct ReceivedFile
+            {
+                uint64_t fileSize = 0;
+                uint64_t modificationTime = 0;
+                uint64_t hash = 0;
+                // Hashes are calculated lazily, the first time a file list provides a hash for the file.
+                bool hashValid = false;
+            };
+
+            struct UserSyncState
+            {
+                // Indicates which files of the user we are missing.
+                std::queue<std::string> missingFiles;
+                // Files that were requested but not received completely yet.
+                std::set<std::string> requestedFiles;
+                // Latest version of the user's manifest we have processed completely.
+                uint64_t acknowledgedManifestVersion = 0;
+                // Version of the file list we are currently requesting files for.
+                uint64_t pendingManifestVersion = 0;
+                bool transferFailed = false;
+                // Whether the user is contained in usersWaitingForTransferSlot.
+                bool waitingForTransferSlot = false;
+                Time lastActivity;
+
+                // Key is the path relative to the storage folder of the user.
+                std::map<std::string, ReceivedFile> receivedFiles;
+            };
+
+            // State of a file that is currently being received in chunks.
+            struct IncomingFileTransfer
+            {
+                std::string targetFilePath;
+                std::string partialFilePath;
+                std::ofstream file;
+                // Number of bytes received (and written to the partial file) contiguously.
+                uint64_t receivedBytes = 0;
+                // Offset and time we last asked the DataSyncModule to resume from, to avoid re-requesting on every out-of-order chunk.
+                bool resumeRequested = false;
+                uint64_t lastResumeRequestOffset = 0;
+                Time lastResumeRequestTime;
+            };
+
+            std::map<std::string, UserSyncState> syncStatePerUser;
+
+            // Key is user id and relative file path.
+            std::map<std::pair<std::string, std::string>, std::shared_ptr<IncomingFileTransfer>> incomingFileTransfers;
+
+            // Users that have missing files which were not requested yet, in round-robin order.
+            std::deque<std::string> usersWaitingForTransferSlot;
+            // Sum of requestedFiles of all users.
+            uint64_t numFilesInFlight = 0;
+
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable conditionVariable;
+            std::deque<std::pair<std::shared_ptr<const DataSyncPackage>, std::string>> packageQueue;
+            bool running = false;
+
+            void run();
+
+            std::string getUserStoragePath(const std::string& userId) const;
+            std::string getTargetFilePath(const std::string& userId, const std::string& relativePath) const;
+            bool createTargetFolder(const std::string& userId, const std::string& relativePath);
+
+            ReceivedFile* lookupReceivedFile(const std::string& userId, const std::string& relativePath);
+            void indexReceivedFile(const std::string& userId, const std::string& relativePath, uint64_t hash);
+            void getMissingFilesOfUser(const std::string& userId, const DataSyncFileDescriptorList& descriptorList, 
+                std::vector<const DataSyncFileDescriptor*>& missingList);
+            void prioritizeMissingFiles(std::vector<const DataSyncFileDescriptor*>& missingFiles) const;
+
+            void onCompleteFileListReceivedFromUser(const DataSyncPackage& pkg, const std::string& userId);
+            void enqueueUserForTransferSlot(const std::string& userId);
+            void assignTransferSlots();
+            void requestNextFileFromUser(const std::string& userId);
+            void requestFileFromUser(const std::string& relativePath, uint64_t offset, const std::string& userId);
+            void onFileTransferDone(const std::string& relativePath, const std::string& userId, bool success);
+            void releaseRequestedFilesOfUser(const std::string& userId);
+
+            void acknowledgeManifestIfComplete(const std::string& userId);
+            void acknowledgeManifestVersion(uint64_t version, const std::string& userId);
+            void acknowledgeFile(const std::string& relativePath, const std::string& userId);
+
+            std::shared_ptr<IncomingFileTransfer> getOrCreateIncomingFileTransfer(const DataSyncFileDescriptor& chunk, const std::string& userId);
+            bool shouldRequestResume(const IncomingFileTransfer& transfer) const;
+            void onFileChunkReceivedFromUser(const DataSyncFileDescriptorList& descriptorList, const std::string& userId);
+            bool finishIncomingFileTransfer(IncomingFileTransfer& transfer, const DataSyncFileDescriptor& lastChunk, const std::string& userId);
+            void onFileReceivedFromUser(const DataSyncFileDescriptorList& descriptorList, const std::string& userId);
+            bool saveDataFileToPath(const DataSyncFileDescriptor& dataFile, const std::string& path);
+
+        public:
+            DataReceiverShard(const Config& config, SendFunction sendToUser);
+            ~DataReceiverShard();
+
+            void start();
+            void stop();
+
+            // Thread-safe, the package is processed on the worker thread of the shard.
+            void enqueuePackage(std::shared_ptr<const DataSyncPackage> package, const std::string& userId);
+
+            // Processes the package on the calling thread. Only use if the shard was not started.
+            void processPackage(const DataSyncPackage& pkg, const std::string& userId);
+
+            // Users might disconnect in the middle of a transfer. To not block transfer slots of other users forever,
+            // we release the slots of users we did not hear from for transferTimeoutSeconds.
+            // The manifest version is not acknowledged, hence the files will be requested again during the next sync.
+            void releaseStalledTransfers();
+    };
+
+    // Distributes the users over a fixed number of DataReceiverShards.
+    class DataReceiverShardPool
+    {
+        private:
+            std::vector<std::unique_ptr<DataReceiverShard>> shards;
+
+        public:
+            ~DataReceiverShardPool();
+
+            // The maxConcurrentFiles of the config is split among the shards.
+            void start(const DataReceiverShard::Config& config, size_t numShards, DataReceiverShard::SendFunction sendToUser);
+            void stop();
+
+            void enqueuePackage(std::shared_ptr<const DataSyncPackage> package, const std::string& userId);
+            size_t getNumShards() const;
+    };
+}
@@ -0,0 +1,407 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/DataCollection/DataSyncer/DataSyncManifest.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+#include "dispatch/core/Utilities/StringUtils.hh"
+#include "dispatch/core/Utilities/XXHash64.hh"
+#include "dispatch/core/Utilities/Path.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+
+#include <fstream>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+namespace claid
+{
+    const std::string DataSyncManifest::INTERNAL_FILE_PREFIX = ".claid_";
+    const std::string DataSyncManifest::MANIFEST_FILE_NAME = ".claid_data_sync_manifest";
+
+    DataSyncManifest::DataSyncManifest()
+    {
+
+    }
+
+    DataSyncManifest::~DataSyncManifest()
+    {
+#if defined(__linux__)
+        if(this->inotifyFd >= 0)
+        {
+            close(this->inotifyFd);
+        }
+#endif
+    }
+
+    absl::Status DataSyncManifest::initialize(const std::string& directoryPath)
+    {
+        this->directoryPath = directoryPath;
+        if(this->directoryPath.size() > 0 && this->directoryPath[this->directoryPath.size() - 1] == '/')
+        {
+            this->directoryPath.pop_back();
+        }
+        this->manifestPath = this->directoryPath + "/" + MANIFEST_FILE_NAME;
+
+#if defined(__linux__)
+        this->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(this->inotifyFd < 0)
+        {
+            Logger::logWarning("DataSyncManifest: inotify not available (errno %d), falling back to scanning \"%s\" on each update.", 
+                errno, this->directoryPath.c_str());
+        }
+#endif
+
+        absl::Status status = this->load();
+        if(absl::IsNotFound(status))
+        {
+            return absl::OkStatus();
+        }
+        if(absl::IsDataLoss(status))
+        {
+            // Starting from scratch makes the next update hash all files again and report them as changed.
+            Logger::logWarning("%s Discarding it and rescanning \"%s\".", std::string(status.message()).c_str(), this->directoryPath.c_str());
+            this->entries.clear();
+            this->version = 0;
+            this->acknowledgedVersion = 0;
+            return absl::OkStatus();
+        }
+        return status;
+    }
+
+    bool DataSyncManifest::isInternalFile(const std::string& path)
+    {
+        return StringUtils::startsWith(Path(path).getFileNameFromPath(), INTERNAL_FILE_PREFIX);
+    }
+
+    void DataSyncManifest::makePathRelative(std::string& path) const
+    {
+        std::string basePath = this->directoryPath + '/';
+        if(StringUtils::startsWith(path, basePath))
+        {
+            path = path.substr(basePath.size(), path.size());   
+        }
+    }
+
+    // The manifest file starts with a line "<version>\t<acknowledged version>",
+    // followed by one line "<relative path>\t<size>\t<modification time>\t<hash>\t<version>" per file.
+    absl::Status DataSyncManifest::load()
+    {
+        this->entries.clear();
+        if(!FileUtils::fileExists(this->manifestPath))
+        {
+            return absl::NotFoundError(absl::StrCat("DataSyncManifest \"", this->manifestPath, "\" does not exist."));
+        }
+
+        std::ifstream file(this->manifestPath);
+        if(!file.is_open())
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to open DataSyncManifest \"", this->manifestPath, "\" for reading."));
+        }
+
+        std::string line;
+        if(std::getline(file, line))
+        {
+            std::vector<absl::string_view> values = absl::StrSplit(line, '\t');
+            if(values.size() != 2 || !absl::SimpleAtoi(values[0], &this->version) || !absl::SimpleAtoi(values[1], &this->acknowledgedVersion))
+            {
+                return absl::DataLossError(absl::StrCat("DataSyncManifest \"", this->manifestPath, "\" has an invalid header."));
+            }
+        }
+
+        while(std::getline(file, line))
+        {
+            std::vector<absl::string_view> values = absl::StrSplit(line, '\t');
+            Entry entry;
+            if(values.size() != 5 || !absl::SimpleAtoi(values[1], &entry.fileSize) || !absl::SimpleAtoi(values[2], &entry.modificationTime) ||
+                !absl::SimpleAtoi(values[3], &entry.hash) || !absl::SimpleAtoi(values[4], &entry.version))
+            {
+                this->entries.clear();
+                return absl::DataLossError(absl::StrCat("DataSyncManifest \"", this->manifestPath, "\" contains an invalid line \"", line, "\"."));
+            }
+            this->entries[std::string(values[0])] = entry;
+        }
+        return absl::OkStatus();
+    }
+
+    // Written to a temporary file first and then renamed, so the manifest always is in a consistent state.
+    absl::Status DataSyncManifest::store()
+    {
+        const std::string tmpManifestPath = this->manifestPath + ".tmp";
+        {
+            std::ofstream file(tmpManifestPath, std::ios::out | std::ios::trunc);
+            if(!file.is_open())
+            {
+                return absl::UnavailableError(absl::StrCat("Failed to open DataSyncManifest \"", tmpManifestPath, "\" for writing."));
+            }
+
+            file << this->version << "\t" << this->acknowledgedVersion << "\n";
+            for(const auto& entry : this->entries)
+            {
+                file << entry.first << "\t" << entry.second.fileSize << "\t" << entry.second.modificationTime 
+                    << "\t" << entry.second.hash << "\t" << entry.second.version << "\n";
+            }
+        }
+
+        if(!FileUtils::renameFile(tmpManifestPath, this->manifestPath))
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to commit DataSyncManifest \"", this->manifestPath, "\"."));
+        }
+        return absl::OkStatus();
+    }
+
+    void DataSyncManifest::watchDirectory(const std::string& path)
+    {
+#if defined(__linux__)
+        if(this->inotifyFd < 0 || this->watchedDirectories.find(path) != this->watchedDirectories.end())
+        {
+            return;
+        }
+
+        const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF;
+        int watchDescriptor = inotify_add_watch(this->inotifyFd, path.c_str(), mask);
+        if(watchDescriptor < 0)
+        {
+            Logger::logWarning("DataSyncManifest: Failed to watch directory \"%s\" (errno %d), falling back to scanning on each update.", path.c_str(), errno);
+            close(this->inotifyFd);
+            this->inotifyFd = -1;
+            return;
+        }
+        this->watchedDirectories.insert(path);
+        this->watchDescriptors[watchDescriptor] = path;
+#endif
+    }
+
+    // inotify is not recursive, hence every sub directory has to be watched separately.
+    void DataSyncManifest::watchDirectoryRecursively(const std::string& path)
+    {
+#if defined(__linux__)
+        this->watchDirectory(path);
+        if(this->inotifyFd < 0)
+        {
+            return;
+        }
+
+        std::vector<std::string> subDirectories;
+        FileUtils::getAllDirectoriesInDirectory(path, subDirectories);
+        for(const std::string& subDirectory : subDirectories)
+        {
+            // On Linux, only the names of the sub directories are returned.
+            this->watchDirectoryRecursively(path + "/" + subDirectory);
+        }
+#endif
+    }
+
+    // Drains all pending inotify events. Returns true if any file (except our internal files) changed,
+    // or if we cannot tell (no inotify, queue overflow).
+    bool DataSyncManifest::hasDirectoryChanged()
+    {
+#if defined(__linux__)
+        if(this->inotifyFd < 0 || !this->scannedSinceStartup)
+        {
+            return true;
+        }
+
+        bool changed = false;
+        alignas(struct inotify_event) char buffer[4096];
+        while(true)
+        {
+            ssize_t numBytes = read(this->inotifyFd, buffer, sizeof(buffer));
+            if(numBytes <= 0)
+            {
+                break;
+            }
+
+            for(char* ptr = buffer; ptr < buffer + numBytes; )
+            {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                ptr += sizeof(struct inotify_event) + event->len;
+
+                if(event->mask & IN_Q_OVERFLOW)
+                {
+                    changed = true;
+                    continue;
+                }
+                if(event->mask & IN_IGNORED)
+                {
+                    // Directory was removed, it has to be watched again if it gets recreated.
+                    auto it = this->watchDescriptors.find(event->wd);
+                    if(it != this->watchDescriptors.end())
+                    {
+                        this->watchedDirectories.erase(it->second);
+                        this->watchDescriptors.erase(it);
+                    }
+                    changed = true;
+                    continue;
+                }
+                if(event->len > 0 && isInternalFile(event->name))
+                {
+                    continue;
+                }
+                changed = true;
+            }
+        }
+        return changed;
+#else
+        return true;
+#endif
+    }
+
+    absl::Status DataSyncManifest::update()
+    {
+        if(!this->hasDirectoryChanged())
+        {
+            return absl::OkStatus();
+        }
+
+        // Watch before scanning, so that changes which happen during the scan are not missed.
+        this->watchDirectoryRecursively(this->directoryPath);
+
+        std::vector<std::string> fileList;
+        if(!FileUtils::getAllFilesInDirectoryRecursively(this->directoryPath, fileList))
+        {
+            return absl::UnavailableError(absl::StrCat("Unable scan directory \"", this->directoryPath, "\" for files."));
+        }
+        this->scannedSinceStartup = true;
+
+        const uint64_t newVersion = this->version + 1;
+        bool changed = false;
+        std::set<std::string> existingFiles;
+
+        for(std::string& path : fileList)
+        {
+            if(isInternalFile(path))
+            {
+                continue;
+            }
+
+            uint64_t fileSize;
+            uint64_t modificationTime;
+            if(!FileUtils::getFileSizeAndModificationTime(path, fileSize, modificationTime))
+            {
+                Logger::logError("DataSyncManifest: Failed to get size of file \"%s\"", path.c_str());
+                continue;
+            }
+
+            std::string relativePath = path;
+            makePathRelative(relativePath);
+            existingFiles.insert(relativePath);
+
+            auto it = this->entries.find(relativePath);
+            if(it != this->entries.end() && it->second.fileSize == fileSize && it->second.modificationTime == modificationTime)
+            {
+                continue;
+            }
+
+            Entry entry;
+            entry.fileSize = fileSize;
+            entry.modificationTime = modificationTime;
+            entry.version = newVersion;
+            if(!XXHash64::hashFile(path, entry.hash))
+            {
+                Logger::logError("DataSyncManifest: Failed to hash file \"%s\"", path.c_str());
+                continue;
+            }
+            this->entries[relativePath] = entry;
+            changed = true;
+        }
+
+        auto it = this->entries.begin();
+        while(it != this->entries.end())
+        {
+            if(existingFiles.find(it->first) == existingFiles.end())
+            {
+                it = this->entries.erase(it);
+                changed = true;
+                continue;
+            }
+            it++;
+        }
+
+        if(!changed)
+        {
+            return absl::OkStatus();
+        }
+
+        this->version = newVersion;
+        return this->store();
+    }
+
+    void DataSyncManifest::getChangesSince(uint64_t version, claidservice::DataSyncFileDescriptorList& descriptorList) const
+    {
+        for(const auto& entry : this->entries)
+        {
+            if(entry.second.version <= version)
+            {
+                continue;
+            }
+
+            claidservice::DataSyncFileDescriptor* descriptor = descriptorList.add_descriptors();
+            descriptor->set_relative_file_path(entry.first);
+            descriptor->set_file_size(entry.second.fileSize);
+            descriptor->set_hash(entry.second.hash);
+            descriptor->set_modification_time(entry.second.modificationTime);
+        }
+    }
+
+    bool DataSyncManifest::getEntry(const std::string& relativePath, Entry& entry) const
+    {
+        auto it = this->entries.find(relativePath);
+        if(it == this->entries.end())
+        {
+            return false;
+        }
+        entry = it->second;
+        return true;
+    }
+
+    void DataSyncManifest::removeEntry(const std::string& relativePath)
+    {
+        this->entries.erase(relativePath);
+    }
+
+    void DataSyncManifest::setAcknowledgedVersion(uint64_t version)
+    {
+        this->acknowledgedVersion = std::min(version, this->version);
+    }
+
+    uint64_t DataSyncManifest::getAcknowledgedVersion() const
+    {
+        return this->acknowledgedVersion;
+    }
+
+    uint64_t DataSyncManifest::getVersion() const
+    {
+        return this->version;
+    }
+
+    size_t DataSyncManifest::size() const
+    {
+        return this->entries.size();
+    }
+}
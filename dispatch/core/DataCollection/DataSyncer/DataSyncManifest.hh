@@ -0,0 +1,104 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include "dispatch/proto/claidservice.pb.h"
+#include "absl/status/status.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace claid
+{
+    // Persistent list of the files available in the directory synchronized by the DataSyncModule.
+    // For each file, the manifest stores size, modification time and an xxHash of the content.
+    // Files are only hashed again if their size or modification time changed.
+    // Each change increments the version of the manifest and is tagged with that version, which allows
+    // to only send the changes since the last version the DataReceiverModule acknowledged.
+    // On Linux (and Android), inotify is used to detect whether the directory changed at all,
+    // in which case scanning the directory can be skipped entirely.
+    class DataSyncManifest
+    {
+        public:
+            struct Entry
+            {
+                uint64_t fileSize = 0;
+                uint64_t modificationTime = 0;
+                uint64_t hash = 0;
+                // Version of the manifest in which the file was added or changed.
+                uint64_t version = 0;
+            };
+
+            // Files starting with this prefix (e.g., the manifest itself) are not synchronized.
+            static const std::string INTERNAL_FILE_PREFIX;
+            static const std::string MANIFEST_FILE_NAME;
+
+        private:
+            std::string directoryPath;
+            std::string manifestPath;
+
+            // Key is the path of the file relative to directoryPath.
+            std::map<std::string, Entry> entries;
+            uint64_t version = 0;
+            uint64_t acknowledgedVersion = 0;
+            bool scannedSinceStartup = false;
+
+            int inotifyFd = -1;
+            std::set<std::string> watchedDirectories;
+            std::map<int, std::string> watchDescriptors;
+
+            void makePathRelative(std::string& path) const;
+            absl::Status load();
+
+            void watchDirectory(const std::string& path);
+            void watchDirectoryRecursively(const std::string& path);
+            bool hasDirectoryChanged();
+
+        public:
+            DataSyncManifest();
+            ~DataSyncManifest();
+
+            DataSyncManifest(const DataSyncManifest&) = delete;
+            DataSyncManifest& operator=(const DataSyncManifest&) = delete;
+
+            // Loads the manifest stored in the directory. A missing or corrupt manifest is replaced by a full scan during the next update.
+            absl::Status initialize(const std::string& directoryPath);
+
+            // Scans the directory for new, changed and removed files, if it changed since the last update.
+            absl::Status update();
+            absl::Status store();
+
+            // Adds all files that were added or changed after the given version of the manifest.
+            void getChangesSince(uint64_t version, claidservice::DataSyncFileDescriptorList& descriptorList) const;
+
+            bool getEntry(const std::string& relativePath, Entry& entry) const;
+            void removeEntry(const std::string& relativePath);
+
+            void setAcknowledgedVersion(uint64_t version);
+            uint64_t getAcknowledgedVersion() const;
+            uint64_t getVersion() const;
+            size_t size() const;
+
+            static bool isInternalFile(const std::string& path);
+    };
+}
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "dispatch/core/Module/Module.hh"
+#include "dispatch/core/DataCollection/DataSyncer/DataSyncManifest.hh"
 #include "dispatch/core/Utilities/FileUtils.hh"
 #include "dispatch/core/Utilities/StringUtils.hh"
 #include "dispatch/proto/sensor_data_types.pb.h"
@@ -37,6 +38,7 @@
 
 #include "absl/strings/str_split.h"
 #include "absl/status/status.h"
+#include <map>
 
 using namespace claidservice;
 
@@ -44,14 +46,18 @@ namespace claid
 {
     // Syncs files contained in a certain directory with a DataReceiverModule.
     // This works in multiple steps:
-    // 1st The DataSyncModule scans the specified directory and builds a list of available files.
-    // 2nd This list is posted to a channel that the DataReceiverModule listens on.
+    // 1st The DataSyncModule updates its manifest of the files available in the specified directory.
+    // 2nd The files that changed since the last manifest version acknowledged by the DataReceiverModule
+    // are posted to a channel that the DataReceiverModule listens on.
     // 3rd The DataReceiverModule build a list of available files in the target directory aswell and compares
     // it with the list received from the DataSyncModule.
     // 4th The DataReceiverModule sends back a list of the files that are missing on it's side; this list is a subset
     // of the original list containing all files sent by the DataSyncModule.
     // 5th The DataSyncModule posts each file (in binary format) to the dataChannel, along with the target path.
+    // If the DataReceiverModule requested a chunked transfer, the file is sent in chunks of chunkSizeBytes,
+    // with at most maxChunksInFlight chunks that have not been acknowledged by the DataReceiverModule yet.
     // 6th The DataReceiverModule saves each file.
+    // 7th Once all missing files have been received, the DataReceiverModule acknowledges the manifest version.
     class DataSyncModule : public Module
     {
         public:
@@ -77,11 +83,36 @@ namespace claid
 
             std::string filePath;
 
+            DataSyncManifest manifest;
+            // Base version of the last file list we sent.
+            uint64_t lastSentBaseManifestVersion = 0;
+
             Time lastMessageFromFileReceiver;
         
             // Constants
             static constexpr int SYNC_TIMEOUT_IN_MS = 3000;
 
+            // State of a file that is currently being sent in chunks.
+            struct OutgoingFileTransfer
+            {
+                std::string relativeFilePath;
+                std::string userId;
+                std::ifstream file;
+                uint64_t fileSize = 0;
+                uint64_t hash = 0;
+                // Offset of the next chunk to send.
+                uint64_t nextOffset = 0;
+                // Number of bytes the DataReceiverModule has acknowledged.
+                uint64_t acknowledgedOffset = 0;
+                bool lastChunkSent = false;
+            };
+
+            // Key is user id and relative file path.
+            std::map<std::pair<std::string, std::string>, std::shared_ptr<OutgoingFileTransfer>> outgoingFileTransfers;
+
+            int chunkSizeBytes = 256 * 1024;
+            int maxChunksInFlight = 8;
+
          
             bool deleteFileAfterSync;
             bool onlyWhenCharging = false;
@@ -93,62 +124,52 @@ namespace claid
             Schedule syncingSchedule;
             std::vector<std::string> syncFunctionSchedulingNames;
             
-            void makePathRelative(std::string& path)
+            // Only files that were added or changed since the last version of the manifest which was
+            // acknowledged by the DataReceiverModule are added to the list.
+            absl::Status buildFileList(DataSyncPackage& dataSyncPackage)
             {
-                std::string basePath = this->filePath;
-                if(this->filePath[this->filePath.size() - 1] != '/')
-                {
-                    basePath += '/';
-                }
+                DataSyncFileDescriptorList* descriptorList = dataSyncPackage.mutable_file_descriptors();
+                descriptorList->clear_descriptors();
 
-                if(StringUtils::startsWith(path, basePath))
+                moduleInfo(absl::StrCat("Updating manifest of directory \"", this->filePath, "\"."));
+                absl::Status status = this->manifest.update();
+                if(!status.ok())
                 {
-                    path = path.substr(basePath.size(), path.size());   
+                    return status;
                 }
+
+                uint64_t baseVersion = this->manifest.getAcknowledgedVersion();
+                this->manifest.getChangesSince(baseVersion, *descriptorList);
+                // The actual data files will be sent once the DataReceiverModule tells us which files it wants.
+                dataSyncPackage.set_manifest_version(this->manifest.getVersion());
+                dataSyncPackage.set_base_manifest_version(baseVersion);
+                this->lastSentBaseManifestVersion = baseVersion;
+                return absl::OkStatus();
             }
 
-            void buildFileList(DataSyncFileDescriptorList& descriptorList)
+            void sendFileList()
             {
-                descriptorList.clear_descriptors();
+                DataSyncPackage dataSyncPackage;
+                dataSyncPackage.set_package_type(DataSyncPackageType::ALL_AVAILABLE_FILES_LIST);
+
+                // A new sync round starts, transfers that did not finish during the last round will be
+                // requested again by the DataReceiverModule (resuming from the data it already received).
+                this->outgoingFileTransfers.clear();
 
-                std::vector<std::string> fileList;
-                if(!FileUtils::getAllFilesInDirectoryRecursively(this->filePath, fileList))
+                absl::Status status = this->buildFileList(dataSyncPackage);
+                if(!status.ok())
                 {
-                    moduleWarning(absl::StrCat("Unable scan directory \"", this->filePath, "\" for files."));
+                    moduleWarning(status);
                     return;
                 }
-
-                moduleInfo(absl::StrCat("Scanning directory \"", this->filePath, "\" for files."));
-
-                for(std::string& path : fileList)
+                if(dataSyncPackage.base_manifest_version() != 0 && dataSyncPackage.base_manifest_version() == dataSyncPackage.manifest_version())
                 {
-                    uint64_t fileSize;
-                    if(!FileUtils::getFileSize(path, fileSize))
-                    {
-                        moduleError(absl::StrCat("Failed to get size of file \"", path, "\""));
-                        return;
-                    }
-
-                    makePathRelative(path);
-                    DataSyncFileDescriptor* descriptor = descriptorList.add_descriptors();
-                    descriptor->set_hash(0); // For now, we do not use any hashing.
-                    descriptor->set_file_size(fileSize);
-                    descriptor->set_relative_file_path(path);
-                    // No data for now, as we are only sending a list of files.
-                    // The actual data files will be sent once the DataReceiverModule tells us which files it wants.
+                    moduleInfo("No files changed since last sync, nothing to send.");
+                    return;
                 }
-
-            }
-
-            void sendFileList()
-            {
-                DataSyncPackage dataSyncPackage;
-                dataSyncPackage.set_package_type(DataSyncPackageType::ALL_AVAILABLE_FILES_LIST);
-
-                DataSyncFileDescriptorList* descriptors = dataSyncPackage.mutable_file_descriptors();
-                this->buildFileList(*descriptors);
                 this->toReceiverModuleChannel.post(dataSyncPackage);
-                moduleInfo(absl::StrCat("Sending file list containing ", descriptors->descriptors_size(), " files"));
+                moduleInfo(absl::StrCat("Sending file list containing ", dataSyncPackage.file_descriptors().descriptors_size(), 
+                    " files (manifest version ", dataSyncPackage.manifest_version(), ", changes since version ", dataSyncPackage.base_manifest_version(), ")"));
             }
 
             void sendRequestedFile(const DataSyncFileDescriptor& descriptor, const std::string& userId)
@@ -156,6 +177,12 @@ namespace claid
                 const std::string& relativeFilePath = descriptor.relative_file_path();
                 printf("Requested file %s\n", relativeFilePath.c_str());
 
+                if(descriptor.chunked_transfer())
+                {
+                    beginChunkedFileTransfer(descriptor, userId);
+                    return;
+                }
+
                 DataSyncFileDescriptor fileToSend;
                 uint64_t fileSize;
                 std::string path = this->filePath + std::string("/") + relativeFilePath;
@@ -175,7 +202,7 @@ namespace claid
                 }
                 
                 fileToSend.set_relative_file_path(relativeFilePath);
-                fileToSend.set_hash(0); // Currently not using any hash.
+                fileToSend.set_hash(this->getHashOfFile(relativeFilePath));
                 // file size was already set in loadDataFileFromPath.
 
                 DataSyncPackage dataSyncPackage;
@@ -186,6 +213,111 @@ namespace claid
                 this->toReceiverModuleChannel.postToUser(dataSyncPackage, userId);
             }
 
+            // Returns 0 if the hash of the file is unknown, in which case the DataReceiverModule skips hash verification.
+            uint64_t getHashOfFile(const std::string& relativeFilePath)
+            {
+                DataSyncManifest::Entry entry;
+                if(!this->manifest.getEntry(relativeFilePath, entry))
+                {
+                    return 0;
+                }
+                return entry.hash;
+            }
+
+            void beginChunkedFileTransfer(const DataSyncFileDescriptor& descriptor, const std::string& userId)
+            {
+                const std::string& relativeFilePath = descriptor.relative_file_path();
+                std::string path = this->filePath + std::string("/") + relativeFilePath;
+
+                std::shared_ptr<OutgoingFileTransfer> transfer = std::make_shared<OutgoingFileTransfer>();
+                transfer->relativeFilePath = relativeFilePath;
+                transfer->userId = userId;
+                transfer->hash = this->getHashOfFile(relativeFilePath);
+
+                if(!FileUtils::getFileSize(path, transfer->fileSize))
+                {
+                    moduleError(absl::StrCat("Failed to get size of file \"", path, "\", cannot send requested file."));
+                    return;
+                }
+
+                transfer->file.open(path, std::ios::in | std::ios::binary);
+                if(!transfer->file.is_open())
+                {
+                    moduleError(absl::StrCat("Failed to load binary data from \"", path, "\".\n",
+                        "Could not open File for reading."));
+                    return;
+                }
+
+                // The DataReceiverModule might already have received parts of the file during a previous sync,
+                // in which case we resume from there.
+                transfer->nextOffset = std::min<uint64_t>(descriptor.chunk_offset(), transfer->fileSize);
+                transfer->acknowledgedOffset = transfer->nextOffset;
+
+                this->outgoingFileTransfers[std::make_pair(userId, relativeFilePath)] = transfer;
+                this->sendNextChunks(*transfer);
+            }
+
+            // Sends chunks until maxChunksInFlight chunks are waiting for acknowledgement.
+            // Only one chunk of the file is held in memory at a time.
+            void sendNextChunks(OutgoingFileTransfer& transfer)
+            {
+                const uint64_t chunkSize = static_cast<uint64_t>(std::max(1, this->chunkSizeBytes));
+                const uint64_t window = chunkSize * static_cast<uint64_t>(std::max(1, this->maxChunksInFlight));
+
+                while(!transfer.lastChunkSent && transfer.nextOffset - transfer.acknowledgedOffset < window)
+                {
+                    uint64_t numBytes = std::min(chunkSize, transfer.fileSize - transfer.nextOffset);
+
+                    DataSyncPackage dataSyncPackage;
+                    dataSyncPackage.set_package_type(DataSyncPackageType::FILE_CHUNK);
+
+                    DataSyncFileDescriptor* chunk = dataSyncPackage.mutable_file_descriptors()->add_descriptors();
+                    chunk->set_relative_file_path(transfer.relativeFilePath);
+                    chunk->set_file_size(transfer.fileSize);
+                    chunk->set_chunk_offset(transfer.nextOffset);
+                    chunk->set_hash(transfer.hash);
+
+                    std::string* chunkData = chunk->mutable_file_data();
+                    chunkData->resize(numBytes);
+                    transfer.file.seekg(transfer.nextOffset, std::ios::beg);
+                    if(!transfer.file.read(&(*chunkData)[0], numBytes))
+                    {
+                        moduleError(absl::StrCat("Failed to read binary data from file \"", transfer.relativeFilePath, "\"."));
+                        this->outgoingFileTransfers.erase(std::make_pair(transfer.userId, transfer.relativeFilePath));
+                        return;
+                    }
+
+                    transfer.nextOffset += numBytes;
+                    transfer.lastChunkSent = transfer.nextOffset >= transfer.fileSize;
+                    chunk->set_is_last_chunk(transfer.lastChunkSent);
+
+                    this->toReceiverModuleChannel.postToUser(dataSyncPackage, transfer.userId);
+                }
+            }
+
+            void onChunksAcknowledged(const DataSyncFileDescriptorList& acknowledgedChunks, const std::string& userId)
+            {
+                this->lastMessageFromFileReceiver = Time::now();
+                for(const DataSyncFileDescriptor& descriptor : acknowledgedChunks.descriptors())
+                {
+                    auto it = this->outgoingFileTransfers.find(std::make_pair(userId, descriptor.relative_file_path()));
+                    if(it == this->outgoingFileTransfers.end())
+                    {
+                        continue;
+                    }
+
+                    std::shared_ptr<OutgoingFileTransfer> transfer = it->second;
+                    transfer->acknowledgedOffset = std::max<uint64_t>(transfer->acknowledgedOffset, descriptor.chunk_offset());
+
+                    if(transfer->lastChunkSent && transfer->acknowledgedOffset >= transfer->fileSize)
+                    {
+                        this->outgoingFileTransfers.erase(it);
+                        continue;
+                    }
+                    this->sendNextChunks(*transfer);
+                }
+            }
+
             void onPackageFromDataReceiver(ChannelData<DataSyncPackage> data)
             {
                 const DataSyncPackage& pkg = data.getData();
@@ -193,9 +325,17 @@ namespace claid
                 {
                     this->onFileRequested(pkg.file_descriptors(), data.getUserId());
                 }
+                else if(pkg.package_type() == DataSyncPackageType::CHUNK_ACKNOWLEDGEMENT)
+                {
+                    this->onChunksAcknowledged(pkg.file_descriptors(), data.getUserId());
+                }
                 else if(pkg.package_type() == DataSyncPackageType::ACKNOWLEDGED_FILES)
                 {
-                    this->onFileReceivalAcknowledged(pkg.file_descriptors());
+                    this->onFileReceivalAcknowledged(pkg.file_descriptors(), data.getUserId());
+                }
+                else if(pkg.package_type() == DataSyncPackageType::MANIFEST_ACKNOWLEDGEMENT)
+                {
+                    this->onManifestAcknowledged(pkg.manifest_version());
                 }
             }
 
@@ -211,11 +351,12 @@ namespace claid
                 
             }
 
-            void onFileReceivalAcknowledged(const DataSyncFileDescriptorList& acknowledgedFiles)
+            void onFileReceivalAcknowledged(const DataSyncFileDescriptorList& acknowledgedFiles, const std::string& userId)
             {
                 this->lastMessageFromFileReceiver = Time::now();
                 for(const DataSyncFileDescriptor& fileDescriptor : acknowledgedFiles.descriptors())
                 {
+                    this->outgoingFileTransfers.erase(std::make_pair(userId, fileDescriptor.relative_file_path()));
                     if(this->deleteFileAfterSync)
                     {
                         const std::string& relativePath = fileDescriptor.relative_file_path().c_str();
@@ -223,9 +364,39 @@ namespace claid
                         std::string path = this->filePath + std::string("/") + relativePath;
                         Logger::logInfo("Deleting %s", path.c_str());
                         FileUtils::removeFileIfExists(path);
+                        this->manifest.removeEntry(relativePath);
                     }
                 }
                 
+                if(this->deleteFileAfterSync)
+                {
+                    absl::Status status = this->manifest.store();
+                    if(!status.ok())
+                    {
+                        moduleWarning(status);
+                    }
+                }
+            }
+
+            void onManifestAcknowledged(uint64_t version)
+            {
+                this->lastMessageFromFileReceiver = Time::now();
+                if(version < this->lastSentBaseManifestVersion)
+                {
+                    // The DataReceiverModule does not know the version our last file list was based on
+                    // (e.g., because it was restarted), hence we have to send all changes since the version it knows.
+                    moduleInfo(absl::StrCat("DataReceiverModule only knows manifest version ", version, ", resending file list."));
+                    this->manifest.setAcknowledgedVersion(version);
+                    this->sendFileList();
+                    return;
+                }
+
+                this->manifest.setAcknowledgedVersion(std::max(version, this->manifest.getAcknowledgedVersion()));
+                absl::Status status = this->manifest.store();
+                if(!status.ok())
+                {
+                    moduleWarning(status);
+                }
             }
 
             size_t millisecondsSinceLastMessageFromFileReceiver()
@@ -380,6 +551,10 @@ namespace claid
                 // When a syncing is due, we require a connection to the remote server, and we are currently not connected,
                 // then we wait a certain number of seconds for a connection to the remote server to be established.
                 properties.getNumberProperty("remoteServerConnectionWaitTimeSeconds", this->remoteServerConnectionWaitTimeSeconds, 60);
+                // Size and maximum number of unacknowledged chunks for files that the DataReceiverModule requests in chunks.
+                // Memory required for a transfer is bounded by chunkSizeBytes * maxChunksInFlight.
+                properties.getNumberProperty("chunkSizeBytes", this->chunkSizeBytes, 256 * 1024);
+                properties.getNumberProperty("maxChunksInFlight", this->maxChunksInFlight, 8);
                 if(properties.wasAnyPropertyUnknown())
                 {
                     std::string unknownProperties;
@@ -402,6 +577,13 @@ namespace claid
                         return;
                     }
                 }
+
+                absl::Status status = this->manifest.initialize(this->filePath);
+                if(!status.ok())
+                {
+                    moduleFatal(status);
+                    return;
+                }
                 
                 // Exposing the internal "startSync" function, allowing other Modules to
                 // trigger the synchronization via a remote function call.
@@ -30,13 +30,18 @@ namespace claid {
             if(numWakeLocks == numAcquiredRuntimeWakeLocks)
             {
                 Logger::logInfo(
-                    "GlobalDeviceScheduler::decreaseAcquiredWakeLocks decreasing numAcquiredRuntimeWakeLocks by %d, number of wakelocks is now: %",
-                    numAcquiredRuntimeWakeLocks,
-                    numWakeLocks - numAcquiredRuntimeWakeLocks);
+                    "GlobalDeviceScheduler::decreaseAcquiredWakeLocks decreasing numAcquiredRuntimeWakeLocks by %d, number of wakelocks is now: %d",
+                    numWakeLocks,
+                    numAcquiredRuntimeWakeLocks - numWakeLocks);
 
+                numAcquiredRuntimeWakeLocks = 0;
                 releaseRuntimeWakeLock();
             }
-            else if(numWakeLocks > numAcquiredRuntimeWakeLocks)
+            else if(numWakeLocks < numAcquiredRuntimeWakeLocks)
+            {
+                numAcquiredRuntimeWakeLocks -= numWakeLocks;
+            }
+            else
             {
                 Logger::logFatal(
                     "Fatal error in GlobalDeviceScheduler::decreaseAcquiredWakeLocks. "
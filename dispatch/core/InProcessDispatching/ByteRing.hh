@@ -0,0 +1,200 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace claid
+{
+    // Lock-free single-producer/single-consumer ring buffer for variable sized messages (e.g., serialized DataPackages).
+    // Each message is stored as a 4 byte length prefix followed by its bytes; messages may wrap around the end of the buffer.
+    // Exactly one thread may push and exactly one (other) thread may pop.
+    class ByteRing
+    {
+        public:
+            static constexpr size_t LENGTH_PREFIX_SIZE = sizeof(uint32_t);
+
+            // Length prefix of a marker for a message which is too large for the ring and stored outside of it (see RingChannel).
+            static constexpr uint32_t EXTERNAL_MESSAGE = UINT32_MAX;
+
+            // The capacity is rounded up to the next power of two.
+            explicit ByteRing(size_t capacity) : buffer(roundUpToPowerOfTwo(capacity)), mask(buffer.size() - 1)
+            {
+            }
+
+            size_t capacity() const
+            {
+                return buffer.size();
+            }
+
+            // Largest message which fits into the ring at all.
+            size_t maxMessageSize() const
+            {
+                return std::min<size_t>(buffer.size() - LENGTH_PREFIX_SIZE, EXTERNAL_MESSAGE - 1);
+            }
+
+            // Producer. Returns false if there currently is not enough space (or the message can never fit).
+            bool tryPush(const void* data, size_t size)
+            {
+                if(size > maxMessageSize())
+                {
+                    return false;
+                }
+                return tryPushWithPrefix(static_cast<uint32_t>(size), data, size);
+            }
+
+            // Producer. Pushes a marker (length prefix EXTERNAL_MESSAGE without data). Returns false if the ring is full.
+            bool tryPushExternal()
+            {
+                return tryPushWithPrefix(EXTERNAL_MESSAGE, nullptr, 0);
+            }
+
+            // Consumer. Removes the next message if it is a marker pushed by tryPushExternal.
+            bool tryPopExternal()
+            {
+                if(peekSize() != EXTERNAL_MESSAGE)
+                {
+                    return false;
+                }
+                tail.store(tail.load(std::memory_order_relaxed) + LENGTH_PREFIX_SIZE, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer. Returns the size of the next message (EXTERNAL_MESSAGE for markers), or -1 if the ring is empty.
+            int64_t peekSize()
+            {
+                const uint64_t currentTail = tail.load(std::memory_order_relaxed);
+                if(currentTail == cachedHead)
+                {
+                    cachedHead = head.load(std::memory_order_acquire);
+                    if(currentTail == cachedHead)
+                    {
+                        return -1;
+                    }
+                }
+
+                uint32_t length;
+                copyOut(currentTail, &length, LENGTH_PREFIX_SIZE);
+                return length;
+            }
+
+            // Consumer. Copies the next message into the given buffer.
+            // Returns the size of the message, or -1 if the ring is empty or the buffer is too small (the message is kept).
+            int64_t tryPop(void* data, size_t dataSize)
+            {
+                int64_t size = peekSize();
+                if(size < 0 || size == EXTERNAL_MESSAGE || static_cast<size_t>(size) > dataSize)
+                {
+                    return -1;
+                }
+
+                const uint64_t currentTail = tail.load(std::memory_order_relaxed);
+                copyOut(currentTail + LENGTH_PREFIX_SIZE, data, size);
+                tail.store(currentTail + LENGTH_PREFIX_SIZE + size, std::memory_order_release);
+                return size;
+            }
+
+            bool tryPop(std::string& message)
+            {
+                int64_t size = peekSize();
+                if(size < 0 || size == EXTERNAL_MESSAGE)
+                {
+                    return false;
+                }
+                message.resize(size);
+                return tryPop(&message[0], message.size()) >= 0;
+            }
+
+            // May be called by both sides, the result is only a snapshot.
+            bool empty() const
+            {
+                return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+            }
+
+        private:
+            std::vector<char> buffer;
+            const size_t mask;
+
+            // Written by the producer only. Separate cache lines to avoid false sharing between producer and consumer.
+            alignas(64) std::atomic<uint64_t> head{0};
+            uint64_t cachedTail = 0;
+
+            // Written by the consumer only.
+            alignas(64) std::atomic<uint64_t> tail{0};
+            uint64_t cachedHead = 0;
+
+            bool tryPushWithPrefix(uint32_t length, const void* data, size_t size)
+            {
+                const uint64_t currentHead = head.load(std::memory_order_relaxed);
+                const size_t required = LENGTH_PREFIX_SIZE + size;
+
+                if(buffer.size() - (currentHead - cachedTail) < required)
+                {
+                    cachedTail = tail.load(std::memory_order_acquire);
+                    if(buffer.size() - (currentHead - cachedTail) < required)
+                    {
+                        return false;
+                    }
+                }
+
+                copyIn(currentHead, &length, LENGTH_PREFIX_SIZE);
+                if(size > 0)
+                {
+                    copyIn(currentHead + LENGTH_PREFIX_SIZE, data, size);
+                }
+                head.store(currentHead + required, std::memory_order_release);
+                return true;
+            }
+
+            static size_t roundUpToPowerOfTwo(size_t value)
+            {
+                size_t result = 64;
+                while(result < value)
+                {
+                    result <<= 1;
+                }
+                return result;
+            }
+
+            void copyIn(uint64_t position, const void* data, size_t size)
+            {
+                const size_t offset = position & mask;
+                const size_t firstPart = std::min(size, buffer.size() - offset);
+                std::memcpy(buffer.data() + offset, data, firstPart);
+                std::memcpy(buffer.data(), static_cast<const char*>(data) + firstPart, size - firstPart);
+            }
+
+            void copyOut(uint64_t position, void* data, size_t size) const
+            {
+                const size_t offset = position & mask;
+                const size_t firstPart = std::min(size, buffer.size() - offset);
+                std::memcpy(data, buffer.data() + offset, firstPart);
+                std::memcpy(static_cast<char*>(data) + firstPart, buffer.data(), size - firstPart);
+            }
+    };
+}
@@ -0,0 +1,290 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/InProcessDispatching/InProcessTransport.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <cstring>
+
+namespace claid
+{
+    RingChannel::RingChannel(size_t capacity) : ring(capacity)
+    {
+    }
+
+    int64_t RingChannel::push(const void* data, size_t size, int timeoutMs)
+    {
+        if(size <= this->ring.maxMessageSize())
+        {
+            return this->pushToRing(data, size, false, timeoutMs);
+        }
+
+        if(this->closed.load(std::memory_order_acquire))
+        {
+            return CLOSED;
+        }
+
+        // The message is added before its marker, so the consumer always finds it. Only we push, hence back() is ours.
+        {
+            std::unique_lock<std::mutex> lock(this->externalMessagesMutex);
+            this->externalMessages.emplace_back(static_cast<const char*>(data), size);
+        }
+
+        int64_t result = this->pushToRing(nullptr, 0, true, timeoutMs);
+        if(result < 0)
+        {
+            std::unique_lock<std::mutex> lock(this->externalMessagesMutex);
+            this->externalMessages.pop_back();
+            return result;
+        }
+        return static_cast<int64_t>(size);
+    }
+
+    int64_t RingChannel::pushToRing(const void* data, size_t size, bool external, int timeoutMs)
+    {
+        auto tryPush = [&]() { return external ? this->ring.tryPushExternal() : this->ring.tryPush(data, size); };
+
+        while(true)
+        {
+            if(this->closed.load(std::memory_order_acquire))
+            {
+                return CLOSED;
+            }
+
+            if(tryPush())
+            {
+                this->notifyConsumer();
+                return static_cast<int64_t>(size);
+            }
+
+            // Announce that we are waiting, then check again to not miss a pop which happened in between.
+            this->producerWaiting.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(tryPush())
+            {
+                this->producerWaiting.store(false, std::memory_order_relaxed);
+                this->notifyConsumer();
+                return static_cast<int64_t>(size);
+            }
+
+            if(this->closed.load(std::memory_order_acquire))
+            {
+                return CLOSED;
+            }
+
+            if(!this->spaceAvailable.wait(timeoutMs))
+            {
+                this->producerWaiting.store(false, std::memory_order_relaxed);
+                return TIMEOUT;
+            }
+        }
+    }
+
+    int64_t RingChannel::peekMessageSize()
+    {
+        int64_t size = this->ring.peekSize();
+        if(size == ByteRing::EXTERNAL_MESSAGE)
+        {
+            std::unique_lock<std::mutex> lock(this->externalMessagesMutex);
+            return static_cast<int64_t>(this->externalMessages.front().size());
+        }
+        return size;
+    }
+
+    int64_t RingChannel::waitForMessage(int timeoutMs)
+    {
+        while(true)
+        {
+            int64_t size = this->peekMessageSize();
+            if(size >= 0)
+            {
+                return size;
+            }
+
+            if(this->closed.load(std::memory_order_acquire))
+            {
+                return CLOSED;
+            }
+
+            this->consumerWaiting.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            size = this->peekMessageSize();
+            if(size >= 0)
+            {
+                this->consumerWaiting.store(false, std::memory_order_relaxed);
+                return size;
+            }
+
+            if(this->closed.load(std::memory_order_acquire))
+            {
+                return CLOSED;
+            }
+
+            if(!this->dataAvailable.wait(timeoutMs))
+            {
+                this->consumerWaiting.store(false, std::memory_order_relaxed);
+                return TIMEOUT;
+            }
+        }
+    }
+
+    int64_t RingChannel::tryPop(void* data, size_t size)
+    {
+        if(this->ring.peekSize() == ByteRing::EXTERNAL_MESSAGE)
+        {
+            std::unique_lock<std::mutex> lock(this->externalMessagesMutex);
+            std::string& message = this->externalMessages.front();
+            if(message.size() > size)
+            {
+                return TIMEOUT;
+            }
+            std::memcpy(data, message.data(), message.size());
+            int64_t result = static_cast<int64_t>(message.size());
+            this->externalMessages.pop_front();
+            lock.unlock();
+
+            this->ring.tryPopExternal();
+            this->notifyProducer();
+            return result;
+        }
+
+        int64_t result = this->ring.tryPop(data, size);
+        if(result < 0)
+        {
+            return TIMEOUT;
+        }
+        this->notifyProducer();
+        return result;
+    }
+
+    bool RingChannel::pop(std::string& message, int timeoutMs)
+    {
+        if(this->waitForMessage(timeoutMs) < 0)
+        {
+            return false;
+        }
+
+        bool result;
+        if(this->ring.peekSize() == ByteRing::EXTERNAL_MESSAGE)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->externalMessagesMutex);
+                message.swap(this->externalMessages.front());
+                this->externalMessages.pop_front();
+            }
+            result = this->ring.tryPopExternal();
+        }
+        else
+        {
+            result = this->ring.tryPop(message);
+        }
+        this->notifyProducer();
+        return result;
+    }
+
+    void RingChannel::close()
+    {
+        this->closed.store(true, std::memory_order_release);
+        this->dataAvailable.notify();
+        this->spaceAvailable.notify();
+    }
+
+    bool RingChannel::isClosed() const
+    {
+        return this->closed.load(std::memory_order_acquire);
+    }
+
+    // The fences pair with the ones in push and waitForMessage: either the waiting side sees the new state of the ring,
+    // or we see that it is waiting.
+    void RingChannel::notifyConsumer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(this->consumerWaiting.load(std::memory_order_seq_cst) && this->consumerWaiting.exchange(false))
+        {
+            this->dataAvailable.notify();
+        }
+    }
+
+    void RingChannel::notifyProducer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(this->producerWaiting.load(std::memory_order_seq_cst) && this->producerWaiting.exchange(false))
+        {
+            this->spaceAvailable.notify();
+        }
+    }
+
+    InProcessTransport::InProcessTransport(claidservice::Runtime runtime, size_t ringCapacity) : 
+        runtime(runtime), toRuntimeChannel(ringCapacity), fromRuntimeChannel(ringCapacity)
+    {
+    }
+
+    claidservice::Runtime InProcessTransport::getRuntime() const
+    {
+        return this->runtime;
+    }
+
+    bool InProcessTransport::sendToRuntime(const claidservice::DataPackage& package)
+    {
+        if(!package.SerializeToString(&this->sendBuffer))
+        {
+            Logger::logError("InProcessTransport failed to serialize package for Runtime %s.", claidservice::Runtime_Name(this->runtime).c_str());
+            return true;
+        }
+
+        // Packages larger than the ring are passed outside of it (see RingChannel), hence this only fails if the transport was closed.
+        return this->toRuntimeChannel.push(this->sendBuffer.data(), this->sendBuffer.size(), -1) >= 0;
+    }
+
+    bool InProcessTransport::receiveFromRuntime(claidservice::DataPackage& package)
+    {
+        while(this->fromRuntimeChannel.pop(this->receiveBuffer, -1))
+        {
+            if(package.ParseFromString(this->receiveBuffer))
+            {
+                return true;
+            }
+            Logger::logError("InProcessTransport received invalid package from Runtime %s.", claidservice::Runtime_Name(this->runtime).c_str());
+        }
+        return false;
+    }
+
+    RingChannel& InProcessTransport::toRuntime()
+    {
+        return this->toRuntimeChannel;
+    }
+
+    RingChannel& InProcessTransport::fromRuntime()
+    {
+        return this->fromRuntimeChannel;
+    }
+
+    void InProcessTransport::close()
+    {
+        this->toRuntimeChannel.close();
+        this->fromRuntimeChannel.close();
+    }
+
+    bool InProcessTransport::isClosed() const
+    {
+        return this->toRuntimeChannel.isClosed();
+    }
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "dispatch/core/InProcessDispatching/ByteRing.hh"
+#include "dispatch/core/InProcessDispatching/WakeupEvent.hh"
+#include "dispatch/proto/claidservice.pb.h"
+
+namespace claid
+{
+    // One direction of an InProcessTransport: a ByteRing plus wakeups for the consumer (data available)
+    // and the producer (space available). Wakeups are only signaled if the other side is actually waiting,
+    // hence a busy stream of packages does not cause any system calls.
+    // Like the ByteRing, a RingChannel has exactly one producer thread and one consumer thread.
+    // Messages larger than the ring are stored in a separate queue; a marker in the ring keeps them in order.
+    class RingChannel
+    {
+        public:
+            static constexpr int64_t TIMEOUT = -1;
+            static constexpr int64_t CLOSED = -2;
+
+            explicit RingChannel(size_t capacity);
+
+            // Blocks while the ring is full. A negative timeout waits indefinitely.
+            // Returns the size of the message, TIMEOUT or CLOSED.
+            int64_t push(const void* data, size_t size, int timeoutMs);
+
+            // Blocks until a message is available. Returns its size, TIMEOUT or CLOSED (closed and no messages left).
+            int64_t waitForMessage(int timeoutMs);
+
+            // Does not block. Returns the size of the popped message, or TIMEOUT if no message is available
+            // or the buffer is too small (call waitForMessage to get the required size).
+            int64_t tryPop(void* data, size_t size);
+            bool pop(std::string& message, int timeoutMs);
+
+            void close();
+            bool isClosed() const;
+
+        private:
+            ByteRing ring;
+            WakeupEvent dataAvailable;
+            WakeupEvent spaceAvailable;
+            std::atomic<bool> consumerWaiting{false};
+            std::atomic<bool> producerWaiting{false};
+            std::atomic<bool> closed{false};
+
+            // Messages which do not fit into the ring, in the order of their markers in the ring.
+            std::mutex externalMessagesMutex;
+            std::deque<std::string> externalMessages;
+
+            int64_t pushToRing(const void* data, size_t size, bool external, int timeoutMs);
+            int64_t peekMessageSize();
+            void notifyConsumer();
+            void notifyProducer();
+    };
+
+    // Exchanges serialized DataPackages between the Middleware and a Runtime which runs in the same process
+    // (e.g., the Python Runtime loading the CLAID library via ctypes), without going through gRPC.
+    // The Middleware side reads and writes DataPackages, the Runtime side only sees bytes (see capi.h).
+    class InProcessTransport
+    {
+        public:
+            InProcessTransport(claidservice::Runtime runtime, size_t ringCapacity);
+
+            claidservice::Runtime getRuntime() const;
+
+            // Middleware side.
+            bool sendToRuntime(const claidservice::DataPackage& package);
+            bool receiveFromRuntime(claidservice::DataPackage& package);
+
+            // Runtime side.
+            RingChannel& toRuntime();
+            RingChannel& fromRuntime();
+
+            // Unblocks both sides. Packages which are still in the rings can be received by the Runtime.
+            void close();
+            bool isClosed() const;
+
+        private:
+            claidservice::Runtime runtime;
+            RingChannel toRuntimeChannel;
+            RingChannel fromRuntimeChannel;
+
+            // Only used by the Middleware side threads (one writer, one reader).
+            std::string sendBuffer;
+            std::string receiveBuffer;
+    };
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/InProcessDispatching/WakeupEvent.hh"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <chrono>
+#include <cstdint>
+
+namespace claid
+{
+#ifdef __linux__
+    WakeupEvent::WakeupEvent() : eventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    {
+    }
+
+    WakeupEvent::~WakeupEvent()
+    {
+        if(this->eventFd >= 0)
+        {
+            close(this->eventFd);
+        }
+    }
+
+    void WakeupEvent::notify()
+    {
+        uint64_t value = 1;
+        // Can only fail if the counter would overflow, in which case the event is signaled anyway.
+        ssize_t written = write(this->eventFd, &value, sizeof(value));
+        (void) written;
+    }
+
+    bool WakeupEvent::wait(int timeoutMs)
+    {
+        struct pollfd pollFd;
+        pollFd.fd = this->eventFd;
+        pollFd.events = POLLIN;
+
+        int result;
+        do
+        {
+            result = poll(&pollFd, 1, timeoutMs < 0 ? -1 : timeoutMs);
+        }
+        while(result < 0 && errno == EINTR);
+
+        if(result <= 0)
+        {
+            return false;
+        }
+
+        // Resets the counter.
+        uint64_t value;
+        ssize_t numRead = read(this->eventFd, &value, sizeof(value));
+        return numRead == sizeof(value);
+    }
+#else
+    WakeupEvent::WakeupEvent()
+    {
+    }
+
+    WakeupEvent::~WakeupEvent()
+    {
+    }
+
+    void WakeupEvent::notify()
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->notified = true;
+        }
+        this->conditionVariable.notify_one();
+    }
+
+    bool WakeupEvent::wait(int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(timeoutMs < 0)
+        {
+            this->conditionVariable.wait(lock, [this]{ return this->notified; });
+        }
+        else if(!this->conditionVariable.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]{ return this->notified; }))
+        {
+            return false;
+        }
+        this->notified = false;
+        return true;
+    }
+#endif
+}
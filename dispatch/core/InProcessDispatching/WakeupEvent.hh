@@ -0,0 +1,57 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace claid
+{
+    // Wakes up a thread waiting for data (or space) of a ring buffer.
+    // Uses an eventfd on Linux (and Android), and a condition variable on other platforms.
+    // Multiple notifications before a wait collapse into a single wakeup.
+    class WakeupEvent
+    {
+        public:
+            WakeupEvent();
+            ~WakeupEvent();
+
+            WakeupEvent(const WakeupEvent&) = delete;
+            WakeupEvent& operator=(const WakeupEvent&) = delete;
+
+            void notify();
+
+            // Waits until notify was called (since the last wait returned) or the timeout expired.
+            // A negative timeout waits indefinitely. Returns true if the event was notified.
+            bool wait(int timeoutMs);
+
+        private:
+#ifdef __linux__
+            int eventFd = -1;
+#else
+            std::mutex mutex;
+            std::condition_variable conditionVariable;
+            bool notified = false;
+#endif
+    };
+}
@@ -24,6 +24,7 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -55,6 +56,21 @@ private:
     typedef std::pair<std::string, std::string> ChannelModulePair;
     std::map<ChannelModulePair, std::vector<std::shared_ptr<AbstractSubscriber>>> moduleChannelsSubscriberMap;
 
+    // Same as moduleChannelsSubscriberMap, keyed by RoutingIdTable::makeKey(channel_id, module_id).
+    // Only contains the subscriptions whose channel and Module are known to routingIds, see setRoutingIds.
+    std::unordered_map<uint64_t, std::vector<std::shared_ptr<AbstractSubscriber>>> subscribersByRoutingKey;
+    const RoutingIdTable* routingIds = nullptr;
+
+    void indexSubscriber(const std::string& channelName, const std::string& moduleId, std::shared_ptr<AbstractSubscriber> subscriber)
+    {
+        uint32_t channelId = this->routingIds->channels.lookupId(channelName);
+        uint32_t moduleRoutingId = this->routingIds->modules.lookupId(moduleId);
+        if(channelId != StringInternTable::INVALID_ID && moduleRoutingId != StringInternTable::INVALID_ID)
+        {
+            this->subscribersByRoutingKey[RoutingIdTable::makeKey(channelId, moduleRoutingId)].push_back(subscriber);
+        }
+    }
+
     SharedQueue<DataPackage>& toModuleDispatcherQueue;
 
 public:
@@ -128,6 +144,30 @@ public:
         }
 
         this->moduleChannelsSubscriberMap[channelModuleKey].push_back(subscriber);
+
+        if(this->routingIds != nullptr)
+        {
+            indexSubscriber(channelName, moduleId, subscriber);
+        }
+    }
+
+    // Indexes the subscribers by the routing IDs received from the Middleware (nullptr if none were received),
+    // which allows to look them up using getSubscriberInstancesOfModule(channelId, moduleId).
+    void setRoutingIds(const RoutingIdTable* routingIds)
+    {
+        this->routingIds = routingIds;
+        this->subscribersByRoutingKey.clear();
+        if(routingIds == nullptr)
+        {
+            return;
+        }
+        for(const auto& entry : this->moduleChannelsSubscriberMap)
+        {
+            for(const std::shared_ptr<AbstractSubscriber>& subscriber : entry.second)
+            {
+                indexSubscriber(entry.first.first, entry.first.second, subscriber);
+            }
+        }
     }
 
     std::vector<std::shared_ptr<AbstractSubscriber>> getSubscriberInstancesOfModule(const std::string& channelName, const std::string& moduleId) 
@@ -143,6 +183,18 @@ public:
         return it->second;
     }
 
+    // Same as above, using the routing IDs of the channel and Module. Returns an empty list if the IDs are unknown.
+    std::vector<std::shared_ptr<AbstractSubscriber>> getSubscriberInstancesOfModule(uint32_t channelId, uint32_t moduleId)
+    {
+        auto it = this->subscribersByRoutingKey.find(RoutingIdTable::makeKey(channelId, moduleId));
+        if(it == this->subscribersByRoutingKey.end())
+        {
+            return std::vector<std::shared_ptr<AbstractSubscriber>>();
+        }
+
+        return it->second;
+    }
+
     
     std::vector<DataPackage> getChannelTemplatePackagesForModule(const std::string& moduleId)
     {
@@ -202,10 +254,34 @@ public:
         return "";
     }
 
+    // Removes all publications and subscriptions of a Module which has been unloaded.
+    void removeModule(const std::string& moduleId)
+    {
+        examplePackagesForEachModule.erase(moduleId);
+        for(auto it = moduleChannelsSubscriberMap.begin(); it != moduleChannelsSubscriberMap.end();)
+        {
+            if(it->first.second == moduleId)
+            {
+                it = moduleChannelsSubscriberMap.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        uint32_t moduleRoutingId = this->routingIds != nullptr ? this->routingIds->modules.lookupId(moduleId) : StringInternTable::INVALID_ID;
+        for(auto it = subscribersByRoutingKey.begin(); it != subscribersByRoutingKey.end();)
+        {
+            it = static_cast<uint32_t>(it->first) == moduleRoutingId ? subscribersByRoutingKey.erase(it) : std::next(it);
+        }
+    }
+
     void reset()
     {
         examplePackagesForEachModule.clear();
         moduleChannelsSubscriberMap.clear();
+        subscribersByRoutingKey.clear();
     }
 
     SharedQueue<DataPackage>& getToModuleDispatcherQueue()
@@ -36,6 +36,13 @@ namespace claid
 {
     Module::Module()
     {
+        this->moduleThreadHandle = std::make_shared<ModuleThreadHandle>();
+        this->moduleThreadHandle->module = this;
+    }
+
+    Module::~Module()
+    {
+        detachModuleThreadHandle();
     }
 
     void Module::moduleFatal(const std::string& error) const
@@ -110,6 +117,10 @@ namespace claid
 
         this->deviceInfoGatherer = getDeviceInfoGatherer();
 
+        // Continuations of Futures awaited before a previous shutdown stay dropped.
+        this->moduleThreadHandle = std::make_shared<ModuleThreadHandle>();
+        this->moduleThreadHandle->module = this;
+
         runnableDispatcher.setRemoteFunctionHandler(remoteFunctionHandler);
         if (!runnableDispatcher.start()) 
         {
@@ -291,6 +302,9 @@ namespace claid
             std::this_thread::sleep_for(std::chrono::milliseconds(20));
             Logger::logInfo("Terminate internal 2");
         }
+        // Drops the continuations of Futures that finish after the Module was shut down.
+        detachModuleThreadHandle();
+
         Logger::logInfo("Runnable dispatcher stop 1");
         this->runnableDispatcher.stop();
         Logger::logInfo("Runnable dispatcher stop 2");
@@ -354,6 +368,75 @@ namespace claid
         );
     }
 
+    std::shared_ptr<Future<bool>> Module::isConnectedToRemoteServerAsync()
+    {
+        return this->isConnectedToRemoteServerRemoteFunction.execute();
+    }
+
+    void Module::runOnModuleThread(std::function<void()> function)
+    {
+        std::shared_ptr<FunctionRunnable<void>> functionRunnable(new FunctionRunnable<void>(function));
+
+        this->runnableDispatcher.addRunnable(
+            ScheduledRunnable(
+                std::static_pointer_cast<Runnable>(functionRunnable), 
+                ScheduleOnce(Time::now()))
+        );
+    }
+
+    FutureContinuationExecutor Module::getModuleThreadExecutor()
+    {
+        std::weak_ptr<ModuleThreadHandle> weakHandle = this->moduleThreadHandle;
+        return [weakHandle](std::function<void()> function)
+        {
+            std::shared_ptr<ModuleThreadHandle> handle = weakHandle.lock();
+            if(handle == nullptr)
+            {
+                return;
+            }
+
+            // Holding the mutex prevents the Module from being shut down or destroyed while the function is enqueued.
+            std::unique_lock<std::mutex> lock(handle->mutex);
+            if(handle->module == nullptr)
+            {
+                Logger::logWarning("Dropping continuation of a Future, the Module awaiting it has been shut down.");
+                return;
+            }
+            handle->module->runOnModuleThread(function);
+        };
+    }
+
+    void Module::detachModuleThreadHandle()
+    {
+        std::unique_lock<std::mutex> lock(this->moduleThreadHandle->mutex);
+        this->moduleThreadHandle->module = nullptr;
+    }
+
+    void Module::cancelFutureAfterTimeout(std::shared_ptr<AbstractFuture> future, const Duration& timeout)
+    {
+        if(timeout.getMilliSeconds() == 0)
+        {
+            return;
+        }
+
+        // Does not keep the Future alive. Cancelling a Future that finished already has no effect.
+        std::weak_ptr<AbstractFuture> weakFuture = future;
+        std::shared_ptr<FunctionRunnable<void>> functionRunnable(new FunctionRunnable<void>([weakFuture]()
+        {
+            std::shared_ptr<AbstractFuture> future = weakFuture.lock();
+            if(future != nullptr)
+            {
+                future->cancel();
+            }
+        }));
+
+        this->runnableDispatcher.addRunnable(
+            ScheduledRunnable(
+                std::static_pointer_cast<Runnable>(functionRunnable), 
+                ScheduleOnce(Time::now() + timeout))
+        );
+    }
+
     bool Module::isConnectedToRemoteServer()
     {
         auto future = this->isConnectedToRemoteServerRemoteFunction.execute();
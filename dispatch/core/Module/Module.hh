@@ -26,6 +26,7 @@
 #include <map>
 #include <functional>
 #include <chrono>
+#include <mutex>
 #include "dispatch/core/Module/RunnableDispatcherThread/RunnableDispatcher.hh"
 #include "dispatch/core/Logger/Logger.hh"
 #include "dispatch/core/Module/ModuleRef.hh"
@@ -36,6 +37,7 @@
 #include "dispatch/core/RemoteFunction/RemoteFunction.hh"
 #include "dispatch/core/RemoteFunction/RemoteFunctionHandler.hh"
 #include "dispatch/core/RemoteFunction/RemoteFunctionRunnableHandler.hh"
+#include "dispatch/core/RemoteFunction/FutureAwaiter.hh"
 #include "dispatch/core/Utilities/ScheduleHelper.hh"
 #include "dispatch/core/DeviceInfoGatherer/DeviceInfoGatherer.hh"
 
@@ -75,12 +77,30 @@ namespace claid
 
         void enqueueRunnable(const ScheduledRunnable& runnable);
 
+        // Used to resume awaitAsync continuations and coroutines on the thread of the Module.
+        void runOnModuleThread(std::function<void()> function);
+        void cancelFutureAfterTimeout(std::shared_ptr<AbstractFuture> future, const Duration& timeout);
+
+        // Shared with the finished-listeners of awaitAsync and awaitFuture, which can outlive the Module
+        // (e.g., if the Module is unloaded while a RemoteFunction call is still in flight).
+        // The handle is detached in shutdown() and in the destructor; continuations of Futures finishing afterwards are dropped.
+        struct ModuleThreadHandle
+        {
+            std::mutex mutex;
+            Module* module = nullptr;
+        };
+        std::shared_ptr<ModuleThreadHandle> moduleThreadHandle;
+
+        // Returns an executor that runs functions on the thread of the Module, as long as the Module was not shut down.
+        FutureContinuationExecutor getModuleThreadExecutor();
+        void detachModuleThreadHandle();
+
     private:
         RemoteFunction<bool> isConnectedToRemoteServerRemoteFunction;
 
     public:
         Module();
-        virtual ~Module() {}
+        virtual ~Module();
         
         void moduleFatal(const std::string& error) const;
         void moduleError(const std::string& error) const;
@@ -112,6 +132,12 @@ namespace claid
 
         virtual bool start(ChannelSubscriberPublisher* subscriberPublisher, RemoteFunctionHandler* remoteFunctionHandler, Properties properties);
 
+        // Has to be called before start(). Allows the Modules of a Runtime to share wake locks and device wakeups.
+        void setWakeCoordinator(std::shared_ptr<WakeCoordinator> wakeCoordinator)
+        {
+            this->runnableDispatcher.setWakeCoordinator(wakeCoordinator);
+        }
+
         void enqueueRPC(std::shared_ptr<DataPackage> rpcRequest)
         {
             std::function<void (std::shared_ptr<DataPackage>)> callback = 
@@ -290,8 +316,46 @@ namespace claid
         }
 
         bool isConnectedToRemoteServer();
+        std::shared_ptr<Future<bool>> isConnectedToRemoteServerAsync();
         bool waitUntilConnectedToRemoteServer(Duration timeout);
 
+        // Non-blocking alternative to future->await(): The continuation is called on the thread of the Module once the Future finished.
+        // In the meantime, the Module keeps processing its subscriptions and timers, and can have many RemoteFunction calls in flight.
+        // Calling future->await() in the continuation returns the result without blocking. 
+        // If a timeout is specified, the Future is cancelled if it did not finish in time.
+        template<typename T>
+        void awaitAsync(std::shared_ptr<Future<T>> future, std::function<void (std::shared_ptr<Future<T>>)> continuation, 
+            const Duration& timeout = Duration::seconds(0))
+        {
+            if(future == nullptr)
+            {
+                moduleError("Cannot await Future asynchronously, Future is null. Did the execution of the RemoteFunction fail?");
+                return;
+            }
+
+            cancelFutureAfterTimeout(future, timeout);
+            FutureContinuationExecutor executor = getModuleThreadExecutor();
+            future->addFinishedListener([executor, future, continuation]()
+            {
+                executor([future, continuation]() { continuation(future); });
+            });
+        }
+
+#ifdef CLAID_COROUTINES_SUPPORTED
+        // Allows to co_await the result of a RemoteFunction in a ModuleTask coroutine (see FutureAwaiter.hh).
+        // The coroutine is resumed on the thread of the Module.
+        template<typename T>
+        FutureAwaiter<T> awaitFuture(std::shared_ptr<Future<T>> future, const Duration& timeout = Duration::seconds(0))
+        {
+            if(future != nullptr)
+            {
+                cancelFutureAfterTimeout(future, timeout);
+            }
+            // If the Module is shut down while the coroutine is suspended, the coroutine is not resumed anymore.
+            return FutureAwaiter<T>(future, getModuleThreadExecutor());
+        }
+#endif
+
 
         void pauseInternal();
         void resumeInternal();
@@ -327,6 +391,14 @@ namespace claid
             return this->remoteFunctionRunnableHandler->registerRunnable(functionName, f, obj);
         }
 
+        // Allows to process all calls of a batched RemoteFunction request at once (e.g., one batched inference), 
+        // see RemoteFunction::executeBatch and RemoteFunctionRunnableHandler::registerBatchedRunnable.
+        template<typename Class, typename Return, typename BatchElement>
+        bool registerBatchedRemoteFunction(std::string functionName, std::vector<Return> (Class::*f)(const std::vector<BatchElement>&), Class* obj)
+        {
+            return this->remoteFunctionRunnableHandler->registerBatchedRunnable(functionName, f, obj);
+        }
+
         template<typename Return, typename... Parameters>
         RemoteFunction<Return> mapRemoteFunctionOfModule(std::string moduleId, std::string functionName)
         {
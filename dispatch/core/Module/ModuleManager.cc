@@ -33,11 +33,11 @@ ModuleManager::ModuleManager(DispatcherClient& dispatcher,
                                                     eventTracker(eventTracker),
                                                     subscriberPublisher(toModuleDispatcherQueue),
                                                     remoteFunctionHandler(toModuleDispatcherQueue),
-                                                    remoteFunctionRunnableHandler("CPP_RUNTIME", toModuleDispatcherQueue)
+                                                    remoteFunctionRunnableHandler("CPP_RUNTIME", toModuleDispatcherQueue),
+                                                    wakeCoordinator(std::make_shared<WakeCoordinator>())
 {
     Logger::logInfo("ModuleManager constructor event tracker %lu", eventTracker.get());
-
-    
+    this->wakeCoordinator->start();
 }
 
 ModuleManager::~ModuleManager()
@@ -122,6 +122,7 @@ absl::Status ModuleManager::initializeModules(const ModuleListResponse& moduleLi
         
         Properties properties = descriptor.properties();
 
+        module->setWakeCoordinator(this->wakeCoordinator);
         if(!module->start(&subscriberPublisher, &this->remoteFunctionHandler, properties))
         {
             return absl::AbortedError(absl::StrCat(
@@ -150,12 +151,27 @@ void ModuleManager::getTemplatePackagesOfModules(std::map<std::string, std::vect
 }
 
 InitRuntimeRequest ModuleManager::makeInitRuntimeRequest()
+{
+    std::set<std::string> moduleIds;
+    for(const auto& entry : this->runningModules)
+    {
+        moduleIds.insert(entry.first);
+    }
+    return makeInitRuntimeRequest(moduleIds);
+}
+
+InitRuntimeRequest ModuleManager::makeInitRuntimeRequest(const std::set<std::string>& moduleIds)
 {
     InitRuntimeRequest initRuntimeRequest;
     std::map<std::string, std::vector<DataPackage>> moduleTemplatePackages;
     getTemplatePackagesOfModules(moduleTemplatePackages);
     for(const auto& entry : moduleTemplatePackages)
     {
+        if(moduleIds.find(entry.first) == moduleIds.end())
+        {
+            continue;
+        }
+
         InitRuntimeRequest_ModuleChannels moduleChannels;
 
         moduleChannels.set_module_id(entry.first);
@@ -220,6 +236,8 @@ absl::Status ModuleManager::start()
                        dispatcherStatus.error_message());
     }
 
+    this->subscriberPublisher.setRoutingIds(this->dispatcher.hasRoutingIds() ? &this->dispatcher.getRoutingIds() : nullptr);
+
     this->running = true;
 
 
@@ -244,6 +262,65 @@ void ModuleManager::shutdownModules()
     this->runningModules.clear();
 }
 
+void ModuleManager::unloadModules(const google::protobuf::RepeatedPtrField<std::string>& moduleIds)
+{
+    for(const std::string& moduleId : moduleIds)
+    {
+        auto it = this->runningModules.find(moduleId);
+        if(it == this->runningModules.end())
+        {
+            continue;
+        }
+        Logger::logInfo("ModuleManager shutting down Module \"%s\".", moduleId.c_str());
+        it->second->shutdown();
+        this->runningModules.erase(it);
+        this->subscriberPublisher.removeModule(moduleId);
+    }
+}
+
+// Loads the Modules assigned to this runtime which are not running yet (e.g., after a partial config reload).
+// Modules which are already running are not touched.
+absl::Status ModuleManager::loadMissingModules()
+{
+    std::unique_ptr<ModuleListResponse> moduleList = this->dispatcher.getModuleList();
+    if(moduleList == nullptr)
+    {
+        return absl::AbortedError("Failed to receive ModuleListResponse from middleware.");
+    }
+
+    ModuleListResponse missingModules;
+    std::set<std::string> missingModuleIds;
+    for(const ModuleListResponse_ModuleDescriptor& descriptor : moduleList->descriptors())
+    {
+        if(this->runningModules.find(descriptor.module_id()) == this->runningModules.end())
+        {
+            *missingModules.add_descriptors() = descriptor;
+            missingModuleIds.insert(descriptor.module_id());
+        }
+    }
+
+    absl::Status status = instantiateModules(missingModules);
+    if(!status.ok())
+    {
+        return status;
+    }
+
+    status = initializeModules(missingModules, subscriberPublisher);
+    if(!status.ok())
+    {
+        return status;
+    }
+
+    grpc::Status dispatcherStatus = this->dispatcher.initRuntime(makeInitRuntimeRequest(missingModuleIds));
+    if(!dispatcherStatus.ok())
+    {
+        return absl::Status(static_cast<absl::StatusCode>(dispatcherStatus.error_code()),
+                       dispatcherStatus.error_message());
+    }
+    Logger::logInfo("ModuleManager loaded %d missing Modules.", static_cast<int>(missingModuleIds.size()));
+    return absl::OkStatus();
+}
+
 void ModuleManager::stop()
 {
     if(!this->running)
@@ -320,8 +397,16 @@ void ModuleManager::onPackageReceivedFromModulesDispatcher(std::shared_ptr<DataP
         return;
     }
 
-    std::vector<std::shared_ptr<AbstractSubscriber>> subscriberList 
-        = this->subscriberPublisher.getSubscriberInstancesOfModule(channelName, moduleId);
+    std::vector<std::shared_ptr<AbstractSubscriber>> subscriberList;
+    if(dataPackage->channel_id() != StringInternTable::INVALID_ID && dataPackage->target_module_id() != StringInternTable::INVALID_ID)
+    {
+        subscriberList = this->subscriberPublisher.getSubscriberInstancesOfModule(dataPackage->channel_id(), dataPackage->target_module_id());
+    }
+    // Channels or Modules added after the handshake (e.g., by a config reload) are not known by their routing IDs.
+    if(subscriberList.empty())
+    {
+        subscriberList = this->subscriberPublisher.getSubscriberInstancesOfModule(channelName, moduleId);
+    }
 
     Logger::logInfo("ModuleManager invoking subscribers. Found %d subscribers.", subscriberList.size());
     for(std::shared_ptr<AbstractSubscriber> subscriber : subscriberList)
@@ -357,8 +442,16 @@ void ModuleManager::handlePackageWithControlVal(std::shared_ptr<DataPackage> pac
         case CtrlType::CTRL_UNLOAD_MODULES:
         {   
             Logger::logInfo("ModuleManager received ControlPackage with code CTRL_UNLOAD_MODULES");
-            Logger::logInfo("Unloading modules!");
-            this->shutdownModules();
+            // If Module ids are specified, only those Modules are unloaded (partial config reload).
+            if(package->control_val().module_ids_size() > 0)
+            {
+                this->unloadModules(package->control_val().module_ids());
+            }
+            else
+            {
+                Logger::logInfo("Unloading modules!");
+                this->shutdownModules();
+            }
             std::shared_ptr<DataPackage> response = std::make_shared<DataPackage>();
             ControlPackage& ctrlPackage = *response->mutable_control_val();
             
@@ -385,6 +478,26 @@ void ModuleManager::handlePackageWithControlVal(std::shared_ptr<DataPackage> pac
             
             break;
         }
+        case CtrlType::CTRL_LOAD_MODULES:
+        {
+            // Processed on the reader thread. Packages for the Modules which keep running are queued meanwhile.
+            // The Middleware is waiting for the acknowledgement, hence it is sent even if loading failed.
+            absl::Status status = this->loadMissingModules();
+            if(!status.ok())
+            {
+                Logger::logError("Failed to load Modules: %s", status.ToString().c_str());
+            }
+
+            std::shared_ptr<DataPackage> response = std::make_shared<DataPackage>();
+            ControlPackage& ctrlPackage = *response->mutable_control_val();
+
+            ctrlPackage.set_ctrl_type(CtrlType::CTRL_LOAD_MODULES_DONE);
+            ctrlPackage.set_runtime(Runtime::RUNTIME_CPP);
+            response->set_source_host(package->target_host());
+            response->set_target_host(package->source_host());
+            toModuleDispatcherQueue.push_back(response);
+            break;
+        }
         case CtrlType::CTRL_PAUSE_MODULE:
         {
             Logger::logWarning("Received pauise module %s", package->target_module().c_str());
@@ -61,6 +61,9 @@ namespace claid {
             RemoteFunctionHandler remoteFunctionHandler;
             RemoteFunctionRunnableHandler remoteFunctionRunnableHandler;
 
+            // Shared by the RunnableDispatchers of all Modules.
+            std::shared_ptr<WakeCoordinator> wakeCoordinator;
+
             // ModuleId, Module
             std::map<std::string, std::unique_ptr<Module>> runningModules;
 
@@ -81,6 +84,7 @@ namespace claid {
             void getTemplatePackagesOfModules(std::map<std::string, std::vector<DataPackage>>& moduleChannels);
 
             InitRuntimeRequest makeInitRuntimeRequest();
+            InitRuntimeRequest makeInitRuntimeRequest(const std::set<std::string>& moduleIds);
 
             void readFromModulesDispatcher();
             void onPackageReceivedFromModulesDispatcher(std::shared_ptr<DataPackage> dataPackage);
@@ -92,6 +96,8 @@ namespace claid {
             void handleRemoteFunctionResponse(std::shared_ptr<DataPackage> remoteFunctionResponse);
 
             void shutdownModules();
+            void unloadModules(const google::protobuf::RepeatedPtrField<std::string>& moduleIds);
+            absl::Status loadMissingModules();
 
             void restart();
 
@@ -32,6 +32,7 @@
 #include "dispatch/core/Utilities/Time.hh"
 #include "dispatch/core/Logger/Logger.hh"
 #include "dispatch/core/Module/RunnableDispatcherThread/ScheduledRunnable.hh"
+#include "dispatch/core/Module/RunnableDispatcherThread/WakeCoordinator.hh"
 #include "dispatch/core/Module/TypeMapping/Mutator.hh"
 #include "dispatch/core/Module/TypeMapping/TypeMapping.hh"
 
@@ -60,11 +61,12 @@ namespace claid
 
             // Allows the RunnableDispatcher to make calls into the Middleware, e.g.,
             // to schedule device wake ups or request to keep the device awake.
-            RemoteFunctionHandler* remoteFunctionHandler;
+            RemoteFunctionHandler* remoteFunctionHandler = nullptr;
 
-            RemoteFunction<void> middlewareFuncAcquireWakeLock;
-            RemoteFunction<void> middlewareFuncReleaseWakeLock;
-            RemoteFunction<void> middlewareFuncScheduleDeviceWakeUpAt;
+            // Shared by all RunnableDispatchers of the Runtime. Only calls into the Middleware if the
+            // aggregate state of all dispatchers changes, instead of on each iteration of runScheduling.
+            std::shared_ptr<WakeCoordinator> wakeCoordinator;
+            uint64_t wakeCoordinatorDispatcherId = 0;
 
 
             std::chrono::microseconds getWaitDurationUntilNextRunnableIsDue()
@@ -117,14 +119,10 @@ namespace claid
                 // However, we are not interested in distinguishing the two cases.
                 // In any case, when we wake up, we see if we need to execute anything.
                 // wait_for will atomically release the mutex and sleep, and will atomically lock the mutex after waiting.
-                std::unique_lock<std::mutex> lock(this->mutex);
-                // Middleware: ScheduleWakeUpInMicroSeconds();
-              
+                this->wakeCoordinator->onDispatcherIdle(this->wakeCoordinatorDispatcherId, executionTime);
 
-                middlewareScheduleDeviceWakeupAt(executionTime.toUnixTimestampMilliseconds());
-                Logger::logInfo("%lu sleeping", this);
+                std::unique_lock<std::mutex> lock(this->mutex);
                 this->conditionVariable.wait_until(lock, executionTime, [&]{return this->rescheduleRequired || this->stopped;});    
-                                Logger::logInfo("%lu woke up", this);
 
             }
 
@@ -247,8 +245,7 @@ namespace claid
                 std::vector<ScheduledRunnable> dueRunnables;
                 while(!stopped)
                 {
-                    Logger::logInfo("Blablabla");
-                    middlewareAcquireWakeLock();
+                    this->wakeCoordinator->onDispatcherBusy(this->wakeCoordinatorDispatcherId);
                     do
                     {
                         // While we process runnables, it is possible
@@ -262,46 +259,11 @@ namespace claid
                     while(dueRunnables.size() != 0);
 
                     rescheduleRequired = false;
-                    middlewareReleaseWakeLock();
                     waitUntilRunnableIsDueOrRescheduleIsRequired();
                 }
                 Logger::logInfo("RunnableDispatcher shutdown.");
             }
 
-            RuntimeType getRuntimeType()
-            {
-                RuntimeType type;
-                type.set_runtime(RUNTIME_CPP);
-                return type;
-            }
-
-            void middlewareAcquireWakeLock()
-            {
-                if(this->remoteFunctionHandler == nullptr)
-                {
-                    return;
-                }
-                middlewareFuncAcquireWakeLock.execute(getRuntimeType());
-            }
-
-            void middlewareReleaseWakeLock()
-            {
-                if(this->remoteFunctionHandler == nullptr)
-                {
-                    return;
-                }
-                middlewareFuncReleaseWakeLock.execute(getRuntimeType());
-            }
-
-            void middlewareScheduleDeviceWakeupAt(int64_t milliseconds)
-            {
-                if(this->remoteFunctionHandler == nullptr)
-                {
-                    return;
-                }
-                middlewareFuncScheduleDeviceWakeUpAt.execute(getRuntimeType(), milliseconds);
-            }
-
         public:
 
             RunnableDispatcher() : stopped(true)
@@ -311,14 +273,13 @@ namespace claid
 
             void setRemoteFunctionHandler(RemoteFunctionHandler* remoteFunctionHandler)
             {
-                this->middlewareFuncAcquireWakeLock = 
-                    remoteFunctionHandler->mapRuntimeFunction<void, RuntimeType>(Runtime::MIDDLEWARE_CORE, "acquire_wakelock");
-
-                this->middlewareFuncReleaseWakeLock = 
-                    remoteFunctionHandler->mapRuntimeFunction<void, RuntimeType>(Runtime::MIDDLEWARE_CORE, "release_wakelock");
+                this->remoteFunctionHandler = remoteFunctionHandler;
+            }
 
-                this->middlewareFuncScheduleDeviceWakeUpAt = 
-                    remoteFunctionHandler->mapRuntimeFunction<void, RuntimeType, int64_t>(Runtime::MIDDLEWARE_CORE, "schedule_device_wakeup_at");
+            // Has to be set before start(). If no WakeCoordinator was set, the RunnableDispatcher uses its own one.
+            void setWakeCoordinator(std::shared_ptr<WakeCoordinator> wakeCoordinator)
+            {
+                this->wakeCoordinator = wakeCoordinator;
             }
 
             bool start()
@@ -328,6 +289,14 @@ namespace claid
                     return false;
                 }
 
+                if(this->wakeCoordinator == nullptr)
+                {
+                    this->wakeCoordinator = std::make_shared<WakeCoordinator>();
+                    this->wakeCoordinator->start();
+                }
+                this->wakeCoordinator->setRemoteFunctionHandler(this->remoteFunctionHandler);
+                this->wakeCoordinatorDispatcherId = this->wakeCoordinator->registerDispatcher();
+
                 this->stopped = false;
                 this->thread = std::thread(&RunnableDispatcher::runScheduling, this);
 
@@ -344,6 +313,7 @@ namespace claid
                 this->stopped = true;
                 this->conditionVariable.notify_all();
                 this->thread.join();
+                this->wakeCoordinator->unregisterDispatcher(this->wakeCoordinatorDispatcherId);
                 return true;
             }
 
@@ -0,0 +1,285 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/Module/RunnableDispatcherThread/WakeCoordinator.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+namespace claid
+{
+    WakeCoordinator::WakeCoordinator(const Duration& hysteresis) : hysteresis(hysteresis)
+    {
+
+    }
+
+    WakeCoordinator::~WakeCoordinator()
+    {
+        this->stop();
+    }
+
+    // The release thread calls the virtual middleware functions, hence it must not be started
+    // from the constructor, where derived classes are not constructed yet.
+    void WakeCoordinator::start()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(this->releaseThread.joinable())
+        {
+            return;
+        }
+        this->stopped = false;
+        this->releaseThread = std::thread(&WakeCoordinator::runReleaseThread, this);
+    }
+
+    void WakeCoordinator::stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if(!this->releaseThread.joinable())
+            {
+                return;
+            }
+            this->stopped = true;
+        }
+        this->conditionVariable.notify_all();
+        this->releaseThread.join();
+    }
+
+    void WakeCoordinator::setRemoteFunctionHandler(RemoteFunctionHandler* remoteFunctionHandler)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(remoteFunctionHandler == nullptr || this->remoteFunctionHandler == remoteFunctionHandler)
+        {
+            return;
+        }
+        this->remoteFunctionHandler = remoteFunctionHandler;
+
+        this->middlewareFuncAcquireWakeLock = 
+            remoteFunctionHandler->mapRuntimeFunction<void, RuntimeType>(Runtime::MIDDLEWARE_CORE, "acquire_wakelock");
+
+        this->middlewareFuncReleaseWakeLock = 
+            remoteFunctionHandler->mapRuntimeFunction<void, RuntimeType>(Runtime::MIDDLEWARE_CORE, "release_wakelock");
+
+        this->middlewareFuncScheduleDeviceWakeUpAt = 
+            remoteFunctionHandler->mapRuntimeFunction<void, RuntimeType, int64_t>(Runtime::MIDDLEWARE_CORE, "schedule_device_wakeup_at");
+    }
+
+    uint64_t WakeCoordinator::registerDispatcher()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        uint64_t dispatcherId = this->nextDispatcherId++;
+        this->dispatchers[dispatcherId] = DispatcherState();
+        return dispatcherId;
+    }
+
+    void WakeCoordinator::unregisterDispatcher(uint64_t dispatcherId)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        auto it = this->dispatchers.find(dispatcherId);
+        if(it == this->dispatchers.end())
+        {
+            return;
+        }
+        if(it->second.busy)
+        {
+            this->numBusyDispatchers--;
+        }
+        this->dispatchers.erase(it);
+        this->updateAggregateState();
+    }
+
+    void WakeCoordinator::onDispatcherBusy(uint64_t dispatcherId)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        auto it = this->dispatchers.find(dispatcherId);
+        if(it == this->dispatchers.end() || it->second.busy)
+        {
+            return;
+        }
+        this->numStateUpdates++;
+        it->second.busy = true;
+        this->numBusyDispatchers++;
+        this->updateAggregateState();
+    }
+
+    void WakeCoordinator::onDispatcherIdle(uint64_t dispatcherId, const Time& nextDeadline)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        auto it = this->dispatchers.find(dispatcherId);
+        if(it == this->dispatchers.end())
+        {
+            return;
+        }
+        this->numStateUpdates++;
+        if(it->second.busy)
+        {
+            it->second.busy = false;
+            this->numBusyDispatchers--;
+        }
+        it->second.nextDeadline = nextDeadline;
+        this->updateAggregateState();
+    }
+
+    // Deadlines before notBefore are ignored. A dispatcher with an overdue Runnable reports itself busy
+    // once it processes the Runnable, hence such a deadline neither keeps the wake lock nor needs a device wakeup.
+    Time WakeCoordinator::getEarliestDeadline(const Time& notBefore) const
+    {
+        Time earliestDeadline = Time::eternity();
+        for(const auto& entry : this->dispatchers)
+        {
+            if(entry.second.nextDeadline < earliestDeadline && !(entry.second.nextDeadline < notBefore))
+            {
+                earliestDeadline = entry.second.nextDeadline;
+            }
+        }
+        return earliestDeadline;
+    }
+
+    // Has to be called with the mutex locked.
+    void WakeCoordinator::updateAggregateState()
+    {
+        if(this->numBusyDispatchers > 0)
+        {
+            this->releasePending = false;
+            if(!this->wakeLockHeld)
+            {
+                this->middlewareAcquireWakeLock();
+                this->wakeLockHeld = true;
+            }
+            // Deadlines of idle dispatchers will be considered once all dispatchers are idle.
+            return;
+        }
+
+        if(!this->wakeLockHeld)
+        {
+            this->scheduleDeviceWakeupIfChanged(this->getEarliestDeadline(Time::now()));
+            return;
+        }
+
+        // All dispatchers are idle, the wake lock is released by the release thread after the hysteresis duration.
+        this->releasePending = true;
+        this->releaseTime = Time::now() + this->hysteresis;
+        this->conditionVariable.notify_all();
+    }
+
+    // Has to be called with the mutex locked.
+    void WakeCoordinator::scheduleDeviceWakeupIfChanged(const Time& earliestDeadline)
+    {
+        if(earliestDeadline == Time::eternity())
+        {
+            return;
+        }
+        int64_t timestamp = static_cast<int64_t>(earliestDeadline.toUnixTimestampMilliseconds());
+        if(timestamp != this->scheduledWakeupTimestamp)
+        {
+            this->middlewareScheduleDeviceWakeupAt(timestamp);
+            this->scheduledWakeupTimestamp = timestamp;
+        }
+    }
+
+    void WakeCoordinator::runReleaseThread()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while(!this->stopped)
+        {
+            if(!this->releasePending)
+            {
+                this->conditionVariable.wait(lock, [&]{return this->stopped || this->releasePending;});
+                continue;
+            }
+
+            const Time releaseTime = this->releaseTime;
+            this->conditionVariable.wait_until(lock, releaseTime, [&]{return this->stopped || !this->releasePending || this->releaseTime != releaseTime;});
+            if(this->stopped || !this->releasePending || this->numBusyDispatchers > 0 || Time::now() < this->releaseTime)
+            {
+                continue;
+            }
+
+            const Time now = Time::now();
+            const Time earliestDeadline = this->getEarliestDeadline(now);
+            if(earliestDeadline != Time::eternity() && earliestDeadline < now + this->hysteresis)
+            {
+                // Next Runnable is due shortly, not worth releasing the wake lock.
+                this->releaseTime = now + this->hysteresis;
+                continue;
+            }
+
+            // Schedule the wakeup before releasing the wake lock, so the device does not go to sleep without a scheduled wakeup.
+            this->scheduleDeviceWakeupIfChanged(earliestDeadline);
+            this->middlewareReleaseWakeLock();
+            this->wakeLockHeld = false;
+            this->releasePending = false;
+        }
+    }
+
+    RuntimeType WakeCoordinator::getRuntimeType() const
+    {
+        RuntimeType type;
+        type.set_runtime(RUNTIME_CPP);
+        return type;
+    }
+
+    void WakeCoordinator::middlewareAcquireWakeLock()
+    {
+        this->numControlMessages++;
+        if(this->remoteFunctionHandler == nullptr)
+        {
+            return;
+        }
+        this->middlewareFuncAcquireWakeLock.execute(getRuntimeType());
+    }
+
+    void WakeCoordinator::middlewareReleaseWakeLock()
+    {
+        this->numControlMessages++;
+        if(this->remoteFunctionHandler == nullptr)
+        {
+            return;
+        }
+        this->middlewareFuncReleaseWakeLock.execute(getRuntimeType());
+    }
+
+    void WakeCoordinator::middlewareScheduleDeviceWakeupAt(int64_t milliseconds)
+    {
+        this->numControlMessages++;
+        if(this->remoteFunctionHandler == nullptr)
+        {
+            return;
+        }
+        this->middlewareFuncScheduleDeviceWakeUpAt.execute(getRuntimeType(), milliseconds);
+    }
+
+    bool WakeCoordinator::isWakeLockHeld()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->wakeLockHeld;
+    }
+
+    uint64_t WakeCoordinator::getNumControlMessages()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->numControlMessages;
+    }
+
+    uint64_t WakeCoordinator::getNumStateUpdates()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->numStateUpdates;
+    }
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "dispatch/core/Utilities/Time.hh"
+#include "dispatch/core/Module/TypeMapping/Mutator.hh"
+#include "dispatch/core/Module/TypeMapping/TypeMapping.hh"
+#include "dispatch/core/RemoteFunction/RemoteFunction.hh"
+#include "dispatch/core/RemoteFunction/RemoteFunctionHandler.hh"
+
+using namespace claidservice;
+
+namespace claid
+{
+    // Coordinates wake locks and device wakeups of all RunnableDispatchers of a Runtime.
+    // Instead of each RunnableDispatcher calling acquire_wakelock, release_wakelock and schedule_device_wakeup_at
+    // of the GlobalDeviceScheduler on every iteration of its scheduling loop, the dispatchers only report to the
+    // WakeCoordinator whether they are busy and when their next Runnable is due.
+    // The WakeCoordinator aggregates the state of all dispatchers and only calls the GlobalDeviceScheduler if the
+    // aggregate state changes (edge-triggered):
+    //  - A wake lock is acquired when the first dispatcher becomes busy.
+    //  - Hysteresis: the wake lock is only released once all dispatchers have been idle for the hysteresis duration,
+    //    and the earliest deadline of all dispatchers is further away than that. Hence, a host processing messages in
+    //    bursts keeps the wake lock instead of acquiring and releasing it for each message.
+    //  - When releasing the wake lock, a device wakeup is scheduled for the earliest deadline, but only if that deadline changed.
+    class WakeCoordinator
+    {
+        private:
+            struct DispatcherState
+            {
+                bool busy = false;
+                Time nextDeadline = Time::eternity();
+            };
+
+            std::mutex mutex;
+            std::condition_variable conditionVariable;
+            // Releases the wake lock once the hysteresis duration passed.
+            std::thread releaseThread;
+            bool stopped = false;
+            bool releasePending = false;
+            Time releaseTime;
+            std::map<uint64_t, DispatcherState> dispatchers;
+            uint64_t nextDispatcherId = 1;
+            size_t numBusyDispatchers = 0;
+
+            Duration hysteresis;
+
+            bool wakeLockHeld = false;
+            // Unix timestamp (ms) of the device wakeup we scheduled last, -1 if none.
+            int64_t scheduledWakeupTimestamp = -1;
+
+            // Number of calls to the GlobalDeviceScheduler and number of state updates of dispatchers, used for benchmarking.
+            uint64_t numControlMessages = 0;
+            uint64_t numStateUpdates = 0;
+
+            RemoteFunctionHandler* remoteFunctionHandler = nullptr;
+            RemoteFunction<void> middlewareFuncAcquireWakeLock;
+            RemoteFunction<void> middlewareFuncReleaseWakeLock;
+            RemoteFunction<void> middlewareFuncScheduleDeviceWakeUpAt;
+
+            Time getEarliestDeadline(const Time& notBefore) const;
+            void updateAggregateState();
+            void scheduleDeviceWakeupIfChanged(const Time& earliestDeadline);
+            void runReleaseThread();
+
+        protected:
+            RuntimeType getRuntimeType() const;
+
+            virtual void middlewareAcquireWakeLock();
+            virtual void middlewareReleaseWakeLock();
+            virtual void middlewareScheduleDeviceWakeupAt(int64_t milliseconds);
+
+        public:
+            WakeCoordinator(const Duration& hysteresis = Duration::milliseconds(1000));
+            virtual ~WakeCoordinator();
+
+            // Starts the thread releasing the wake lock. Has to be called after construction, before dispatchers are registered.
+            void start();
+            // Derived classes overriding the middleware functions have to call stop() in their destructor.
+            void stop();
+
+            void setRemoteFunctionHandler(RemoteFunctionHandler* remoteFunctionHandler);
+
+            uint64_t registerDispatcher();
+            void unregisterDispatcher(uint64_t dispatcherId);
+
+            // Called by a RunnableDispatcher before it starts processing due Runnables.
+            void onDispatcherBusy(uint64_t dispatcherId);
+            // Called by a RunnableDispatcher before it goes to sleep until its next Runnable is due (Time::eternity() if none).
+            void onDispatcherIdle(uint64_t dispatcherId, const Time& nextDeadline);
+
+            bool isWakeLockHeld();
+            uint64_t getNumControlMessages();
+            uint64_t getNumStateUpdates();
+    };
+}
@@ -21,6 +21,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "AbstractSubscriber.hh"
 #include "dispatch/core/Module/RunnableDispatcherThread/RunnableDispatcher.hh"
 #include "dispatch/core/Module/RunnableDispatcherThread/FunctionRunnableWithParams.hh"
@@ -41,6 +44,26 @@ namespace claid{
         RunnableDispatcher& callbackDispatcher;
 
         Mutator<T> mutator;
+
+        // Data of the previous package. Once the callback (and everyone else) released it, 
+        // the next package is decoded into it, which reuses the memory of vectors, strings, maps or repeated fields.
+        std::shared_ptr<T> recycledData;
+        std::mutex recycledDataMutex;
+
+        std::shared_ptr<T> getDecodeBuffer()
+        {
+            std::lock_guard<std::mutex> lock(this->recycledDataMutex);
+            if(this->recycledData == nullptr || this->recycledData.use_count() != 1)
+            {
+                this->recycledData = std::make_shared<T>();
+            }
+            else
+            {
+                // Synchronizes with the release of the last other reference.
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            return this->recycledData;
+        }
             
     public:
         Subscriber(std::function<void(ChannelData<T>)> callback, 
@@ -70,9 +93,20 @@ namespace claid{
 
         void onNewData(std::shared_ptr<DataPackage> package) override final
         {
-            std::shared_ptr<T> data = std::make_shared<T>();
+            std::shared_ptr<T> data = getDecodeBuffer();
 
-            this->mutator.getPackagePayload(*package, *data);
+            // Called by the reader thread of the ModuleManager, which must not be terminated by a single invalid package.
+            // Decoding fails, e.g., if the payload was stored in a shared memory segment whose lease expired before the package arrived.
+            try
+            {
+                this->mutator.getPackagePayload(*package, *data);
+            }
+            catch(const std::exception& e)
+            {
+                Logger::logError("Dropping package on channel \"%s\" for Module \"%s\", failed to decode its payload: %s",
+                    package->channel().c_str(), package->target_module().c_str(), e.what());
+                return;
+            }
 
             // Create a new copy of the data so we can take ownership.
             ChannelData<T> channelData(data, Time::fromUnixTimestampMilliseconds(package->unix_timestamp_ms()), package->source_user_token());
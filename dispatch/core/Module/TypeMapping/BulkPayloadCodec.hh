@@ -0,0 +1,325 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+
+namespace claid
+{
+    // Reads and writes the wire format of NumberArray, NumberMap and StringMap directly from/to C++ containers,
+    // without building the intermediate protobuf message (and its RepeatedField or Map).
+    // The encoders produce the same bytes as the protobuf serialization. 
+    // The decoders only handle the canonical encoding (e.g., a single packed field for NumberArray) and return false otherwise,
+    // in which case the caller has to fall back to regular parsing.
+    namespace BulkPayloadCodec
+    {
+        using google::protobuf::io::CodedInputStream;
+        using google::protobuf::io::CodedOutputStream;
+
+        // Field 1 (val), wire type 2 (length delimited): packed repeated double, or map entry.
+        static constexpr uint32_t VAL_TAG = (1 << 3) | 2;
+        static constexpr uint32_t MAP_KEY_TAG = (1 << 3) | 2;
+        static constexpr uint32_t MAP_DOUBLE_VALUE_TAG = (2 << 3) | 1;
+        static constexpr uint32_t MAP_STRING_VALUE_TAG = (2 << 3) | 2;
+
+        inline uint8_t* writeVarint(uint32_t value, uint8_t* target)
+        {
+            return CodedOutputStream::WriteVarint32ToArray(value, target);
+        }
+
+        inline uint8_t* writeDouble(double value, uint8_t* target)
+        {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return CodedOutputStream::WriteLittleEndian64ToArray(bits, target);
+        }
+
+        inline double readDouble(const uint8_t* source)
+        {
+            uint64_t bits;
+            CodedInputStream::ReadLittleEndian64FromArray(source, &bits);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        inline uint8_t* writeString(uint32_t tag, const std::string& value, uint8_t* target)
+        {
+            target = writeVarint(tag, target);
+            target = writeVarint(static_cast<uint32_t>(value.size()), target);
+            memcpy(target, value.data(), value.size());
+            return target + value.size();
+        }
+
+        inline size_t stringFieldSize(const std::string& value)
+        {
+            return 1 + CodedOutputStream::VarintSize32(static_cast<uint32_t>(value.size())) + value.size();
+        }
+
+        inline constexpr bool isLittleEndian()
+        {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // NumberArray
+        template<typename Value>
+        void encodeNumberArray(const Value* values, size_t size, std::string& output)
+        {
+            output.clear();
+            if(size == 0)
+            {
+                return;
+            }
+
+            const uint32_t numBytes = static_cast<uint32_t>(size * sizeof(double));
+            output.resize(1 + CodedOutputStream::VarintSize32(numBytes) + numBytes);
+
+            uint8_t* target = reinterpret_cast<uint8_t*>(&output[0]);
+            target = writeVarint(VAL_TAG, target);
+            target = writeVarint(numBytes, target);
+
+            if(std::is_same<Value, double>::value && isLittleEndian())
+            {
+                memcpy(target, values, numBytes);
+                return;
+            }
+
+            for(size_t i = 0; i < size; i++)
+            {
+                target = writeDouble(static_cast<double>(values[i]), target);
+            }
+        }
+
+        template<typename Value>
+        bool decodeNumberArray(const char* data, size_t size, std::vector<Value>& values)
+        {
+            if(size == 0)
+            {
+                values.clear();
+                return true;
+            }
+
+            CodedInputStream input(reinterpret_cast<const uint8_t*>(data), static_cast<int>(size));
+            uint32_t numBytes;
+            if(input.ReadTag() != VAL_TAG || !input.ReadVarint32(&numBytes) || numBytes % sizeof(double) != 0 
+                || static_cast<size_t>(input.CurrentPosition()) + numBytes != size)
+            {
+                return false;
+            }
+
+            const uint8_t* source = reinterpret_cast<const uint8_t*>(data) + input.CurrentPosition();
+            const size_t numValues = numBytes / sizeof(double);
+            values.resize(numValues);
+
+            if(std::is_same<Value, double>::value && isLittleEndian())
+            {
+                memcpy(values.data(), source, numBytes);
+                return true;
+            }
+
+            for(size_t i = 0; i < numValues; i++)
+            {
+                values[i] = static_cast<Value>(readDouble(source + i * sizeof(double)));
+            }
+            return true;
+        }
+
+        // NumberMap, StringMap
+        inline size_t mapValueFieldSize(double)
+        {
+            return 1 + sizeof(double);
+        }
+
+        inline size_t mapValueFieldSize(const std::string& value)
+        {
+            return stringFieldSize(value);
+        }
+
+        inline uint8_t* writeMapValue(double value, uint8_t* target)
+        {
+            target = writeVarint(MAP_DOUBLE_VALUE_TAG, target);
+            return writeDouble(value, target);
+        }
+
+        inline uint8_t* writeMapValue(const std::string& value, uint8_t* target)
+        {
+            return writeString(MAP_STRING_VALUE_TAG, value, target);
+        }
+
+        inline bool readMapValue(CodedInputStream& input, uint32_t tag, double& value)
+        {
+            uint64_t bits;
+            if(tag != MAP_DOUBLE_VALUE_TAG || !input.ReadLittleEndian64(&bits))
+            {
+                return false;
+            }
+            memcpy(&value, &bits, sizeof(value));
+            return true;
+        }
+
+        inline bool readMapValue(CodedInputStream& input, uint32_t tag, std::string& value)
+        {
+            uint32_t length;
+            return tag == MAP_STRING_VALUE_TAG && input.ReadVarint32(&length) && input.ReadString(&value, static_cast<int>(length));
+        }
+
+        // Values of NumberMaps are sent as double, values of StringMaps as string.
+        template<typename Value>
+        using MapWireValue = typename std::conditional<std::is_arithmetic<Value>::value, double, std::string>::type;
+
+        template<typename Value>
+        void encodeMap(const std::map<std::string, Value>& map, std::string& output)
+        {
+            typedef MapWireValue<Value> WireValue;
+
+            size_t totalSize = 0;
+            for(const auto& pair : map)
+            {
+                const WireValue& value = static_cast<const WireValue&>(pair.second);
+                const size_t entrySize = stringFieldSize(pair.first) + mapValueFieldSize(value);
+                totalSize += 1 + CodedOutputStream::VarintSize32(static_cast<uint32_t>(entrySize)) + entrySize;
+            }
+
+            output.resize(totalSize);
+            uint8_t* target = reinterpret_cast<uint8_t*>(&output[0]);
+            for(const auto& pair : map)
+            {
+                const WireValue& value = static_cast<const WireValue&>(pair.second);
+                const size_t entrySize = stringFieldSize(pair.first) + mapValueFieldSize(value);
+                target = writeVarint(VAL_TAG, target);
+                target = writeVarint(static_cast<uint32_t>(entrySize), target);
+                target = writeString(MAP_KEY_TAG, pair.first, target);
+                target = writeMapValue(value, target);
+            }
+        }
+
+        // Calls onEntry(key, value) for every entry. Fields of an entry may appear in any order or be omitted (default value).
+        template<typename WireValue, typename Callback>
+        bool forEachMapEntry(const char* data, size_t size, std::string& key, WireValue& value, Callback onEntry)
+        {
+            CodedInputStream input(reinterpret_cast<const uint8_t*>(data), static_cast<int>(size));
+            while(!input.ExpectAtEnd())
+            {
+                uint32_t entrySize;
+                if(input.ReadTag() != VAL_TAG || !input.ReadVarint32(&entrySize))
+                {
+                    return false;
+                }
+
+                CodedInputStream::Limit limit = input.PushLimit(static_cast<int>(entrySize));
+                key.clear();
+                value = WireValue();
+                while(input.BytesUntilLimit() > 0)
+                {
+                    const uint32_t tag = input.ReadTag();
+                    if(tag == MAP_KEY_TAG)
+                    {
+                        uint32_t length;
+                        if(!input.ReadVarint32(&length) || !input.ReadString(&key, static_cast<int>(length)))
+                        {
+                            return false;
+                        }
+                    }
+                    else if(!readMapValue(input, tag, value))
+                    {
+                        return false;
+                    }
+                }
+                input.PopLimit(limit);
+
+                if(!onEntry(key, value))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Whether all keys were matched exactly once, i.e., none of the keys of the map kept a stale value.
+        inline bool allKeysMatched(std::vector<const std::string*>& matchedKeys, size_t mapSize, bool matchedInOrder)
+        {
+            if(matchedKeys.size() != mapSize)
+            {
+                return false;
+            }
+            // Keys matched in ascending order are distinct (entries are usually encoded in the order of the map).
+            if(matchedInOrder)
+            {
+                return true;
+            }
+            // Keys of the map are unique, hence equal keys were matched by the same node.
+            std::sort(matchedKeys.begin(), matchedKeys.end());
+            return std::adjacent_find(matchedKeys.begin(), matchedKeys.end()) == matchedKeys.end();
+        }
+
+        // If the map already contains exactly the received keys (e.g., the same features in every message),
+        // the values are updated in place and no map nodes are allocated. Otherwise, the map is rebuilt.
+        template<typename Value>
+        bool decodeMap(const char* data, size_t size, std::map<std::string, Value>& map)
+        {
+            typedef MapWireValue<Value> WireValue;
+            std::string key;
+            WireValue value;
+
+            // Entries might be repeated on the wire (the last one wins), hence the matched keys are tracked instead of counted.
+            static thread_local std::vector<const std::string*> matchedKeys;
+            matchedKeys.clear();
+            bool matchedInOrder = true;
+            bool updatedInPlace = forEachMapEntry(data, size, key, value, [&](const std::string& key, WireValue& value)
+            {
+                auto it = map.find(key);
+                if(it == map.end() || matchedKeys.size() == map.size())
+                {
+                    return false;
+                }
+                it->second = static_cast<Value>(std::move(value));
+                matchedInOrder = matchedInOrder && (matchedKeys.empty() || *matchedKeys.back() < it->first);
+                matchedKeys.push_back(&it->first);
+                return true;
+            });
+
+            if(updatedInPlace && allKeysMatched(matchedKeys, map.size(), matchedInOrder))
+            {
+                return true;
+            }
+
+            map.clear();
+            return forEachMapEntry(data, size, key, value, [&](const std::string& key, WireValue& value)
+            {
+                map[key] = static_cast<Value>(std::move(value));
+                return true;
+            });
+        }
+    }
+}
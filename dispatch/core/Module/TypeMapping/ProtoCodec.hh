@@ -31,6 +31,7 @@
 
 
 #include "dispatch/core/Logger/Logger.hh"
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
 #include "dispatch/proto/claidservice.pb.h"
 
 using claidservice::Blob;
@@ -67,25 +68,31 @@ public:
 
 
 
-    bool encode(const google::protobuf::Message* protoMessage, Blob& returnBlob) 
+    // Comparing the descriptors avoids comparing the names for every message.
+    bool hasType(const google::protobuf::Message* message) const
     {
-        const std::string name = protoMessage->GetDescriptor()->full_name();
-        if(name != fullName)
+        const google::protobuf::Descriptor* descriptor = message->GetDescriptor();
+        return msg != nullptr && (descriptor == msg->GetDescriptor() || descriptor->full_name() == fullName);
+    }
+
+    bool encode(const google::protobuf::Message* protoMessage, Blob& returnBlob) const
+    {
+        if(!hasType(protoMessage))
         {
             return false;
         }
 
-        std::string serializedData = protoMessage->SerializeAsString();
+        // Serialize directly into the Blob instead of copying a temporary string.
+        protoMessage->SerializeToString(returnBlob.mutable_payload());
 
         returnBlob.set_codec(Codec::CODEC_PROTO);
-        returnBlob.set_payload(serializedData);
 
         returnBlob.set_message_type(fullName);
 
         return true;
     }
 
-    bool decode(const Blob& blob, google::protobuf::Message* returnValue) 
+    bool decode(const Blob& blob, google::protobuf::Message* returnValue) const
     {
         if(returnValue == nullptr)
         {
@@ -93,15 +100,15 @@ public:
             return false;
         }
      
-        const std::string name = returnValue->GetDescriptor()->full_name();
-        if(name != fullName)
+        if(!hasType(returnValue))
         {
             return false;
         }
         try 
         {
 
-            if (!returnValue->ParseFromString(blob.payload())) 
+            // The payload might be stored in shared memory, if it was offloaded by the LargePayloadStore.
+            if (!LargePayloadStore::parseBlobPayload(blob, *returnValue)) 
             {
                 Logger::logError("Failed to parse protobuf message of type. ParseFromString failed.");
                 return false;
@@ -117,7 +124,7 @@ public:
         }
     }
 
-    std::shared_ptr<google::protobuf::Message> decodeIntoNewInstance(const Blob& blob)
+    std::shared_ptr<google::protobuf::Message> decodeIntoNewInstance(const Blob& blob) const
     {
         if(this->msg == nullptr)
         {
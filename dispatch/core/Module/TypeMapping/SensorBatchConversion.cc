@@ -0,0 +1,120 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/Module/TypeMapping/SensorBatchConversion.hh"
+
+#include "absl/strings/str_cat.h"
+#include "dispatch/core/Module/TypeMapping/SensorColumns.hh"
+
+namespace claid
+{
+    template<typename Data, typename Batch>
+    static absl::Status samplesToBatch(const Data& data, Batch& batch)
+    {
+        typedef ThreeAxisSensorTraits<Data> Axes;
+        batch.Clear();
+        const int numSamples = data.samples_size();
+        if(numSamples == 0)
+        {
+            return absl::OkStatus();
+        }
+
+        const auto& firstSample = data.samples(0);
+        batch.set_sensor_body_location(firstSample.sensor_body_location());
+        batch.set_effective_time_frame(firstSample.effective_time_frame());
+        batch.set_first_unix_timestamp_in_ms(firstSample.unix_timestamp_in_ms());
+
+        batch.mutable_x()->Resize(numSamples, 0.0);
+        batch.mutable_y()->Resize(numSamples, 0.0);
+        batch.mutable_z()->Resize(numSamples, 0.0);
+        batch.mutable_timestamp_deltas_in_ms()->Resize(numSamples, 0);
+        double* x = batch.mutable_x()->mutable_data();
+        double* y = batch.mutable_y()->mutable_data();
+        double* z = batch.mutable_z()->mutable_data();
+        int64_t* deltas = batch.mutable_timestamp_deltas_in_ms()->mutable_data();
+
+        uint64_t previousTimestamp = firstSample.unix_timestamp_in_ms();
+        for(int i = 0; i < numSamples; i++)
+        {
+            const auto& sample = data.samples(i);
+            if(sample.sensor_body_location() != batch.sensor_body_location() || sample.effective_time_frame() != batch.effective_time_frame())
+            {
+                return absl::InvalidArgumentError(absl::StrCat(
+                    "Cannot convert ", data.GetDescriptor()->name(), " to ", batch.GetDescriptor()->name(), ". Sample ", i, 
+                    " has sensor_body_location \"", sample.sensor_body_location(), "\" and effective_time_frame \"", sample.effective_time_frame(), 
+                    "\", but the first sample has \"", batch.sensor_body_location(), "\" and \"", batch.effective_time_frame(), "\"."));
+            }
+
+            x[i] = Axes::x(sample);
+            y[i] = Axes::y(sample);
+            z[i] = Axes::z(sample);
+            deltas[i] = static_cast<int64_t>(sample.unix_timestamp_in_ms() - previousTimestamp);
+            previousTimestamp = sample.unix_timestamp_in_ms();
+        }
+        return absl::OkStatus();
+    }
+
+    template<typename Data, typename Batch>
+    static void batchToSamples(const Batch& batch, Data& data)
+    {
+        typedef ThreeAxisSensorTraits<Data> Axes;
+        data.Clear();
+        const int numSamples = batch.x_size();
+        data.mutable_samples()->Reserve(numSamples);
+
+        uint64_t timestamp = batch.first_unix_timestamp_in_ms();
+        for(int i = 0; i < numSamples; i++)
+        {
+            auto* sample = data.add_samples();
+            Axes::set(*sample, batch.x(i), 
+                i < batch.y_size() ? batch.y(i) : 0.0, 
+                i < batch.z_size() ? batch.z(i) : 0.0);
+
+            if(i < batch.timestamp_deltas_in_ms_size())
+            {
+                timestamp += static_cast<uint64_t>(batch.timestamp_deltas_in_ms(i));
+            }
+            sample->set_unix_timestamp_in_ms(timestamp);
+            sample->set_sensor_body_location(batch.sensor_body_location());
+            sample->set_effective_time_frame(batch.effective_time_frame());
+        }
+    }
+
+    absl::Status SensorBatchConversion::toBatch(const AccelerationData& data, AccelerationBatch& batch)
+    {
+        return samplesToBatch(data, batch);
+    }
+
+    absl::Status SensorBatchConversion::toBatch(const GyroscopeData& data, GyroscopeBatch& batch)
+    {
+        return samplesToBatch(data, batch);
+    }
+
+    void SensorBatchConversion::fromBatch(const AccelerationBatch& batch, AccelerationData& data)
+    {
+        batchToSamples(batch, data);
+    }
+
+    void SensorBatchConversion::fromBatch(const GyroscopeBatch& batch, GyroscopeData& data)
+    {
+        batchToSamples(batch, data);
+    }
+}
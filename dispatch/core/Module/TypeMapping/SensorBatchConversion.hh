@@ -0,0 +1,42 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include "absl/status/status.h"
+#include "dispatch/proto/sensor_data_types.pb.h"
+
+namespace claid
+{
+    // Conversion between the per-sample sensor data types (e.g., AccelerationData) and
+    // their columnar counterparts (e.g., AccelerationBatch).
+    class SensorBatchConversion
+    {
+        public:
+            // Fails if the samples do not share the same sensor_body_location and effective_time_frame,
+            // as a batch stores them only once.
+            static absl::Status toBatch(const AccelerationData& data, AccelerationBatch& batch);
+            static absl::Status toBatch(const GyroscopeData& data, GyroscopeBatch& batch);
+
+            static void fromBatch(const AccelerationBatch& batch, AccelerationData& data);
+            static void fromBatch(const GyroscopeBatch& batch, GyroscopeData& data);
+    };
+}
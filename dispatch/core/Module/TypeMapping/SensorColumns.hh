@@ -0,0 +1,197 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <google/protobuf/repeated_field.h>
+
+#include "dispatch/proto/sensor_data_types.pb.h"
+
+namespace claid
+{
+    // Columnar batch of 3-axis sensor samples (e.g., acceleration or gyroscope), which keeps every axis
+    // in a contiguous array and hence allows vectorized signal processing.
+    // Sent and received as the corresponding packed batch message (e.g., AccelerationBatch) by the TypeMapping.
+    template<typename Value, typename BatchMessage>
+    struct ThreeAxisSensorColumns
+    {
+        static_assert(std::is_same<Value, float>::value || std::is_same<Value, double>::value, 
+            "ThreeAxisSensorColumns only supports float and double values.");
+
+        typedef Value value_type;
+        typedef BatchMessage message_type;
+
+        std::vector<Value> x;
+        std::vector<Value> y;
+        std::vector<Value> z;
+        std::vector<uint64_t> unixTimestampsInMs;
+        std::string sensorBodyLocation;
+        std::string effectiveTimeFrame;
+
+        size_t size() const
+        {
+            return x.size();
+        }
+    };
+
+    template<typename Value>
+    using AccelerationColumns = ThreeAxisSensorColumns<Value, AccelerationBatch>;
+
+    template<typename Value>
+    using GyroscopeColumns = ThreeAxisSensorColumns<Value, GyroscopeBatch>;
+
+    // Maps the per-sample 3-axis sensor data types to their samples, axes and columnar batch message.
+    template<typename SensorData>
+    struct ThreeAxisSensorTraits;
+
+    template<>
+    struct ThreeAxisSensorTraits<AccelerationData>
+    {
+        typedef AccelerationSample Sample;
+        typedef AccelerationBatch BatchMessage;
+
+        static double x(const Sample& sample) { return sample.acceleration_x(); }
+        static double y(const Sample& sample) { return sample.acceleration_y(); }
+        static double z(const Sample& sample) { return sample.acceleration_z(); }
+
+        static void set(Sample& sample, double x, double y, double z)
+        {
+            sample.set_acceleration_x(x);
+            sample.set_acceleration_y(y);
+            sample.set_acceleration_z(z);
+        }
+    };
+
+    template<>
+    struct ThreeAxisSensorTraits<GyroscopeData>
+    {
+        typedef GyroscopeSample Sample;
+        typedef GyroscopeBatch BatchMessage;
+
+        static double x(const Sample& sample) { return sample.gyroscope_x(); }
+        static double y(const Sample& sample) { return sample.gyroscope_y(); }
+        static double z(const Sample& sample) { return sample.gyroscope_z(); }
+
+        static void set(Sample& sample, double x, double y, double z)
+        {
+            sample.set_gyroscope_x(x);
+            sample.set_gyroscope_y(y);
+            sample.set_gyroscope_z(z);
+        }
+    };
+
+    namespace SensorColumns
+    {
+        // Copies (and converts, if necessary) a column into a packed repeated field in bulk.
+        template<typename Value>
+        void copyToRepeatedField(const std::vector<Value>& values, google::protobuf::RepeatedField<double>& field)
+        {
+            field.Resize(static_cast<int>(values.size()), 0.0);
+            if constexpr(std::is_same<Value, double>::value)
+            {
+                if(!values.empty())
+                {
+                    memcpy(field.mutable_data(), values.data(), values.size() * sizeof(double));
+                }
+            }
+            else
+            {
+                std::copy(values.begin(), values.end(), field.mutable_data());
+            }
+        }
+
+        template<typename Value>
+        void copyFromRepeatedField(const google::protobuf::RepeatedField<double>& field, std::vector<Value>& values)
+        {
+            values.resize(field.size());
+            if constexpr(std::is_same<Value, double>::value)
+            {
+                if(!values.empty())
+                {
+                    memcpy(values.data(), field.data(), values.size() * sizeof(double));
+                }
+            }
+            else
+            {
+                std::copy(field.begin(), field.end(), values.begin());
+            }
+        }
+
+        inline void encodeTimestamps(const std::vector<uint64_t>& timestamps, uint64_t& firstTimestamp, 
+            google::protobuf::RepeatedField<int64_t>& deltas)
+        {
+            firstTimestamp = timestamps.empty() ? 0 : timestamps[0];
+            deltas.Resize(static_cast<int>(timestamps.size()), 0);
+            int64_t* deltaData = deltas.mutable_data();
+            uint64_t previous = firstTimestamp;
+            for(size_t i = 0; i < timestamps.size(); i++)
+            {
+                deltaData[i] = static_cast<int64_t>(timestamps[i] - previous);
+                previous = timestamps[i];
+            }
+        }
+
+        inline void decodeTimestamps(uint64_t firstTimestamp, const google::protobuf::RepeatedField<int64_t>& deltas, 
+            std::vector<uint64_t>& timestamps)
+        {
+            timestamps.resize(deltas.size());
+            uint64_t timestamp = firstTimestamp;
+            for(int i = 0; i < deltas.size(); i++)
+            {
+                timestamp += static_cast<uint64_t>(deltas.Get(i));
+                timestamps[i] = timestamp;
+            }
+        }
+
+        template<typename Value, typename BatchMessage>
+        void toMessage(const ThreeAxisSensorColumns<Value, BatchMessage>& columns, BatchMessage& batch)
+        {
+            copyToRepeatedField(columns.x, *batch.mutable_x());
+            copyToRepeatedField(columns.y, *batch.mutable_y());
+            copyToRepeatedField(columns.z, *batch.mutable_z());
+
+            uint64_t firstTimestamp;
+            encodeTimestamps(columns.unixTimestampsInMs, firstTimestamp, *batch.mutable_timestamp_deltas_in_ms());
+            batch.set_first_unix_timestamp_in_ms(firstTimestamp);
+
+            batch.set_sensor_body_location(columns.sensorBodyLocation);
+            batch.set_effective_time_frame(columns.effectiveTimeFrame);
+        }
+
+        template<typename Value, typename BatchMessage>
+        void fromMessage(const BatchMessage& batch, ThreeAxisSensorColumns<Value, BatchMessage>& columns)
+        {
+            copyFromRepeatedField(batch.x(), columns.x);
+            copyFromRepeatedField(batch.y(), columns.y);
+            copyFromRepeatedField(batch.z(), columns.z);
+            decodeTimestamps(batch.first_unix_timestamp_in_ms(), batch.timestamp_deltas_in_ms(), columns.unixTimestampsInMs);
+            columns.sensorBodyLocation = batch.sensor_body_location();
+            columns.effectiveTimeFrame = batch.effective_time_frame();
+        }
+    }
+}
@@ -31,6 +31,8 @@
 #include "dispatch/proto/claidservice.pb.h"
 #include "dispatch/core/Module/TypeMapping/ProtoCodec.hh"
 #include "dispatch/core/Module/TypeMapping/AnyProtoType.hh"
+#include "dispatch/core/Module/TypeMapping/BulkPayloadCodec.hh"
+#include "dispatch/core/Module/TypeMapping/SensorColumns.hh"
 
 using namespace claidservice;
 
@@ -64,33 +66,66 @@ namespace claid {
             // return it->second;
         }
 
+        // The codec of a generated message type does not hold any state besides the type, 
+        // hence it is created only once per type instead of for every encode/decode.
+        template<typename T>
+        static const ProtoCodec& getCachedProtoCodec()
+        {
+            static const ProtoCodec protoCodec(makeMessage<typename std::remove_const<T>::type>());
+            return protoCodec;
+        }
+
         template<typename T>
         static bool setProtoPayload(DataPackage& packet, T& protoValue)
         {
-            std::shared_ptr<ProtoCodec> protoCodec = getProtoCodec(&protoValue);
+            const ProtoCodec& protoCodec = getCachedProtoCodec<T>();
 
             Blob& blob = *packet.mutable_payload();
 
-            return protoCodec->encode(static_cast<const google::protobuf::Message*>(&protoValue), blob);
+            return protoCodec.encode(static_cast<const google::protobuf::Message*>(&protoValue), blob);
         }
 
-        template<typename T>
-        static bool getProtoPayload(const DataPackage& packet, T& returnValue)
+        static void checkPayloadType(const DataPackage& packet)
         {
-            std::shared_ptr<ProtoCodec> protoCodec = getProtoCodec(&returnValue);
-
             if(packet.payload().message_type() == "")
             {
                 Logger::logError("Invalid package, unknown payload! Expected payload type to be specified in message_type of Blob, but got \"\"");
                 throw std::invalid_argument("ProtoCodec.decode failed. Wrong payload type.");
             }
+        }
+
+        template<typename T>
+        static bool getProtoPayload(const DataPackage& packet, T& returnValue)
+        {
+            const ProtoCodec& protoCodec = getCachedProtoCodec<T>();
+
+            checkPayloadType(packet);
             
-            if(!protoCodec->decode(packet.payload(), static_cast<google::protobuf::Message*>(&returnValue)))
+            if(!protoCodec.decode(packet.payload(), static_cast<google::protobuf::Message*>(&returnValue)))
             {
                 throw std::invalid_argument("ProtoCodec.decode failed");
             }
             return true;
         }
+
+        // Returns the payload string of the package, to be filled with the serialized ProtoType by the BulkPayloadCodec.
+        template<typename ProtoType>
+        static std::string& getBulkPayloadBuffer(DataPackage& packet)
+        {
+            Blob& blob = *packet.mutable_payload();
+            blob.set_codec(Codec::CODEC_PROTO);
+            blob.set_message_type(ProtoType::descriptor()->full_name());
+            return *blob.mutable_payload();
+        }
+
+        // Passes the serialized payload to the decoder of the BulkPayloadCodec.
+        // Returns false if the payload is not canonically encoded and has to be parsed using getProtoPayload.
+        template<typename Decoder>
+        static bool decodeBulkPayload(const DataPackage& packet, Decoder decoder)
+        {
+            checkPayloadType(packet);
+            return LargePayloadStore::visitBlobPayload(packet.payload(), decoder);
+        }
         
 
     public:
@@ -203,23 +238,22 @@ namespace claid {
                 makeMessage<NumberArray>(),
                 [](DataPackage& packet, const T& array) 
                 { 
-                    NumberArray numberArray;
-                    for(auto number : array)
-                    {
-                        numberArray.add_val(number);
-                    }
-                    setProtoPayload(packet, numberArray);
+                    std::string& payload = getBulkPayloadBuffer<NumberArray>(packet);
+                    BulkPayloadCodec::encodeNumberArray(array.data(), array.size(), payload);
                 },
                 [](const DataPackage& packet, T& returnValue) 
                 { 
+                    if(decodeBulkPayload(packet, [&returnValue](const char* data, size_t size) 
+                        { return BulkPayloadCodec::decodeNumberArray(data, size, returnValue); }))
+                    {
+                        return;
+                    }
+
                     NumberArray numberArray;
                     getProtoPayload(packet, numberArray);
 
-                    returnValue = T(numberArray.val_size());
-                    for (int i = 0; i < numberArray.val_size(); i++) 
-                    {
-                        returnValue[i] = numberArray.val(i);
-                    }
+                    returnValue.resize(numberArray.val_size());
+                    std::copy(numberArray.val().begin(), numberArray.val().end(), returnValue.begin());
                 }
             );
         }
@@ -234,6 +268,7 @@ namespace claid {
                 [](DataPackage& packet, const T& array) 
                 { 
                     StringArray stringArray;
+                    stringArray.mutable_val()->Reserve(static_cast<int>(array.size()));
                     for(const auto& str : array)
                     {
                         stringArray.add_val(str);
@@ -245,7 +280,8 @@ namespace claid {
                     StringArray stringArray;
                     getProtoPayload(packet, stringArray);
 
-                    returnValue = T(stringArray.val_size());
+                    // Assigning to the existing strings reuses their buffers.
+                    returnValue.resize(stringArray.val_size());
                     for (int i = 0; i < stringArray.val_size(); i++) 
                     {
                         returnValue[i] = stringArray.val(i);
@@ -266,15 +302,17 @@ namespace claid {
                 makeMessage<NumberMap>(),
                 [](DataPackage& packet, const T& map) 
                 { 
-                    NumberMap numberMap;
-                    for (const auto& pair : map) 
-                    {
-                        (*numberMap.mutable_val())[pair.first] = pair.second;
-                    }
-                    setProtoPayload(packet, numberMap);
+                    std::string& payload = getBulkPayloadBuffer<NumberMap>(packet);
+                    BulkPayloadCodec::encodeMap(map, payload);
                 },
                 [](const DataPackage& packet, T& returnValue) 
                 { 
+                    if(decodeBulkPayload(packet, [&returnValue](const char* data, size_t size) 
+                        { return BulkPayloadCodec::decodeMap(data, size, returnValue); }))
+                    {
+                        return;
+                    }
+
                     returnValue.clear();
                     NumberMap numberMap;
                     getProtoPayload(packet, numberMap);
@@ -295,15 +333,17 @@ namespace claid {
                 makeMessage<StringMap>(),
                 [](DataPackage& packet, const T& map) 
                 { 
-                    StringMap stringMap;
-                    for (const auto& pair : map) 
-                    {
-                        (*stringMap.mutable_val())[pair.first] = pair.second;
-                    }
-                    setProtoPayload(packet, stringMap);
+                    std::string& payload = getBulkPayloadBuffer<StringMap>(packet);
+                    BulkPayloadCodec::encodeMap(map, payload);
                 },
                 [](const DataPackage& packet, T& returnValue) 
                 { 
+                    if(decodeBulkPayload(packet, [&returnValue](const char* data, size_t size) 
+                        { return BulkPayloadCodec::decodeMap(data, size, returnValue); }))
+                    {
+                        return;
+                    }
+
                     returnValue.clear();
 
                     StringMap stringMap;
@@ -318,6 +358,29 @@ namespace claid {
             );
         }
 
+        // AccelerationColumns, GyroscopeColumns
+        template<typename T>
+        typename std::enable_if<std::is_same<T, ThreeAxisSensorColumns<typename T::value_type, typename T::message_type>>::value, Mutator<T>>::type
+        static getMutator()
+        {
+            typedef typename T::message_type BatchMessage;
+            return Mutator<T>(
+                makeMessage<BatchMessage>(),
+                [](DataPackage& packet, const T& columns) 
+                { 
+                    BatchMessage batch;
+                    SensorColumns::toMessage(columns, batch);
+                    setProtoPayload(packet, batch);
+                },
+                [](const DataPackage& packet, T& returnValue) 
+                { 
+                    BatchMessage batch;
+                    getProtoPayload(packet, batch);
+                    SensorColumns::fromMessage(batch, returnValue);
+                }
+            );
+        }
+
         // // void
         // template<typename T>
         // typename std::enable_if<std::is_same<void, T>::value, Mutator<T>>::type
@@ -429,7 +492,7 @@ namespace claid {
 
                     std::shared_ptr<google::protobuf::Message> msg(protoType->New());
 
-                    if(!msg->ParseFromString(packet.payload().payload()))
+                    if(!LargePayloadStore::parseBlobPayload(packet.payload(), *msg))
                     {
                         throw std::invalid_argument("ProtoCodec.decode failed for AnyProtoType");
                     }
@@ -0,0 +1,268 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/RemoteDispatching/AsyncRemoteClientHandler.hh"
+#include "dispatch/core/RemoteDispatching/AsyncRemoteService.hh"
+#include "dispatch/core/RemoteDispatching/RemoteClientKey.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+using claidservice::CtrlType;
+
+namespace claid
+{
+    AsyncRemoteClientHandler::AsyncRemoteClientHandler(AsyncRemoteService& service,
+        claidservice::ClaidRemoteService::AsyncService& grpcService,
+        grpc::ServerCompletionQueue* completionQueue) :
+            service(service), grpcService(grpcService), completionQueue(completionQueue), stream(&context),
+            connectTag{this, Operation::CONNECT}, readTag{this, Operation::READ},
+            writeTag{this, Operation::WRITE}, finishTag{this, Operation::FINISH}
+    {
+        this->service.onHandlerCreated();
+    }
+
+    AsyncRemoteClientHandler::~AsyncRemoteClientHandler()
+    {
+        this->service.onHandlerDestroyed();
+    }
+
+    void AsyncRemoteClientHandler::start()
+    {
+        this->self = shared_from_this();
+        this->grpcService.RequestSendReceivePackages(&this->context, &this->stream,
+            this->completionQueue, this->completionQueue, &this->connectTag);
+    }
+
+    void AsyncRemoteClientHandler::proceed(Operation operation, bool ok)
+    {
+        switch(operation)
+        {
+            case Operation::CONNECT:
+            {
+                onConnected(ok);
+                break;
+            }
+            case Operation::READ:
+            {
+                // The first package of each client is the handshake package.
+                if(this->registered)
+                {
+                    onRead(ok);
+                }
+                else
+                {
+                    onHandshake(ok);
+                }
+                break;
+            }
+            case Operation::WRITE:
+            {
+                onWriteDone(ok);
+                break;
+            }
+            case Operation::FINISH:
+            {
+                onFinished();
+                break;
+            }
+        }
+    }
+
+    void AsyncRemoteClientHandler::onConnected(bool ok)
+    {
+        if(!ok)
+        {
+            // The server is shutting down, no client will connect to this handler anymore.
+            this->self.reset();
+            return;
+        }
+
+        // Wait for the next client on the same completion queue.
+        std::make_shared<AsyncRemoteClientHandler>(this->service, this->grpcService, this->completionQueue)->start();
+
+        // The first package sent by the connected client should be a control package 
+        // which includes the RemoteClientInfo of the client as payload.
+        this->stream.Read(&this->incomingPackage, &this->readTag);
+    }
+
+    void AsyncRemoteClientHandler::onHandshake(bool ok)
+    {
+        std::unique_lock<std::mutex> lock(this->handlerMutex);
+        if(!ok)
+        {
+            finish(grpc::Status(grpc::CANCELLED, "Unable to read input package from RemoteDispatcherClient!"));
+            return;
+        }
+
+        auto ctrlType = this->incomingPackage.control_val().ctrl_type();
+        if(ctrlType != CtrlType::CTRL_REMOTE_PING)
+        {
+            finish(grpc::Status(grpc::INVALID_ARGUMENT, 
+                absl::StrCat("Runtime init failed. Expected control package with type CTRL_REMOTE_PING, but got: \"",
+                claidservice::CtrlType_Name(ctrlType), "\"")));
+            return;
+        }
+
+        this->remoteClientInfo = this->incomingPackage.control_val().remote_client_info();
+
+        absl::Status status = this->service.registerRemoteClient(shared_from_this(), this->incomingQueue, this->outgoingQueue);
+        if(!status.ok())
+        {
+            Logger::logWarning("AsyncRemoteClientHandler failed to accept client: %s", status.ToString().c_str());
+            finish(grpc::Status(grpc::CANCELLED, status.ToString()));
+            return;
+        }
+        this->registered = true;
+        Logger::logInfo("Client \"%s\" connected!", makeRemoteClientIdentifier(this->remoteClientInfo).c_str());
+
+        // Return the package to the sender, to acknowledge that we accepted the connection.
+        this->packageInFlight = std::make_shared<DataPackage>(this->incomingPackage);
+        this->writeInFlight = true;
+        this->stream.Write(*this->packageInFlight, &this->writeTag);
+        lock.unlock();
+
+        // From now on, we get notified whenever the router adds a package for our client.
+        // Packages that have been enqueued before are sent once the handshake package was written.
+        std::weak_ptr<AsyncRemoteClientHandler> weakHandler = shared_from_this();
+        this->outgoingQueue->setPushListener([weakHandler]()
+        {
+            std::shared_ptr<AsyncRemoteClientHandler> handler = weakHandler.lock();
+            if(handler != nullptr)
+            {
+                handler->onOutgoingPackageAvailable();
+            }
+        });
+
+        this->stream.Read(&this->incomingPackage, &this->readTag);
+    }
+
+    void AsyncRemoteClientHandler::onRead(bool ok)
+    {
+        if(!ok)
+        {
+            // The client has disconnected, or the server is shutting down.
+            Logger::logWarning("Client \"%s\" disconnected or died", makeRemoteClientIdentifier(this->remoteClientInfo).c_str());
+            std::unique_lock<std::mutex> lock(this->handlerMutex);
+            finish(grpc::Status::OK);
+            return;
+        }
+
+        // Forward package to the input queue, that's all we have to do (same as RemoteClientHandler::processPacket).
+        // The input queue is connected to the MasterRouter, which will forward the package accordingly.
+        std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+        package->Swap(&this->incomingPackage);
+        this->incomingQueue->push_back(package);
+
+        this->stream.Read(&this->incomingPackage, &this->readTag);
+    }
+
+    void AsyncRemoteClientHandler::onWriteDone(bool ok)
+    {
+        std::unique_lock<std::mutex> lock(this->handlerMutex);
+        this->writeInFlight = false;
+
+        if(!ok)
+        {
+            // The stream is broken, hence the pending read will fail as well and end the call.
+            // Remaining packages are dropped together with the outgoing queue, same as for the RemoteClientHandler.
+            Logger::logWarning("AsyncRemoteClientHandler failed to write package to client \"%s\"",
+                makeRemoteClientIdentifier(this->remoteClientInfo).c_str());
+            this->writeFailed = true;
+        }
+        this->packageInFlight = nullptr;
+
+        if(this->finishRequested)
+        {
+            // The call was ended while the write was in flight.
+            finish(this->finishStatus);
+            return;
+        }
+        startNextWrite();
+    }
+
+    void AsyncRemoteClientHandler::onFinished()
+    {
+        if(this->outgoingQueue != nullptr)
+        {
+            this->outgoingQueue->setPushListener(nullptr);
+        }
+
+        if(this->registered)
+        {
+            this->service.unregisterRemoteClient(this);
+        }
+
+        // Might delete this handler, hence has to be the last statement.
+        this->self.reset();
+    }
+
+    void AsyncRemoteClientHandler::onOutgoingPackageAvailable()
+    {
+        std::unique_lock<std::mutex> lock(this->handlerMutex);
+        startNextWrite();
+    }
+
+    void AsyncRemoteClientHandler::startNextWrite()
+    {
+        // Only one write can be outstanding at any given time.
+        // If a write is in flight, the next package will be written once it has completed.
+        if(this->writeInFlight || this->writeFailed || this->finishRequested)
+        {
+            return;
+        }
+
+        this->packageInFlight = this->outgoingQueue->try_pop_front();
+        if(this->packageInFlight == nullptr)
+        {
+            return;
+        }
+
+        this->writeInFlight = true;
+        this->stream.Write(*this->packageInFlight, &this->writeTag);
+    }
+
+    void AsyncRemoteClientHandler::finish(const grpc::Status& status)
+    {
+        if(!this->finishRequested)
+        {
+            this->finishRequested = true;
+            this->finishStatus = status;
+        }
+
+        // Finish must not be called while a write is outstanding.
+        if(this->writeInFlight || this->finishStarted)
+        {
+            return;
+        }
+
+        this->finishStarted = true;
+        this->stream.Finish(this->finishStatus, &this->finishTag);
+    }
+
+    void AsyncRemoteClientHandler::cancel()
+    {
+        this->context.TryCancel();
+    }
+
+    const RemoteClientInfo& AsyncRemoteClientHandler::getRemoteClientInfo() const
+    {
+        return this->remoteClientInfo;
+    }
+}
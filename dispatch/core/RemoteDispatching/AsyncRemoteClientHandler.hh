@@ -0,0 +1,129 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <grpc/grpc.h>
+#include <grpcpp/server_context.h>
+#include <grpcpp/support/async_stream.h>
+
+#include <memory>
+#include <mutex>
+
+#include "dispatch/core/shared_queue.hh"
+#include "dispatch/proto/claidservice.pb.h"
+#include "dispatch/proto/claidservice.grpc.pb.h"
+
+using claidservice::DataPackage;
+using claidservice::RemoteClientInfo;
+
+namespace claid
+{
+    class AsyncRemoteService;
+
+    // Counterpart of the RemoteClientHandler for the AsyncRemoteService.
+    // Instead of occupying a gRPC handler thread and a dedicated writer thread, the AsyncRemoteClientHandler
+    // is a small state machine that is driven by the events of the completion queue it was created for.
+    // Incoming packages are forwarded to the input queue of the HostUserTable, outgoing packages are
+    // written to the stream whenever the outgoing queue of the client was pushed to or the previous write completed.
+    // Each handler owns itself (see self) and releases itself once the stream was finished.
+    class AsyncRemoteClientHandler : public std::enable_shared_from_this<AsyncRemoteClientHandler>
+    {
+    public:
+        enum class Operation
+        {
+            CONNECT,
+            READ,
+            WRITE,
+            FINISH
+        };
+
+        // Passed as tag to the completion queue.
+        struct Tag
+        {
+            AsyncRemoteClientHandler* handler;
+            Operation operation;
+        };
+
+        AsyncRemoteClientHandler(AsyncRemoteService& service,
+            claidservice::ClaidRemoteService::AsyncService& grpcService,
+            grpc::ServerCompletionQueue* completionQueue);
+        ~AsyncRemoteClientHandler();
+
+        // Waits for the next client to connect on the completion queue of this handler.
+        void start();
+
+        // Called by the thread of the completion queue once one of our operations has completed.
+        void proceed(Operation operation, bool ok);
+
+        // Cancels the stream, e.g., if the client reconnected with a new stream before we noticed the old one has died.
+        void cancel();
+
+        const RemoteClientInfo& getRemoteClientInfo() const;
+
+    private:
+        void onConnected(bool ok);
+        void onHandshake(bool ok);
+        void onRead(bool ok);
+        void onWriteDone(bool ok);
+        void onFinished();
+
+        void onOutgoingPackageAvailable();
+
+        // The following functions have to be called while holding the handlerMutex.
+        void startNextWrite();
+        void finish(const grpc::Status& status);
+
+    private:
+        AsyncRemoteService& service;
+        claidservice::ClaidRemoteService::AsyncService& grpcService;
+        grpc::ServerCompletionQueue* completionQueue;
+
+        grpc::ServerContext context;
+        grpc::ServerAsyncReaderWriter<DataPackage, DataPackage> stream;
+
+        Tag connectTag;
+        Tag readTag;
+        Tag writeTag;
+        Tag finishTag;
+
+        RemoteClientInfo remoteClientInfo;
+        bool registered = false;
+
+        DataPackage incomingPackage;
+
+        // Package currently being written, kept alive until the write has completed.
+        std::shared_ptr<DataPackage> packageInFlight;
+
+        std::shared_ptr<SharedQueue<DataPackage>> incomingQueue;
+        std::shared_ptr<SharedQueue<DataPackage>> outgoingQueue;
+
+        std::mutex handlerMutex; // protects the write and finish state below.
+        bool writeInFlight = false;
+        bool writeFailed = false;
+        bool finishRequested = false;
+        bool finishStarted = false;
+        grpc::Status finishStatus;
+
+        // Keeps the handler alive as long as gRPC might still deliver events for it.
+        std::shared_ptr<AsyncRemoteClientHandler> self;
+    };
+}
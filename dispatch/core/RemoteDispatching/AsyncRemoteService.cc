@@ -0,0 +1,229 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/RemoteDispatching/AsyncRemoteService.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+namespace claid
+{
+    // Number of handlers per completion queue waiting for a client to connect.
+    // Allows to accept bursts of connections (e.g., when many devices reconnect after a server restart).
+    static const size_t NUM_PENDING_CONNECTIONS_PER_QUEUE = 8;
+
+    AsyncRemoteService::AsyncRemoteService(HostUserTable& hostUserTable, size_t numThreads) : 
+        hostUserTable(hostUserTable),
+        numThreads(numThreads != 0 ? numThreads : std::max<size_t>(1, std::thread::hardware_concurrency()))
+    {
+
+    }
+
+    AsyncRemoteService::~AsyncRemoteService()
+    {
+        this->shutdown();
+    }
+
+    void AsyncRemoteService::registerService(grpc::ServerBuilder& builder)
+    {
+        builder.RegisterService(&this->grpcService);
+        for(size_t i = 0; i < this->numThreads; i++)
+        {
+            this->completionQueues.push_back(builder.AddCompletionQueue());
+        }
+    }
+
+    void AsyncRemoteService::start()
+    {
+        if(this->running)
+        {
+            return;
+        }
+        this->running = true;
+
+        for(std::unique_ptr<grpc::ServerCompletionQueue>& completionQueue : this->completionQueues)
+        {
+            for(size_t i = 0; i < NUM_PENDING_CONNECTIONS_PER_QUEUE; i++)
+            {
+                std::make_shared<AsyncRemoteClientHandler>(*this, this->grpcService, completionQueue.get())->start();
+            }
+
+            grpc::ServerCompletionQueue* queue = completionQueue.get();
+            this->completionQueueThreads.push_back(
+                std::make_unique<std::thread>([this, queue]() { processCompletionQueue(queue); }));
+        }
+        Logger::logInfo("AsyncRemoteService started with %zu completion queue threads.", this->numThreads);
+    }
+
+    void AsyncRemoteService::shutdown()
+    {
+        if(this->completionQueuesShutdown)
+        {
+            return;
+        }
+
+        if(this->running)
+        {
+            // grpc::Server::Shutdown() has cancelled all ongoing calls. 
+            // Wait until all handlers have observed this and released themselves.
+            std::unique_lock<std::mutex> lock(this->numHandlersMutex);
+            bool allHandlersReleased = this->numHandlersChanged.wait_for(lock, std::chrono::seconds(10), 
+                [this]() { return this->numHandlers == 0; });
+            
+            if(!allHandlersReleased)
+            {
+                Logger::logWarning("AsyncRemoteService: %zu client handlers have not been released 10 seconds after the server was shut down.", 
+                    this->numHandlers);
+            }
+        }
+
+        for(std::unique_ptr<grpc::ServerCompletionQueue>& completionQueue : this->completionQueues)
+        {
+            completionQueue->Shutdown();
+        }
+        this->completionQueuesShutdown = true;
+
+        if(this->running)
+        {
+            for(std::unique_ptr<std::thread>& thread : this->completionQueueThreads)
+            {
+                thread->join();
+            }
+            this->completionQueueThreads.clear();
+        }
+        else
+        {
+            // The service was never started (e.g., failed to build the server), we have to drain the queues ourselves.
+            void* tag;
+            bool ok;
+            for(std::unique_ptr<grpc::ServerCompletionQueue>& completionQueue : this->completionQueues)
+            {
+                while(completionQueue->Next(&tag, &ok));
+            }
+        }
+        this->running = false;
+    }
+
+    size_t AsyncRemoteService::getNumThreads() const
+    {
+        return this->numThreads;
+    }
+
+    void AsyncRemoteService::processCompletionQueue(grpc::ServerCompletionQueue* completionQueue)
+    {
+        void* tag;
+        bool ok;
+        // Returns false once the completion queue was shut down and drained.
+        while(completionQueue->Next(&tag, &ok))
+        {
+            AsyncRemoteClientHandler::Tag* handlerTag = static_cast<AsyncRemoteClientHandler::Tag*>(tag);
+            handlerTag->handler->proceed(handlerTag->operation, ok);
+        }
+    }
+
+    absl::Status AsyncRemoteService::registerRemoteClient(std::shared_ptr<AsyncRemoteClientHandler> handler,
+        std::shared_ptr<SharedQueue<DataPackage>>& incomingQueue,
+        std::shared_ptr<SharedQueue<DataPackage>>& outgoingQueue)
+    {
+        const RemoteClientInfo& remoteClientInfo = handler->getRemoteClientInfo();
+        RemoteClientKey remoteClient = makeRemoteClientKey(remoteClientInfo);
+
+        std::lock_guard<std::mutex> lock(this->remoteClientHandlersMutex);
+        auto it = this->remoteClientHandlers.find(remoteClient);
+        if(it != this->remoteClientHandlers.end())
+        {
+            // The same client connected again. Typically, this happens if the connection of the client died silently
+            // and the client reconnected before we noticed. In contrast to the RemoteServiceImpl, we cannot block
+            // to test whether the old stream is still reachable. Hence, the new stream always replaces the old one.
+            Logger::logWarning("Client \"%s\" reconnected, cancelling previous stream.", 
+                makeRemoteClientIdentifier(remoteClientInfo).c_str());
+            it->second->cancel();
+            this->hostUserTable.removeRemoteClient(remoteClientInfo.host(), remoteClientInfo.user_token(), remoteClientInfo.device_id()).IgnoreError();
+            this->remoteClientHandlers.erase(it);
+        }
+
+        absl::Status status = this->hostUserTable.addRemoteClient(
+            remoteClientInfo.host(), remoteClientInfo.user_token(), remoteClientInfo.device_id());
+        if(!status.ok())
+        {
+            return status;
+        }
+
+        status = this->hostUserTable.lookupOutputQueueForHostUser(
+            remoteClientInfo.host(), remoteClientInfo.user_token(), outgoingQueue);
+        if(!status.ok())
+        {
+            return status;
+        }
+        incomingQueue = this->hostUserTable.inputQueue();
+
+        this->remoteClientHandlers[remoteClient] = handler;
+        return absl::OkStatus();
+    }
+
+    void AsyncRemoteService::disconnectRemoteClient(const std::string& host, const std::string& userToken)
+    {
+        std::lock_guard<std::mutex> lock(this->remoteClientHandlersMutex);
+        auto it = this->remoteClientHandlers.find(makeRemoteClientKey(host, userToken));
+        if(it == this->remoteClientHandlers.end())
+        {
+            return;
+        }
+
+        // The handler unregisters the client once it observed the cancellation.
+        it->second->cancel();
+    }
+
+    void AsyncRemoteService::unregisterRemoteClient(AsyncRemoteClientHandler* handler)
+    {
+        const RemoteClientInfo& remoteClientInfo = handler->getRemoteClientInfo();
+        RemoteClientKey remoteClient = makeRemoteClientKey(remoteClientInfo);
+
+        std::lock_guard<std::mutex> lock(this->remoteClientHandlersMutex);
+        auto it = this->remoteClientHandlers.find(remoteClient);
+
+        // If the client has reconnected in the meantime, the entry belongs to the new stream.
+        if(it == this->remoteClientHandlers.end() || it->second.get() != handler)
+        {
+            return;
+        }
+        this->remoteClientHandlers.erase(it);
+
+        absl::Status status = this->hostUserTable.removeRemoteClient(
+            remoteClientInfo.host(), remoteClientInfo.user_token(), remoteClientInfo.device_id());
+        if(!status.ok())
+        {
+            Logger::logWarning("Failed to remove host %s:%s:%s from HostUserTable: %s", 
+            remoteClientInfo.host().c_str(), remoteClientInfo.user_token().c_str(), remoteClientInfo.device_id().c_str(),  status.ToString().c_str());
+        }
+    }
+
+    void AsyncRemoteService::onHandlerCreated()
+    {
+        std::lock_guard<std::mutex> lock(this->numHandlersMutex);
+        this->numHandlers++;
+    }
+
+    void AsyncRemoteService::onHandlerDestroyed()
+    {
+        std::lock_guard<std::mutex> lock(this->numHandlersMutex);
+        this->numHandlers--;
+        this->numHandlersChanged.notify_all();
+    }
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <grpcpp/server_builder.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dispatch/proto/claidservice.pb.h"
+#include "dispatch/core/RemoteDispatching/AsyncRemoteClientHandler.hh"
+#include "dispatch/core/RemoteDispatching/RemoteClientKey.hh"
+#include "dispatch/core/RemoteDispatching/HostUserTable.hh"
+
+using claidservice::DataPackage;
+using claidservice::RemoteClientInfo;
+
+namespace claid
+{
+    // Alternative to the RemoteServiceImpl based on the asynchronous (completion queue) API of gRPC.
+    // The RemoteServiceImpl occupies one gRPC handler thread and one writer thread per connected client.
+    // The AsyncRemoteService, in contrast, multiplexes the streams of all clients on a fixed number of
+    // completion queues, each of which is served by a single thread.
+    // Hence, the number of threads does not grow with the number of connected clients.
+    class AsyncRemoteService
+    {
+    public:
+        AsyncRemoteService(HostUserTable& hostUserTable, size_t numThreads);
+        virtual ~AsyncRemoteService();
+
+        // Registers the service and adds the completion queues to the builder.
+        // Has to be called before builder.BuildAndStart().
+        void registerService(grpc::ServerBuilder& builder);
+
+        // Starts the completion queue threads. Has to be called after the server was built and started.
+        void start();
+
+        // Has to be called after grpc::Server::Shutdown() returned.
+        // Shuts down the completion queues and waits for their threads to finish.
+        void shutdown();
+
+        size_t getNumThreads() const;
+
+        // Cancels the stream of the given client, if connected (e.g., because the client cannot keep up with its packages).
+        void disconnectRemoteClient(const std::string& host, const std::string& userToken);
+
+    private:
+        void processCompletionQueue(grpc::ServerCompletionQueue* completionQueue);
+
+        // Called by the AsyncRemoteClientHandlers.
+        absl::Status registerRemoteClient(std::shared_ptr<AsyncRemoteClientHandler> handler,
+            std::shared_ptr<SharedQueue<DataPackage>>& incomingQueue,
+            std::shared_ptr<SharedQueue<DataPackage>>& outgoingQueue);
+        void unregisterRemoteClient(AsyncRemoteClientHandler* handler);
+        void onHandlerCreated();
+        void onHandlerDestroyed();
+
+    private:
+        HostUserTable& hostUserTable;
+        const size_t numThreads;
+
+        claidservice::ClaidRemoteService::AsyncService grpcService;
+
+        std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> completionQueues;
+        std::vector<std::unique_ptr<std::thread>> completionQueueThreads;
+
+        std::map<RemoteClientKey, std::shared_ptr<AsyncRemoteClientHandler>> remoteClientHandlers;
+        std::mutex remoteClientHandlersMutex;    // protects remoteClientHandlers
+
+        // Number of AsyncRemoteClientHandlers alive, including the ones waiting for a client to connect.
+        // Operations must not be started on a completion queue that was shut down, hence we can only shut
+        // down the completion queues once all handlers have observed the end of their calls.
+        size_t numHandlers = 0;
+        std::mutex numHandlersMutex;
+        std::condition_variable numHandlersChanged;
+
+        bool running = false;
+        bool completionQueuesShutdown = false;
+
+        friend class AsyncRemoteClientHandler;
+    };
+}
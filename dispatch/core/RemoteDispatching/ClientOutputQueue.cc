@@ -0,0 +1,520 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/RemoteDispatching/ClientOutputQueue.hh"
+#include "dispatch/core/Logger/Logger.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+#include "dispatch/core/Utilities/Path.hh"
+
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+using claidservice::DataPackage;
+using claidservice::ClientQueueOverflowPolicy;
+
+namespace claid
+{
+    static std::string makeSpillFileName(const std::string& host, const std::string& userToken)
+    {
+        std::string name = host + "_" + userToken;
+        for(char& c : name)
+        {
+            if(!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.')
+            {
+                c = '_';
+            }
+        }
+        return name + ".claid_spill";
+    }
+
+    ClientOutputQueueRefiller::ClientOutputQueueRefiller() : thread([this]() { run(); })
+    {
+
+    }
+
+    ClientOutputQueueRefiller::~ClientOutputQueueRefiller()
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->running = false;
+            this->conditionVariable.notify_all();
+        }
+        this->thread.join();
+    }
+
+    void ClientOutputQueueRefiller::scheduleRefill(std::weak_ptr<ClientOutputQueue> queue)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->queuesToRefill.push_back(queue);
+        this->conditionVariable.notify_one();
+    }
+
+    void ClientOutputQueueRefiller::run()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while(this->running)
+        {
+            if(this->queuesToRefill.empty())
+            {
+                this->conditionVariable.wait(lock);
+                continue;
+            }
+            std::shared_ptr<ClientOutputQueue> queue = this->queuesToRefill.front().lock();
+            this->queuesToRefill.pop_front();
+
+            if(queue != nullptr)
+            {
+                lock.unlock();
+                queue->refill();
+                lock.lock();
+            }
+        }
+    }
+
+    std::shared_ptr<ClientOutputQueue> ClientOutputQueue::create(const std::string& host, const std::string& userToken,
+            const claidservice::ClientQueueLimits& limits, std::shared_ptr<ClientOutputQueueRefiller> refiller,
+            DisconnectFunction disconnectFunction)
+    {
+        std::shared_ptr<ClientOutputQueue> queue = 
+            std::make_shared<ClientOutputQueue>(host, userToken, limits, refiller, disconnectFunction);
+        queue->start();
+        return queue;
+    }
+
+    ClientOutputQueue::ClientOutputQueue(const std::string& host, const std::string& userToken,
+            const claidservice::ClientQueueLimits& limits, std::shared_ptr<ClientOutputQueueRefiller> refiller,
+            DisconnectFunction disconnectFunction) : 
+        host(host), userToken(userToken), limits(limits),
+        spillFilePath(Path::join(limits.spill_path(), makeSpillFileName(host, userToken)).toString()),
+        queue(std::make_shared<SharedQueue<DataPackage>>()), refiller(refiller), disconnectFunction(disconnectFunction)
+    {
+
+    }
+
+    void ClientOutputQueue::start()
+    {
+        if(!isLimited())
+        {
+            return;
+        }
+
+        if(this->limits.max_bytes() > 0)
+        {
+            this->queue->setElementSizeFunction([](const DataPackage& package) { return package.ByteSizeLong(); });
+        }
+
+        if(this->limits.overflow_policy() != ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK)
+        {
+            return;
+        }
+
+        std::weak_ptr<ClientOutputQueue> weakQueue = shared_from_this();
+        this->queue->setPopListener([weakQueue]()
+        {
+            std::shared_ptr<ClientOutputQueue> queue = weakQueue.lock();
+            if(queue != nullptr)
+            {
+                queue->onPopped();
+            }
+        });
+
+        // Packages spilled during a previous connection of the client are delivered first.
+        std::unique_lock<std::mutex> lock(this->mutex);
+        countSpilledPackages();
+        if(this->numSpilledPackages > 0)
+        {
+            Logger::logInfo("ClientOutputQueue: %zu packages for client \"%s:%s\" have been spilled to disk during a previous connection.",
+                this->numSpilledPackages.load(), this->host.c_str(), this->userToken.c_str());
+            this->refillScheduled = true;
+            this->refiller->scheduleRefill(weakQueue);
+        }
+    }
+
+    bool ClientOutputQueue::isLimited() const
+    {
+        return this->limits.max_packages() > 0 || this->limits.max_bytes() > 0;
+    }
+
+    bool ClientOutputQueue::exceedsLimits(size_t numPackages, size_t numBytes) const
+    {
+        return (this->limits.max_packages() > 0 && numPackages > static_cast<size_t>(this->limits.max_packages())) ||
+            (this->limits.max_bytes() > 0 && numBytes > static_cast<size_t>(this->limits.max_bytes()));
+    }
+
+    bool ClientOutputQueue::canRefill(size_t numPackages, size_t numBytes) const
+    {
+        // Refill once the client has consumed half of the queue, to not read from disk for every package.
+        return (this->limits.max_packages() <= 0 || numPackages <= static_cast<size_t>(this->limits.max_packages()) / 2) &&
+            (this->limits.max_bytes() <= 0 || numBytes <= static_cast<size_t>(this->limits.max_bytes()) / 2);
+    }
+
+    void ClientOutputQueue::push(std::shared_ptr<DataPackage> package)
+    {
+        if(!isLimited())
+        {
+            this->queue->push_back(package);
+            return;
+        }
+
+        const size_t packageSize = this->limits.max_bytes() > 0 ? package->ByteSizeLong() : 0;
+        const bool spillToDisk = 
+            this->limits.overflow_policy() == ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK;
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        const bool exceeds = exceedsLimits(this->queue->size() + 1, this->queue->elements_size() + packageSize);
+        updateOverflowState(exceeds);
+        const bool disconnect = shouldDisconnect();
+
+        if(spillToDisk && (exceeds || this->numSpilledPackages > 0 || this->refilling || this->closed))
+        {
+            absl::Status status = spill(*package);
+            lock.unlock();
+            if(!status.ok())
+            {
+                this->numDroppedPackages++;
+                Logger::logError("ClientOutputQueue failed to spill package for client \"%s:%s\", dropping it: %s", 
+                    this->host.c_str(), this->userToken.c_str(), status.ToString().c_str());
+            }
+        }
+        else
+        {
+            lock.unlock();
+            this->queue->push_back(package);
+
+            // Always keep the newest package, even if it exceeds the limits on its own.
+            while(!spillToDisk && this->queue->size() > 1 && exceedsLimits(this->queue->size(), this->queue->elements_size()))
+            {
+                if(this->queue->try_pop_front() != nullptr)
+                {
+                    this->numDroppedPackages++;
+                }
+            }
+        }
+
+        if(disconnect && this->disconnectFunction)
+        {
+            Logger::logWarning("ClientOutputQueue: queue of client \"%s:%s\" exceeded its limits for more than %d seconds, disconnecting client.",
+                this->host.c_str(), this->userToken.c_str(), this->limits.disconnect_after_overflow_seconds());
+            this->disconnectFunction(this->host, this->userToken);
+        }
+    }
+
+    void ClientOutputQueue::updateOverflowState(bool exceedsLimits)
+    {
+        if(exceedsLimits == this->overflowing)
+        {
+            return;
+        }
+
+        this->overflowing = exceedsLimits;
+        if(exceedsLimits)
+        {
+            this->overflowSince = Time::now();
+            Logger::logWarning("ClientOutputQueue: queue of client \"%s:%s\" exceeds its limits (%zu packages, %zu bytes), applying overflow policy %s.",
+                this->host.c_str(), this->userToken.c_str(), this->queue->size(), this->queue->elements_size(),
+                claidservice::ClientQueueOverflowPolicy_Name(this->limits.overflow_policy()).c_str());
+        }
+        else
+        {
+            this->disconnectRequested = false;
+        }
+    }
+
+    bool ClientOutputQueue::shouldDisconnect()
+    {
+        if(!this->overflowing || this->disconnectRequested || this->limits.disconnect_after_overflow_seconds() <= 0)
+        {
+            return false;
+        }
+
+        if(Time::now() < this->overflowSince + Duration::seconds(this->limits.disconnect_after_overflow_seconds()))
+        {
+            return false;
+        }
+        this->disconnectRequested = true;
+        return true;
+    }
+
+    void ClientOutputQueue::onPopped()
+    {
+        // Called by the consumer of the queue, hence only schedules the refill.
+        if(this->numSpilledPackages == 0 || this->refillScheduled)
+        {
+            return;
+        }
+
+        if(!canRefill(this->queue->size(), this->queue->elements_size()))
+        {
+            return;
+        }
+
+        if(!this->refillScheduled.exchange(true))
+        {
+            this->refiller->scheduleRefill(weak_from_this());
+        }
+    }
+
+    void ClientOutputQueue::close()
+    {
+        if(this->limits.overflow_policy() != ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK || !isLimited())
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->closed = true;
+        // Packages which are read from the spill file already have to reach the queue first.
+        this->refillDone.wait(lock, [this]{ return !this->refilling; });
+
+        std::vector<std::shared_ptr<DataPackage>> packages;
+        while(std::shared_ptr<DataPackage> package = this->queue->try_pop_front())
+        {
+            packages.push_back(package);
+        }
+
+        // The queue might contain null packages used to wake up the consumer.
+        packages.erase(std::remove(packages.begin(), packages.end(), nullptr), packages.end());
+        if(packages.empty())
+        {
+            return;
+        }
+
+        absl::Status status = spillToFront(packages);
+        if(!status.ok())
+        {
+            this->numDroppedPackages += packages.size();
+            Logger::logError("ClientOutputQueue failed to spill %zu queued packages of disconnected client \"%s:%s\", dropping them: %s", 
+                packages.size(), this->host.c_str(), this->userToken.c_str(), status.ToString().c_str());
+            return;
+        }
+        Logger::logInfo("ClientOutputQueue: spilled %zu queued packages of disconnected client \"%s:%s\" to disk.",
+            packages.size(), this->host.c_str(), this->userToken.c_str());
+    }
+
+    void ClientOutputQueue::refill()
+    {
+        std::vector<std::shared_ptr<DataPackage>> packages;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->refillScheduled = false;
+            if(this->closed)
+            {
+                return;
+            }
+
+            absl::Status status = readSpilledPackages(packages);
+            if(!status.ok())
+            {
+                Logger::logError("ClientOutputQueue failed to read spilled packages of client \"%s:%s\": %s", 
+                    this->host.c_str(), this->userToken.c_str(), status.ToString().c_str());
+            }
+            this->refilling = true;
+        }
+
+        // Pushed without holding the mutex, as pushing might trigger the consumer to pop (see onPopped).
+        for(std::shared_ptr<DataPackage>& package : packages)
+        {
+            this->queue->push_back(package);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->refilling = false;
+            this->refillDone.notify_all();
+            if(this->numSpilledPackages == 0)
+            {
+                this->spillFileReadOffset = 0;
+                FileUtils::removeFileIfExists(this->spillFilePath);
+                updateOverflowState(exceedsLimits(this->queue->size(), this->queue->elements_size()));
+            }
+        }
+
+        // The consumer might have caught up in the meantime.
+        onPopped();
+    }
+
+    absl::Status ClientOutputQueue::spill(const DataPackage& package)
+    {
+        if(this->numSpilledPackages == 0 && !FileUtils::dirExists(this->limits.spill_path()) &&
+            !FileUtils::createDirectoriesRecursively(this->limits.spill_path()))
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to create spill directory \"", this->limits.spill_path(), "\"."));
+        }
+
+        std::string serialized;
+        if(!package.SerializeToString(&serialized))
+        {
+            return absl::InvalidArgumentError("Failed to serialize package.");
+        }
+
+        std::ofstream file(this->spillFilePath, std::ios::binary | std::ios::app);
+        uint32_t length = static_cast<uint32_t>(serialized.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(serialized.data(), serialized.size());
+        if(!file)
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to write to spill file \"", this->spillFilePath, "\"."));
+        }
+
+        this->numSpilledPackages++;
+        return absl::OkStatus();
+    }
+
+    // Rewrites the spill file, such that the given packages precede the packages that were not enqueued yet.
+    absl::Status ClientOutputQueue::spillToFront(const std::vector<std::shared_ptr<DataPackage>>& packages)
+    {
+        if(!FileUtils::dirExists(this->limits.spill_path()) && !FileUtils::createDirectoriesRecursively(this->limits.spill_path()))
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to create spill directory \"", this->limits.spill_path(), "\"."));
+        }
+
+        const std::string tmpSpillFilePath = this->spillFilePath + ".tmp";
+        {
+            std::ofstream file(tmpSpillFilePath, std::ios::binary | std::ios::trunc);
+            for(const std::shared_ptr<DataPackage>& package : packages)
+            {
+                std::string serialized;
+                if(!package->SerializeToString(&serialized))
+                {
+                    return absl::InvalidArgumentError("Failed to serialize package.");
+                }
+                uint32_t length = static_cast<uint32_t>(serialized.size());
+                file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                file.write(serialized.data(), serialized.size());
+            }
+
+            if(this->numSpilledPackages > 0)
+            {
+                std::ifstream spillFile(this->spillFilePath, std::ios::binary);
+                spillFile.seekg(this->spillFileReadOffset);
+                file << spillFile.rdbuf();
+            }
+            if(!file)
+            {
+                FileUtils::removeFileIfExists(tmpSpillFilePath);
+                return absl::UnavailableError(absl::StrCat("Failed to write to spill file \"", tmpSpillFilePath, "\"."));
+            }
+        }
+
+        // Replaces the spill file atomically.
+        if(!FileUtils::renameFile(tmpSpillFilePath, this->spillFilePath))
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to rename \"", tmpSpillFilePath, "\" to \"", this->spillFilePath, "\"."));
+        }
+        this->spillFileReadOffset = 0;
+        this->numSpilledPackages += packages.size();
+        return absl::OkStatus();
+    }
+
+    absl::Status ClientOutputQueue::readSpilledPackages(std::vector<std::shared_ptr<DataPackage>>& packages)
+    {
+        std::ifstream file(this->spillFilePath, std::ios::binary);
+        if(!file)
+        {
+            this->numSpilledPackages = 0;
+            return absl::NotFoundError(absl::StrCat("Failed to open spill file \"", this->spillFilePath, "\"."));
+        }
+        file.seekg(this->spillFileReadOffset);
+
+        size_t numPackages = this->queue->size();
+        size_t numBytes = this->queue->elements_size();
+        while(this->numSpilledPackages > 0)
+        {
+            uint32_t length;
+            if(!file.read(reinterpret_cast<char*>(&length), sizeof(length)))
+            {
+                break;
+            }
+
+            std::string serialized(length, '\0');
+            if(!file.read(&serialized[0], length))
+            {
+                break;
+            }
+
+            std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+            if(!package->ParseFromString(serialized))
+            {
+                this->numSpilledPackages = 0;
+                return absl::DataLossError(absl::StrCat("Spill file \"", this->spillFilePath, "\" is corrupted."));
+            }
+
+            // Refill up to the limits, but at least one package.
+            if(!packages.empty() && exceedsLimits(numPackages + 1, numBytes + length))
+            {
+                break;
+            }
+            numPackages++;
+            numBytes += length;
+
+            packages.push_back(package);
+            this->spillFileReadOffset += sizeof(length) + length;
+            this->numSpilledPackages--;
+        }
+
+        if(this->numSpilledPackages > 0 && packages.empty())
+        {
+            // The file ended before the expected number of packages, e.g., because the server died while writing.
+            this->numSpilledPackages = 0;
+            return absl::DataLossError(absl::StrCat("Spill file \"", this->spillFilePath, "\" is truncated."));
+        }
+        return absl::OkStatus();
+    }
+
+    void ClientOutputQueue::countSpilledPackages()
+    {
+        std::ifstream file(this->spillFilePath, std::ios::binary);
+        uint32_t length;
+        size_t numPackages = 0;
+        while(file.read(reinterpret_cast<char*>(&length), sizeof(length)) && file.seekg(length, std::ios::cur))
+        {
+            numPackages++;
+        }
+        this->numSpilledPackages = numPackages;
+        this->spillFileReadOffset = 0;
+    }
+
+    std::shared_ptr<SharedQueue<DataPackage>> ClientOutputQueue::getQueue() const
+    {
+        return this->queue;
+    }
+
+    ClientQueueMetrics ClientOutputQueue::getMetrics()
+    {
+        ClientQueueMetrics metrics;
+        metrics.host = this->host;
+        metrics.userToken = this->userToken;
+        metrics.numQueuedPackages = this->queue->size();
+        metrics.numQueuedBytes = this->queue->elements_size();
+        metrics.numSpilledPackages = this->numSpilledPackages;
+        metrics.numDroppedPackages = this->numDroppedPackages;
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(this->overflowing)
+        {
+            metrics.overflowDurationMs = Time::now().subtract(this->overflowSince).getMilliSeconds();
+        }
+        return metrics;
+    }
+}
@@ -0,0 +1,155 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "dispatch/core/shared_queue.hh"
+#include "dispatch/core/Utilities/Time.hh"
+#include "dispatch/proto/claidservice.pb.h"
+
+#include "absl/status/status.h"
+
+namespace claid
+{
+    // State of the outgoing queue of a connected client, see HostUserTable::getWorstClientQueues.
+    struct ClientQueueMetrics
+    {
+        std::string host;
+        std::string userToken;
+        size_t numQueuedPackages = 0;
+        size_t numQueuedBytes = 0;
+        size_t numSpilledPackages = 0;      // Packages currently stored on disk.
+        uint64_t numDroppedPackages = 0;    // Packages dropped since the client connected.
+        uint64_t overflowDurationMs = 0;    // How long the queue is exceeding its limits already (0 = not exceeding).
+    };
+
+    class ClientOutputQueue;
+
+    // Refills the queues of clients that have packages spilled to disk, once the clients caught up.
+    // Runs on a separate thread, as refilling reads from disk and pushes to the queue, 
+    // which must not happen on the consumer thread that popped from the queue.
+    class ClientOutputQueueRefiller
+    {
+    public:
+        ClientOutputQueueRefiller();
+        ~ClientOutputQueueRefiller();
+
+        void scheduleRefill(std::weak_ptr<ClientOutputQueue> queue);
+
+    private:
+        void run();
+
+    private:
+        std::mutex mutex;
+        std::condition_variable conditionVariable;
+        std::deque<std::weak_ptr<ClientOutputQueue>> queuesToRefill;
+        bool running = true;
+        std::thread thread;
+    };
+
+    // Outgoing queue of a client connected to the RemoteDispatcherServer, which enforces the ClientQueueLimits.
+    // Packages are pushed by the ServerRouter and popped by the RemoteClientHandler (or AsyncRemoteClientHandler) of the client.
+    // If the limits are exceeded (e.g., because the client is on a slow network), the overflow policy is applied:
+    // - CLIENT_QUEUE_OVERFLOW_DROP_OLDEST: the oldest packages are dropped until the queue is within its limits again.
+    // - CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK: further packages are appended to a spill file and enqueued again in order,
+    //   once the client has caught up. The spill file is kept if the client disconnects, and packages that were
+    //   still queued in memory are added to it (see close()), hence they are delivered after the client reconnected.
+    // If the queue keeps exceeding its limits for longer than disconnect_after_overflow_seconds, the client is disconnected.
+    class ClientOutputQueue : public std::enable_shared_from_this<ClientOutputQueue>
+    {
+    public:
+        typedef std::function<void(const std::string& host, const std::string& userToken)> DisconnectFunction;
+
+        static std::shared_ptr<ClientOutputQueue> create(const std::string& host, const std::string& userToken,
+            const claidservice::ClientQueueLimits& limits, std::shared_ptr<ClientOutputQueueRefiller> refiller,
+            DisconnectFunction disconnectFunction);
+
+        ClientOutputQueue(const std::string& host, const std::string& userToken,
+            const claidservice::ClientQueueLimits& limits, std::shared_ptr<ClientOutputQueueRefiller> refiller,
+            DisconnectFunction disconnectFunction);
+
+        void push(std::shared_ptr<claidservice::DataPackage> package);
+
+        // Called when the client disconnected. With CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK, packages still in memory
+        // are moved to the front of the spill file, and packages pushed afterwards are spilled as well,
+        // hence they are delivered once the client reconnects.
+        void close();
+
+        std::shared_ptr<SharedQueue<claidservice::DataPackage>> getQueue() const;
+        ClientQueueMetrics getMetrics();
+
+    private:
+        void start();
+
+        bool isLimited() const;
+        bool exceedsLimits(size_t numPackages, size_t numBytes) const;
+        bool canRefill(size_t numPackages, size_t numBytes) const;
+
+        void onPopped();
+        void refill();
+
+        // The following functions have to be called while holding the mutex.
+        void updateOverflowState(bool exceedsLimits);
+        bool shouldDisconnect();
+        absl::Status spill(const claidservice::DataPackage& package);
+        absl::Status spillToFront(const std::vector<std::shared_ptr<claidservice::DataPackage>>& packages);
+        absl::Status readSpilledPackages(std::vector<std::shared_ptr<claidservice::DataPackage>>& packages);
+        void countSpilledPackages();
+
+    private:
+        const std::string host;
+        const std::string userToken;
+        const claidservice::ClientQueueLimits limits;
+        const std::string spillFilePath;
+
+        std::shared_ptr<SharedQueue<claidservice::DataPackage>> queue;
+        std::shared_ptr<ClientOutputQueueRefiller> refiller;
+        DisconnectFunction disconnectFunction;
+
+        std::mutex mutex; // Protects the overflow and spill state.
+        bool overflowing = false;
+        Time overflowSince;
+        bool disconnectRequested = false;
+
+        // Byte offset of the first package in the spill file which was not enqueued yet.
+        uint64_t spillFileReadOffset = 0;
+        // While refilling, new packages are spilled as well to preserve the order of packages.
+        bool refilling = false;
+        std::condition_variable refillDone;
+        // Client disconnected, all packages are spilled.
+        bool closed = false;
+
+        std::atomic<size_t> numSpilledPackages{0};
+        std::atomic<uint64_t> numDroppedPackages{0};
+        std::atomic<bool> refillScheduled{false};
+
+        friend class ClientOutputQueueRefiller;
+    };
+}
@@ -22,23 +22,58 @@
 #include "dispatch/core/RemoteDispatching/HostUserTable.hh"
 #include "dispatch/core/Logger/Logger.hh"
 #include "absl/status/status.h"
+
+#include <algorithm>
+
 namespace claid
 {
 
-HostUserTable::HostUserTable() : fromClientsQueue(std::make_shared<SharedQueue<DataPackage>>())
+HostUserTable::HostUserTable() : fromClientsQueue(std::make_shared<SharedQueue<DataPackage>>()),
+    hostOutputQueuesMap(std::make_shared<const HostOutputQueuesMap>())
 {
 
 }
 
+HostUserTable::~HostUserTable()
+{
+    this->stopMetricsLogging();
+}
+
+HostUserTable::UserQueueShard& HostUserTable::shardOf(const RemoteClientKey& key)
+{
+    return this->userQueueShards[RemoteClientKeyHash()(key) % NUM_SHARDS];
+}
+
 // Looks up the output queue for the host of specific user (i.e., address host:user)
 absl::Status HostUserTable::lookupOutputQueueForHostUser(const std::string& host, 
     const std::string& userToken, std::shared_ptr<SharedQueue<DataPackage>>& queue)
 {
-    std::lock_guard<std::recursive_mutex> lock(this->hostUserTableMutex);
     RemoteClientKey key = makeRemoteClientKey(host, userToken);
+    UserQueueShard& shard = shardOf(key);
 
-    auto it = this->hostUserQueueMap.find(key);
-    if(it == this->hostUserQueueMap.end())
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.hostUserQueueMap.find(key);
+    if(it == shard.hostUserQueueMap.end())
+    {
+        return absl::NotFoundError(absl::StrCat(
+            "HostUserTable unable to find queue for user \"", userToken, "\" on host \"", host, "\".\n",
+            "The client was not found in the host user map."
+        ));
+    }
+
+    queue = it->second->getQueue();
+    return absl::OkStatus();
+}
+
+absl::Status HostUserTable::lookupClientOutputQueue(const std::string& host, 
+    const std::string& userToken, std::shared_ptr<ClientOutputQueue>& queue)
+{
+    RemoteClientKey key = makeRemoteClientKey(host, userToken);
+    UserQueueShard& shard = shardOf(key);
+
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.hostUserQueueMap.find(key);
+    if(it == shard.hostUserQueueMap.end())
     {
         return absl::NotFoundError(absl::StrCat(
             "HostUserTable unable to find queue for user \"", userToken, "\" on host \"", host, "\".\n",
@@ -55,124 +90,249 @@ absl::Status HostUserTable::lookupOutputQueuesForHost(const std::string& host,
     std::vector<std::shared_ptr<SharedQueue<DataPackage>>>& queues)
 {
     queues.clear();
-        Logger::logInfo("T14");
 
-    std::lock_guard<std::recursive_mutex> lock(this->hostUserTableMutex);
+    HostOutputQueuesPtr hostOutputQueues;
+    absl::Status status = lookupOutputQueuesForHost(host, hostOutputQueues);
+    if(!status.ok())
+    {
+        return status;
+    }
+
+    queues.reserve(hostOutputQueues->queues.size());
+    for(const std::shared_ptr<ClientOutputQueue>& queue : hostOutputQueues->queues)
+    {
+        queues.push_back(queue->getQueue());
+    }
+    return absl::OkStatus();
+}
+
+absl::Status HostUserTable::lookupOutputQueuesForHost(const std::string& host, HostOutputQueuesPtr& queues)
+{
+    std::shared_ptr<const HostOutputQueuesMap> snapshot = std::atomic_load(&this->hostOutputQueuesMap);
 
-    auto it = this->hostToUserMap.find(host);
-    if(it == this->hostToUserMap.end())
+    auto it = snapshot->find(host);
+    if(it == snapshot->end())
     {
         return absl::NotFoundError(absl::StrCat(
             "HostUserTable failed to lookup output queues for all users with host \"", host, "\".\n",
             "Host was not found and possibly has not been registered yet."
         ));
     }
-        Logger::logInfo("T15");
-
-    const std::vector<std::string>& listOfUsers = it->second;
 
-    for(const std::string& user : listOfUsers)
-    {
-                Logger::logInfo("T16");
+    queues = it->second;
+    return absl::OkStatus();
+}
 
-        std::shared_ptr<SharedQueue<DataPackage>> queue;
-                        Logger::logInfo("T17");
+absl::Status HostUserTable::addRemoteClient(const std::string& host, const std::string& userToken, const std::string& deviceID)
+{
+    std::lock_guard<std::mutex> writerLock(this->writerMutex);
 
-        absl::Status status = this->lookupOutputQueueForHostUser(host, user, queue);
-                        Logger::logInfo("T18");
+    RemoteClientKey key = makeRemoteClientKey(host, userToken);
+    UserQueueShard& shard = shardOf(key);
 
-        if(!status.ok())
+    // Forwards to the current disconnect function, as the server might be restarted while the client is connected.
+    std::shared_ptr<ClientOutputQueue> queue = ClientOutputQueue::create(host, userToken, 
+        this->clientQueueLimits, this->clientQueueRefiller, 
+        [this](const std::string& host, const std::string& userToken) { disconnectClient(host, userToken); });
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if(!shard.hostUserQueueMap.insert(std::make_pair(key, queue)).second)
         {
-            return status;
+            return absl::AlreadyExistsError(absl::StrCat(
+                "HostUserTable cannot add remote client \"", host, ":", userToken, "\".\n",
+                "A user with these identifiers was already registered before."
+            ));
         }
+    }
 
-        queues.push_back(queue);
+    std::shared_ptr<HostOutputQueues> hostOutputQueues = std::make_shared<HostOutputQueues>();
+    auto it = this->hostOutputQueuesMap->find(host);
+    if(it != this->hostOutputQueuesMap->end())
+    {
+        *hostOutputQueues = *it->second;
     }
 
+    this->userPositions[key] = hostOutputQueues->queues.size();
+    hostOutputQueues->userTokens.push_back(userToken);
+    hostOutputQueues->queues.push_back(queue);
+
+    publishHostOutputQueues(host, hostOutputQueues);
     return absl::OkStatus();
 }
 
-absl::Status HostUserTable::addRemoteClient(const std::string& host, const std::string& userToken, const std::string& deviceID)
+absl::Status HostUserTable::removeRemoteClient(const std::string& host, const std::string& userToken, const std::string& deviceID)
 {
-    std::lock_guard<std::recursive_mutex> lock(this->hostUserTableMutex);
-        Logger::logInfo("hostusrtable 1");
+    std::lock_guard<std::mutex> writerLock(this->writerMutex);
 
     RemoteClientKey key = makeRemoteClientKey(host, userToken);
-            Logger::logInfo("hostusrtable 2");
+    UserQueueShard& shard = shardOf(key);
 
-    auto it = this->hostUserQueueMap.find(key);
+    std::shared_ptr<ClientOutputQueue> queue;
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto queueIt = shard.hostUserQueueMap.find(key);
+        if(queueIt == shard.hostUserQueueMap.end())
+        {
+            return absl::NotFoundError(absl::StrCat(
+                "HostUserTable cannot remove remote client \"", host, ":", userToken, "\".\n",
+                "A user with these identifiers was not registered."
+            ));
+        }
+        queue = queueIt->second;
+        shard.hostUserQueueMap.erase(queueIt);
+    }
+    // Keeps the packages queued for the client, if the queue spills to disk.
+    queue->close();
 
-    if(it != this->hostUserQueueMap.end())
+    auto it = this->hostOutputQueuesMap->find(host);
+    auto positionIt = this->userPositions.find(key);
+    if(it == this->hostOutputQueuesMap->end() || positionIt == this->userPositions.end())
     {
-        return absl::AlreadyExistsError(absl::StrCat(
-            "HostUserTable cannot add remote client \"", host, ":", userToken, "\".\n",
-            "A user with these identifiers was already registered before."
+        return absl::NotFoundError(absl::StrCat(
+            "HostUserTable failed to remove user \"", userToken, "\" from list of users of host \"", host, "\".\n",
+            "The user was not found or not registered before."
         ));
     }
 
-    std::shared_ptr<SharedQueue<DataPackage>> queue = std::make_shared<SharedQueue<DataPackage>>();
-    this->hostUserQueueMap.insert(std::make_pair(key, queue));
-    std::vector<std::string>& listOfUsers = this->hostToUserMap[host];
-        Logger::logInfo("hostusrtable 4");
-
-    auto it2 = std::find(listOfUsers.begin(), listOfUsers.end(), userToken);
-    if(it2 != listOfUsers.end())
+    // Remove the user by moving the last user of the host to its position.
+    std::shared_ptr<HostOutputQueues> hostOutputQueues = std::make_shared<HostOutputQueues>(*it->second);
+    const size_t position = positionIt->second;
+    const size_t last = hostOutputQueues->queues.size() - 1;
+    if(position != last)
     {
-        return absl::AlreadyExistsError(absl::StrCat(
-            "HostUserTable failed to insert user \"", userToken, "\" for to list of users for host \"", host, "\".\n",
-            "This user was already registered before."
-        ));
+        hostOutputQueues->userTokens[position] = std::move(hostOutputQueues->userTokens[last]);
+        hostOutputQueues->queues[position] = std::move(hostOutputQueues->queues[last]);
+        this->userPositions[makeRemoteClientKey(host, hostOutputQueues->userTokens[position])] = position;
     }
-    listOfUsers.push_back(userToken);
-        Logger::logInfo("hostusrtable 5");
+    hostOutputQueues->userTokens.pop_back();
+    hostOutputQueues->queues.pop_back();
+    this->userPositions.erase(key);
 
+    // The host stays registered, even if no user is connected anymore.
+    publishHostOutputQueues(host, hostOutputQueues);
     return absl::OkStatus();
 }
 
-absl::Status HostUserTable::removeRemoteClient(const std::string& host, const std::string& userToken, const std::string& deviceID)
+void HostUserTable::setClientQueueLimits(const claidservice::ClientQueueLimits& limits)
 {
-    std::lock_guard<std::recursive_mutex> lock(this->hostUserTableMutex);
+    {
+        std::lock_guard<std::mutex> writerLock(this->writerMutex);
+        this->clientQueueLimits = limits;
 
-    RemoteClientKey key = makeRemoteClientKey(host, userToken);
+        if(limits.overflow_policy() == claidservice::ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK &&
+            this->clientQueueRefiller == nullptr)
+        {
+            this->clientQueueRefiller = std::make_shared<ClientOutputQueueRefiller>();
+        }
+    }
 
+    this->stopMetricsLogging();
+    if(limits.metrics_log_interval_seconds() >= 0)
     {
-        auto it = this->hostUserQueueMap.find(key);
+        this->startMetricsLogging(std::chrono::seconds(
+            limits.metrics_log_interval_seconds() > 0 ? limits.metrics_log_interval_seconds() : 60));
+    }
+}
+
+void HostUserTable::setDisconnectClientFunction(ClientOutputQueue::DisconnectFunction disconnectClientFunction)
+{
+    std::lock_guard<std::mutex> lock(this->disconnectClientMutex);
+    this->disconnectClientFunction = disconnectClientFunction;
+}
 
-        if(it == this->hostUserQueueMap.end())
+void HostUserTable::disconnectClient(const std::string& host, const std::string& userToken)
+{
+    ClientOutputQueue::DisconnectFunction disconnectClientFunction;
+    {
+        std::lock_guard<std::mutex> lock(this->disconnectClientMutex);
+        disconnectClientFunction = this->disconnectClientFunction;
+    }
+
+    if(disconnectClientFunction)
+    {
+        disconnectClientFunction(host, userToken);
+    }
+}
+
+std::vector<ClientQueueMetrics> HostUserTable::getWorstClientQueues(size_t n)
+{
+    std::vector<ClientQueueMetrics> metrics;
+    for(UserQueueShard& shard : this->userQueueShards)
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for(const auto& entry : shard.hostUserQueueMap)
         {
-            return absl::NotFoundError(absl::StrCat(
-                "HostUserTable cannot remove remote client \"", host, ":", userToken, "\".\n",
-                "A user with these identifiers was not registered."
-            ));
+            metrics.push_back(entry.second->getMetrics());
         }
-        this->hostUserQueueMap.erase(it);
     }
 
+    auto isWorse = [](const ClientQueueMetrics& a, const ClientQueueMetrics& b)
+    {
+        if(a.numQueuedBytes != b.numQueuedBytes)
+        {
+            return a.numQueuedBytes > b.numQueuedBytes;
+        }
+        return a.numQueuedPackages + a.numSpilledPackages > b.numQueuedPackages + b.numSpilledPackages;
+    };
 
-    auto it = this->hostToUserMap.find(host);
+    n = std::min(n, metrics.size());
+    std::partial_sort(metrics.begin(), metrics.begin() + n, metrics.end(), isWorse);
+    metrics.resize(n);
+    return metrics;
+}
 
-    if(it == this->hostToUserMap.end())
+void HostUserTable::logWorstClientQueues(size_t n)
+{
+    for(const ClientQueueMetrics& metrics : this->getWorstClientQueues(n))
     {
-        return absl::NotFoundError(absl::StrCat(
-            "HostUserTable failed to remove client.\n",
-            "The host \"", host, "\" of user \"", userToken, "\" was not registered, but should have been."
-        ));
+        if(metrics.numQueuedPackages == 0 && metrics.numSpilledPackages == 0 && metrics.numDroppedPackages == 0)
+        {
+            continue;
+        }
+        const std::string overflow = metrics.overflowDurationMs > 0 ? 
+            absl::StrCat(", exceeding its limits for ", metrics.overflowDurationMs, " ms") : "";
+        Logger::logInfo("HostUserTable: queue of client \"%s:%s\" contains %zu packages (%zu bytes), %zu packages spilled to disk, "
+            "%lu packages dropped%s.",
+            metrics.host.c_str(), metrics.userToken.c_str(), metrics.numQueuedPackages, metrics.numQueuedBytes,
+            metrics.numSpilledPackages, metrics.numDroppedPackages, overflow.c_str());
     }
-    
-    std::vector<std::string>& listOfUsers = it->second;
-    // Remove user from the list of users for that host. 
+}
 
-    auto it2 = std::find(listOfUsers.begin(), listOfUsers.end(), userToken);
-    if(it2 == listOfUsers.end())
+void HostUserTable::startMetricsLogging(std::chrono::seconds interval)
+{
+    std::unique_lock<std::mutex> lock(this->metricsLogMutex);
+    this->metricsLogStopped = false;
+    this->metricsLogThread = std::thread([this, interval]()
     {
-        return absl::NotFoundError(absl::StrCat(
-            "HostUserTable failed to remove user \"", userToken, "\" from list of users of host \"", host, "\".\n",
-            "The user was not found or not registered before."
-        ));
+        std::unique_lock<std::mutex> lock(this->metricsLogMutex);
+        while(!this->metricsLogConditionVariable.wait_for(lock, interval, [this]{ return this->metricsLogStopped; }))
+        {
+            lock.unlock();
+            this->logWorstClientQueues(5);
+            lock.lock();
+        }
+    });
+}
+
+void HostUserTable::stopMetricsLogging()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->metricsLogMutex);
+        this->metricsLogStopped = true;
+    }
+    this->metricsLogConditionVariable.notify_all();
+    if(this->metricsLogThread.joinable())
+    {
+        this->metricsLogThread.join();
     }
+}
 
-    listOfUsers.erase(it2);
-    return absl::OkStatus();
+void HostUserTable::publishHostOutputQueues(const std::string& host, HostOutputQueuesPtr hostOutputQueues)
+{
+    // The map contains one entry per host (not per user), hence copying it is cheap.
+    std::shared_ptr<HostOutputQueuesMap> snapshot = std::make_shared<HostOutputQueuesMap>(*this->hostOutputQueuesMap);
+    (*snapshot)[host] = hostOutputQueues;
+    std::atomic_store(&this->hostOutputQueuesMap, std::shared_ptr<const HostOutputQueuesMap>(snapshot));
 }
 
 }
@@ -24,31 +24,56 @@
 #include "dispatch/core/shared_queue.hh"
 
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <map>
 #include <memory>
-#include <set>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 
 #include "dispatch/proto/claidservice.pb.h"
 #include "dispatch/core/shared_queue.hh"
 #include "dispatch/core/RemoteDispatching/RemoteClientKey.hh"
+#include "dispatch/core/RemoteDispatching/ClientOutputQueue.hh"
 
 
 namespace claid
 {
 
-typedef std::map<RemoteClientKey, std::shared_ptr<SharedQueue<claidservice::DataPackage>>> HostUserQueueMap;
+typedef std::unordered_map<RemoteClientKey, std::shared_ptr<ClientOutputQueue>, RemoteClientKeyHash> HostUserQueueMap;
+
+// Immutable list of the output queues of all users currently connected for a certain host.
+// Published by the HostUserTable whenever a user of the host connects or disconnects.
+// Readers can keep and iterate a list without holding any lock, it is never modified after publication.
+struct HostOutputQueues
+{
+    std::vector<std::string> userTokens;
+    std::vector<std::shared_ptr<ClientOutputQueue>> queues;
+};
+
+typedef std::shared_ptr<const HostOutputQueues> HostOutputQueuesPtr;
 
 // Just as the ModuleTable manages the queues for all local Modules across the available runtimes,
 // The HostUserTable manages the queues for all connected Hosts, possibly representing different users.
 // In other words, the HostUserTable has a queue for each connected user. 
 // Multiple users, however, can run the same host (e.g., multiple participants of a study running the "android_app_host").
+//
+// The table is optimized for routing, i.e., for many concurrent lookups and rare connects/disconnects:
+// - Lookups of single users go to one of several shards, each guarded by a shared (reader/writer) mutex.
+// - Lookups of all users of a host atomically load a snapshot (HostOutputQueues) and never block on connects/disconnects.
+// - Connects and disconnects are serialized among each other and update the indices in O(1).
+//   Afterwards, they publish a new snapshot for the affected host only.
 class HostUserTable 
 {
   public:
     HostUserTable();
-    virtual ~HostUserTable() {}
+    virtual ~HostUserTable();
 
     inline std::shared_ptr<SharedQueue<claidservice::DataPackage>> inputQueue() { return fromClientsQueue; }
 
@@ -58,36 +83,90 @@ class HostUserTable
     // This function looks up the queue for one specific user connected to the current host.
     absl::Status lookupOutputQueueForHostUser(const std::string& host, const std::string& userToken, std::shared_ptr<SharedQueue<claidservice::DataPackage>>& queue);
 
+    // Same as above, but returns the ClientOutputQueue, which enforces the ClientQueueLimits when pushing.
+    // Preferred for routing.
+    absl::Status lookupClientOutputQueue(const std::string& host, const std::string& userToken, std::shared_ptr<ClientOutputQueue>& queue);
+
     // Looks up output queue for all users running the same host (i.e., address host:*)
     absl::Status lookupOutputQueuesForHost(const std::string& host, std::vector<std::shared_ptr<SharedQueue<claidservice::DataPackage>>>& queues);
 
+    // Same as above, but returns the current snapshot of the queues without copying them.
+    // Preferred for routing, as it neither copies nor locks.
+    absl::Status lookupOutputQueuesForHost(const std::string& host, HostOutputQueuesPtr& queues);
+
     // Typically called when a user connects to the current host (i.e., the current instance of CLAID).
     // Registers the user with the current server.
     absl::Status addRemoteClient(const std::string& host, const std::string& userToken, const std::string& deviceID);
     absl::Status removeRemoteClient(const std::string& host, const std::string& userToken, const std::string& deviceID);
 
+    // Limits applied to the output queues of clients connecting afterwards.
+    // By default, the queues are unlimited.
+    void setClientQueueLimits(const claidservice::ClientQueueLimits& limits);
+
+    // Called if a client has to be disconnected, because its output queue exceeded the limits for too long.
+    // Set by the RemoteDispatcherServer.
+    void setDisconnectClientFunction(ClientOutputQueue::DisconnectFunction disconnectClientFunction);
+
+    // Returns the metrics of the (at most) n client queues with the most queued bytes (or packages, if bytes are equal).
+    std::vector<ClientQueueMetrics> getWorstClientQueues(size_t n);
+
+    // Logs the metrics of the (at most) n worst client queues which contain, spilled or dropped packages.
+    // Called periodically according to the metrics_log_interval_seconds of the ClientQueueLimits.
+    void logWorstClientQueues(size_t n);
+
   private:
+    typedef std::unordered_map<std::string, HostOutputQueuesPtr> HostOutputQueuesMap;
+
+    struct UserQueueShard
+    {
+        std::shared_mutex mutex;
+        HostUserQueueMap hostUserQueueMap;
+    };
+
+    static const size_t NUM_SHARDS = 16;
+
+    UserQueueShard& shardOf(const RemoteClientKey& key);
+
+    // Publishes a new snapshot for the given host (has to be called while holding the writerMutex).
+    void publishHostOutputQueues(const std::string& host, HostOutputQueuesPtr hostOutputQueues);
+
+    void disconnectClient(const std::string& host, const std::string& userToken);
+
+    void startMetricsLogging(std::chrono::seconds interval);
+    void stopMetricsLogging();
     
     // Queue where the clients output their received packages to.
     std::shared_ptr<SharedQueue<claidservice::DataPackage>> fromClientsQueue;
 
-    // Maps <host, user> to the corresponding queue.
+    // Maps <host, user> to the corresponding queue, sharded by the hash of <host, user>.
     // Each queue will be used by a corresponding RemoteClientHandler.
-    HostUserQueueMap hostUserQueueMap;
+    std::array<UserQueueShard, NUM_SHARDS> userQueueShards;
 
     // Multiple users can run the same host.
-    // This map stores connected users for each host.
+    // This snapshot stores the connected users (and their queues) for each host.
     // In other words, you can use this map to find out 
     // which *connected* users run a certain host.
-    std::map<std::string, std::vector<std::string>> hostToUserMap;
-    
-    // Recursive_mutex, because a calling thread might 
-    // make sub calls to lookupOutputQueueForHostUser e.g. from the lookupOutputQueuesForHost function.
-    std::recursive_mutex hostUserTableMutex;
+    // Only accessed via std::atomic_load and std::atomic_store, the map itself is never modified after publication.
+    std::shared_ptr<const HostOutputQueuesMap> hostOutputQueuesMap;
 
+    // Position of each user in the HostOutputQueues of its host, allows to remove users in O(1). 
+    // Only used by connects/disconnects.
+    std::unordered_map<RemoteClientKey, size_t, RemoteClientKeyHash> userPositions;
 
+    // Serializes connects and disconnects. Lookups never acquire this mutex.
+    std::mutex writerMutex;
 
-    
+    // Only accessed while holding the writerMutex.
+    claidservice::ClientQueueLimits clientQueueLimits;
+    std::shared_ptr<ClientOutputQueueRefiller> clientQueueRefiller;
+
+    std::mutex disconnectClientMutex;
+    ClientOutputQueue::DisconnectFunction disconnectClientFunction;
+
+    std::mutex metricsLogMutex;
+    std::condition_variable metricsLogConditionVariable;
+    std::thread metricsLogThread;
+    bool metricsLogStopped = false;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/RemoteDispatching/ReconnectBackoff.hh"
+
+#include <algorithm>
+
+namespace claid
+{
+    ReconnectBackoff::ReconnectBackoff(Duration initialBackoff, Duration maxBackoff, double multiplier, double jitter) :
+        initialBackoffMs(initialBackoff.getMilliSeconds()), 
+        maxBackoffMs(std::max(initialBackoff.getMilliSeconds(), maxBackoff.getMilliSeconds())),
+        multiplier(multiplier), jitter(jitter), currentBackoffMs(initialBackoffMs), randomGenerator(std::random_device()())
+    {
+
+    }
+
+    Duration ReconnectBackoff::nextDelay()
+    {
+        std::uniform_real_distribution<double> distribution(1.0 - this->jitter, 1.0 + this->jitter);
+        const double delayMs = this->currentBackoffMs * distribution(this->randomGenerator);
+
+        this->currentBackoffMs = std::min(this->currentBackoffMs * this->multiplier, this->maxBackoffMs);
+        this->numAttempts++;
+        return Duration::milliseconds(static_cast<int>(delayMs));
+    }
+
+    void ReconnectBackoff::reset()
+    {
+        this->currentBackoffMs = this->initialBackoffMs;
+        this->numAttempts = 0;
+    }
+
+    size_t ReconnectBackoff::getNumAttempts() const
+    {
+        return this->numAttempts;
+    }
+}
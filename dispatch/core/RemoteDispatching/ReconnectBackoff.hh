@@ -0,0 +1,58 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include "dispatch/core/Utilities/Time.hh"
+
+#include <random>
+
+namespace claid
+{
+    // Jittered exponential backoff for the reconnect attempts of the RemoteDispatcherClient.
+    // Each delay is the current backoff, randomized by +-jitter, after which the backoff grows by the multiplier
+    // up to maxBackoff. The randomization prevents clients that lost their connection at the same time 
+    // (e.g., because the server restarted) from reconnecting to the server at the same time.
+    class ReconnectBackoff
+    {
+    public:
+        ReconnectBackoff(Duration initialBackoff, Duration maxBackoff, double multiplier = 1.6, double jitter = 0.2);
+
+        // Returns the delay before the next attempt and increases the backoff.
+        Duration nextDelay();
+
+        // Has to be called after a successful attempt.
+        void reset();
+
+        size_t getNumAttempts() const;
+
+    private:
+        const double initialBackoffMs;
+        const double maxBackoffMs;
+        const double multiplier;
+        const double jitter;
+
+        double currentBackoffMs;
+        size_t numAttempts = 0;
+
+        std::mt19937 randomGenerator;
+    };
+}
@@ -70,6 +70,9 @@ namespace claid
 
         grpc::ServerReaderWriter<claidservice::DataPackage, claidservice::DataPackage>* writeStream = nullptr;
 
+        // Context of the SendReceivePackages call of the client, allows to cancel the call.
+        grpc::ServerContext* serverContext = nullptr;
+
         std::mutex writeThreadMutex; // protects the write thread
         std::mutex pingMutex;
         std::unique_ptr<std::thread> writeThread;
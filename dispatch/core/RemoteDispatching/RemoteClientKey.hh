@@ -23,6 +23,7 @@
 
 #include "dispatch/proto/claidservice.pb.h"
 
+#include <functional>
 #include <map>
 #include <sstream>
 
@@ -42,6 +43,16 @@ inline RemoteClientKey makeRemoteClientKey(const RemoteClientInfo& info)
     return makeRemoteClientKey(info.host(), info.user_token());
 }
 
+// Allows to use RemoteClientKeys in unordered containers.
+struct RemoteClientKeyHash
+{
+    size_t operator()(const RemoteClientKey& key) const
+    {
+        size_t hostHash = std::hash<std::string>()(key.first);
+        return hostHash ^ (std::hash<std::string>()(key.second) + 0x9e3779b97f4a7c15ULL + (hostHash << 6) + (hostHash >> 2));
+    }
+};
+
 inline std::string makeRemoteClientIdentifier(const RemoteClientInfo& info)
 {
     std::stringstream ss;
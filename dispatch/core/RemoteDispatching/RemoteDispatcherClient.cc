@@ -75,42 +75,59 @@ namespace claid
 
     void RemoteDispatcherClient::shutdown() 
     {
-        Logger::logWarning("RemoteDispatcherClient shutdown 1");
         if(!this->connectionMonitorRunning)
         {
             return;
         }
-        // Closing the outgoing queue will end the writer thread.
-        // The writer thread will invoke stream->WritesDone() after the outgoingQueue was closed.
-        // This will close the stream and also abort stream->Read() for the reader thread.
-        Logger::logWarning("RemoteDispatcherClient shutdown 2");
-        Logger::logWarning("RemoteDispatcherClient shutdown 3");
+        Logger::logInfo("RemoteDispatcherClient shutdown");
 
-        this->connectionMonitorRunning = false;
-        this->connected = false;
-                this->clientTable.getToRemoteClientQueue().interruptOnce();
-
-                Logger::logWarning("RemoteDispatcherClient shutdown 4");
-
-       // this->stream->Finish();
+        {
+            std::unique_lock<std::mutex> lock(this->connectionMutex);
+            this->connectionMonitorRunning = false;
+            this->connectionStateChanged.notify_all();
+        }
 
+        // The writer thread invokes stream->WritesDone() when it stops, which lets the server close the stream.
+        stopWriterThread();
 
-        // Do not do this here!
-        // WriteThread will be shut down in monitoring function.
-        // if (this->writeThread) 
-        // {
-        //     this->writeThread->join();
-        //     this->writeThread = nullptr;
-        // }
+        // Ends stream->Read() of the monitor thread (or a pending handshake), even if the server is not reachable anymore.
+        {
+            std::unique_lock<std::mutex> lock(this->connectionMutex);
+            if(this->streamContext != nullptr)
+            {
+                this->streamContext->TryCancel();
+            }
+        }
 
-        Logger::logWarning("RemoteDispatcherClient shutdown 6");
         if (this->watcherAndReaderThreader) 
         {
             this->watcherAndReaderThreader->join();
             this->watcherAndReaderThreader = nullptr;
         }
-        Logger::logWarning("RemoteDispatcherClient shutdown 7");
+        this->connected = false;
+        Logger::logInfo("RemoteDispatcherClient shutdown done");
+    }
 
+    void RemoteDispatcherClient::stopWriterThread()
+    {
+        if(this->writeThread == nullptr)
+        {
+            return;
+        }
+
+        // The writer thread might be blocked in interruptable_pop_front(), which does not know about our state.
+        // An interrupt is lost if the writer thread is just about to wait, hence we interrupt until the writer has stopped.
+        SharedQueue<DataPackage>& toRemoteClientQueue = this->clientTable.getToRemoteClientQueue();
+        std::unique_lock<std::mutex> lock(this->connectionMutex);
+        while(this->writerRunning)
+        {
+            toRemoteClientQueue.interruptOnce();
+            this->connectionStateChanged.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        lock.unlock();
+
+        this->writeThread->join();
+        this->writeThread = nullptr;
     }
 
     void makeRemoteRuntimePing(ControlPackage& pkt, const std::string& host, 
@@ -126,87 +143,41 @@ namespace claid
 
     void RemoteDispatcherClient::connectAndMonitorConnection() 
     {
+        ReconnectBackoff backoff(this->initialReconnectBackoff, this->maxReconnectBackoff);
+
         while(this->connectionMonitorRunning)
         {
             Logger::logInfo("RemoteDispatcherClient is trying to establish a connection.");
-            streamContext = std::make_shared<grpc::ClientContext>();
-
-            const int RECONNECT_TIMEOUT_SECONDS = 10;
-            auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(RECONNECT_TIMEOUT_SECONDS);
-            // Note: If the server is unreachable, this will wait 10 seconds.
-            // HOWEVER: If the server is reachable, but it denies our request (does not accept connection), this will not wait.
-            // ONLY waits if server is NOT reachable. Does NOT wait if we connect successfully OR server rejects us :)
-            bool connected = grpcChannel->WaitForConnected(deadline);
-
-
-            grpc_connectivity_state state = grpcChannel->GetState(/* try_to_connect */ true);
-
-            if (!(connected && state == GRPC_CHANNEL_READY))
+            if(!waitUntilChannelReady())
             {
-                Logger::logInfo("SERVER UNAVAILABLE");
-                this->lastStatus = absl::UnavailableError("RemoteDispatcherClient failed to connect to remote server. Server unreachable.");
                 continue;
             }
 
-            stream = stub->SendReceivePackages(streamContext.get());
-
-            if(!stream)
+            absl::Status status = openStreamAndHandshake();
+            if(!status.ok())
             {
-                this->lastStatus = absl::UnavailableError("RemoteDispatcherClient failed to connect to remote server. Stream is null.");
+                this->lastStatus = status;
+                Duration delay = backoff.nextDelay();
+                Logger::logWarning("RemoteDispatcherClient failed to connect (attempt %zu), retrying in %llu ms: %s", 
+                    backoff.getNumAttempts(), static_cast<unsigned long long>(delay.getMilliSeconds()), status.ToString().c_str());
+                waitForReconnectDelay(delay);
                 continue;
             }
-
-            claidservice::DataPackage pingRequestPackage;
-            makeRemoteRuntimePing(*pingRequestPackage.mutable_control_val(), this->host, this->userToken, this->deviceID);
-
-            Logger::logInfo("Sending ping package");
-
-            if (!stream->Write(pingRequestPackage)) 
-            {
-                grpc::Status status = stream->Finish();
-                this->lastStatus = absl::InvalidArgumentError(absl::StrCat(
-                    "RemoteDispatcherClient failed to send ping package to server. Received error \"", status.error_message(), "\"\n"
-                ));
-            }                
-        
-            Logger::logInfo("Waiting for ping response");
-
-            // Wait for the valid response ping
-            DataPackage pingResp;
-            if (!stream->Read(&pingResp)) {
-                auto status = stream->Finish();
-                this->lastStatus = absl::InvalidArgumentError(absl::StrCat(
-                    "RemoteDispatcherClient failed to receive a ping package from the server. Received error \"", status.error_message(), "\"."
-                ));
-            }
-
-            if (pingResp.control_val().ctrl_type() != CtrlType::CTRL_REMOTE_PING) 
-            {
-                this->lastStatus = absl::InvalidArgumentError(absl::StrCat(
-                    "RemoteDispatcherClient received ControlPackage package from server during handshake, however the package has an unexpected ControlType.\n",
-                    "Expected ControlType \"", CtrlType_Name(CtrlType::CTRL_REMOTE_PING), "\", but got \"", CtrlType_Name(pingResp.control_val().ctrl_type()), "\""
-                ));
-            }
-            this->connected = true;
+            backoff.reset();
             this->lastStatus = absl::OkStatus();
-
             this->lastTimePackageWasSent = Time::now();
 
-            // Start the thread to service the input/output queues.
-            writeThread = std::make_unique<std::thread>([this]() { processWriting(); });
-            
+            // The server has registered us before answering the handshake, hence queued packages can be sent right away.
+            setConnected(true);
             Logger::logInfo("RemoteDispatcherClient setup successful");
-            std::this_thread::sleep_for(std::chrono::milliseconds(2000));
 
             this->onConnectedToServer();
             // Blocks as long as we are connected
             processReading();
 
+            setConnected(false);
             this->onDisconnectedFromServer();
-
-            Logger::logInfo("RemoteDispatcherClient lost connection, stopping reader and writer.");
-            this->connected = false;
-            this->clientTable.getToRemoteClientQueue().interruptOnce();
+            Logger::logInfo("RemoteDispatcherClient lost connection.");
 
             // TODO: Check if we have to call stream->Finish().
             // By this point, the stream should already be cancelled/ended, becase processReading keeps blocking
@@ -215,17 +186,107 @@ namespace claid
             // a client connected with the same user id), the application would crash if we call stream->Finish() due to 
             // "API misuse of type GRPC_CALL_ERROR_TOO_MANY_OPERATIONS observed".
            // this->stream->Finish();
-            
-            Logger::logInfo("RemoteDispatcherClient waiting for writerThread to join.");
 
-            if(writeThread != nullptr)
+            // Short randomized delay, so that clients which lost their connection at the same time (e.g., because the server restarted),
+            // do not all reconnect at the same time.
+            waitForReconnectDelay(backoff.nextDelay());
+        }    
+    }
+
+    bool RemoteDispatcherClient::waitUntilChannelReady()
+    {
+        // The channel (re)connects on its own (see the reconnect backoff arguments in createGRPCChannelToServer).
+        // We only watch its connectivity state, hence we notice immediately once the server is reachable.
+        // The state is watched in slices to notice a shutdown.
+        const std::chrono::milliseconds WATCH_SLICE(500);
+
+        grpc_connectivity_state state = this->grpcChannel->GetState(/* try_to_connect */ true);
+        while(this->connectionMonitorRunning && state != GRPC_CHANNEL_READY)
+        {
+            if(state == GRPC_CHANNEL_TRANSIENT_FAILURE)
             {
-                writeThread->join();
-                writeThread = nullptr;
+                this->lastStatus = absl::UnavailableError("RemoteDispatcherClient failed to connect to remote server. Server unreachable.");
             }
-            
-            Logger::logInfo("RemoteDispatcherClient is reset.");
-        }    
+            this->grpcChannel->WaitForStateChange(state, std::chrono::system_clock::now() + WATCH_SLICE);
+            state = this->grpcChannel->GetState(/* try_to_connect */ true);
+        }
+        return state == GRPC_CHANNEL_READY && this->connectionMonitorRunning;
+    }
+
+    absl::Status RemoteDispatcherClient::openStreamAndHandshake()
+    {
+        std::shared_ptr<grpc::ClientContext> context = std::make_shared<grpc::ClientContext>();
+        {
+            // Publish the context before starting the call, so that shutdown() can cancel the handshake.
+            std::unique_lock<std::mutex> lock(this->connectionMutex);
+            if(!this->connectionMonitorRunning)
+            {
+                return absl::CancelledError("RemoteDispatcherClient was shut down.");
+            }
+            this->streamContext = context;
+        }
+
+        std::shared_ptr<grpc::ClientReaderWriter<claidservice::DataPackage, claidservice::DataPackage>> newStream = 
+            stub->SendReceivePackages(context.get());
+        if(!newStream)
+        {
+            return absl::UnavailableError("RemoteDispatcherClient failed to connect to remote server. Stream is null.");
+        }
+
+        claidservice::DataPackage pingRequestPackage;
+        makeRemoteRuntimePing(*pingRequestPackage.mutable_control_val(), this->host, this->userToken, this->deviceID);
+
+        Logger::logInfo("Sending ping package");
+        if (!newStream->Write(pingRequestPackage)) 
+        {
+            grpc::Status status = newStream->Finish();
+            return absl::InvalidArgumentError(absl::StrCat(
+                "RemoteDispatcherClient failed to send ping package to server. Received error \"", status.error_message(), "\"\n"
+            ));
+        }                
+    
+        Logger::logInfo("Waiting for ping response");
+
+        // Wait for the valid response ping
+        DataPackage pingResp;
+        if (!newStream->Read(&pingResp)) 
+        {
+            grpc::Status status = newStream->Finish();
+            return absl::InvalidArgumentError(absl::StrCat(
+                "RemoteDispatcherClient failed to receive a ping package from the server. Received error \"", status.error_message(), "\"."
+            ));
+        }
+
+        if (pingResp.control_val().ctrl_type() != CtrlType::CTRL_REMOTE_PING) 
+        {
+            context->TryCancel();
+            return absl::InvalidArgumentError(absl::StrCat(
+                "RemoteDispatcherClient received ControlPackage package from server during handshake, however the package has an unexpected ControlType.\n",
+                "Expected ControlType \"", CtrlType_Name(CtrlType::CTRL_REMOTE_PING), "\", but got \"", CtrlType_Name(pingResp.control_val().ctrl_type()), "\""
+            ));
+        }
+
+        std::unique_lock<std::mutex> lock(this->connectionMutex);
+        this->stream = newStream;
+        return absl::OkStatus();
+    }
+
+    void RemoteDispatcherClient::waitForReconnectDelay(Duration delay)
+    {
+        std::unique_lock<std::mutex> lock(this->connectionMutex);
+        this->connectionStateChanged.wait_for(lock, std::chrono::milliseconds(delay.getMilliSeconds()), 
+            [this]() { return !this->connectionMonitorRunning; });
+    }
+
+    void RemoteDispatcherClient::setConnected(bool connected)
+    {
+        std::unique_lock<std::mutex> lock(this->connectionMutex);
+        if(connected)
+        {
+            this->connectionId++;
+        }
+        this->connected = connected;
+        this->connectionStateChanged.notify_all();
     }
 
     void RemoteDispatcherClient::createGRPCChannelToServer()
@@ -243,6 +304,12 @@ namespace claid
     
         // Set the maximum send message size (in bytes)
         args.SetInt(GRPC_ARG_MAX_SEND_MESSAGE_LENGTH, -1);  // -1 means unlimited
+
+        // gRPC waits up to 120 seconds between connection attempts by default, which is too long for devices
+        // on unreliable (mobile) networks. Use the same backoff as for the handshake instead.
+        args.SetInt(GRPC_ARG_INITIAL_RECONNECT_BACKOFF_MS, this->initialReconnectBackoff.getMilliSeconds());
+        args.SetInt(GRPC_ARG_MIN_RECONNECT_BACKOFF_MS, this->initialReconnectBackoff.getMilliSeconds());
+        args.SetInt(GRPC_ARG_MAX_RECONNECT_BACKOFF_MS, this->maxReconnectBackoff.getMilliSeconds());
     
         grpcChannel = grpc::CreateCustomChannel(addressToConnectTo, makeChannelCredentials(), args);
         stub = claidservice::ClaidRemoteService::NewStub(grpcChannel);
@@ -250,17 +317,25 @@ namespace claid
 
     absl::Status RemoteDispatcherClient::start()
     {
-        createGRPCChannelToServer();
-
         if(this->connectionMonitorRunning)
         {
             return absl::AlreadyExistsError("RemoteDispatcherClient was started twice");
         }
+        createGRPCChannelToServer();
+
         this->connectionMonitorRunning = true;
+        this->writerRunning = true;
+        writeThread = std::make_unique<std::thread>([this]() { processWriting(); });
         watcherAndReaderThreader = std::make_unique<std::thread>([this]() { connectAndMonitorConnection(); });
         return absl::OkStatus();
     }
 
+    void RemoteDispatcherClient::setReconnectBackoff(Duration initialBackoff, Duration maxBackoff)
+    {
+        this->initialReconnectBackoff = initialBackoff;
+        this->maxReconnectBackoff = maxBackoff;
+    }
+
     absl::Status RemoteDispatcherClient::start(const TLSClientKeyStore& clientKeyStore)
     {
         this->useTLS = true;
@@ -322,25 +397,60 @@ namespace claid
     void RemoteDispatcherClient::processWriting() 
     {
         Logger::logInfo("RemoteDispatcherClient: processWriting()");
+        SharedQueue<DataPackage>& toRemoteClientQueue = this->clientTable.getToRemoteClientQueue();
 
-        while(this->connected) 
+        bool queueClosed = false;
+        // Connection whose stream failed to write, we have to wait for the next one.
+        uint64_t brokenConnectionId = 0;
+        while(!queueClosed)
         {
-            SharedQueue<DataPackage>& toRemoteClientQueue = this->clientTable.getToRemoteClientQueue();
-            auto pkt = toRemoteClientQueue.interruptable_pop_front();
-            Logger::logWarning("RemoteDispatcherClient processwriting woke up!");
-            if (!pkt) 
+            // Wait until we are connected, packages remain in the queue in the meantime.
+            std::shared_ptr<grpc::ClientReaderWriter<claidservice::DataPackage, claidservice::DataPackage>> stream;
+            uint64_t streamConnectionId;
             {
-                // It's alright, null pkt can happen due to spurious wakeups or when toRemoteClientQueue.interruptOnce() is called.
-                // interruptable_pop_front() waits but can be woken up due to spurious wakeups, in contrast to pop_front() which will always 
-                // ever return if data is really available, or the channel is closed.
-                if (toRemoteClientQueue.is_closed()) 
+                std::unique_lock<std::mutex> lock(this->connectionMutex);
+                this->connectionStateChanged.wait(lock, [&]() 
+                { 
+                    return (this->connected && this->connectionId != brokenConnectionId) || !this->connectionMonitorRunning; 
+                });
+                if(!this->connectionMonitorRunning)
                 {
-                    Logger::logInfo("RemoteDispatcherClient: pkt is null and queue is closed, shutting down.");
                     break;
                 }
-            } 
-            else 
+                stream = this->stream;
+                streamConnectionId = this->connectionId;
+            }
+
+            while(true)
             {
+                auto pkt = toRemoteClientQueue.interruptable_pop_front();
+                if (!pkt) 
+                {
+                    // It's alright, null pkt can happen due to spurious wakeups or when toRemoteClientQueue.interruptOnce() is called.
+                    // interruptable_pop_front() waits but can be woken up due to spurious wakeups, in contrast to pop_front() which will always 
+                    // ever return if data is really available, or the channel is closed.
+                    if (toRemoteClientQueue.is_closed()) 
+                    {
+                        Logger::logInfo("RemoteDispatcherClient: pkt is null and queue is closed, shutting down.");
+                        queueClosed = true;
+                        stream->WritesDone();
+                        break;
+                    }
+                    if(!this->connectionMonitorRunning)
+                    {
+                        stream->WritesDone();
+                        break;
+                    }
+                    continue;
+                }
+
+                // The connection was lost (and possibly reestablished) while we were waiting for the package.
+                if(!this->connected || this->connectionId != streamConnectionId)
+                {
+                    toRemoteClientQueue.push_front(pkt);
+                    break;
+                }
+
                 // If the last time we send a package is > then CONNECTION_TIMEOUT_INTERVAL,
                 // we first send a ping package to the Server to test whether the connection is alive.
                 // If we or the server lost connection to the internet, then the connection might have faded silently,
@@ -348,37 +458,48 @@ namespace claid
                 // Hence, before we send the actual package, we first send a ping package to test whether the stream is alive.
                 // We do not care about the response to that ping, but only whether stream->Write() still returns successfully.
                 // If it does not, the connection is dead and we reenqueue the package to be sent later, when we have reconnected.
-
                 Time currentTime = Time::now();
                 Duration timeSinceLastPackage = currentTime.subtract(this->lastTimePackageWasSent);
+                bool streamAlive = true;
                 if(timeSinceLastPackage > MAX_TIME_WITHOUT_PACKAGE_BEFORE_TESTING_TIMEOUT)
                 {
                     claidservice::DataPackage pingRequestPackage;
                     makeRemoteRuntimePing(*pingRequestPackage.mutable_control_val(), this->host, this->userToken, this->deviceID);
                     if(!stream->Write(pingRequestPackage))
                     {
-                        Logger::logWarning("RemoteDispatcherClient tried to send a message to the server after not having sent a message for %d minutes.\n",
-                                           "Since a package has not been sent for a while, a ping package was sent to the server to test whether the connection is still alive.\n",
-                                           "Such a ping package will be sent before an actual package, if the last actual package was sent more than %d minutes ago.\n",
-                                           "While sending that ping package, it was noticed that the connection is actually dead. Hence, we are closing the connection on\n",
-                                           "The side of the RemoteDispatcherClient as well and try to reconnect soon. The actual package will be reenqueued to be sent once the connection is reestablished.");
-                        toRemoteClientQueue.push_front(pkt);
-                        break;
+                        Logger::logWarning("RemoteDispatcherClient tried to send a message to the server after not having sent a message for a while.\n"
+                                           "While sending a ping package to test the connection, it was noticed that the connection is actually dead.\n"
+                                           "The package will be sent once the connection is reestablished.");
+                        streamAlive = false;
                     }
-                    
                 }
-                
 
-                if (!stream->Write(*pkt)) 
+                if (streamAlive && !stream->Write(*pkt)) 
                 {
                     // Server is down?
-                    Logger::logWarning("Failed to write to remote server. RemoteDispatcherClient is lost connection.");
+                    Logger::logWarning("Failed to write to remote server. RemoteDispatcherClient lost connection.");
+                    streamAlive = false;
+                }
+
+                if(!streamAlive)
+                {
+                    // Keep the package for the next connection and let the reader notice the broken stream right away.
+                    toRemoteClientQueue.push_front(pkt);
+                    brokenConnectionId = streamConnectionId;
+                    std::unique_lock<std::mutex> lock(this->connectionMutex);
+                    if(this->connectionId == streamConnectionId && this->streamContext != nullptr)
+                    {
+                        this->streamContext->TryCancel();
+                    }
                     break;
                 }
                 this->lastTimePackageWasSent = Time::now();
             }
         }
-        this->stream->WritesDone();
+
+        std::unique_lock<std::mutex> lock(this->connectionMutex);
+        this->writerRunning = false;
+        this->connectionStateChanged.notify_all();
         Logger::logInfo("RemoteDispatcherClient processWriting done");
     }
 
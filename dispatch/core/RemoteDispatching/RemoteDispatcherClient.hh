@@ -26,10 +26,14 @@
 #include "dispatch/core/RemoteDispatching/ClientTable.hh"
 #include "dispatch/core/Utilities/Time.hh"
 #include "dispatch/core/RemoteDispatching/TLSClientKeyStore.hh"
+#include "dispatch/core/RemoteDispatching/ReconnectBackoff.hh"
 
 #include <grpc/grpc.h>
 #include <grpcpp/create_channel.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 using claidservice::DataPackage;
@@ -39,6 +43,13 @@ using claidservice::RemoteClientInfo;
 
 namespace claid
 {
+    // Connects to a RemoteDispatcherServer and keeps the connection alive.
+    // The connection is monitored by a single thread, which:
+    // 1. Watches the connectivity state of the (long-lived) gRPC channel until it is ready.
+    // 2. Opens the stream and performs the handshake (CTRL_REMOTE_PING).
+    // 3. Reads packages until the stream breaks.
+    // Failed attempts are retried after a jittered exponential backoff, which is reset after each successful handshake.
+    // The writer thread lives as long as the client and resumes sending queued packages as soon as a new stream is established.
     class RemoteDispatcherClient
     {
       
@@ -55,6 +66,9 @@ namespace claid
             absl::Status start();
             absl::Status start(const TLSClientKeyStore& clientKeyStore);
 
+            // Has to be called before start().
+            void setReconnectBackoff(Duration initialBackoff, Duration maxBackoff);
+
             bool isConnected() const;
             absl::Status getLastStatus() const;
 
@@ -66,6 +80,12 @@ namespace claid
             void processPacket(DataPackage& pkt);
             
             void connectAndMonitorConnection();
+            bool waitUntilChannelReady();
+            absl::Status openStreamAndHandshake();
+            void waitForReconnectDelay(Duration delay);
+
+            void setConnected(bool connected);
+            void stopWriterThread();
 
             void onConnectedToServer();
             void onDisconnectedFromServer();
@@ -82,10 +102,20 @@ namespace claid
             const std::string userToken;
             const std::string deviceID;
 
-            bool connected = false;
-            bool connectionMonitorRunning = false;
+            std::atomic<bool> connected{false};
+            std::atomic<bool> connectionMonitorRunning{false};
             absl::Status lastStatus;
 
+            // Protects stream, streamContext and connectionId, which are replaced on each reconnect.
+            std::mutex connectionMutex;
+            std::condition_variable connectionStateChanged;
+            // Incremented for each established stream, allows the writer thread to find out whether its stream is outdated.
+            std::atomic<uint64_t> connectionId{0};
+            bool writerRunning = false;
+
+            Duration initialReconnectBackoff = Duration::milliseconds(100);
+            Duration maxReconnectBackoff = Duration::seconds(30);
+
             Time lastTimePackageWasSent;
 
             static Duration MAX_TIME_WITHOUT_PACKAGE_BEFORE_TESTING_TIMEOUT;
@@ -103,6 +133,7 @@ namespace claid
             // If connected, this thread reads packages.
             // Upon disconnet, the reading stops and the thread tries to reconnect.
             std::unique_ptr<std::thread> watcherAndReaderThreader;
+            // Writes packages to the current stream, waits while disconnected.
             std::unique_ptr<std::thread> writeThread;
 
             bool useTLS = false;
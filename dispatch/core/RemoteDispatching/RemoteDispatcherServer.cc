@@ -33,7 +33,15 @@
 namespace claid 
 {
     RemoteDispatcherServer::RemoteDispatcherServer(const std::string& addr, HostUserTable& hostUserTable)
-        : addr(addr), remoteServiceImpl(hostUserTable)
+        : RemoteDispatcherServer(addr, hostUserTable, claidservice::RemoteServerThreadingModel::REMOTE_SERVER_THREADING_SYNC)
+    {
+
+    }
+
+    RemoteDispatcherServer::RemoteDispatcherServer(const std::string& addr, HostUserTable& hostUserTable, 
+        claidservice::RemoteServerThreadingModel threadingModel, size_t numAsyncServerThreads)
+        : addr(addr), hostUserTable(hostUserTable), threadingModel(threadingModel), 
+            numAsyncServerThreads(numAsyncServerThreads), remoteServiceImpl(hostUserTable)
     {
 
     }
@@ -59,6 +67,24 @@ namespace claid
                 absl::StrCat("Failed to start RemoteDispatcherServer with address \"", this->addr, "\"."));
         }
 
+        if(this->asyncRemoteService != nullptr)
+        {
+            this->asyncRemoteService->start();
+        }
+
+        // Allows the HostUserTable to disconnect clients which exceed their ClientQueueLimits for too long.
+        this->hostUserTable.setDisconnectClientFunction([this](const std::string& host, const std::string& userToken)
+        {
+            if(this->asyncRemoteService != nullptr)
+            {
+                this->asyncRemoteService->disconnectRemoteClient(host, userToken);
+            }
+            else
+            {
+                this->remoteServiceImpl.disconnectRemoteClient(host, userToken);
+            }
+        });
+
         this->running = true;
 
         return absl::OkStatus();
@@ -77,12 +103,17 @@ namespace claid
         {
             return;
         }
+        this->hostUserTable.setDisconnectClientFunction(nullptr);
         
         // server->Shutdown() will hang indefintely as long as there are still ongoing RPC calls by any client.
         // The clients call SendReceivePackages to stream data to/from the server. The SendReceivePackage RPC call
         // typically never returns, as long as the client is alive.
         // Hence, we have to forcefully end all client's RPC calls registered in the RemoteService.
-        this->remoteServiceImpl.shutdown();
+        // The AsyncRemoteService does not block any threads, its calls are cancelled by server->Shutdown().
+        if(this->asyncRemoteService == nullptr)
+        {
+            this->remoteServiceImpl.shutdown();
+        }
         // Now we can safely call server->Shutdown();
 
         // Without deadline, server->Shutdown() will wait indefinitely for all rpc calls to finish.
@@ -93,14 +124,31 @@ namespace claid
 
         server->Shutdown(deadline);
 
+        if(this->asyncRemoteService != nullptr)
+        {
+            this->asyncRemoteService->shutdown();
+        }
+
         this->running = false;
     }
 
     void RemoteDispatcherServer::buildAndStartServer()
     {
+        // Release the server and service of a previous start (the server needs to be destroyed first).
+        this->server = nullptr;
+        this->asyncRemoteService = nullptr;
+
         grpc::ServerBuilder builder;
         builder.AddListeningPort(addr, makeServerCredentials());
-        builder.RegisterService(&remoteServiceImpl);
+        if(this->threadingModel == claidservice::RemoteServerThreadingModel::REMOTE_SERVER_THREADING_ASYNC)
+        {
+            this->asyncRemoteService = std::make_unique<AsyncRemoteService>(this->hostUserTable, this->numAsyncServerThreads);
+            this->asyncRemoteService->registerService(builder);
+        }
+        else
+        {
+            builder.RegisterService(&remoteServiceImpl);
+        }
         builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS,
                                     10 * 60 * 1000 /*10 min*/);
         builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
@@ -27,6 +27,7 @@
 #include <grpcpp/server.h>
 
 #include "dispatch/core/RemoteDispatching/RemoteService.hh"
+#include "dispatch/core/RemoteDispatching/AsyncRemoteService.hh"
 
 #include "absl/strings/str_split.h"
 #include "absl/status/status.h"
@@ -39,6 +40,11 @@ namespace claid
   {
     public:
       RemoteDispatcherServer(const std::string& addr, HostUserTable& hostUserTable);
+
+      // With REMOTE_SERVER_THREADING_ASYNC, clients are served by the AsyncRemoteService using numAsyncServerThreads
+      // completion queue threads (0 = number of hardware threads) instead of by the RemoteServiceImpl.
+      RemoteDispatcherServer(const std::string& addr, HostUserTable& hostUserTable, 
+        claidservice::RemoteServerThreadingModel threadingModel, size_t numAsyncServerThreads = 0);
       
       virtual ~RemoteDispatcherServer();
 
@@ -56,7 +62,15 @@ namespace claid
 
       bool running = false;
 
+      HostUserTable& hostUserTable;
+      const claidservice::RemoteServerThreadingModel threadingModel;
+      const size_t numAsyncServerThreads;
+
       RemoteServiceImpl remoteServiceImpl;
+
+      // Recreated for every start, as an async service can only be registered with a single grpc::Server.
+      // Has to be declared before the server, as the server needs to be destroyed first.
+      std::unique_ptr<AsyncRemoteService> asyncRemoteService;
       std::unique_ptr<grpc::Server> server;
 
       bool useTLS = false;
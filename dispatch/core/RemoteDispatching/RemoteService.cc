@@ -52,7 +52,7 @@ namespace claid
         std::cout << "Client \"" << makeRemoteClientIdentifier(remoteClientInfo) << " connected!\n";
 
         // Add a RemoteClientHandler for this particular client and add it to the list of handlers.
-        RemoteClientHandler* remoteClientHandler = addRemoteClientHandler(remoteClientInfo, status);
+        RemoteClientHandler* remoteClientHandler = addRemoteClientHandler(remoteClientInfo, context, status);
         if (!status.ok()) 
         {
             return status;
@@ -110,7 +110,7 @@ namespace claid
     }
 
 
-    RemoteClientHandler* RemoteServiceImpl::addRemoteClientHandler(const RemoteClientInfo& remoteClientInfo, grpc::Status& status) 
+    RemoteClientHandler* RemoteServiceImpl::addRemoteClientHandler(const RemoteClientInfo& remoteClientInfo, grpc::ServerContext* context, grpc::Status& status) 
     {
         status = grpc::Status::OK;
 
@@ -168,6 +168,7 @@ namespace claid
             new RemoteClientHandler(
                     *fromRemoteClientQueue, *toRemoteClientQueue, 
                     remoteClientInfo.user_token(), remoteClientInfo.device_id());
+        remoteClientHandler->serverContext = context;
 
         this->remoteClientHandlers[remoteClient] = 
             std::unique_ptr<RemoteClientHandler>(remoteClientHandler);
@@ -209,6 +210,19 @@ namespace claid
         }
     }
 
+    void RemoteServiceImpl::disconnectRemoteClient(const std::string& host, const std::string& userToken)
+    {
+        std::lock_guard<std::mutex> lock(this->remoteClientHandlersMutex);
+        auto it = this->remoteClientHandlers.find(makeRemoteClientKey(host, userToken));
+        if(it == this->remoteClientHandlers.end() || it->second->serverContext == nullptr)
+        {
+            return;
+        }
+
+        // Makes processReading return in SendReceivePackages, which then removes the handler.
+        it->second->serverContext->TryCancel();
+    }
+
     bool RemoteServiceImpl::isClientStillReachable(RemoteClientHandler& handler)
     {
         return handler.sendPingToClient();
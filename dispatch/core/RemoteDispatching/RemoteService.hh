@@ -53,9 +53,12 @@ namespace claid
 
         bool isClientStillReachable(RemoteClientHandler& handler);
 
+        // Cancels the stream of the given client, if connected (e.g., because the client cannot keep up with its packages).
+        void disconnectRemoteClient(const std::string& host, const std::string& userToken);
+
     private:
 
-        RemoteClientHandler* addRemoteClientHandler(const RemoteClientInfo& remoteClientInfo, grpc::Status& status);
+        RemoteClientHandler* addRemoteClientHandler(const RemoteClientInfo& remoteClientInfo, grpc::ServerContext* context, grpc::Status& status);
         void stopAndRemoveRemoteClientHandler(const RemoteClientInfo& remoteClientInfo);
 
         grpc::Status getRemoteClientInfoFromHandshakePackage(const DataPackage& package, RemoteClientInfo& info);
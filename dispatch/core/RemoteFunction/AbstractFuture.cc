@@ -35,8 +35,9 @@ std::shared_ptr<DataPackage> AbstractFuture::awaitResponse(int timeoutSeconds)
     
     if(!finished)
     {
-        // Then timeout
-        successful = false;
+        // Then timeout. The response will not be awaited anymore, hence the Future does not have to be kept in the table.
+        lock.unlock();
+        this->futuresTableInHandler.removeFuture(this->uniqueIdentifier);
         return nullptr;
     }
 
@@ -56,39 +57,84 @@ std::shared_ptr<DataPackage> AbstractFuture::awaitResponse(int timeoutSeconds)
 
 void AbstractFuture::thenUntyped(ThenCallback callback)
 {
+    std::unique_lock<std::mutex> lock(this->mutex);
     this->callback = callback;
     this->callbackSet = true;
 }
 
 void AbstractFuture::setResponse(std::shared_ptr<DataPackage> responsePackage) 
 {
-    std::unique_lock<std::mutex>(this->mutex);
+    finish(responsePackage, true, false);
+}
+
+void AbstractFuture::setFailed()
+{
+    finish(nullptr, false, false);
+}
 
-    this->responsePackage = responsePackage;
-    this->successful = true;
+void AbstractFuture::cancel()
+{
+    // A response that arrives later will not find the Future anymore.
+    this->futuresTableInHandler.removeFuture(this->uniqueIdentifier);
+    finish(nullptr, false, true);
+}
 
-    if(this->callback)
+void AbstractFuture::finish(std::shared_ptr<DataPackage> responsePackage, bool successful, bool cancelled)
+{
+    ThenCallback callback;
+    std::vector<std::function<void ()>> finishedListeners;
     {
-        this->callback(responsePackage);
-    }
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(this->finished)
+        {
+            // Future might have been failed or cancelled already (e.g., timeout expired).
+            return;
+        }
 
-    this->finished = true;
+        this->responsePackage = responsePackage;
+        this->successful = successful;
+        this->cancelled = cancelled;
+        this->finished = true;
+        callback = this->callback;
+        finishedListeners.swap(this->finishedListeners);
+    }
     this->conditionVariable.notify_all();
+
+    // The callbacks are invoked without holding the lock, so they can access the Future (or start another RemoteFunction).
+    if(callback)
+    {
+        callback(responsePackage);
+    }
+
+    for(std::function<void ()>& listener : finishedListeners)
+    {
+        listener();
+    }
 }
 
-void AbstractFuture::setFailed()
+void AbstractFuture::addFinishedListener(std::function<void ()> listener)
 {
-    std::unique_lock<std::mutex>(this->mutex);
-    this->responsePackage = nullptr;
-    this->successful = false;
-    
-    if(this->callbackSet)
     {
-        this->callback(nullptr);
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(!this->finished)
+        {
+            this->finishedListeners.push_back(listener);
+            return;
+        }
     }
+    listener();
+}
 
-    this->finished = true;
-    this->conditionVariable.notify_all();
+bool AbstractFuture::isFinished()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->finished;
+}
+
+bool AbstractFuture::wasCancelled()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->cancelled;
 }
 
 FutureUniqueIdentifier AbstractFuture::getUniqueIdentifier() const
@@ -23,6 +23,11 @@
 #include "dispatch/proto/claidservice.pb.h"
 #include "FuturesTable.hh"
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
 using namespace claidservice;
 namespace claid {
 
@@ -48,6 +53,9 @@ class AbstractFuture
         FutureUniqueIdentifier uniqueIdentifier;
 
         ThenCallback callback;
+        std::vector<std::function<void ()>> finishedListeners;
+
+        void finish(std::shared_ptr<DataPackage> responsePackage, bool successful, bool cancelled);
 
 
     
@@ -57,6 +65,7 @@ class AbstractFuture
         bool finished = false;
         bool successful = false;
         bool callbackSet = false;
+        bool cancelled = false;
 
         std::shared_ptr<DataPackage> responsePackage;
 
@@ -74,6 +83,16 @@ class AbstractFuture
         void setResponse(std::shared_ptr<DataPackage> responsePackage);
         void setFailed();
 
+        // Fails the Future and stops waiting for its response. A response arriving afterwards is discarded.
+        void cancel();
+
+        // The listener is called once the Future finished (successful, failed or cancelled), 
+        // on the thread that finished it. If the Future finished already, it is called right away.
+        void addFinishedListener(std::function<void ()> listener);
+
+        bool isFinished();
+        bool wasCancelled();
+
         FutureUniqueIdentifier getUniqueIdentifier() const;
 
         bool wasExecutedSuccessfully() const;
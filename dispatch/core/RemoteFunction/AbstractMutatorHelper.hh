@@ -4,13 +4,14 @@
 #include "dispatch/proto/claidservice.pb.h"
 
 using claidservice::DataPackage;
+using claidservice::Blob;
 
 namespace claid {
 
     class AbstractMutatorHelper
     {
         private:
-            virtual void setPackagePayloadUntyped(DataPackage& dataPackage, void* dataPtr) = 0;
+            virtual void setPackagePayloadUntyped(DataPackage& dataPackage, const void* dataPtr) = 0;
             virtual void getPackagePayloadUntyped(DataPackage& dataPackage, void* dataPtr) = 0;
 
         public: 
@@ -21,9 +22,20 @@ namespace claid {
             }
 
             template<typename T>
-            void setPackagePayload(DataPackage& dataPackage, T& data)
+            void setPackagePayload(DataPackage& dataPackage, const T& data)
             {
-                this->setPackagePayloadUntyped(dataPackage, reinterpret_cast<void*>(&data));
+                this->setPackagePayloadUntyped(dataPackage, reinterpret_cast<const void*>(&data));
+            }
+
+            // Serializes the data into the given Blob (e.g., a parameter of a RemoteFunctionRequest).
+            // The Mutators expect a DataPackage, hence the data is serialized into a stub package first, 
+            // whose payload is then swapped into the Blob (no copy of the serialized data).
+            template<typename T>
+            void setBlobPayload(Blob& blob, const T& data)
+            {
+                DataPackage stubPackage;
+                this->setPackagePayload(stubPackage, data);
+                blob.Swap(stubPackage.mutable_payload());
             }
 
             template<typename T>
@@ -33,12 +45,20 @@ namespace claid {
             }
 
             template<typename T>
-            bool isSameType()
+            bool isSameType() const
             {
+                if(this->isSameTypeInternal(typeid(T)))
+                {
+                    return true;
+                }
+
+                // Different C++ types might still map to the same proto type (e.g., int32_t and int64_t).
                 Mutator<T> tmpMutator = TypeMapping::getMutator<T>();
                 return tmpMutator.getMessageTypeName() == this->getTypeName();
             }
 
-            virtual std::string getTypeName() const = 0;
+            virtual bool isSameTypeInternal(const std::type_info& type) const = 0;
+
+            virtual const std::string& getTypeName() const = 0;
     };
-}
\ No newline at end of file
+}
@@ -65,7 +65,8 @@ public:
 
     void callback(std::shared_ptr<DataPackage> data) 
     {
-        if (!this->typedCallbackSet) {
+        // data is null if the Future failed.
+        if (!this->typedCallbackSet || data == nullptr) {
             return;
         }
 
@@ -0,0 +1,140 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include "Future.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <functional>
+
+// Coroutine support requires C++20 (-std=c++20). With older standards, only the callback based
+// Module::awaitAsync is available, which provides the same non-blocking behaviour.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define CLAID_COROUTINES_SUPPORTED 1
+#endif
+#endif
+
+namespace claid {
+
+// Runs a function on the thread of a Module (i.e., its RunnableDispatcher).
+typedef std::function<void (std::function<void ()>)> FutureContinuationExecutor;
+
+#ifdef CLAID_COROUTINES_SUPPORTED
+
+// Return type of coroutines running on a Module, e.g.:
+//
+//   ModuleTask MyModule::onData(ChannelData<int> data)
+//   {
+//       int result = co_await awaitFuture(remoteFunction.execute(data.getData()), Duration::seconds(5));
+//       ...
+//   }
+//
+// The coroutine starts immediately and is not awaited by the caller (fire and forget).
+// While it is suspended, the Module keeps processing its other subscriptions and timers.
+class ModuleTask
+{
+    public:
+        struct promise_type
+        {
+            ModuleTask get_return_object() 
+            { 
+                return ModuleTask(); 
+            }
+
+            std::suspend_never initial_suspend() noexcept 
+            { 
+                return {}; 
+            }
+
+            std::suspend_never final_suspend() noexcept 
+            { 
+                return {}; 
+            }
+
+            void return_void() 
+            {
+            }
+
+            void unhandled_exception() 
+            {
+                try
+                {
+                    throw;
+                }
+                catch(const std::exception& e)
+                {
+                    Logger::logError("Unhandled exception in ModuleTask: %s", e.what());
+                }
+                catch(...)
+                {
+                    Logger::logError("Unhandled exception in ModuleTask.");
+                }
+            }
+        };
+};
+
+// Suspends a coroutine until the Future finished, and resumes it using the executor (i.e., on the thread of the Module).
+// co_await yields the result of the Future. If the Future failed, timed out or was cancelled, 
+// the default value of T is returned and future->wasExecutedSuccessfully() is false.
+template<typename T>
+class FutureAwaiter
+{
+    private:
+        std::shared_ptr<Future<T>> future;
+        FutureContinuationExecutor executor;
+
+    public:
+        FutureAwaiter(std::shared_ptr<Future<T>> future, FutureContinuationExecutor executor) 
+            : future(future), executor(executor)
+        {
+        }
+
+        bool await_ready()
+        {
+            return this->future == nullptr || this->future->isFinished();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            FutureContinuationExecutor executor = this->executor;
+            this->future->addFinishedListener([executor, handle]() 
+            {
+                executor([handle]() { handle.resume(); });
+            });
+        }
+
+        T await_resume()
+        {
+            if(this->future == nullptr)
+            {
+                return T();
+            }
+            // Does not block, as the Future finished already.
+            return this->future->await();
+        }
+};
+
+#endif
+
+}
@@ -22,6 +22,9 @@
 #pragma once
 #include "FuturesTable.hh"
 #include "Future.hh"
+#include "dispatch/core/Utilities/Time.hh"
+
+#include <atomic>
 
 namespace claid 
 {
@@ -30,6 +33,10 @@ namespace claid
         private:
             FuturesTable openFutures;
 
+            // Futures which did not receive a response within this time are failed and removed from the table.
+            // This prevents leaking Futures of RemoteFunctions which are never answered (e.g., if the Module is gone).
+            std::atomic<uint64_t> futureTimeoutMs{60 * 60 * 1000};
+
         public:
         
             template<typename T>
@@ -38,7 +45,7 @@ namespace claid
                 FutureUniqueIdentifier uniqueIdentifier = FutureUniqueIdentifier::makeUniqueIdentifier();
                 std::shared_ptr<Future<T>> future = std::make_shared<Future<T>>(this->openFutures, uniqueIdentifier);
 
-                this->openFutures.addFuture(std::static_pointer_cast<AbstractFuture>(future));
+                this->openFutures.addFuture(std::static_pointer_cast<AbstractFuture>(future), this->futureTimeoutMs.load(std::memory_order_relaxed));
 
                 return future;
             };
@@ -48,6 +55,21 @@ namespace claid
                 return openFutures.lookupFuture(identifier);
             }
 
+            std::shared_ptr<AbstractFuture> takeFuture(FutureUniqueIdentifier identifier)
+            {
+                return openFutures.takeFuture(identifier);
+            }
+
+            // A timeout of 0 disables the expiry of Futures.
+            void setFutureTimeout(Duration timeout)
+            {
+                this->futureTimeoutMs.store(timeout.getMilliSeconds(), std::memory_order_relaxed);
+            }
+
+            size_t getNumOpenFutures()
+            {
+                return openFutures.size();
+            }
+
     };
 }
-
@@ -1,40 +1,74 @@
 #include "FutureUniqueIdentifier.hh"
 
+#include <cstdlib>
+
 namespace claid {
 
-std::mutex FutureUniqueIdentifier::mutex;
-long FutureUniqueIdentifier::currentId = 0;
+std::atomic<uint64_t> FutureUniqueIdentifier::currentSequenceNumber(0);
 
-    FutureUniqueIdentifier::FutureUniqueIdentifier(std::string id) : identifier(id)
+    FutureUniqueIdentifier::FutureUniqueIdentifier() : id(INVALID_ID)
+    {
+    }
+
+    FutureUniqueIdentifier::FutureUniqueIdentifier(uint64_t id) : id(id)
     {
     }
 
     FutureUniqueIdentifier FutureUniqueIdentifier::makeUniqueIdentifier()
     {
-        mutex.lock();
-        long idCopy = currentId;
-        currentId++;
-        mutex.unlock();
+        const uint64_t sequenceMask = (uint64_t(1) << SEQUENCE_NUMBER_BITS) - 1;
 
-        std::string identifier = std::string("CLAID_CPP_") + std::to_string(idCopy) + std::string("_") +
-             std::to_string(Time::now().toUnixTimestampMilliseconds());
+        // Starts at 1, as 0 is the invalid identifier.
+        const uint64_t sequenceNumber = (currentSequenceNumber.fetch_add(1, std::memory_order_relaxed) + 1) & sequenceMask;
+        const uint64_t runtime = static_cast<uint64_t>(claidservice::Runtime::RUNTIME_CPP);
 
-        return FutureUniqueIdentifier(identifier);
+        return FutureUniqueIdentifier((runtime << SEQUENCE_NUMBER_BITS) | sequenceNumber);
     } 
 
-    FutureUniqueIdentifier FutureUniqueIdentifier::fromString(std::string identifier)
+    FutureUniqueIdentifier FutureUniqueIdentifier::fromId(uint64_t id)
+    {
+        return FutureUniqueIdentifier(id);
+    }
+
+    FutureUniqueIdentifier FutureUniqueIdentifier::fromString(const std::string& identifier)
     {
-        return FutureUniqueIdentifier(identifier);
+        char* end = nullptr;
+        uint64_t id = std::strtoull(identifier.c_str(), &end, 10);
+        if(identifier.empty() || end == nullptr || *end != '\0')
+        {
+            return FutureUniqueIdentifier(INVALID_ID);
+        }
+        return FutureUniqueIdentifier(id);
     }   
 
+    uint64_t FutureUniqueIdentifier::getId() const
+    {
+        return this->id;
+    }
+
+    claidservice::Runtime FutureUniqueIdentifier::getRuntime() const
+    {
+        return static_cast<claidservice::Runtime>(this->id >> SEQUENCE_NUMBER_BITS);
+    }
+
+    bool FutureUniqueIdentifier::isValid() const
+    {
+        return this->id != INVALID_ID;
+    }
+
     std::string FutureUniqueIdentifier::toString() const
     {
-        return this->identifier;
+        return std::to_string(this->id);
     }
 
     bool FutureUniqueIdentifier::operator <(const FutureUniqueIdentifier& rhs) const
     {
-        return identifier < rhs.identifier;
+        return id < rhs.id;
+    }
+
+    bool FutureUniqueIdentifier::operator ==(const FutureUniqueIdentifier& rhs) const
+    {
+        return id == rhs.id;
     }
 
-}
\ No newline at end of file
+}
@@ -20,31 +20,45 @@
 ***************************************************************************/
 
 #pragma once
-#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <string>
 
-#include "dispatch/core/Utilities/Time.hh"
+#include "dispatch/proto/claidservice.pb.h"
 
 namespace claid {
 
-
+// Identifies a Future waiting for the response of a RemoteFunction.
+// The identifier is a 64 bit integer, which consists of the Runtime that created the Future (upper 8 bits)
+// and a sequence number (lower 56 bits). Hence, creating, sending and looking up an identifier
+// neither requires formatting or parsing strings, nor any locks.
 class FutureUniqueIdentifier 
 {
 private:
-    static std::mutex mutex;
-    static long currentId;
+    static std::atomic<uint64_t> currentSequenceNumber;
 
-    std::string identifier;
+    uint64_t id;
 
 public:
+    static constexpr uint64_t INVALID_ID = 0;
+    static constexpr int RUNTIME_BITS = 8;
+    static constexpr int SEQUENCE_NUMBER_BITS = 64 - RUNTIME_BITS;
 
     static FutureUniqueIdentifier makeUniqueIdentifier();
-    static FutureUniqueIdentifier fromString(std::string identifier);
+    static FutureUniqueIdentifier fromId(uint64_t id);
+    static FutureUniqueIdentifier fromString(const std::string& identifier);
+
+    FutureUniqueIdentifier();
+    explicit FutureUniqueIdentifier(uint64_t id);
 
-    FutureUniqueIdentifier(std::string id);
+    uint64_t getId() const;
+    claidservice::Runtime getRuntime() const;
+    bool isValid() const;
 
     std::string toString() const;
 
     bool operator <(const FutureUniqueIdentifier& rhs) const;
+    bool operator ==(const FutureUniqueIdentifier& rhs) const;
 };
 
-}
\ No newline at end of file
+}
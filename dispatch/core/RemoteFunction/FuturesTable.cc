@@ -1,42 +1,236 @@
 #include "FuturesTable.hh"
 #include "AbstractFuture.hh"
+#include "dispatch/core/Utilities/Time.hh"
 
 
 namespace claid {
 
-void FuturesTable::addFuture(std::shared_ptr<AbstractFuture> future)
+FuturesTable::FuturesTable()
 {
-    std::unique_lock<std::mutex>(this->lock);
-    futures.insert(std::make_pair(future->getUniqueIdentifier(), future));
+    for(Stripe& stripe : this->stripes)
+    {
+        stripe.slots.resize(INITIAL_CAPACITY_PER_STRIPE);
+    }
 }
 
-bool FuturesTable::removeFuture(FutureUniqueIdentifier futureIdentifier)
+uint64_t FuturesTable::hash(uint64_t id)
+{
+    // Finalizer of splitmix64. Sequence numbers are consecutive, hence they have to be mixed to avoid clustering.
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ULL;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebULL;
+    id ^= id >> 31;
+    return id;
+}
+
+FuturesTable::Stripe& FuturesTable::stripeOf(uint64_t hash)
+{
+    return this->stripes[hash % NUM_STRIPES];
+}
+
+size_t FuturesTable::findSlot(const Stripe& stripe, uint64_t id, uint64_t hash)
+{
+    const size_t mask = stripe.slots.size() - 1;
+    for(size_t index = (hash / NUM_STRIPES) & mask; ; index = (index + 1) & mask)
+    {
+        const Slot& slot = stripe.slots[index];
+        if(slot.id == id || slot.id == FutureUniqueIdentifier::INVALID_ID)
+        {
+            return index;
+        }
+    }
+}
+
+void FuturesTable::insertSlot(Stripe& stripe, Slot&& slot)
+{
+    // Keep the load factor below 3/4, hence there is always an empty slot which terminates probing.
+    if((stripe.numFutures + 1) * 4 > stripe.slots.size() * 3)
+    {
+        grow(stripe);
+    }
+
+    size_t index = findSlot(stripe, slot.id, hash(slot.id));
+    if(stripe.slots[index].id == FutureUniqueIdentifier::INVALID_ID)
+    {
+        stripe.numFutures++;
+    }
+    else if(stripe.slots[index].deadlineMs != 0)
+    {
+        stripe.numFuturesWithDeadline--;
+    }
+
+    if(slot.deadlineMs != 0)
+    {
+        stripe.numFuturesWithDeadline++;
+    }
+    stripe.slots[index] = std::move(slot);
+}
+
+void FuturesTable::eraseSlot(Stripe& stripe, size_t index)
+{
+    if(stripe.slots[index].deadlineMs != 0)
+    {
+        stripe.numFuturesWithDeadline--;
+    }
+    stripe.slots[index] = Slot();
+    stripe.numFutures--;
+
+    // Backward shift deletion: moves subsequent entries of the probe sequence into the gap, so that no tombstones are required.
+    const size_t mask = stripe.slots.size() - 1;
+    size_t gap = index;
+    for(size_t next = (gap + 1) & mask; stripe.slots[next].id != FutureUniqueIdentifier::INVALID_ID; next = (next + 1) & mask)
+    {
+        const size_t home = (hash(stripe.slots[next].id) / NUM_STRIPES) & mask;
+
+        // The entry can be moved if its home position is not within (gap, next] (cyclically).
+        const bool homeInRange = gap <= next ? (gap < home && home <= next) : (gap < home || home <= next);
+        if(!homeInRange)
+        {
+            stripe.slots[gap] = std::move(stripe.slots[next]);
+            stripe.slots[next] = Slot();
+            gap = next;
+        }
+    }
+}
+
+void FuturesTable::grow(Stripe& stripe)
+{
+    std::vector<Slot> oldSlots(stripe.slots.size() * 2);
+    oldSlots.swap(stripe.slots);
+    stripe.numFutures = 0;
+    stripe.numFuturesWithDeadline = 0;
+
+    for(Slot& slot : oldSlots)
+    {
+        if(slot.id != FutureUniqueIdentifier::INVALID_ID)
+        {
+            insertSlot(stripe, std::move(slot));
+        }
+    }
+}
+
+void FuturesTable::collectExpiredFutures(Stripe& stripe, uint64_t nowMs, std::vector<std::shared_ptr<AbstractFuture>>& expired)
 {
-    std::unique_lock<std::mutex>(this->lock);
+    stripe.nextEvictionCheckMs = nowMs + EVICTION_CHECK_INTERVAL_MS;
 
-    auto it = futures.find(futureIdentifier);
-    if(it != futures.end())
+    size_t index = 0;
+    while(stripe.numFuturesWithDeadline > 0 && index < stripe.slots.size())
     {
-        std::shared_ptr<AbstractFuture> other = it->second;
-     
-        futures.erase(it);
-        return true;
+        Slot& slot = stripe.slots[index];
+        if(slot.id != FutureUniqueIdentifier::INVALID_ID && slot.deadlineMs != 0 && slot.deadlineMs <= nowMs)
+        {
+            expired.push_back(slot.future);
+            // Erasing might shift another entry into this slot, hence the index is not incremented.
+            eraseSlot(stripe, index);
+            continue;
+        }
+        index++;
     }
-    return false;
+}
+
+void FuturesTable::addFuture(std::shared_ptr<AbstractFuture> future, uint64_t timeoutMs)
+{
+    Slot slot;
+    slot.id = future->getUniqueIdentifier().getId();
+    slot.future = future;
+
+    const uint64_t nowMs = Time::now().toUnixTimestampMilliseconds();
+    if(timeoutMs > 0)
+    {
+        slot.deadlineMs = nowMs + timeoutMs;
+    }
+
+    std::vector<std::shared_ptr<AbstractFuture>> expired;
+    {
+        Stripe& stripe = stripeOf(hash(slot.id));
+        std::unique_lock<std::mutex> lock(stripe.mutex);
+        insertSlot(stripe, std::move(slot));
+
+        if(stripe.numFuturesWithDeadline > 0 && nowMs >= stripe.nextEvictionCheckMs)
+        {
+            collectExpiredFutures(stripe, nowMs, expired);
+        }
+    }
+
+    // Failing a Future might invoke its callback, which must not happen while holding the lock.
+    for(std::shared_ptr<AbstractFuture>& expiredFuture : expired)
+    {
+        expiredFuture->setFailed();
+    }
+}
+
+bool FuturesTable::removeFuture(FutureUniqueIdentifier futureIdentifier)
+{
+    return takeFuture(futureIdentifier) != nullptr;
 }
 
 std::shared_ptr<AbstractFuture> FuturesTable::lookupFuture(FutureUniqueIdentifier uniqueIdentifier)
 {
-    std::shared_ptr<AbstractFuture> future = nullptr;
+    const uint64_t id = uniqueIdentifier.getId();
+    if(id == FutureUniqueIdentifier::INVALID_ID)
+    {
+        return nullptr;
+    }
+
+    const uint64_t idHash = hash(id);
+    Stripe& stripe = stripeOf(idHash);
+    std::unique_lock<std::mutex> lock(stripe.mutex);
+
+    const Slot& slot = stripe.slots[findSlot(stripe, id, idHash)];
+    return slot.id == id ? slot.future : nullptr;
+}
+
+std::shared_ptr<AbstractFuture> FuturesTable::takeFuture(FutureUniqueIdentifier uniqueIdentifier)
+{
+    const uint64_t id = uniqueIdentifier.getId();
+    if(id == FutureUniqueIdentifier::INVALID_ID)
+    {
+        return nullptr;
+    }
 
-    std::unique_lock<std::mutex>(this->lock);
+    const uint64_t idHash = hash(id);
+    Stripe& stripe = stripeOf(idHash);
+    std::unique_lock<std::mutex> lock(stripe.mutex);
 
-    auto it = futures.find(uniqueIdentifier);
-    if(it != futures.end())
+    const size_t index = findSlot(stripe, id, idHash);
+    if(stripe.slots[index].id != id)
     {
-        future = it->second;
+        return nullptr;
     }
+
+    std::shared_ptr<AbstractFuture> future = std::move(stripe.slots[index].future);
+    eraseSlot(stripe, index);
     return future;
 }
 
-}
\ No newline at end of file
+size_t FuturesTable::evictExpiredFutures()
+{
+    const uint64_t nowMs = Time::now().toUnixTimestampMilliseconds();
+
+    std::vector<std::shared_ptr<AbstractFuture>> expired;
+    for(Stripe& stripe : this->stripes)
+    {
+        std::unique_lock<std::mutex> lock(stripe.mutex);
+        collectExpiredFutures(stripe, nowMs, expired);
+    }
+
+    for(std::shared_ptr<AbstractFuture>& expiredFuture : expired)
+    {
+        expiredFuture->setFailed();
+    }
+    return expired.size();
+}
+
+size_t FuturesTable::size()
+{
+    size_t size = 0;
+    for(Stripe& stripe : this->stripes)
+    {
+        std::unique_lock<std::mutex> lock(stripe.mutex);
+        size += stripe.numFutures;
+    }
+    return size;
+}
+
+}
@@ -23,27 +23,75 @@
 
 #include "dispatch/proto/claidservice.pb.h"
 #include "FutureUniqueIdentifier.hh"
-#include <map>
+#include <array>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace claid {
 
 class AbstractFuture;
 
+// Table of the Futures waiting for the response of a RemoteFunction.
+// Responses of many concurrent RPCs are looked up from the thread of the RemoteFunctionHandler, while Futures 
+// are added and removed by the threads executing and awaiting the RPCs. Hence, the table is split into stripes,
+// each of which is an open addressing hash table (linear probing) guarded by its own mutex.
+// Identifiers are distributed evenly across the stripes, and an operation only holds the mutex of one stripe for a few probes.
+//
+// Futures can be registered with a timeout. Futures whose timeout expired are removed and failed 
+// (see evictExpiredFutures), which is checked periodically when new Futures are added.
 class FuturesTable 
 {
     private:
-        std::map<FutureUniqueIdentifier, std::shared_ptr<AbstractFuture>> futures;
-        
-        std::mutex lock;
+        struct Slot
+        {
+            uint64_t id = FutureUniqueIdentifier::INVALID_ID;
+            std::shared_ptr<AbstractFuture> future;
+            uint64_t deadlineMs = 0; // 0 = no timeout.
+        };
+
+        struct Stripe
+        {
+            std::mutex mutex;
+            std::vector<Slot> slots; // Capacity is always a power of 2.
+            size_t numFutures = 0;
+            size_t numFuturesWithDeadline = 0;
+            uint64_t nextEvictionCheckMs = 0;
+        };
+
+        static constexpr size_t NUM_STRIPES = 8;
+        static constexpr size_t INITIAL_CAPACITY_PER_STRIPE = 16;
+        static constexpr uint64_t EVICTION_CHECK_INTERVAL_MS = 1000;
+
+        std::array<Stripe, NUM_STRIPES> stripes;
+
+        static uint64_t hash(uint64_t id);
+        Stripe& stripeOf(uint64_t hash);
+
+        // The following functions have to be called while holding the mutex of the stripe.
+        static size_t findSlot(const Stripe& stripe, uint64_t id, uint64_t hash);
+        static void insertSlot(Stripe& stripe, Slot&& slot);
+        static void eraseSlot(Stripe& stripe, size_t index);
+        static void grow(Stripe& stripe);
+        static void collectExpiredFutures(Stripe& stripe, uint64_t nowMs, std::vector<std::shared_ptr<AbstractFuture>>& expired);
 
     public:
+        FuturesTable();
 
-        void addFuture(std::shared_ptr<AbstractFuture> future);
+        // A timeoutMs of 0 means that the Future does not expire.
+        void addFuture(std::shared_ptr<AbstractFuture> future, uint64_t timeoutMs = 0);
 
         bool removeFuture(FutureUniqueIdentifier futureIdentifier);
 
         std::shared_ptr<AbstractFuture> lookupFuture(FutureUniqueIdentifier uniqueIdentifier);
+
+        // Looks up and removes the Future in one step (e.g., when the response for the Future was received).
+        std::shared_ptr<AbstractFuture> takeFuture(FutureUniqueIdentifier uniqueIdentifier);
+
+        // Removes all Futures whose timeout expired and sets them failed. Returns the number of evicted Futures.
+        size_t evictExpiredFutures();
+
+        size_t size();
         
 };
 
@@ -30,6 +30,8 @@
 #include "FutureHandler.hh"
 #include "dispatch/core/proto_util.hh"
 #include <functional>
+#include <tuple>
+#include <vector>
 // A remote function is an RPC stub, 
 // which remotely calls an RemoteFunctionRunnable in another entity (another Runtime or Module).
 // Actually, this should be called RemoteFunctionStub, but might be less intutive for people not familiar with RPC terminology.
@@ -86,7 +88,7 @@ class RemoteFunction
 
 
         template<typename... Parameters>
-        std::shared_ptr<Future<T>> execute(Parameters... params)
+        std::shared_ptr<Future<T>> execute(const Parameters&... params)
         {
             if(!this->valid)
             {
@@ -111,69 +113,123 @@ class RemoteFunction
 
             std::shared_ptr<Future<T>> future = this->futuresHandler->template registerNewFuture<T>();
 
-            std::shared_ptr<DataPackage> dataPackage = std::make_shared<DataPackage>();
-            ControlPackage& controlPackage = *(dataPackage->mutable_control_val());
+            std::shared_ptr<DataPackage> dataPackage = makeRequestPackage();
+            RemoteFunctionRequest& remoteFunctionRequest = *dataPackage->mutable_control_val()->mutable_remote_function_request();
 
-            controlPackage.set_ctrl_type(CtrlType::CTRL_REMOTE_FUNCTION_REQUEST);
-            controlPackage.set_runtime(Runtime::RUNTIME_CPP);
+            // The numeric identifier is copied to the RemoteFunctionReturn by the runnable, hence no string has to be formatted per call.
+            remoteFunctionRequest.set_remote_future_id(future->getUniqueIdentifier().getId());
+            setParameterPayloads<0, Parameters...>(*remoteFunctionRequest.mutable_parameter_payloads(), params...);
 
-            RemoteFunctionRequest& remoteFunctionRequest = *controlPackage.mutable_remote_function_request();
+            toMiddlewareQueue->push_back(dataPackage);
 
-            makeRemoteFunctionRequest(future->getUniqueIdentifier().toString(), remoteFunctionRequest, params...);
+            return future;
 
+        }
 
-            if(this->remoteFunctionIdentifier.has_module_id())
+        // Calls the function once for every element of the batch, but sends all calls in a single request.
+        // The callee can process the whole batch at once, if it registered the function using registerBatchedRemoteFunction.
+        // Batches to Modules of other Runtimes than C++ are split into single calls by the middleware.
+        // Returns one Future per call (same order as the batch), or an empty vector if the batch could not be executed.
+        template<typename Parameter>
+        std::vector<std::shared_ptr<Future<T>>> executeBatch(const std::vector<Parameter>& batch)
+        {
+            std::vector<std::tuple<const Parameter&>> tuples;
+            tuples.reserve(batch.size());
+            for(const Parameter& parameter : batch)
             {
-                dataPackage->set_target_module(this->remoteFunctionIdentifier.module_id());
+                tuples.emplace_back(parameter);
             }
-        
+            return executeBatch(tuples);
+        }
 
-            toMiddlewareQueue->push_back(dataPackage);
+        // Batch of functions with multiple parameters, each call is given as tuple of its parameters.
+        template<typename... Parameters>
+        std::vector<std::shared_ptr<Future<T>>> executeBatch(const std::vector<std::tuple<Parameters...>>& batch)
+        {
+            std::vector<std::shared_ptr<Future<T>>> futures;
+            if(!this->valid)
+            {
+                Logger::logError("Failed to execute RemoteFunction (RPC stub) \"%s\". Function is not valid.", getFunctionSignature().c_str());      
+                return futures;
+            }
 
-            return future;
+            size_t parametersLength = sizeof...(Parameters);
+            if(parametersLength != mutatorHelpers.size())
+            {
+                Logger::logError("Failed to execute batch of RemoteFunction (RPC stub) \"%s\". "
+                "Number of parameters do not match. Function expected %d parameters, but was executed with %d",
+                getFunctionSignature().c_str(), mutatorHelpers.size(), parametersLength);
+                return futures;
+            }
+
+            if(batch.empty() || !std::apply([this](const Parameters&... params) 
+                { return checkParameterTypes<0, typename std::decay<Parameters>::type...>(params...); }, batch[0]))
+            {
+                return futures;
+            }
+
+            std::shared_ptr<DataPackage> dataPackage = makeRequestPackage();
+            RemoteFunctionRequest& remoteFunctionRequest = *dataPackage->mutable_control_val()->mutable_remote_function_request();
+            remoteFunctionRequest.mutable_batched_calls()->Reserve(batch.size());
+            futures.reserve(batch.size());
+
+            for(const std::tuple<Parameters...>& parameters : batch)
+            {
+                std::shared_ptr<Future<T>> future = this->futuresHandler->template registerNewFuture<T>();
+                futures.push_back(future);
+
+                RemoteFunctionBatchedCall& call = *remoteFunctionRequest.add_batched_calls();
+                call.set_remote_future_id(future->getUniqueIdentifier().getId());
+                std::apply([&](const Parameters&... params) 
+                { 
+                    setParameterPayloads<0, typename std::decay<Parameters>::type...>(*call.mutable_parameter_payloads(), params...); 
+                }, parameters);
+            }
+
+            toMiddlewareQueue->push_back(dataPackage);
 
+            return futures;
         }
 
-        template<typename... Parameters>
-        void makeRemoteFunctionRequest(std::string futureIdentifier, RemoteFunctionRequest& request, Parameters... parameters)
+        std::shared_ptr<DataPackage> makeRequestPackage()
         {
-            *(request.mutable_remote_function_identifier()) = this->remoteFunctionIdentifier;
-            request.set_remote_future_identifier(futureIdentifier);
-
-            // We want to use the mutator to convert each parameter to a Blob.
-            // However, Mutator expects a DataPackage to set the blob directly.
-            // Hence, we create a stub data package and simply retrieve it's payload, 
-            // after the mutator has converted and set the blob.
-            DataPackage stubPackage;
+            std::shared_ptr<DataPackage> dataPackage = std::make_shared<DataPackage>();
+            ControlPackage& controlPackage = *(dataPackage->mutable_control_val());
 
+            controlPackage.set_ctrl_type(CtrlType::CTRL_REMOTE_FUNCTION_REQUEST);
+            controlPackage.set_runtime(Runtime::RUNTIME_CPP);
 
-            setParameterPayloads<0, Parameters...>(request, parameters...);
-          
+            *(controlPackage.mutable_remote_function_request()->mutable_remote_function_identifier()) = this->remoteFunctionIdentifier;
 
+            if(this->remoteFunctionIdentifier.has_module_id())
+            {
+                dataPackage->set_target_module(this->remoteFunctionIdentifier.module_id());
+            }
+            return dataPackage;
         }
 
         template<int C, typename U, typename... Us>
-        void setParameterPayloads(RemoteFunctionRequest& request, U& parameter, Us&... rest)
+        void setParameterPayloads(google::protobuf::RepeatedPtrField<Blob>& payloads, const U& parameter, const Us&... rest)
         {
-            DataPackage stubPackage;
+            if(C == 0)
+            {
+                payloads.Reserve(sizeof...(Us) + 1);
+            }
 
-            std::shared_ptr<AbstractMutatorHelper> helper = this->mutatorHelpers[C];
-            helper->setPackagePayload(stubPackage, parameter);
-            
-            Logger::logInfo("Stub package %s", messageToString(stubPackage).c_str());
-            (*request.add_parameter_payloads()) = stubPackage.payload();
+            // The helpers cache the Mutator of each parameter type, see TypedMutatorHelper.
+            this->mutatorHelpers[C]->setBlobPayload(*payloads.Add(), parameter);
 
-            setParameterPayloads<C + 1, Us...>(request, rest...);
+            setParameterPayloads<C + 1, Us...>(payloads, rest...);
         }
 
         template<int C>
-        void setParameterPayloads(RemoteFunctionRequest& request)
+        void setParameterPayloads(google::protobuf::RepeatedPtrField<Blob>& payloads)
         {
             // Base case
         }
 
         template<int C, typename U, typename... Us>
-        bool checkParameterTypes(U& parameter, Us&... rest)
+        bool checkParameterTypes(const U& parameter, const Us&... rest)
         {
             if(C >= mutatorHelpers.size())
             {
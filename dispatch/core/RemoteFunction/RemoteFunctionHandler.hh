@@ -86,6 +86,62 @@ namespace claid {
             return function;
         }
 
+        // Splits a batched request (see RemoteFunction::executeBatch) into one regular request per call.
+        // Used for callees in Runtimes which only support single calls (e.g., Java, Dart, Swift).
+        // The response to each request resolves the Future of the corresponding call directly.
+        static std::vector<std::shared_ptr<DataPackage>> splitBatchedRequest(const DataPackage& batchedRequest)
+        {
+            std::vector<std::shared_ptr<DataPackage>> requests;
+            const RemoteFunctionRequest& batchedRemoteFunctionRequest = batchedRequest.control_val().remote_function_request();
+
+            // Copies the header of the package only once, not the whole batch per call.
+            DataPackage header = batchedRequest;
+            header.mutable_control_val()->mutable_remote_function_request()->clear_batched_calls();
+
+            requests.reserve(batchedRemoteFunctionRequest.batched_calls_size());
+            for(const RemoteFunctionBatchedCall& call : batchedRemoteFunctionRequest.batched_calls())
+            {
+                std::shared_ptr<DataPackage> request = std::make_shared<DataPackage>(header);
+                RemoteFunctionRequest& remoteFunctionRequest = *request->mutable_control_val()->mutable_remote_function_request();
+
+                // Runtimes which do not copy the numeric identifier yet only return the string identifier.
+                remoteFunctionRequest.set_remote_future_id(call.remote_future_id());
+                remoteFunctionRequest.set_remote_future_identifier(FutureUniqueIdentifier::fromId(call.remote_future_id()).toString());
+                *remoteFunctionRequest.mutable_parameter_payloads() = call.parameter_payloads();
+                requests.push_back(request);
+            }
+            return requests;
+        }
+
+        // Fans out the returns of a batched request (see RemoteFunction::executeBatch) to the Futures of the individual calls.
+        void handleBatchedResponse(std::shared_ptr<DataPackage> remoteFunctionResponse)
+        {
+            RemoteFunctionReturn& remoteFunctionReturn = *remoteFunctionResponse->mutable_control_val()->mutable_remote_function_return();
+
+            for(RemoteFunctionBatchedReturn& batchedReturn : *remoteFunctionReturn.mutable_batched_returns())
+            {
+                FutureUniqueIdentifier uniqueIdentifier = FutureUniqueIdentifier::fromId(batchedReturn.remote_future_id());
+                std::shared_ptr<AbstractFuture> future = this->futuresHandler.takeFuture(uniqueIdentifier);
+                if(future == nullptr)
+                {
+                    continue;
+                }
+
+                if(batchedReturn.execution_status() != RemoteFunctionStatus::STATUS_OK)
+                {
+                    Logger::logError("Remote function failed. Future with identifier \"%s\" of batched call failed with status \"%s\".",
+                        uniqueIdentifier.toString().c_str(), RemoteFunctionStatus_Name(batchedReturn.execution_status()).c_str());
+                    future->setFailed();
+                    continue;
+                }
+
+                // The Future expects the return value as payload of a DataPackage.
+                std::shared_ptr<DataPackage> response = std::make_shared<DataPackage>();
+                response->mutable_payload()->Swap(batchedReturn.mutable_return_payload());
+                future->setResponse(response);
+            }
+        }
+
          void handleResponse(std::shared_ptr<DataPackage> remoteFunctionResponse)
         {
             if(!remoteFunctionResponse->control_val().has_remote_function_return())
@@ -98,10 +154,19 @@ namespace claid {
 
             const RemoteFunctionReturn& remoteFunctionReturn = remoteFunctionResponse->control_val().remote_function_return();
 
-            std::string futureIdentifier = remoteFunctionReturn.remote_future_identifier();
-            FutureUniqueIdentifier uniqueIdentifier = FutureUniqueIdentifier::fromString(futureIdentifier);
+            if(remoteFunctionReturn.batched_returns_size() > 0)
+            {
+                handleBatchedResponse(remoteFunctionResponse);
+                return;
+            }
+
+            // Runtimes which do not copy the numeric identifier yet only return the string identifier.
+            FutureUniqueIdentifier uniqueIdentifier = remoteFunctionReturn.remote_future_id() != FutureUniqueIdentifier::INVALID_ID ?
+                FutureUniqueIdentifier::fromId(remoteFunctionReturn.remote_future_id()) :
+                FutureUniqueIdentifier::fromString(remoteFunctionReturn.remote_future_identifier());
 
-            std::shared_ptr<AbstractFuture> future = this->futuresHandler.lookupFuture(uniqueIdentifier);
+            // Each Future receives exactly one response, hence it is removed from the table right away.
+            std::shared_ptr<AbstractFuture> future = this->futuresHandler.takeFuture(uniqueIdentifier);
 
             if(future == nullptr)
             {
@@ -113,7 +178,7 @@ namespace claid {
             if(remoteFunctionReturn.execution_status() != RemoteFunctionStatus::STATUS_OK)
             {
                 Logger::logError("Remote function failed. Future with identifier \"%s\" failed with status \"%s\".",
-                futureIdentifier.c_str(), RemoteFunctionStatus_Name(remoteFunctionReturn.execution_status()).c_str());
+                uniqueIdentifier.toString().c_str(), RemoteFunctionStatus_Name(remoteFunctionReturn.execution_status()).c_str());
 
                 future->setFailed();
                 return;
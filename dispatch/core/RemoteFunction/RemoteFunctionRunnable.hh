@@ -35,42 +35,147 @@ using namespace claidservice;
 
 namespace claid {
 
+// Element of the batch passed to batched functions (see registerBatchedRemoteFunction):
+// The parameter itself for functions with a single parameter, a tuple of the parameters otherwise.
+template<typename... Parameters>
+struct RemoteFunctionBatchElement
+{
+    typedef std::tuple<Parameters...> type;
+};
+
+template<typename Parameter>
+struct RemoteFunctionBatchElement<Parameter>
+{
+    typedef Parameter type;
+};
+
 template<typename Return, typename... Parameters>
 class RemoteFunctionRunnable : public AbstractRemoteFunctionRunnable
 {
-    private:
-        std::string functionName;
-        
+    public:
         // Binds function and object!
         // Works for class and non-class methods.
         typedef std::function<Return (Parameters...)> FunctionType;
-        FunctionType function;
 
-        std::vector<std::shared_ptr<AbstractMutatorHelper>> mutatorHelpers;
+        // Processes all calls of a batched RemoteFunctionRequest at once (e.g., a single batched inference).
+        // Has to return one value per element of the batch.
+        typedef typename RemoteFunctionBatchElement<Parameters...>::type BatchElementType;
+        typedef typename std::conditional<std::is_void<Return>::value, bool, Return>::type BatchReturnType;
+        typedef std::function<std::vector<BatchReturnType> (const std::vector<BatchElementType>&)> BatchFunctionType;
 
+    private:
+        std::string functionName;
         
+        // Either function or batchFunction is set. Requests which do not match (i.e., single calls for 
+        // a batched function, or batched calls for a regular function) are mapped to the available one.
+        FunctionType function;
+        BatchFunctionType batchFunction;
 
-        
+        std::vector<std::shared_ptr<AbstractMutatorHelper>> mutatorHelpers;
 
         template<int C, typename U, typename... Us>
-        void extractParameters(const RemoteFunctionRequest& request, std::tuple<Parameters...>& tuple)
+        void extractParameters(const google::protobuf::RepeatedPtrField<Blob>& payloads, std::tuple<Parameters...>& tuple)
         {
             DataPackage tmpPackage;
-            *tmpPackage.mutable_payload() = request.parameter_payloads(C);
+            *tmpPackage.mutable_payload() = payloads.Get(C);
 
-            Mutator<U> mutator = TypeMapping::getMutator<U>();
-            
-            mutator.getPackagePayload(tmpPackage, std::get<C>(tuple));
+            this->mutatorHelpers[C]->getPackagePayload(tmpPackage, std::get<C>(tuple));
 
-            extractParameters<C + 1, Us...>(request, tuple);
+            extractParameters<C + 1, Us...>(payloads, tuple);
         }
 
         template<int C>
-        void extractParameters(const RemoteFunctionRequest& request, std::tuple<Parameters...>& tuple)
+        void extractParameters(const google::protobuf::RepeatedPtrField<Blob>& payloads, std::tuple<Parameters...>& tuple)
         {
 
         }
 
+        std::vector<RemoteFunctionRunnableResult<Return>> executeBatchFromTuples(std::vector<std::tuple<Parameters...>>& tuples)
+        {
+            std::vector<RemoteFunctionRunnableResult<Return>> results;
+            if constexpr(!std::is_void<Return>::value)
+            {
+                std::vector<BatchElementType> batch;
+                batch.reserve(tuples.size());
+                for(std::tuple<Parameters...>& tuple : tuples)
+                {
+                    if constexpr(sizeof...(Parameters) == 1)
+                    {
+                        batch.push_back(std::move(std::get<0>(tuple)));
+                    }
+                    else
+                    {
+                        batch.push_back(std::move(tuple));
+                    }
+                }
+
+                std::vector<BatchReturnType> returnValues = this->batchFunction(batch);
+                if(returnValues.size() != batch.size())
+                {
+                    Logger::logError("Batched function \"%s\" returned %d values for a batch of %d calls.", 
+                        this->functionName.c_str(), returnValues.size(), batch.size());
+                    results.assign(batch.size(), 
+                        RemoteFunctionRunnableResult<Return>::makeFailedResult(RemoteFunctionStatus::FAILED_FUNCTION_NOT_FOUND_OR_FAILED_TO_EXECUTE));
+                    return results;
+                }
+
+                results.reserve(returnValues.size());
+                for(size_t i = 0; i < returnValues.size(); i++)
+                {
+                    results.push_back(RemoteFunctionRunnableResult<Return>::makeSuccessfulResult(std::make_shared<Return>(returnValues[i])));
+                }
+            }
+            return results;
+        }
+
+        std::shared_ptr<DataPackage> executeBatchedRemoteFunctionRequest(std::shared_ptr<DataPackage> rpcRequest)
+        {
+            const RemoteFunctionRequest& executionRequest = rpcRequest->control_val().remote_function_request();
+            const int numCalls = executionRequest.batched_calls_size();
+            const int parameterSize = sizeof...(Parameters);
+
+            std::vector<RemoteFunctionRunnableResult<Return>> results(numCalls, 
+                RemoteFunctionRunnableResult<Return>::makeFailedResult(RemoteFunctionStatus::FAILED_INVALID_NUMBER_OF_PARAMETERS));
+
+            std::vector<std::tuple<Parameters...>> tuples;
+            std::vector<int> callIndices;
+            tuples.reserve(numCalls);
+            callIndices.reserve(numCalls);
+
+            for(int i = 0; i < numCalls; i++)
+            {
+                const RemoteFunctionBatchedCall& call = executionRequest.batched_calls(i);
+                if(call.parameter_payloads_size() != parameterSize)
+                {
+                    Logger::logError("Failed to execute call %d of batched RemoteFunctionRunnable \"%s\". Function expected %d parameters, but was executed with %d",
+                        i, getFunctionSignature(executionRequest.remote_function_identifier()).c_str(), parameterSize, call.parameter_payloads_size());
+                    continue;
+                }
+
+                tuples.emplace_back();
+                extractParameters<0, Parameters...>(call.parameter_payloads(), tuples.back());
+                callIndices.push_back(i);
+            }
+
+            if(this->batchFunction)
+            {
+                std::vector<RemoteFunctionRunnableResult<Return>> batchResults = executeBatchFromTuples(tuples);
+                for(size_t i = 0; i < batchResults.size(); i++)
+                {
+                    results[callIndices[i]] = batchResults[i];
+                }
+            }
+            else
+            {
+                for(size_t i = 0; i < tuples.size(); i++)
+                {
+                    results[callIndices[i]] = executeRemoteFunctionRequestFromTuple(tuples[i]);
+                }
+            }
+
+            return makeBatchedRPCResponsePackage(results, rpcRequest);
+        }
+
         template<typename U = Return>
         typename std::enable_if<std::is_same<void, U>::value, RemoteFunctionRunnableResult<U>>::type
         executeRemoteFunctionRequestFromTuple(std::tuple<Parameters...>& tuple)
@@ -96,11 +201,23 @@ class RemoteFunctionRunnable : public AbstractRemoteFunctionRunnable
             this->mutatorHelpers = {std::static_pointer_cast<AbstractMutatorHelper>(std::make_shared<TypedMutatorHelper<Parameters>>())...};
         }
 
+        RemoteFunctionRunnable(std::string functionName, 
+            BatchFunctionType batchFunction) : functionName(functionName), batchFunction(batchFunction)
+        {
+            static_assert(!std::is_void<Return>::value, "Batched remote functions have to return a value for every element of the batch.");
+            this->mutatorHelpers = {std::static_pointer_cast<AbstractMutatorHelper>(std::make_shared<TypedMutatorHelper<Parameters>>())...};
+        }
+
         std::shared_ptr<DataPackage> executeRemoteFunctionRequest(std::shared_ptr<DataPackage> rpcRequest) override final
         {
-            RemoteFunctionRequest executionRequest = rpcRequest->control_val().remote_function_request();
+            const RemoteFunctionRequest& executionRequest = rpcRequest->control_val().remote_function_request();
+
+            if(executionRequest.batched_calls_size() > 0)
+            {
+                return executeBatchedRemoteFunctionRequest(rpcRequest);
+            }
 
-            RemoteFunctionIdentifier remoteFunctionIdentifier = executionRequest.remote_function_identifier();
+            const RemoteFunctionIdentifier& remoteFunctionIdentifier = executionRequest.remote_function_identifier();
 
             int payloadsSize = executionRequest.parameter_payloads_size();
 
@@ -117,8 +234,15 @@ class RemoteFunctionRunnable : public AbstractRemoteFunctionRunnable
 
             std::tuple<Parameters...> parameters;
 
-            extractParameters<0, Parameters...>(rpcRequest->control_val().remote_function_request(), parameters);
+            extractParameters<0, Parameters...>(executionRequest.parameter_payloads(), parameters);
 
+            if(!this->function)
+            {
+                // Only the batched function is available, which is executed with a batch of one.
+                std::vector<std::tuple<Parameters...>> tuples(1, std::move(parameters));
+                RemoteFunctionRunnableResult<Return> status = executeBatchFromTuples(tuples)[0];
+                return makeRPCResponsePackage(status, rpcRequest);
+            }
         
             RemoteFunctionRunnableResult<Return> status
                 = executeRemoteFunctionRequestFromTuple(parameters);
@@ -145,7 +269,7 @@ class RemoteFunctionRunnable : public AbstractRemoteFunctionRunnable
             return true;
         }
 
-        std::string getFunctionSignature(RemoteFunctionIdentifier remoteFunctionIdentifier)
+        std::string getFunctionSignature(const RemoteFunctionIdentifier& remoteFunctionIdentifier)
         {
             std::string returnTypeName = typeid(Return).name();
             std::string functionName = "";
@@ -174,14 +298,14 @@ class RemoteFunctionRunnable : public AbstractRemoteFunctionRunnable
             return functionSignature;
         }
 
-        RemoteFunctionReturn makeRemoteFunctionReturn(RemoteFunctionRunnableResult<Return> result, RemoteFunctionRequest executionRequest)
+        RemoteFunctionReturn makeRemoteFunctionReturn(RemoteFunctionRunnableResult<Return>& result, const RemoteFunctionRequest& executionRequest)
         {
             RemoteFunctionReturn remoteFunctionReturn;
-            RemoteFunctionIdentifier remoteFunctionIdentifier = executionRequest.remote_function_identifier();
 
             remoteFunctionReturn.set_execution_status(result.getStatus());
-            *(remoteFunctionReturn.mutable_remote_function_identifier()) = remoteFunctionIdentifier;
+            *(remoteFunctionReturn.mutable_remote_function_identifier()) = executionRequest.remote_function_identifier();
             remoteFunctionReturn.set_remote_future_identifier(executionRequest.remote_future_identifier());
+            remoteFunctionReturn.set_remote_future_id(executionRequest.remote_future_id());
 
 
             return remoteFunctionReturn;
@@ -211,6 +335,32 @@ class RemoteFunctionRunnable : public AbstractRemoteFunctionRunnable
             return responsePackage;
         }
 
+        std::shared_ptr<DataPackage> 
+            makeBatchedRPCResponsePackage(std::vector<RemoteFunctionRunnableResult<Return>>& results, std::shared_ptr<DataPackage> rpcRequest)
+        {
+            const RemoteFunctionRequest& executionRequest = rpcRequest->control_val().remote_function_request();
+
+            // The request as a whole succeeded, the status of each call is set in the batched returns.
+            RemoteFunctionRunnableResult<Return> status = RemoteFunctionRunnableResult<Return>::makeSuccessfulResult(nullptr);
+            std::shared_ptr<DataPackage> responsePackage = makeRPCResponsePackage(status, rpcRequest);
+
+            RemoteFunctionReturn& remoteFunctionReturn = *responsePackage->mutable_control_val()->mutable_remote_function_return();
+            remoteFunctionReturn.mutable_batched_returns()->Reserve(results.size());
+
+            std::shared_ptr<DataPackage> stubPackage = std::make_shared<DataPackage>();
+            for(size_t i = 0; i < results.size(); i++)
+            {
+                RemoteFunctionBatchedReturn& batchedReturn = *remoteFunctionReturn.add_batched_returns();
+                batchedReturn.set_remote_future_id(executionRequest.batched_calls(i).remote_future_id());
+                batchedReturn.set_execution_status(results[i].getStatus());
+
+                setReturnPackagePayload<Return>(stubPackage, results[i]);
+                batchedReturn.mutable_return_payload()->Swap(stubPackage->mutable_payload());
+            }
+
+            return responsePackage;
+        }
+
         template<typename U>
         typename std::enable_if<!std::is_same<U, void>::value>::type
         setReturnPackagePayload(std::shared_ptr<DataPackage> package, RemoteFunctionRunnableResult<U>& result)
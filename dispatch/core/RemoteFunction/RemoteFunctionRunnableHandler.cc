@@ -23,18 +23,15 @@ bool RemoteFunctionRunnableHandler::addRunnable(std::string functionName, std::s
 
 bool RemoteFunctionRunnableHandler::executeRemoteFunctionRunnable(std::shared_ptr<DataPackage> rpcRequest)
 {
-    RemoteFunctionRequest request;
     if(!rpcRequest->control_val().has_remote_function_request())
     {
         Logger::logError("Failed to execute RPC request data package. Could not find definition of RemoteFunctionRequest.");
         return false;
     }
 
-    request = rpcRequest->control_val().remote_function_request();
+    const RemoteFunctionRequest& request = rpcRequest->control_val().remote_function_request();
 
-    RemoteFunctionIdentifier remoteFunctionIdentifier = request.remote_function_identifier();
-
-    std::string functionName = remoteFunctionIdentifier.function_name();
+    const std::string& functionName = request.remote_function_identifier().function_name();
     
     auto it = this->registeredRunnables.find(functionName);
 
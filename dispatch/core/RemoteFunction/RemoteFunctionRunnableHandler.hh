@@ -35,6 +35,19 @@ using namespace claidservice;
 
 namespace claid {
 
+// Maps the element type of a batch to the parameters of the RemoteFunctionRunnable (see RemoteFunctionBatchElement).
+template<typename Return, typename BatchElement>
+struct BatchedRunnableType
+{
+    typedef RemoteFunctionRunnable<Return, BatchElement> type;
+};
+
+template<typename Return, typename... Parameters>
+struct BatchedRunnableType<Return, std::tuple<Parameters...>>
+{
+    typedef RemoteFunctionRunnable<Return, Parameters...> type;
+};
+
 class RemoteFunctionRunnableHandler 
 {
 
@@ -91,6 +104,36 @@ public:
         return this->addRunnable(functionName, std::static_pointer_cast<AbstractRemoteFunctionRunnable>(runnable));
     }
     
+    // Registers a function which receives all calls of a batched request at once (see RemoteFunction::executeBatch).
+    // Functions with a single parameter receive a vector of that parameter, functions with multiple parameters 
+    // a vector of tuples. The function has to return one value per element of the batch.
+    // Single (non-batched) calls are executed as batch of one.
+    template<typename Class, typename Return, typename BatchElement>
+    bool registerBatchedRunnable(std::string functionName, std::vector<Return> (Class::*f)(const std::vector<BatchElement>&), Class* obj)
+    {
+        auto it = this->registeredRunnables.find(functionName);
+
+        if(it != this->registeredRunnables.end())
+        {
+            CLAID_LOG_THROW_FATAL(
+                claid::Exception,
+                absl::StrCat("Failed to register function \"", functionName, " in Module \"", entityName, "\". Function already registered before.")
+            );
+            return false;
+        }
+
+        typedef typename BatchedRunnableType<Return, BatchElement>::type RunnableType;
+        
+        typename RunnableType::BatchFunctionType function = [f, obj](const std::vector<BatchElement>& batch)
+        {
+            return (obj->*f)(batch);
+        };
+
+        std::shared_ptr<RunnableType> runnable = std::make_shared<RunnableType>(functionName, function);
+        
+        return this->addRunnable(functionName, std::static_pointer_cast<AbstractRemoteFunctionRunnable>(runnable));
+    }
+
     bool executeRemoteFunctionRunnable(std::shared_ptr<DataPackage> rpcRequest);
 
     private:
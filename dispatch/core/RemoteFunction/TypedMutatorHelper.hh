@@ -8,32 +8,40 @@ namespace claid {
     template<typename T>
     class TypedMutatorHelper : public AbstractMutatorHelper
     {
-        void setPackagePayloadUntyped(DataPackage& dataPackage, void* dataPtr)
+        // Created once per helper, so RemoteFunctions and RemoteFunctionRunnables 
+        // do not have to look up the Mutator (and its codec) for every call.
+        Mutator<T> mutator;
+        std::string typeName;
+
+        void setPackagePayloadUntyped(DataPackage& dataPackage, const void* dataPtr)
         {
-            Mutator<T> mutator = TypeMapping::getMutator<T>();
-            T* data = reinterpret_cast<T*>(dataPtr);
+            const T* data = reinterpret_cast<const T*>(dataPtr);
 
-            mutator.setPackagePayload(dataPackage, *data);
+            this->mutator.setPackagePayload(dataPackage, *data);
         }
 
         void getPackagePayloadUntyped(DataPackage& dataPackage, void* dataPtr)
         {
-            Mutator<T> mutator = TypeMapping::getMutator<T>();
             T* data = reinterpret_cast<T*>(dataPtr);
 
-            mutator.getPackagePayload(dataPackage, *data);
+            this->mutator.getPackagePayload(dataPackage, *data);
+        }
+
+    public:
+        TypedMutatorHelper() : mutator(TypeMapping::getMutator<T>())
+        {
+            this->typeName = this->mutator.getMessageTypeName();
         }
 
-        bool isSameTypeInternal(const std::type_info& type)
+        bool isSameTypeInternal(const std::type_info& type) const
         {
             return type == typeid(T);
         }
 
-        std::string getTypeName() const
+        const std::string& getTypeName() const
         {
-            Mutator<T> mutator = TypeMapping::getMutator<T>();
-            return mutator.getMessageTypeName();
+            return this->typeName;
         }
     };
 
-}
\ No newline at end of file
+}
@@ -25,6 +25,8 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_cat.h"
 #include "dispatch/core/proto_util.hh"
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
 namespace claid {
     
     ClientRouter::ClientRouter(const std::string& currentHost,
@@ -36,13 +38,7 @@ namespace claid {
     absl::Status ClientRouter::routePackage(std::shared_ptr<DataPackage> dataPackage)
     {
         const std::string& sourceHost = dataPackage->source_host();
-        const std::string& sourceModule = dataPackage->source_module();
-
         const std::string& targetHost = dataPackage->target_host();
-        const std::string& targetModule = dataPackage->target_module();
-
-        Logger::logInfo("ClientRouter routing package from host \"%s\" (Module \"%s\"), "
-                        "destined for host \"%s\" (Module \"%s\").", sourceHost.c_str(), sourceModule.c_str(), targetHost.c_str(), targetModule.c_str());
 
         if(!canReachHost(targetHost))
         {
@@ -52,6 +48,16 @@ namespace claid {
             ));
         }
 
+        // Shared memory segments can only be mapped on the current host, hence large payloads have to be sent inline.
+        absl::Status inlineStatus = LargePayloadStore::inlineSharedMemoryCopy(dataPackage);
+        if(!inlineStatus.ok())
+        {
+            return inlineStatus;
+        }
+
+        // Routing IDs are only valid on the current host.
+        RoutingIdTable::clearIds(*dataPackage);
+
         this->clientTable.getToRemoteClientQueue().push_back(dataPackage);
 
         return absl::OkStatus();
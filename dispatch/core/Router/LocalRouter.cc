@@ -34,16 +34,10 @@ namespace claid {
         {
             return routeControlPackage(dataPackage);
         }
-        const std::string& sourceHost = dataPackage->source_host();
-        const std::string& sourceModule = dataPackage->source_module();
-
-        const std::string& targetHost = dataPackage->target_host();
         const std::string& targetModule = dataPackage->target_module();
 
-        Logger::logInfo("LocalRouter routing package from host \"%s\" (Module \"%s\"), "
-                        "destined for host \"%s\" (Module \"%s\").", sourceHost.c_str(), sourceModule.c_str(), targetHost.c_str(), targetModule.c_str());
-
-        SharedQueue<DataPackage>* inputQueueForRuntime = this->moduleTable.lookupOutputQueue(targetModule);
+        SharedQueue<DataPackage>* inputQueueForRuntime = dataPackage->target_module_id() != StringInternTable::INVALID_ID ?
+            this->moduleTable.lookupOutputQueue(dataPackage->target_module_id()) : this->moduleTable.lookupOutputQueue(targetModule);
 
         if(!inputQueueForRuntime)
         {
@@ -64,7 +58,6 @@ namespace claid {
 
     absl::Status LocalRouter::routeControlPackage(std::shared_ptr<DataPackage> package)
     {
-        Logger::logInfo("LocalRouter routing control package %s", CtrlType_Name(package->control_val().ctrl_type()).c_str());
         this->moduleTable.controlPackagesQueue().push_front(package);
         return absl::OkStatus();
     }
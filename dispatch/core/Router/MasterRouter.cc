@@ -23,6 +23,8 @@
 #include "dispatch/core/Router/RoutingTreeParser.hh"
 #include "dispatch/core/Logger/Logger.hh"
 #include "dispatch/core/Configuration/HostDescription.hh"
+#include <algorithm>
+#include <functional>
 #include <sstream>
 
 namespace claid
@@ -64,6 +66,16 @@ namespace claid
             }
 
             this->routingTable[hostname] = responsibleRouter;
+
+            if(this->routingIds != nullptr)
+            {
+                uint32_t hostId = this->routingIds->hosts.intern(hostname);
+                if(hostId > this->routersByHostId.size())
+                {
+                    this->routersByHostId.resize(hostId);
+                }
+                this->routersByHostId[hostId - 1] = responsibleRouter;
+            }
         }
 
         return absl::OkStatus();
@@ -72,11 +84,13 @@ namespace claid
 
     absl::Status MasterRouter::routePackage(std::shared_ptr<DataPackage> dataPackage) 
     {
-        const std::string& sourceHost = dataPackage->source_host();
-        const std::string& sourceModule = dataPackage->source_module();
+        uint32_t targetHostId = dataPackage->target_host_id();
+        if(targetHostId != StringInternTable::INVALID_ID && targetHostId <= this->routersByHostId.size() && this->routersByHostId[targetHostId - 1] != nullptr)
+        {
+            return this->routersByHostId[targetHostId - 1]->routePackage(dataPackage);
+        }
 
         const std::string& targetHost = dataPackage->target_host();
-        const std::string& targetModule = dataPackage->target_module();
 
         auto it = this->routingTable.find(targetHost);
         if(it == this->routingTable.end())
@@ -85,9 +99,6 @@ namespace claid
             return absl::InvalidArgumentError(absl::StrCat("Host \"", targetHost, "\" is unknown and could not be found in routing tree.\n"));
         }
 
-        Logger::logInfo("MasterRouter received package from host \"%s\" (Module \"%s\"), "
-                        "destined for host \"%s\" (Module \"%s\").", sourceHost.c_str(), sourceModule.c_str(), targetHost.c_str(), targetModule.c_str());
-                        
         absl::Status status = it->second->routePackage(dataPackage);
 
         return status;
@@ -111,43 +122,112 @@ namespace claid
                 continue;
             }
 
-            absl::Status status;
-            status = addPackageSourceIfNotSet(package);
-            if(!status.ok())
+            if(this->shards.empty())
             {
-                std::stringstream ss;
-                ss << status;
-                this->lastError = status;
-                Logger::logError("MasterRouter: Failed to route package on channel \"%s\", got error: %s", package->channel().c_str(), ss.str().c_str());
+                resolveAndRoutePackage(package);
                 continue;
             }
 
-            status = addPackageDestinationIfNotSet(package);
-            if(!status.ok())
-            {
-                std::stringstream ss;
-                ss << status;
-                this->lastError = status;
-                Logger::logError("MasterRouter: Failed to route package on channel \"%s\", got error: %s", package->channel().c_str(), ss.str().c_str());
-                continue;
-            }
+            this->numPackagesInShards++;
+            this->shards[getShardOfPackage(*package)]->inbox.push_back(package);
+        }
+    }
 
-            if(!package)
-            {
-                Logger::logError("MasterRouter: Failed to route package on channel \"%s\", package is null.", package->channel().c_str());
-                continue;
-            }
+    void MasterRouter::processShard(RouterShard& shard)
+    {
+        // The inbox is closed in stop() after the processingThread was joined.
+        // pop_front keeps returning the remaining packages until the inbox is empty, hence no package is lost.
+        std::shared_ptr<DataPackage> package;
+        while((package = shard.inbox.pop_front()) != nullptr)
+        {
+            resolveAndRoutePackage(package);
+            this->numPackagesInShards--;
+        }
+    }
 
-            status = this->routePackage(package);
-            if(!status.ok())
-            {
-                std::stringstream ss;
-                ss << status;
-                this->lastError = status;
-                Logger::logInfo("MasterRouter: Failed to route on channel \"%s\" package, got error: %s", package->channel().c_str(), ss.str().c_str());
-                continue;
-            }
+    void MasterRouter::resolveAndRoutePackage(std::shared_ptr<DataPackage> package)
+    {
+        absl::Status status;
+        status = addPackageSourceIfNotSet(package);
+        if(!status.ok())
+        {
+            std::stringstream ss;
+            ss << status;
+            setLastError(status);
+            Logger::logError("MasterRouter: Failed to route package on channel \"%s\", got error: %s", package->channel().c_str(), ss.str().c_str());
+            return;
+        }
+
+        status = addPackageDestinationIfNotSet(package);
+        if(!status.ok())
+        {
+            std::stringstream ss;
+            ss << status;
+            setLastError(status);
+            Logger::logError("MasterRouter: Failed to route package on channel \"%s\", got error: %s", package->channel().c_str(), ss.str().c_str());
+            return;
+        }
+
+        status = this->routePackage(package);
+        if(!status.ok())
+        {
+            std::stringstream ss;
+            ss << status;
+            setLastError(status);
+            Logger::logInfo("MasterRouter: Failed to route on channel \"%s\" package, got error: %s", package->channel().c_str(), ss.str().c_str());
+        }
+    }
+
+    size_t MasterRouter::getShardOfPackage(const DataPackage& package) const
+    {
+        // Only uses fields that are set before source and destination are resolved, hence all packages
+        // of a channel sent to the same Module (or host and user, in case of control packages) end up in the same shard.
+        // Packages of Modules carry the interned channel and target Module, if the ModuleTable knows them.
+        if(package.channel_id() != StringInternTable::INVALID_ID && package.target_module_id() != StringInternTable::INVALID_ID)
+        {
+            return std::hash<uint64_t>()(RoutingIdTable::makeKey(package.channel_id(), package.target_module_id())) % this->shards.size();
         }
+
+        std::hash<std::string> hash;
+        size_t key = hash(package.channel());
+        for(const std::string* field : {&package.target_module(), &package.target_host(), &package.target_user_token()})
+        {
+            key ^= hash(*field) + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2);
+        }
+        return key % this->shards.size();
+    }
+
+    void MasterRouter::setLastError(const absl::Status& status)
+    {
+        std::unique_lock<std::mutex> lock(this->lastErrorMutex);
+        this->lastError = status;
+    }
+
+    absl::Status MasterRouter::setNumShards(size_t numShards)
+    {
+        if(this->active)
+        {
+            return absl::InternalError("Cannot change number of shards of MasterRouter. Router is running, you first have to stop and then later restart it.");
+        }
+        this->numShards = std::max<size_t>(1, numShards);
+        return absl::OkStatus();
+    }
+
+    absl::Status MasterRouter::setRoutingIdTable(std::shared_ptr<RoutingIdTable> routingIds)
+    {
+        if(this->active)
+        {
+            return absl::InternalError("Cannot set routing IDs of MasterRouter. Router is running, you first have to stop and then later restart it.");
+        }
+        this->routingIds = routingIds;
+        this->routersByHostId.clear();
+        this->updateModuleDescriptions(*std::atomic_load(&this->moduleDescriptions));
+        return absl::OkStatus();
+    }
+
+    size_t MasterRouter::getNumShards() const
+    {
+        return this->numShards;
     }
 
     absl::Status MasterRouter::start() 
@@ -175,6 +255,19 @@ namespace claid
         }
 
         this->active = true;
+
+        // With a single shard, the processingThread routes the packages itself.
+        if(this->numShards > 1)
+        {
+            for(size_t i = 0; i < this->numShards; i++)
+            {
+                this->shards.push_back(std::make_unique<RouterShard>());
+            }
+            for(std::unique_ptr<RouterShard>& shard : this->shards)
+            {
+                shard->worker = make_unique<std::thread>(&MasterRouter::processShard, this, std::ref(*shard));
+            }
+        }
         this->processingThread = make_unique<std::thread>(&MasterRouter::processQueue, this);
 
         return absl::OkStatus();
@@ -192,6 +285,17 @@ namespace claid
         this->incomingQueue.interruptOnce();
         this->processingThread->join();
         this->processingThread = nullptr;
+
+        // Route the packages which were already distributed to the shards.
+        for(std::unique_ptr<RouterShard>& shard : this->shards)
+        {
+            shard->inbox.close();
+        }
+        for(std::unique_ptr<RouterShard>& shard : this->shards)
+        {
+            shard->worker->join();
+        }
+        this->shards.clear();
         return absl::OkStatus();
     }   
 
@@ -202,7 +306,7 @@ namespace claid
             return absl::InvalidArgumentError("Failed to stop MasterRouter. Router is not running.");
         }
 
-        while(this->incomingQueue.size() > 0)
+        while(this->incomingQueue.size() > 0 || this->numPackagesInShards > 0)
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
@@ -225,6 +329,7 @@ namespace claid
 
     absl::Status MasterRouter::getLastError()
     {
+        std::unique_lock<std::mutex> lock(this->lastErrorMutex);
         return this->lastError;
     }
 
@@ -235,8 +340,7 @@ namespace claid
         {
             return absl::OkStatus();
         }
-        
-        Logger::logInfo("Aadd destination has control val %d", package->has_control_val());
+
         if(package->has_control_val())
         {
             if(package->target_host() == "")
@@ -255,6 +359,14 @@ namespace claid
             ));
         }
 
+        uint32_t targetHostId;
+        if(package->target_module_id() != StringInternTable::INVALID_ID &&
+            findHostOfModule(package->target_module_id(), targetHostId, *package->mutable_target_host()))
+        {
+            package->set_target_host_id(targetHostId);
+            return absl::OkStatus();
+        }
+
         const std::string& targetModule = package->target_module();
         std::string targetHost;
 
@@ -301,6 +413,14 @@ namespace claid
             ));
         }
 
+        uint32_t sourceHostId;
+        if(package->source_module_id() != StringInternTable::INVALID_ID &&
+            findHostOfModule(package->source_module_id(), sourceHostId, *package->mutable_source_host()))
+        {
+            package->set_source_host_id(sourceHostId);
+            return absl::OkStatus();
+        }
+
         const std::string& sourceModule = package->source_module();
         std::string sourceHost;
 
@@ -319,18 +439,25 @@ namespace claid
 
     bool MasterRouter::findHostOfModule(const std::string& module, std::string& hostOfModule) const
     {
-        for(const auto& moduleEntry : this->moduleDescriptions)
+        std::shared_ptr<const ModuleDescriptionMap> descriptions = std::atomic_load(&this->moduleDescriptions);
+        auto it = descriptions->find(module);
+        if(it == descriptions->end())
         {
-            const std::string& moduleName = moduleEntry.first;
-            const ModuleDescription& moduleDescription = moduleEntry.second;
-            Logger::logInfo("Module %s %s", moduleName.c_str(), moduleDescription.host.c_str());
-            if(moduleName == module)
-            {
-                hostOfModule = moduleDescription.host;
-                return hostOfModule != "";
-            }
+            return false;
         }
-        return false;
+        hostOfModule = it->second.host;
+        return hostOfModule != "";
+    }
+
+    bool MasterRouter::findHostOfModule(uint32_t moduleId, uint32_t& hostIdOfModule, std::string& hostOfModule) const
+    {
+        std::shared_ptr<const std::vector<uint32_t>> hostIds = std::atomic_load(&this->hostIdsByModuleId);
+        if(hostIds == nullptr || moduleId == StringInternTable::INVALID_ID || moduleId > hostIds->size())
+        {
+            return false;
+        }
+        hostIdOfModule = (*hostIds)[moduleId - 1];
+        return this->routingIds->hosts.lookupName(hostIdOfModule, hostOfModule);
     }
 
     absl::Status MasterRouter::updateHostAndModuleDescriptions(const HostDescriptionMap& hostDescriptions,
@@ -342,11 +469,38 @@ namespace claid
         }
 
         this->hostDescriptions = hostDescriptions;
-        this->moduleDescriptions = moduleDescriptions;
+        this->updateModuleDescriptions(moduleDescriptions);
 
         return absl::OkStatus();
     }
 
+    void MasterRouter::updateModuleDescriptions(const ModuleDescriptionMap& moduleDescriptions)
+    {
+        std::shared_ptr<const ModuleDescriptionMap> descriptions = std::make_shared<const ModuleDescriptionMap>(moduleDescriptions);
+        std::atomic_store(&this->moduleDescriptions, descriptions);
+
+        if(this->routingIds == nullptr)
+        {
+            return;
+        }
+
+        std::shared_ptr<std::vector<uint32_t>> hostIds = std::make_shared<std::vector<uint32_t>>();
+        for(const auto& entry : moduleDescriptions)
+        {
+            if(entry.second.host == "")
+            {
+                continue;
+            }
+            uint32_t moduleId = this->routingIds->modules.intern(entry.first);
+            if(moduleId > hostIds->size())
+            {
+                hostIds->resize(moduleId, StringInternTable::INVALID_ID);
+            }
+            (*hostIds)[moduleId - 1] = this->routingIds->hosts.intern(entry.second.host);
+        }
+        std::atomic_store(&this->hostIdsByModuleId, std::shared_ptr<const std::vector<uint32_t>>(hostIds));
+    }
+
 }
 
 
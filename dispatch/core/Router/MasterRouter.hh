@@ -27,12 +27,18 @@
 #include "dispatch/core/Router/ClientRouter.hh"
 #include "dispatch/core/Configuration/HostDescription.hh"
 #include "dispatch/core/Configuration/ModuleDescription.hh"
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace claid
 {
 
     // Waits on an incoming queue in a separate thread and forwards the package to either the LocalRouter,
     // ClientRouter or ServerRouter, depending on the target host of the package.
+    // Optionally, routing can be spread over multiple shards (threads), see setNumShards.
     class MasterRouter final : public Router
     {
         private:
@@ -64,16 +70,47 @@ namespace claid
             SharedQueue<DataPackage>& incomingQueue;
 
             std::unique_ptr<std::thread> processingThread;
-            bool active = false;
+            std::atomic<bool> active{false};
+
+            // If more than one shard is used, the processingThread only distributes the packages from the incomingQueue
+            // to the inboxes of the shards. Each shard has its own worker thread, which resolves source and destination
+            // of the package and forwards it to the sub-router. All packages of the same channel and destination are
+            // assigned to the same shard, hence their order is preserved.
+            struct RouterShard
+            {
+                SharedQueue<DataPackage> inbox;
+                std::unique_ptr<std::thread> worker;
+            };
+
+            size_t numShards = 1;
+            std::vector<std::unique_ptr<RouterShard>> shards;
+
+            // Packages which have been distributed to a shard but were not yet routed.
+            std::atomic<size_t> numPackagesInShards{0};
 
             const std::string currentHost;
             const std::string userId;
             const std::string deviceId;
 
             HostDescriptionMap hostDescriptions;
-            ModuleDescriptionMap moduleDescriptions;
+
+            // Read by the routing threads for every package which lacks source or target host.
+            // Swapped atomically by updateModuleDescriptions, so the Router keeps running while a config is reloaded.
+            std::shared_ptr<const ModuleDescriptionMap> moduleDescriptions;
+
+            // Interned names shared with the ModuleTable, see setRoutingIdTable. Packages carrying IDs are routed
+            // using the tables below, all other packages using the names.
+            std::shared_ptr<RoutingIdTable> routingIds;
+
+            // Same as routingTable, indexed by the interned ID of the host. Built together with routingTable.
+            std::vector<std::shared_ptr<Router>> routersByHostId;
+
+            // Interned ID of the host of each Module, indexed by the interned ID of the Module.
+            // Swapped atomically after moduleDescriptions by updateModuleDescriptions.
+            std::shared_ptr<const std::vector<uint32_t>> hostIdsByModuleId;
 
             absl::Status lastError;
+            std::mutex lastErrorMutex;
 
         private:    
    
@@ -81,10 +118,15 @@ namespace claid
             absl::Status buildRoutingTable(const std::string& currentHost, const HostDescriptionMap& hostDescriptions);
 
             void processQueue();
+            void processShard(RouterShard& shard);
+            void resolveAndRoutePackage(std::shared_ptr<DataPackage> package);
+            size_t getShardOfPackage(const DataPackage& package) const;
+            void setLastError(const absl::Status& status);
 
             absl::Status addPackageDestinationIfNotSet(std::shared_ptr<DataPackage> package) const;
             absl::Status addPackageSourceIfNotSet(std::shared_ptr<DataPackage> package) const;
             bool findHostOfModule(const std::string& module, std::string& hostOfModule) const;
+            bool findHostOfModule(uint32_t moduleId, uint32_t& hostIdOfModule, std::string& hostOfModule) const;
 
         public:
         
@@ -99,11 +141,21 @@ namespace claid
                 SharedQueue<claidservice::DataPackage>& incomingQueue, 
                 std::shared_ptr<RouterTypes>... routersToRegister) : incomingQueue(incomingQueue), currentHost(currentHost), 
                                                                     userId(userId), deviceId(deviceId),
-                                                                    hostDescriptions(hostDescriptions), moduleDescriptions(moduleDescriptions)
+                                                                    hostDescriptions(hostDescriptions), 
+                                                                    moduleDescriptions(std::make_shared<const ModuleDescriptionMap>(moduleDescriptions))
             {
                 routers = {std::static_pointer_cast<Router>(routersToRegister)...};
             }
 
+            // Sets the number of shards (routing threads). Has to be called before start.
+            // 1 (default) routes all packages on the processing thread itself.
+            absl::Status setNumShards(size_t numShards);
+            size_t getNumShards() const;
+
+            // Uses the interned IDs of the given table (usually the one of the ModuleTable) to route packages carrying IDs.
+            // Host names are added to the table. Has to be called before start.
+            absl::Status setRoutingIdTable(std::shared_ptr<RoutingIdTable> routingIds);
+
             absl::Status start() override final;
             absl::Status stop();
             absl::Status stopAfterQueueFinished();
@@ -113,6 +165,10 @@ namespace claid
             absl::Status routePackage(std::shared_ptr<DataPackage> dataPackage) override final;
             absl::Status updateHostAndModuleDescriptions(const HostDescriptionMap& hostDescriptions,
                 const ModuleDescriptionMap& moduleDescriptions);
+
+            // Replaces the Module descriptions while the Router is running.
+            // Packages which are currently being routed still use the previous descriptions.
+            void updateModuleDescriptions(const ModuleDescriptionMap& moduleDescriptions);
             bool canReachHost(const std::string& hostname) override final;
     };
 }
\ No newline at end of file
@@ -21,6 +21,8 @@
 
 #include "dispatch/core/Router/ServerRouter.hh"
 #include "dispatch/core/Logger/Logger.hh"
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
 #include <sstream>
 
 namespace claid
@@ -36,13 +38,7 @@ namespace claid
     {
 
         const std::string& sourceHost = dataPackage->source_host();
-        const std::string& sourceModule = dataPackage->source_module();
-
         const std::string& targetHost = dataPackage->target_host();
-        const std::string& targetModule = dataPackage->target_module();
-        Logger::logInfo("ServerRouter routing package from host \"%s\" (Module \"%s\"), "
-                        "destined for host \"%s\" (Module \"%s\").", sourceHost.c_str(), sourceModule.c_str(), targetHost.c_str(), targetModule.c_str());
-
 
         if(!canReachHost(targetHost))
         {
@@ -52,9 +48,22 @@ namespace claid
             ));
         }
 
+        // Clients cannot map shared memory segments of our host.
+        absl::Status inlineStatus = LargePayloadStore::inlineSharedMemoryCopy(dataPackage);
+        if(!inlineStatus.ok())
+        {
+            return inlineStatus;
+        }
+
+        // Routing IDs are only valid on the current host.
+        RoutingIdTable::clearIds(*dataPackage);
+
         // The function canReachHost will automatically cache the route to the targetHost in our routingTable.
         // Hence, it is assured that the routingTable will have an entry for targetHost.
-        const std::vector<std::string>& route = this->routingTable[targetHost];
+        // Entries are never erased, so the reference stays valid after releasing the lock.
+        std::unique_lock<std::mutex> routingTableLock(this->routingTableMutex);
+        const std::vector<std::string>& route = this->routingTable.find(targetHost)->second;
+        routingTableLock.unlock();
 
         if(route.size() == 0)
         {
@@ -76,12 +85,11 @@ namespace claid
 
             if(routeToAllUsers)
             {
-                Logger::logInfo("ServerRouter routing to all users");
-                std::vector<std::shared_ptr<SharedQueue<DataPackage>>> queues;
+                HostOutputQueuesPtr queues;
 
                 status = this->hostUserTable.lookupOutputQueuesForHost(nextHost, queues);
 
-                if(!status.ok() || queues.size() == 0)
+                if(!status.ok() || queues->queues.size() == 0)
                 {
                     std::stringstream ss;
                     ss << status;
@@ -91,21 +99,18 @@ namespace claid
                     return absl::OkStatus();
                 }
 
-                for(std::shared_ptr<SharedQueue<DataPackage>> queue : queues)
+                for(const std::shared_ptr<ClientOutputQueue>& queue : queues->queues)
                 {
-                    Logger::logInfo("ServerRouter routing to all users, inserting to queue");
-                    queue->push_back(dataPackage);
+                    queue->push(dataPackage);
                 }
 
             }
             else
             {
                 const std::string& targetUserToken = dataPackage->target_user_token();
-                
-                Logger::logInfo("ServerRouter routing to user \"%s\"", dataPackage->target_user_token().c_str());
 
-                std::shared_ptr<SharedQueue<DataPackage>> queue;
-                status = this->hostUserTable.lookupOutputQueueForHostUser(nextHost, targetUserToken, queue);
+                std::shared_ptr<ClientOutputQueue> queue;
+                status = this->hostUserTable.lookupClientOutputQueue(nextHost, targetUserToken, queue);
 
                 if(!status.ok())
                 {
@@ -117,8 +122,7 @@ namespace claid
                     return absl::OkStatus();
                 }
 
-                Logger::logInfo("ServerRouter routing to one user, inserting to queue");
-                queue->push_back(dataPackage);
+                queue->push(dataPackage);
             }
 
         }   
@@ -126,7 +130,7 @@ namespace claid
         // In that case, the next host in the list HAS to be a server, and there can only be ONE instance of that host.
         else
         {
-            std::vector<std::shared_ptr<SharedQueue<DataPackage>>> queues;
+            HostOutputQueuesPtr queues;
             status = this->hostUserTable.lookupOutputQueuesForHost(nextHost, queues);
 
             if(!status.ok())
@@ -138,7 +142,7 @@ namespace claid
                 return absl::OkStatus();
             }
 
-            if(queues.size() > 1)
+            if(queues->queues.size() > 1)
             {
                 return absl::InvalidArgumentError(absl::StrCat(
                     "Amiguity detected in ServerRouter: Trying to route package from host \"", sourceHost, "\" ",
@@ -147,12 +151,19 @@ namespace claid
                     " and therefore only one instance of that host should exist."
                 ));
             }
-            Logger::logInfo("ServerRouter routing to intermediate server, inserting to queue");
 
-            queues[0]->push_back(dataPackage);
+            if(queues->queues.size() == 0)
+            {
+                Logger::logWarning("ServerRouter failed to route package from host \"%s\" to host \"%s\", "
+                "via intermediate host \"%s\". The intermediate host \"%s\" is currently not connected.\n"
+                "Package will be discarded.", sourceHost.c_str(), targetHost.c_str(), nextHost.c_str(), nextHost.c_str());
+
+                return absl::OkStatus();
+            }
+
+            queues->queues[0]->push(dataPackage);
 
         }
-        Logger::logInfo("ServerRouter routed package successfully");
         return absl::OkStatus();
     }
 
@@ -160,10 +171,14 @@ namespace claid
     {
         // Check if we have seen this host already before. 
         // If yes, and we can reach it, we have cached the routing path to that host in our routing table.
-        auto it = this->routingTable.find(hostname);
-        if(it != this->routingTable.end())
+        // canReachHost is called by the router threads concurrently, hence the routingTable has to be locked.
+        // The route is computed without holding the lock.
         {
-            return true;
+            std::unique_lock<std::mutex> routingTableLock(this->routingTableMutex);
+            if(this->routingTable.find(hostname) != this->routingTable.end())
+            {
+                return true;
+            }
         }
 
         std::vector<std::string> route;
@@ -182,8 +197,9 @@ namespace claid
             return false;
         }
 
-        // Cache result for later routing.
-        this->routingTable[hostname] = route;
+        // Cache result for later routing. Another thread might have inserted the same route meanwhile, which is fine.
+        std::unique_lock<std::mutex> routingTableLock(this->routingTableMutex);
+        this->routingTable.insert(std::make_pair(hostname, route));
         return true;
     }
 
@@ -24,6 +24,8 @@
 #include "dispatch/core/Router/Router.hh"
 #include "dispatch/core/Router/RoutingTree.hh"
 #include "dispatch/core/RemoteDispatching/HostUserTable.hh"
+
+#include <mutex>
 namespace claid
 {
 
@@ -48,6 +50,7 @@ namespace claid
             std::map<std::string /* target host */, 
                     std::vector<std::string> > /* route to host from currentHost */
                      routingTable;
+            std::mutex routingTableMutex;
         
     };
 }
\ No newline at end of file
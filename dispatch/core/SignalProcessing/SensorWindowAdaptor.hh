@@ -0,0 +1,255 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "dispatch/core/Module/ChannelData.hh"
+#include "dispatch/core/SignalProcessing/SensorWindowBuffer.hh"
+#include "dispatch/core/SignalProcessing/SignalKernels.hh"
+
+namespace claid
+{
+    struct SensorWindowSettings
+    {
+        // Window length and distance between the starts of consecutive windows, in samples.
+        size_t windowSize = 0;
+        size_t hopSize = 0;
+
+        // If greater than 0, the (possibly irregularly sampled) input is linearly interpolated 
+        // onto a uniform grid with this rate before windowing.
+        double resamplingRateHz = 0.0;
+    };
+
+    // Turns a stream of AccelerationData/GyroscopeData (or the corresponding batches) into windows of 
+    // ThreeAxisSensorColumns, optionally resampled to a fixed rate.
+    // Can be used as a subscription adaptor within any Module, e.g.:
+    //
+    //      adaptor.configure(settings, [this](const SensorWindowAdaptor<AccelerationData>::Window& window) { ... });
+    //      subscribe<AccelerationData>("Acceleration", &SensorWindowAdaptor<AccelerationData>::onData, &adaptor);
+    //
+    // The window callback is invoked from the thread of the subscription callback. 
+    // After the first few messages, the adaptor does not allocate memory for incoming data or windows.
+    template<typename SensorData>
+    class SensorWindowAdaptor
+    {
+        public:
+            typedef ThreeAxisSensorTraits<SensorData> Traits;
+            typedef typename Traits::BatchMessage BatchMessage;
+            typedef typename SensorWindowBuffer<BatchMessage>::Window Window;
+            typedef typename SensorWindowBuffer<BatchMessage>::WindowCallback WindowCallback;
+
+            absl::Status configure(const SensorWindowSettings& settings, WindowCallback callback)
+            {
+                if(settings.resamplingRateHz < 0.0)
+                {
+                    return absl::InvalidArgumentError(absl::StrCat("Invalid resampling rate ", settings.resamplingRateHz, " Hz."));
+                }
+
+                this->settings = settings;
+                hasPreviousSample = false;
+                return buffer.configure(settings.windowSize, settings.hopSize, callback);
+            }
+
+            void onData(ChannelData<SensorData> data)
+            {
+                addSamples(data.getData());
+            }
+
+            void onBatchData(ChannelData<BatchMessage> data)
+            {
+                addBatch(data.getData());
+            }
+
+            void addSamples(const SensorData& data)
+            {
+                const int numSamples = data.samples_size();
+                if(numSamples == 0)
+                {
+                    return;
+                }
+
+                const size_t offset = prepareInput(numSamples);
+                for(int i = 0; i < numSamples; i++)
+                {
+                    const auto& sample = data.samples(i);
+                    inputX[offset + i] = Traits::x(sample);
+                    inputY[offset + i] = Traits::y(sample);
+                    inputZ[offset + i] = Traits::z(sample);
+                    inputTimestamps[offset + i] = sample.unix_timestamp_in_ms();
+                }
+                setWindowMetadata(data.samples(0).sensor_body_location(), data.samples(0).effective_time_frame());
+                processInput();
+            }
+
+            void addBatch(const BatchMessage& batch)
+            {
+                const int numSamples = batch.x_size();
+                if(numSamples == 0 || batch.y_size() != numSamples || batch.z_size() != numSamples 
+                    || batch.timestamp_deltas_in_ms_size() != numSamples)
+                {
+                    return;
+                }
+
+                const size_t offset = prepareInput(numSamples);
+                memcpy(inputX.data() + offset, batch.x().data(), numSamples * sizeof(double));
+                memcpy(inputY.data() + offset, batch.y().data(), numSamples * sizeof(double));
+                memcpy(inputZ.data() + offset, batch.z().data(), numSamples * sizeof(double));
+
+                uint64_t timestamp = batch.first_unix_timestamp_in_ms();
+                for(int i = 0; i < numSamples; i++)
+                {
+                    timestamp += static_cast<uint64_t>(batch.timestamp_deltas_in_ms(i));
+                    inputTimestamps[offset + i] = timestamp;
+                }
+                setWindowMetadata(batch.sensor_body_location(), batch.effective_time_frame());
+                processInput();
+            }
+
+            const SensorWindowSettings& getSettings() const
+            {
+                return settings;
+            }
+
+        private:
+            SensorWindowSettings settings;
+            SensorWindowBuffer<BatchMessage> buffer;
+
+            std::string sensorBodyLocation;
+            std::string effectiveTimeFrame;
+
+            // Samples of the current message. When resampling, index 0 holds the last sample of the previous message,
+            // so that the grid can be interpolated across message boundaries.
+            std::vector<double> inputX;
+            std::vector<double> inputY;
+            std::vector<double> inputZ;
+            std::vector<uint64_t> inputTimestamps;
+            size_t numInputSamples = 0;
+            bool hasPreviousSample = false;
+
+            std::vector<uint32_t> interpolationIndices;
+            std::vector<double> interpolationWeights;
+            std::vector<double> resampledX;
+            std::vector<double> resampledY;
+            std::vector<double> resampledZ;
+            std::vector<uint64_t> resampledTimestamps;
+            double nextGridTimestamp = 0.0;
+
+            bool isResampling() const
+            {
+                return settings.resamplingRateHz > 0.0;
+            }
+
+            // Grows the input buffers if necessary and returns the index of the first new sample.
+            size_t prepareInput(size_t numNewSamples)
+            {
+                const size_t offset = (isResampling() && hasPreviousSample) ? 1 : 0;
+                numInputSamples = offset + numNewSamples;
+                if(inputX.size() < numInputSamples)
+                {
+                    inputX.resize(numInputSamples);
+                    inputY.resize(numInputSamples);
+                    inputZ.resize(numInputSamples);
+                    inputTimestamps.resize(numInputSamples);
+                }
+                return offset;
+            }
+
+            void setWindowMetadata(const std::string& newSensorBodyLocation, const std::string& newEffectiveTimeFrame)
+            {
+                if(newSensorBodyLocation != sensorBodyLocation)
+                {
+                    sensorBodyLocation = newSensorBodyLocation;
+                    buffer.setSensorBodyLocation(sensorBodyLocation);
+                }
+                if(newEffectiveTimeFrame != effectiveTimeFrame)
+                {
+                    effectiveTimeFrame = newEffectiveTimeFrame;
+                    buffer.setEffectiveTimeFrame(effectiveTimeFrame);
+                }
+            }
+
+            void processInput()
+            {
+                if(!isResampling())
+                {
+                    buffer.append(inputX.data(), inputY.data(), inputZ.data(), inputTimestamps.data(), numInputSamples);
+                    return;
+                }
+
+                const double periodMs = 1000.0 / settings.resamplingRateHz;
+                if(!hasPreviousSample)
+                {
+                    nextGridTimestamp = static_cast<double>(inputTimestamps[0]);
+                }
+                else if(inputTimestamps[1] > inputTimestamps[0] + periodMs * settings.windowSize)
+                {
+                    // Gap of more than a whole window (e.g., the sensor was paused): 
+                    // do not interpolate across it, but start over with the new samples.
+                    buffer.reset();
+                    nextGridTimestamp = static_cast<double>(inputTimestamps[1]);
+                }
+
+                const double lastTimestamp = static_cast<double>(inputTimestamps[numInputSamples - 1]);
+                size_t numOutput = 0;
+                if(numInputSamples >= 2 && nextGridTimestamp <= lastTimestamp)
+                {
+                    numOutput = static_cast<size_t>(std::floor((lastTimestamp - nextGridTimestamp) / periodMs)) + 1;
+                }
+
+                if(numOutput > 0)
+                {
+                    if(resampledX.size() < numOutput)
+                    {
+                        interpolationIndices.resize(numOutput);
+                        interpolationWeights.resize(numOutput);
+                        resampledX.resize(numOutput);
+                        resampledY.resize(numOutput);
+                        resampledZ.resize(numOutput);
+                        resampledTimestamps.resize(numOutput);
+                    }
+
+                    SignalKernels::planLinearInterpolation(inputTimestamps.data(), numInputSamples, nextGridTimestamp, periodMs, 
+                        numOutput, interpolationIndices.data(), interpolationWeights.data());
+                    SignalKernels::applyLinearInterpolation(inputX.data(), interpolationIndices.data(), interpolationWeights.data(), numOutput, resampledX.data());
+                    SignalKernels::applyLinearInterpolation(inputY.data(), interpolationIndices.data(), interpolationWeights.data(), numOutput, resampledY.data());
+                    SignalKernels::applyLinearInterpolation(inputZ.data(), interpolationIndices.data(), interpolationWeights.data(), numOutput, resampledZ.data());
+                    for(size_t k = 0; k < numOutput; k++)
+                    {
+                        resampledTimestamps[k] = static_cast<uint64_t>(std::llround(nextGridTimestamp + k * periodMs));
+                    }
+
+                    nextGridTimestamp += numOutput * periodMs;
+                    buffer.append(resampledX.data(), resampledY.data(), resampledZ.data(), resampledTimestamps.data(), numOutput);
+                }
+
+                // Keep the last sample for interpolating across the boundary to the next message.
+                const size_t last = numInputSamples - 1;
+                inputX[0] = inputX[last];
+                inputY[0] = inputY[last];
+                inputZ[0] = inputZ[last];
+                inputTimestamps[0] = inputTimestamps[last];
+                hasPreviousSample = true;
+            }
+    };
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "dispatch/core/Module/TypeMapping/SensorColumns.hh"
+
+namespace claid
+{
+    // Ring buffer of 3-axis sensor samples, which emits sliding (hopSize < windowSize) 
+    // or tumbling (hopSize == windowSize) windows of windowSize samples every hopSize samples.
+    // Samples are appended and windows are emitted in bulk; after configure, 
+    // neither appending nor emitting allocates memory.
+    // The emitted window is owned by the buffer and only valid during the callback.
+    template<typename BatchMessage>
+    class SensorWindowBuffer
+    {
+        public:
+            typedef ThreeAxisSensorColumns<double, BatchMessage> Window;
+            typedef std::function<void(const Window&)> WindowCallback;
+
+            absl::Status configure(size_t windowSize, size_t hopSize, WindowCallback callback)
+            {
+                if(windowSize == 0 || hopSize == 0)
+                {
+                    return absl::InvalidArgumentError(absl::StrCat(
+                        "Invalid window configuration: windowSize (", windowSize, ") and hopSize (", hopSize, ") need to be greater than 0."));
+                }
+
+                this->windowSize = windowSize;
+                this->hopSize = hopSize;
+                this->callback = callback;
+
+                x.assign(windowSize, 0.0);
+                y.assign(windowSize, 0.0);
+                z.assign(windowSize, 0.0);
+                timestamps.assign(windowSize, 0);
+
+                window.x.assign(windowSize, 0.0);
+                window.y.assign(windowSize, 0.0);
+                window.z.assign(windowSize, 0.0);
+                window.unixTimestampsInMs.assign(windowSize, 0);
+
+                reset();
+                return absl::OkStatus();
+            }
+
+            // Drops all buffered samples, e.g., after a gap in the data.
+            void reset()
+            {
+                head = 0;
+                numBufferedSamples = 0;
+                samplesUntilNextWindow = windowSize;
+            }
+
+            void setSensorBodyLocation(const std::string& sensorBodyLocation)
+            {
+                window.sensorBodyLocation = sensorBodyLocation;
+            }
+
+            void setEffectiveTimeFrame(const std::string& effectiveTimeFrame)
+            {
+                window.effectiveTimeFrame = effectiveTimeFrame;
+            }
+
+            void append(const double* newX, const double* newY, const double* newZ, const uint64_t* newTimestamps, size_t numSamples)
+            {
+                if(windowSize == 0)
+                {
+                    return;
+                }
+
+                size_t offset = 0;
+                while(offset < numSamples)
+                {
+                    const size_t chunk = std::min({numSamples - offset, samplesUntilNextWindow, windowSize - head});
+
+                    memcpy(x.data() + head, newX + offset, chunk * sizeof(double));
+                    memcpy(y.data() + head, newY + offset, chunk * sizeof(double));
+                    memcpy(z.data() + head, newZ + offset, chunk * sizeof(double));
+                    memcpy(timestamps.data() + head, newTimestamps + offset, chunk * sizeof(uint64_t));
+
+                    head = (head + chunk) % windowSize;
+                    numBufferedSamples = std::min(numBufferedSamples + chunk, windowSize);
+                    samplesUntilNextWindow -= chunk;
+                    offset += chunk;
+
+                    if(samplesUntilNextWindow == 0)
+                    {
+                        emitWindow();
+                        samplesUntilNextWindow = hopSize;
+                    }
+                }
+            }
+
+            size_t getWindowSize() const
+            {
+                return windowSize;
+            }
+
+            size_t getHopSize() const
+            {
+                return hopSize;
+            }
+
+            size_t getNumBufferedSamples() const
+            {
+                return numBufferedSamples;
+            }
+
+        private:
+            size_t windowSize = 0;
+            size_t hopSize = 0;
+            WindowCallback callback;
+
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> z;
+            std::vector<uint64_t> timestamps;
+
+            // Next position to write to. Once the buffer is full, this is also the oldest sample.
+            size_t head = 0;
+            size_t numBufferedSamples = 0;
+            size_t samplesUntilNextWindow = 0;
+
+            Window window;
+
+            // Linearizes the ring (oldest sample first) into the window.
+            template<typename Value>
+            void linearize(const std::vector<Value>& ring, std::vector<Value>& output)
+            {
+                const size_t numOldest = windowSize - head;
+                memcpy(output.data(), ring.data() + head, numOldest * sizeof(Value));
+                memcpy(output.data() + numOldest, ring.data(), head * sizeof(Value));
+            }
+
+            void emitWindow()
+            {
+                linearize(x, window.x);
+                linearize(y, window.y);
+                linearize(z, window.z);
+                linearize(timestamps, window.unixTimestampsInMs);
+
+                if(callback)
+                {
+                    callback(window);
+                }
+            }
+    };
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/SignalProcessing/SensorWindowFeatureExtractor.hh"
+
+namespace claid
+{
+    void SensorWindowFeatureExtractor::configure(size_t windowSize, bool computeSpectrum)
+    {
+        this->computeSpectrum = computeSpectrum;
+        if(computeSpectrum)
+        {
+            fft.setSize(windowSize);
+        }
+    }
+
+    double SensorWindowFeatureExtractor::estimateSamplingRate(const std::vector<uint64_t>& timestamps)
+    {
+        if(timestamps.size() < 2 || timestamps.back() <= timestamps.front())
+        {
+            return 0.0;
+        }
+        return (timestamps.size() - 1) * 1000.0 / (timestamps.back() - timestamps.front());
+    }
+
+    void SensorWindowFeatureExtractor::extractAxis(const double* values, size_t numSamples, double samplingRateHz, AxisWindowFeatures& features)
+    {
+        const double mean = SignalKernels::mean(values, numSamples);
+        features.set_mean(mean);
+        features.set_variance(SignalKernels::variance(values, numSamples, mean));
+        features.set_energy(SignalKernels::energy(values, numSamples));
+
+        if(!computeSpectrum || fft.getSize() == 0)
+        {
+            features.clear_fft_magnitude();
+            features.set_dominant_frequency_hz(0.0);
+            return;
+        }
+
+        const size_t numBins = fft.getNumBins();
+        features.mutable_fft_magnitude()->Resize(static_cast<int>(numBins), 0.0);
+        double* magnitude = features.mutable_fft_magnitude()->mutable_data();
+        fft.magnitude(values, numSamples, mean, magnitude);
+
+        // The DC bin is zero since the mean was removed.
+        size_t dominantBin = 0;
+        for(size_t i = 1; i < numBins; i++)
+        {
+            if(magnitude[i] > magnitude[dominantBin])
+            {
+                dominantBin = i;
+            }
+        }
+        features.set_dominant_frequency_hz(dominantBin * samplingRateHz / fft.getSize());
+    }
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "dispatch/core/Module/TypeMapping/SensorColumns.hh"
+#include "dispatch/core/SignalProcessing/SignalKernels.hh"
+#include "dispatch/proto/sensor_data_types.pb.h"
+
+namespace claid
+{
+    // Computes ThreeAxisWindowFeatures (mean, variance, energy and optionally the FFT magnitude) of windows of 3-axis sensor data.
+    // The FFT buffers are allocated once in configure and reused for every window. 
+    // Passing the same features message for every window also reuses its fft_magnitude arrays.
+    class SensorWindowFeatureExtractor
+    {
+        public:
+            void configure(size_t windowSize, bool computeSpectrum);
+
+            // If samplingRateHz is 0, the rate is estimated from the timestamps of the window.
+            template<typename BatchMessage>
+            void extract(const ThreeAxisSensorColumns<double, BatchMessage>& window, double samplingRateHz, ThreeAxisWindowFeatures& features)
+            {
+                const size_t numSamples = window.size();
+                if(samplingRateHz <= 0.0)
+                {
+                    samplingRateHz = estimateSamplingRate(window.unixTimestampsInMs);
+                }
+
+                features.set_num_samples(static_cast<uint32_t>(numSamples));
+                features.set_sampling_rate_hz(samplingRateHz);
+                features.set_window_start_unix_timestamp_in_ms(numSamples == 0 ? 0 : window.unixTimestampsInMs.front());
+                features.set_window_end_unix_timestamp_in_ms(numSamples == 0 ? 0 : window.unixTimestampsInMs.back());
+                features.set_sensor_body_location(window.sensorBodyLocation);
+
+                extractAxis(window.x.data(), numSamples, samplingRateHz, *features.mutable_x());
+                extractAxis(window.y.data(), numSamples, samplingRateHz, *features.mutable_y());
+                extractAxis(window.z.data(), numSamples, samplingRateHz, *features.mutable_z());
+            }
+
+            static double estimateSamplingRate(const std::vector<uint64_t>& timestamps);
+
+        private:
+            bool computeSpectrum = false;
+            SignalKernels::FFT fft;
+
+            void extractAxis(const double* values, size_t numSamples, double samplingRateHz, AxisWindowFeatures& features);
+    };
+}
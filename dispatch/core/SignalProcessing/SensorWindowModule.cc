@@ -0,0 +1,120 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/SignalProcessing/SensorWindowModule.hh"
+
+namespace claid
+{
+    void SensorWindowModule::initialize(Properties properties)
+    {
+        std::string sensorType;
+        int windowSize;
+        int hopSize;
+        double resamplingRateHz;
+        bool computeSpectrum;
+
+        properties.getStringProperty("sensorType", sensorType, "acceleration");
+        properties.getNumberProperty("windowSize", windowSize);
+        properties.getNumberProperty("hopSize", hopSize, windowSize);
+        properties.getNumberProperty("resamplingRateHz", resamplingRateHz, 0.0);
+        properties.getBoolProperty("publishWindows", this->publishWindows, true);
+        properties.getBoolProperty("computeFeatures", this->computeFeatures, true);
+        properties.getBoolProperty("computeSpectrum", computeSpectrum, true);
+
+        if(properties.wasAnyPropertyUnknown())
+        {
+            std::string unknownProperties;
+            properties.unknownPropertiesToString(unknownProperties);
+
+            this->moduleFatal(absl::StrCat("Missing properties: [", unknownProperties, "]. Please sepcify the properties in the configuration file."));
+            return;
+        }
+
+        if(windowSize < 1 || hopSize < 1)
+        {
+            this->moduleFatal(absl::StrCat("Invalid window configuration: windowSize ", windowSize, ", hopSize ", hopSize, 
+                ". Both need to be at least 1."));
+            return;
+        }
+
+        SensorWindowSettings settings;
+        settings.windowSize = windowSize;
+        settings.hopSize = hopSize;
+        settings.resamplingRateHz = resamplingRateHz;
+
+        this->featureExtractor.configure(settings.windowSize, computeSpectrum);
+
+        if(sensorType == "acceleration")
+        {
+            setupPipeline(settings, this->accelerationAdaptor, this->accelerationInputChannel, this->accelerationWindowChannel);
+        }
+        else if(sensorType == "gyroscope")
+        {
+            setupPipeline(settings, this->gyroscopeAdaptor, this->gyroscopeInputChannel, this->gyroscopeWindowChannel);
+        }
+        else
+        {
+            this->moduleFatal(absl::StrCat("Invalid sensorType \"", sensorType, "\". Supported are \"acceleration\" and \"gyroscope\"."));
+            return;
+        }
+
+        if(this->computeFeatures)
+        {
+            this->featuresChannel = this->publish<ThreeAxisWindowFeatures>("OutputFeatures");
+        }
+    }
+
+    template<typename SensorData>
+    void SensorWindowModule::setupPipeline(const SensorWindowSettings& settings, std::unique_ptr<SensorWindowAdaptor<SensorData>>& adaptor, 
+        Channel<SensorData>& inputChannel, Channel<typename SensorWindowAdaptor<SensorData>::Window>& windowChannel)
+    {
+        typedef typename SensorWindowAdaptor<SensorData>::Window Window;
+
+        adaptor = std::make_unique<SensorWindowAdaptor<SensorData>>();
+        absl::Status status = adaptor->configure(settings, [this, &windowChannel, settings](const Window& window)
+        {
+            const Time timestamp = Time::fromUnixTimestampMilliseconds(window.unixTimestampsInMs.back());
+            if(this->publishWindows)
+            {
+                windowChannel.post(window, timestamp);
+            }
+            if(this->computeFeatures)
+            {
+                this->featureExtractor.extract(window, settings.resamplingRateHz, this->features);
+                this->featuresChannel.post(this->features, timestamp);
+            }
+        });
+
+        if(!status.ok())
+        {
+            this->moduleFatal(status);
+            return;
+        }
+
+        if(this->publishWindows)
+        {
+            windowChannel = this->publish<Window>("OutputWindows");
+        }
+        inputChannel = this->subscribe<SensorData>("InputData", &SensorWindowAdaptor<SensorData>::onData, adaptor.get());
+    }
+}
+
+REGISTER_MODULE(SensorWindowModule, claid::SensorWindowModule)
@@ -0,0 +1,80 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <memory>
+
+#include "dispatch/core/Module/Module.hh"
+#include "dispatch/core/SignalProcessing/SensorWindowAdaptor.hh"
+#include "dispatch/core/SignalProcessing/SensorWindowFeatureExtractor.hh"
+
+namespace claid
+{
+    class SensorWindowModule : public claid::Module
+    {
+        public:
+            static void annotateModule(ModuleAnnotator& annotator)
+            {
+                annotator.setModuleCategory("SignalProcessing");
+                annotator.setModuleDescription(absl::StrCat(
+                    "The SensorWindowModule splits acceleration or gyroscope data arriving on the InputData channel into sliding or tumbling windows ",
+                    "of windowSize samples, which start every hopSize samples. Optionally, the data is resampled to a fixed rate before windowing.\n",
+                    "Windows are published as columnar batches (AccelerationBatch/GyroscopeBatch) on the OutputWindows channel. ",
+                    "Additionally, mean, variance, energy and the FFT magnitude of every axis can be published on the OutputFeatures channel. ",
+                    "Downstream Modules (e.g., in Python) hence receive one message per window instead of handling every sample individually."
+                ));
+
+                annotator.describeProperty("sensorType", "Type of the input data.", annotator.makeEnumProperty({"acceleration", "gyroscope"}));
+                annotator.describeProperty("windowSize", "Number of samples per window.", annotator.makeIntegerProperty(1, 1000000));
+                annotator.describeProperty("hopSize", "Number of samples between the starts of two windows. Defaults to windowSize (tumbling windows).", annotator.makeIntegerProperty(1, 1000000));
+                annotator.describeProperty("resamplingRateHz", "If greater than 0, the data is linearly interpolated to this sampling rate before windowing.");
+                annotator.describeProperty("publishWindows", "If set to \"true\", windows are published on the OutputWindows channel.", annotator.makeEnumProperty({"true", "false"}));
+                annotator.describeProperty("computeFeatures", "If set to \"true\", features of every window are published on the OutputFeatures channel.", annotator.makeEnumProperty({"true", "false"}));
+                annotator.describeProperty("computeSpectrum", "If set to \"true\", the features include the FFT magnitude and dominant frequency of every axis.", annotator.makeEnumProperty({"true", "false"}));
+
+                annotator.describeSubscribeChannel<AccelerationData>("InputData", "AccelerationData or GyroscopeData, depending on the sensorType.");
+                annotator.describePublishChannel<AccelerationBatch>("OutputWindows", "AccelerationBatch or GyroscopeBatch, depending on the sensorType.");
+                annotator.describePublishChannel<ThreeAxisWindowFeatures>("OutputFeatures", "Features of every window.");
+            }
+
+        private:
+            std::unique_ptr<SensorWindowAdaptor<AccelerationData>> accelerationAdaptor;
+            std::unique_ptr<SensorWindowAdaptor<GyroscopeData>> gyroscopeAdaptor;
+
+            Channel<AccelerationData> accelerationInputChannel;
+            Channel<GyroscopeData> gyroscopeInputChannel;
+            Channel<AccelerationColumns<double>> accelerationWindowChannel;
+            Channel<GyroscopeColumns<double>> gyroscopeWindowChannel;
+            Channel<ThreeAxisWindowFeatures> featuresChannel;
+
+            bool publishWindows;
+            bool computeFeatures;
+            SensorWindowFeatureExtractor featureExtractor;
+            ThreeAxisWindowFeatures features;
+
+            void initialize(Properties properties);
+
+            template<typename SensorData>
+            void setupPipeline(const SensorWindowSettings& settings, std::unique_ptr<SensorWindowAdaptor<SensorData>>& adaptor, 
+                Channel<SensorData>& inputChannel, Channel<typename SensorWindowAdaptor<SensorData>::Window>& windowChannel);
+    };
+}
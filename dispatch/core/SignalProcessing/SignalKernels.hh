@@ -0,0 +1,279 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace claid
+{
+    // Numerical kernels for windows of sensor data.
+    // All kernels operate on contiguous arrays (e.g., the columns of a ThreeAxisSensorColumns window).
+    // Reductions use four independent accumulators, which allows the compiler to vectorize them 
+    // without relaxing floating point semantics (i.e., without -ffast-math).
+    namespace SignalKernels
+    {
+        template<typename Value>
+        double sum(const Value* values, size_t size)
+        {
+            double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+            size_t i = 0;
+            for(; i + 4 <= size; i += 4)
+            {
+                sum0 += values[i];
+                sum1 += values[i + 1];
+                sum2 += values[i + 2];
+                sum3 += values[i + 3];
+            }
+            for(; i < size; i++)
+            {
+                sum0 += values[i];
+            }
+            return (sum0 + sum1) + (sum2 + sum3);
+        }
+
+        template<typename Value>
+        double mean(const Value* values, size_t size)
+        {
+            return size == 0 ? 0.0 : sum(values, size) / size;
+        }
+
+        // Sum of squared values.
+        template<typename Value>
+        double energy(const Value* values, size_t size)
+        {
+            double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+            size_t i = 0;
+            for(; i + 4 <= size; i += 4)
+            {
+                sum0 += static_cast<double>(values[i]) * values[i];
+                sum1 += static_cast<double>(values[i + 1]) * values[i + 1];
+                sum2 += static_cast<double>(values[i + 2]) * values[i + 2];
+                sum3 += static_cast<double>(values[i + 3]) * values[i + 3];
+            }
+            for(; i < size; i++)
+            {
+                sum0 += static_cast<double>(values[i]) * values[i];
+            }
+            return (sum0 + sum1) + (sum2 + sum3);
+        }
+
+        // Population variance around the given mean (two-pass, numerically stable).
+        template<typename Value>
+        double variance(const Value* values, size_t size, double mean)
+        {
+            if(size == 0)
+            {
+                return 0.0;
+            }
+
+            double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+            size_t i = 0;
+            for(; i + 4 <= size; i += 4)
+            {
+                const double d0 = values[i] - mean;
+                const double d1 = values[i + 1] - mean;
+                const double d2 = values[i + 2] - mean;
+                const double d3 = values[i + 3] - mean;
+                sum0 += d0 * d0;
+                sum1 += d1 * d1;
+                sum2 += d2 * d2;
+                sum3 += d3 * d3;
+            }
+            for(; i < size; i++)
+            {
+                const double d = values[i] - mean;
+                sum0 += d * d;
+            }
+            return ((sum0 + sum1) + (sum2 + sum3)) / size;
+        }
+
+        // Computes where the uniform grid startTimestamp + k * periodMs (k < numOutput) falls into the 
+        // (non-decreasing) input timestamps: output k is interpolated between input indices[k] and indices[k] + 1 
+        // with the given weight of the latter. Grid points outside of the input are clamped to the first/last input sample.
+        // The plan is computed once per block and applied to every axis with applyLinearInterpolation.
+        // Requires numInput >= 2.
+        inline void planLinearInterpolation(const uint64_t* timestamps, size_t numInput, 
+            double startTimestamp, double periodMs, size_t numOutput, 
+            uint32_t* indices, double* weights)
+        {
+            size_t i = 0;
+            for(size_t k = 0; k < numOutput; k++)
+            {
+                const double t = startTimestamp + k * periodMs;
+                while(i + 2 < numInput && timestamps[i + 1] <= t)
+                {
+                    i++;
+                }
+
+                const double left = static_cast<double>(timestamps[i]);
+                const double right = static_cast<double>(timestamps[i + 1]);
+                double weight = right > left ? (t - left) / (right - left) : 0.0;
+                weight = weight < 0.0 ? 0.0 : (weight > 1.0 ? 1.0 : weight);
+
+                indices[k] = static_cast<uint32_t>(i);
+                weights[k] = weight;
+            }
+        }
+
+        template<typename Value, typename OutputValue>
+        void applyLinearInterpolation(const Value* values, const uint32_t* indices, const double* weights, 
+            size_t numOutput, OutputValue* output)
+        {
+            for(size_t k = 0; k < numOutput; k++)
+            {
+                const double left = values[indices[k]];
+                const double right = values[indices[k] + 1];
+                output[k] = static_cast<OutputValue>(left + weights[k] * (right - left));
+            }
+        }
+
+        // Iterative radix-2 FFT for real signals with precomputed twiddle factors and bit reversal table.
+        // Real and imaginary parts are kept in separate arrays, which keeps the butterflies vectorizable.
+        // An instance allocates its buffers in setSize and can be reused for any number of transforms.
+        class FFT
+        {
+            public:
+                FFT() {}
+
+                explicit FFT(size_t minimumSize)
+                {
+                    setSize(minimumSize);
+                }
+
+                // Rounds the size up to the next power of two. Inputs shorter than the size are zero-padded.
+                void setSize(size_t minimumSize)
+                {
+                    size_t newSize = 1;
+                    while(newSize < minimumSize)
+                    {
+                        newSize <<= 1;
+                    }
+                    if(newSize == size)
+                    {
+                        return;
+                    }
+
+                    size = newSize;
+                    real.assign(size, 0.0);
+                    imaginary.assign(size, 0.0);
+                    twiddleReal.resize(size / 2);
+                    twiddleImaginary.resize(size / 2);
+                    for(size_t i = 0; i < size / 2; i++)
+                    {
+                        const double angle = -2.0 * M_PI * i / size;
+                        twiddleReal[i] = std::cos(angle);
+                        twiddleImaginary[i] = std::sin(angle);
+                    }
+
+                    bitReversed.resize(size);
+                    size_t numBits = 0;
+                    while((size_t(1) << numBits) < size)
+                    {
+                        numBits++;
+                    }
+                    for(size_t i = 0; i < size; i++)
+                    {
+                        size_t reversed = 0;
+                        for(size_t bit = 0; bit < numBits; bit++)
+                        {
+                            reversed |= ((i >> bit) & 1) << (numBits - 1 - bit);
+                        }
+                        bitReversed[i] = static_cast<uint32_t>(reversed);
+                    }
+                }
+
+                size_t getSize() const
+                {
+                    return size;
+                }
+
+                // Number of bins of the one-sided spectrum (size / 2 + 1).
+                size_t getNumBins() const
+                {
+                    return size == 0 ? 0 : size / 2 + 1;
+                }
+
+                // Writes the magnitude of the one-sided spectrum of (input - offset) to magnitude (getNumBins() values).
+                // Passing the mean as offset removes the DC component.
+                template<typename Value>
+                void magnitude(const Value* input, size_t inputSize, double offset, double* magnitude)
+                {
+                    if(size == 0)
+                    {
+                        return;
+                    }
+                    if(inputSize > size)
+                    {
+                        inputSize = size;
+                    }
+
+                    for(size_t i = 0; i < size; i++)
+                    {
+                        const uint32_t source = bitReversed[i];
+                        real[i] = source < inputSize ? input[source] - offset : 0.0;
+                        imaginary[i] = 0.0;
+                    }
+
+                    for(size_t length = 2; length <= size; length <<= 1)
+                    {
+                        const size_t half = length / 2;
+                        const size_t twiddleStep = size / length;
+                        for(size_t start = 0; start < size; start += length)
+                        {
+                            double* evenReal = real.data() + start;
+                            double* evenImaginary = imaginary.data() + start;
+                            double* oddReal = evenReal + half;
+                            double* oddImaginary = evenImaginary + half;
+                            for(size_t j = 0; j < half; j++)
+                            {
+                                const double wr = twiddleReal[j * twiddleStep];
+                                const double wi = twiddleImaginary[j * twiddleStep];
+                                const double tr = wr * oddReal[j] - wi * oddImaginary[j];
+                                const double ti = wr * oddImaginary[j] + wi * oddReal[j];
+                                oddReal[j] = evenReal[j] - tr;
+                                oddImaginary[j] = evenImaginary[j] - ti;
+                                evenReal[j] += tr;
+                                evenImaginary[j] += ti;
+                            }
+                        }
+                    }
+
+                    const size_t numBins = getNumBins();
+                    for(size_t i = 0; i < numBins; i++)
+                    {
+                        magnitude[i] = std::sqrt(real[i] * real[i] + imaginary[i] * imaginary[i]);
+                    }
+                }
+
+            private:
+                size_t size = 0;
+                std::vector<double> real;
+                std::vector<double> imaginary;
+                std::vector<double> twiddleReal;
+                std::vector<double> twiddleImaginary;
+                std::vector<uint32_t> bitReversed;
+        };
+    }
+}
@@ -524,6 +524,11 @@ namespace claid
 
 		return removeFile(source);
 	}
+
+	bool FileUtils::renameFile(const std::string& source, const std::string& destination)
+	{
+		return rename(source.c_str(), destination.c_str()) == 0;
+	}
             
 	bool FileUtils::getFileSize(const std::string& path, uint64_t& size)
 	{
@@ -535,6 +540,22 @@ namespace claid
 		return true;
 	}
 
+	bool FileUtils::getFileSizeAndModificationTime(const std::string& path, uint64_t& size, uint64_t& modificationTime)
+	{
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+		{
+			return false;
+		}
+		size = static_cast<uint64_t>(info.st_size);
+	#if defined(__linux__)
+		modificationTime = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000 + static_cast<uint64_t>(info.st_mtim.tv_nsec) / 1000000;
+	#else
+		modificationTime = static_cast<uint64_t>(info.st_mtime) * 1000;
+	#endif
+		return true;
+	}
+
 	bool FileUtils::getCurrentWorkingDirectory(std::string& outPath) 
 	{
 		char buffer[PATH_MAX];
@@ -52,8 +52,12 @@ namespace claid
 
             static bool copyFileTo(const std::string& source, const std::string& destination, bool appendExistingFile = false);
             static bool moveFileTo(const std::string& source, const std::string& destination, bool appendExistingFile = false);
+            // Atomically renames source to destination (both have to reside on the same file system).
+            static bool renameFile(const std::string& source, const std::string& destination);
 
             static bool getFileSize(const std::string& path, uint64_t& size);
+            // Retrieves size and last modification time (unix timestamp in milliseconds) using a single stat call.
+            static bool getFileSizeAndModificationTime(const std::string& path, uint64_t& size, uint64_t& modificationTime);
 
 	        static bool getCurrentWorkingDirectory(std::string& outPath);
             
@@ -0,0 +1,320 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+using claidservice::Blob;
+using claidservice::Codec;
+using claidservice::DataPackage;
+
+namespace claid
+{
+    LargePayloadStore::LargePayloadStore() : 
+        thresholdBytes(SharedMemorySegment::isSupported() ? DEFAULT_THRESHOLD_BYTES : 0)
+    {
+    }
+
+    LargePayloadStore* LargePayloadStore::getInstance()
+    {
+        // Accessed concurrently by the reader and writer threads of the runtime and by the Modules.
+        static LargePayloadStore instance;
+        return &instance;
+    }
+
+    void LargePayloadStore::setThreshold(size_t thresholdBytes)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->thresholdBytes = SharedMemorySegment::isSupported() ? thresholdBytes : 0;
+    }
+
+    size_t LargePayloadStore::getThreshold()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->thresholdBytes;
+    }
+
+    void LargePayloadStore::setLeaseDuration(std::chrono::milliseconds leaseDuration)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->leaseDuration = leaseDuration;
+    }
+
+    void LargePayloadStore::setMaxLeasedBytes(size_t maxLeasedBytes)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->maxLeasedBytes = maxLeasedBytes;
+    }
+
+    void LargePayloadStore::releaseExpiredSegments(std::chrono::steady_clock::time_point now)
+    {
+        // The lease duration might have been changed in the meantime, hence leases are not necessarily sorted by expiration.
+        auto it = this->leases.begin();
+        while(it != this->leases.end())
+        {
+            if(it->expiration <= now)
+            {
+                this->leasedBytes -= it->segment->size();
+                it = this->leases.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    bool LargePayloadStore::isLargeLocked(const DataPackage& package) const
+    {
+        if(!package.has_payload())
+        {
+            return false;
+        }
+        const Blob& blob = package.payload();
+        return this->thresholdBytes != 0 && blob.payload().size() >= this->thresholdBytes && 
+            blob.codec() == Codec::CODEC_PROTO && !blob.has_shared_memory();
+    }
+
+    bool LargePayloadStore::isLarge(const DataPackage& package)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return isLargeLocked(package);
+    }
+
+    bool LargePayloadStore::offloadIfLarge(DataPackage& package)
+    {
+        if(!package.has_payload())
+        {
+            return false;
+        }
+
+        Blob& blob = *package.mutable_payload();
+        const size_t size = blob.payload().size();
+        const auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            releaseExpiredSegments(now);
+
+            if(!isLargeLocked(package))
+            {
+                return false;
+            }
+
+            if(this->leasedBytes + size > this->maxLeasedBytes)
+            {
+                Logger::logWarning("LargePayloadStore: %zu bytes are already leased, sending payload of %zu bytes of package for channel \"%s\" inline.", 
+                    this->leasedBytes, size, package.channel().c_str());
+                return false;
+            }
+        }
+
+        std::shared_ptr<SharedMemorySegment> segment;
+        absl::Status status = SharedMemorySegment::create(blob.payload().data(), size, segment);
+        if(!status.ok())
+        {
+            Logger::logWarning("LargePayloadStore: Failed to offload payload of package for channel \"%s\", sending it inline: %s", 
+                package.channel().c_str(), std::string(status.message()).c_str());
+            return false;
+        }
+
+        *blob.mutable_shared_memory() = segment->getHandle();
+        blob.clear_payload();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->leasedBytes += size;
+        this->leases.push_back(Lease{now + this->leaseDuration, std::move(segment)});
+        return true;
+    }
+
+    size_t LargePayloadStore::getNumLeasedSegments()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        releaseExpiredSegments(std::chrono::steady_clock::now());
+        return this->leases.size();
+    }
+
+    absl::Status LargePayloadStore::takeDelivery(DataPackage& package, std::shared_ptr<SharedMemorySegment>& segment)
+    {
+        if(!package.has_payload() || !package.payload().has_shared_memory())
+        {
+            return absl::OkStatus();
+        }
+
+        std::unique_ptr<SharedMemorySegment> openedSegment;
+        absl::Status status = SharedMemorySegment::open(package.payload().shared_memory(), openedSegment);
+        if(!status.ok())
+        {
+            return status;
+        }
+
+        segment = std::shared_ptr<SharedMemorySegment>(openedSegment.release(), [](SharedMemorySegment* releasedSegment)
+        {
+            LargePayloadStore::getInstance()->leaseDeliveredSegment(releasedSegment);
+        });
+        *package.mutable_payload()->mutable_shared_memory() = segment->getHandle();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->deliveredSegments[segment->getHandle().fd()] = segment;
+        return absl::OkStatus();
+    }
+
+    // The returned package shares ownership of the original package and the segment.
+    static std::shared_ptr<DataPackage> makePackageHoldingSegment(std::shared_ptr<DataPackage> package, std::shared_ptr<SharedMemorySegment> segment)
+    {
+        DataPackage* packagePtr = package.get();
+        auto owner = std::make_shared<std::pair<std::shared_ptr<DataPackage>, std::shared_ptr<SharedMemorySegment>>>(std::move(package), std::move(segment));
+        return std::shared_ptr<DataPackage>(owner, packagePtr);
+    }
+
+    absl::Status LargePayloadStore::takeDelivery(std::shared_ptr<DataPackage>& package)
+    {
+        std::shared_ptr<SharedMemorySegment> segment;
+        absl::Status status = takeDelivery(*package, segment);
+        if(!status.ok() || segment == nullptr)
+        {
+            return status;
+        }
+        package = makePackageHoldingSegment(package, std::move(segment));
+        return absl::OkStatus();
+    }
+
+    void LargePayloadStore::holdSharedMemory(std::shared_ptr<DataPackage>& package)
+    {
+        if(!package->has_payload() || !package->payload().has_shared_memory())
+        {
+            return;
+        }
+        const claidservice::SharedMemoryHandle& handle = package->payload().shared_memory();
+
+        // Declared before the lock: if the segment is released concurrently, this might be the last reference, whose deleter locks the mutex.
+        std::shared_ptr<SharedMemorySegment> segment;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            auto it = this->deliveredSegments.find(handle.fd());
+            if(it != this->deliveredSegments.end())
+            {
+                segment = it->second.lock();
+            }
+        }
+
+        if(segment == nullptr)
+        {
+            return;
+        }
+
+        // The handle might refer to a segment of another process, which uses the same file descriptor.
+        const claidservice::SharedMemoryHandle deliveredHandle = segment->getHandle();
+        if(deliveredHandle.pid() == handle.pid() && deliveredHandle.segment_id() == handle.segment_id())
+        {
+            package = makePackageHoldingSegment(package, std::move(segment));
+        }
+    }
+
+    void LargePayloadStore::leaseDeliveredSegment(SharedMemorySegment* segment)
+    {
+        std::shared_ptr<SharedMemorySegment> leasedSegment(segment);
+        const auto now = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        // The file descriptor stays open until the lease expires, hence it cannot have been reused for another delivered segment.
+        this->deliveredSegments.erase(leasedSegment->getHandle().fd());
+        releaseExpiredSegments(now);
+        this->leasedBytes += leasedSegment->size();
+        this->leases.push_back(Lease{now + this->leaseDuration, std::move(leasedSegment)});
+    }
+
+    absl::Status LargePayloadStore::inlineSharedMemory(Blob& blob)
+    {
+        if(!blob.has_shared_memory())
+        {
+            return absl::OkStatus();
+        }
+
+        std::unique_ptr<SharedMemoryMapping> mapping;
+        absl::Status status = SharedMemoryMapping::map(blob.shared_memory(), mapping);
+        if(!status.ok())
+        {
+            return status;
+        }
+
+        blob.set_payload(mapping->data(), mapping->size());
+        blob.clear_shared_memory();
+        return absl::OkStatus();
+    }
+
+    absl::Status LargePayloadStore::inlineSharedMemory(DataPackage& package)
+    {
+        if(!package.has_payload())
+        {
+            return absl::OkStatus();
+        }
+        return inlineSharedMemory(*package.mutable_payload());
+    }
+
+    absl::Status LargePayloadStore::inlineSharedMemoryCopy(std::shared_ptr<DataPackage>& package)
+    {
+        if(!package->has_payload() || !package->payload().has_shared_memory())
+        {
+            return absl::OkStatus();
+        }
+
+        std::shared_ptr<DataPackage> copy = std::make_shared<DataPackage>(*package);
+        absl::Status status = inlineSharedMemory(*copy);
+        if(!status.ok())
+        {
+            return status;
+        }
+        package = copy;
+        return absl::OkStatus();
+    }
+
+    bool LargePayloadStore::parseBlobPayload(const Blob& blob, google::protobuf::Message& message)
+    {
+        if(!blob.has_shared_memory())
+        {
+            return message.ParseFromString(blob.payload());
+        }
+
+        // Parsing directly from the read-only mapping, the bytes are never copied into the DataPackage.
+        return visitBlobPayload(blob, [&message](const char* data, size_t size)
+        {
+            return message.ParseFromArray(data, static_cast<int>(size));
+        });
+    }
+
+    bool LargePayloadStore::visitBlobPayload(const Blob& blob, const std::function<bool(const char* data, size_t size)>& visitor)
+    {
+        if(!blob.has_shared_memory())
+        {
+            return visitor(blob.payload().data(), blob.payload().size());
+        }
+
+        std::unique_ptr<SharedMemoryMapping> mapping;
+        absl::Status status = SharedMemoryMapping::map(blob.shared_memory(), mapping);
+        if(!status.ok())
+        {
+            Logger::logError("Failed to access payload stored in shared memory: %s", std::string(status.message()).c_str());
+            return false;
+        }
+
+        return visitor(mapping->data(), mapping->size());
+    }
+}
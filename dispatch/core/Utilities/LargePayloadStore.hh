@@ -0,0 +1,126 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <google/protobuf/message.h>
+
+#include "absl/status/status.h"
+#include "dispatch/core/Utilities/SharedMemorySegment.hh"
+#include "dispatch/proto/claidservice.pb.h"
+
+namespace claid
+{
+    // Side channel for large payloads (e.g., camera frames, audio chunks or tensors) exchanged between runtimes on the same host.
+    // Payloads above a threshold are moved into a sealed SharedMemorySegment and the DataPackage only carries a SharedMemoryHandle,
+    // which receivers map read-only. This avoids copying the bytes through the Middleware and every RuntimeDispatcher.
+    //
+    // Segments are leased: the creator keeps each segment for at least the lease duration, which has to cover the time
+    // until the next process has received the package. Each receiving process (the Middleware and the C++ runtimes) takes delivery
+    // of the segment when reading the package and holds it as long as the package is queued, hence it does not matter how long
+    // packages wait for their Subscribers. Existing mappings stay valid after a segment was released (the kernel keeps the memory alive),
+    // but the segment cannot be opened anymore.
+    // Packages leaving the host, or sent to runtimes that cannot map segments, have to be inlined using inlineSharedMemory.
+    class LargePayloadStore
+    {
+        public:
+            static constexpr size_t DEFAULT_THRESHOLD_BYTES = 256 * 1024;
+            static constexpr size_t DEFAULT_MAX_LEASED_BYTES = 256 * 1024 * 1024;
+
+            static LargePayloadStore* getInstance();
+
+            // Payloads of at least thresholdBytes are offloaded. 0 disables offloading.
+            void setThreshold(size_t thresholdBytes);
+            size_t getThreshold();
+
+            void setLeaseDuration(std::chrono::milliseconds leaseDuration);
+
+            // If more bytes are leased at the same time, payloads are sent inline.
+            void setMaxLeasedBytes(size_t maxLeasedBytes);
+
+            // Whether offloadIfLarge would try to move the payload of the package into a SharedMemorySegment.
+            bool isLarge(const claidservice::DataPackage& package);
+
+            // Moves the payload of the package into a SharedMemorySegment, if it is a protobuf payload above the threshold.
+            // Returns true if the package was offloaded. If creating the segment fails, the package is left unchanged.
+            bool offloadIfLarge(claidservice::DataPackage& package);
+
+            size_t getNumLeasedSegments();
+
+            // Opens the segment the package refers to (if any) and replaces the handle of the package by one referring to this process.
+            // The segment is held as long as the returned segment or packages holding it (see holdSharedMemory) are alive,
+            // afterward it is leased like segments created by offloadIfLarge. Fails if the sender released the segment already.
+            absl::Status takeDelivery(claidservice::DataPackage& package, std::shared_ptr<SharedMemorySegment>& segment);
+
+            // Same as above, the package is replaced by one holding the segment. Must be called before the package is shared.
+            absl::Status takeDelivery(std::shared_ptr<claidservice::DataPackage>& package);
+
+            // Replaces the package by one holding the segment it refers to, if the segment was delivered to this process and is still held.
+            // Has to be called for copies of delivered packages, as they might outlive the original package.
+            void holdSharedMemory(std::shared_ptr<claidservice::DataPackage>& package);
+
+            // Replaces the SharedMemoryHandle of the Blob (if any) by the bytes of the segment.
+            static absl::Status inlineSharedMemory(claidservice::Blob& blob);
+            static absl::Status inlineSharedMemory(claidservice::DataPackage& package);
+
+            // Same as above, but replaces the package by an inlined copy, as the package might be shared with other queues.
+            static absl::Status inlineSharedMemoryCopy(std::shared_ptr<claidservice::DataPackage>& package);
+
+            // Parses the payload of the Blob into the message, regardless of whether it is stored inline or in shared memory.
+            static bool parseBlobPayload(const claidservice::Blob& blob, google::protobuf::Message& message);
+
+            // Passes the serialized payload of the Blob to the visitor without copying it, regardless of where it is stored.
+            // Returns the result of the visitor, or false if the payload could not be accessed.
+            static bool visitBlobPayload(const claidservice::Blob& blob, const std::function<bool(const char* data, size_t size)>& visitor);
+
+        private:
+            LargePayloadStore();
+
+            void releaseExpiredSegments(std::chrono::steady_clock::time_point now);
+            void leaseDeliveredSegment(SharedMemorySegment* segment);
+            bool isLargeLocked(const claidservice::DataPackage& package) const;
+
+            struct Lease
+            {
+                std::chrono::steady_clock::time_point expiration;
+                std::shared_ptr<SharedMemorySegment> segment;
+            };
+
+            std::mutex mutex;
+            std::deque<Lease> leases;
+            size_t leasedBytes = 0;
+
+            // Segments delivered to this process which are still held, by their file descriptor.
+            std::map<int, std::weak_ptr<SharedMemorySegment>> deliveredSegments;
+
+            size_t thresholdBytes;
+            size_t maxLeasedBytes = DEFAULT_MAX_LEASED_BYTES;
+            std::chrono::milliseconds leaseDuration = std::chrono::milliseconds(5000);
+    };
+}
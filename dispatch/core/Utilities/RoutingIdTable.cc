@@ -0,0 +1,220 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
+
+#include <mutex>
+
+using claidservice::DataPackage;
+using claidservice::RoutingIds;
+
+namespace claid
+{
+    uint32_t StringInternTable::intern(const std::string& name)
+    {
+        if(name.empty())
+        {
+            return INVALID_ID;
+        }
+
+        {
+            std::shared_lock<std::shared_mutex> lock(this->mutex);
+            auto it = this->ids.find(name);
+            if(it != this->ids.end())
+            {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        auto result = this->ids.emplace(name, static_cast<uint32_t>(this->names.size() + 1));
+        if(result.second)
+        {
+            this->names.push_back(name);
+        }
+        return result.first->second;
+    }
+
+    uint32_t StringInternTable::lookupId(const std::string& name) const
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        auto it = this->ids.find(name);
+        return it != this->ids.end() ? it->second : INVALID_ID;
+    }
+
+    bool StringInternTable::lookupName(uint32_t id, std::string& name) const
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        if(id == INVALID_ID || id > this->names.size() || this->names[id - 1].empty())
+        {
+            return false;
+        }
+        name = this->names[id - 1];
+        return true;
+    }
+
+    bool StringInternTable::contains(uint32_t id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        return id != INVALID_ID && id <= this->names.size() && !this->names[id - 1].empty();
+    }
+
+    size_t StringInternTable::size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        return this->ids.size();
+    }
+
+    void StringInternTable::assign(const std::string& name, uint32_t id)
+    {
+        if(name.empty() || id == INVALID_ID)
+        {
+            return;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        if(id > this->names.size())
+        {
+            this->names.resize(id);
+        }
+        this->names[id - 1] = name;
+        this->ids[name] = id;
+    }
+
+    void StringInternTable::clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        this->ids.clear();
+        this->names.clear();
+    }
+
+    void StringInternTable::toProto(google::protobuf::Map<std::string, uint32_t>& map) const
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        for(const auto& entry : this->ids)
+        {
+            map[entry.first] = entry.second;
+        }
+    }
+
+    void StringInternTable::fromProto(const google::protobuf::Map<std::string, uint32_t>& map)
+    {
+        clear();
+        for(const auto& entry : map)
+        {
+            assign(entry.first, entry.second);
+        }
+    }
+
+    void RoutingIdTable::toProto(RoutingIds& routingIds) const
+    {
+        this->channels.toProto(*routingIds.mutable_channels());
+        this->modules.toProto(*routingIds.mutable_modules());
+        this->hosts.toProto(*routingIds.mutable_hosts());
+    }
+
+    void RoutingIdTable::fromProto(const RoutingIds& routingIds)
+    {
+        this->channels.fromProto(routingIds.channels());
+        this->modules.fromProto(routingIds.modules());
+        this->hosts.fromProto(routingIds.hosts());
+    }
+
+    void RoutingIdTable::clear()
+    {
+        this->channels.clear();
+        this->modules.clear();
+        this->hosts.clear();
+    }
+
+    namespace
+    {
+        // A name of a DataPackage and the field carrying its interned ID.
+        struct RoutedField
+        {
+            const std::string& (DataPackage::*name)() const;
+            std::string* (DataPackage::*mutableName)();
+            void (DataPackage::*clearName)();
+            uint32_t (DataPackage::*id)() const;
+            void (DataPackage::*setId)(uint32_t);
+            StringInternTable RoutingIdTable::*table;
+        };
+
+        const RoutedField ROUTED_FIELDS[] = {
+            {&DataPackage::channel, &DataPackage::mutable_channel, &DataPackage::clear_channel,
+                &DataPackage::channel_id, &DataPackage::set_channel_id, &RoutingIdTable::channels},
+            {&DataPackage::source_module, &DataPackage::mutable_source_module, &DataPackage::clear_source_module,
+                &DataPackage::source_module_id, &DataPackage::set_source_module_id, &RoutingIdTable::modules},
+            {&DataPackage::target_module, &DataPackage::mutable_target_module, &DataPackage::clear_target_module,
+                &DataPackage::target_module_id, &DataPackage::set_target_module_id, &RoutingIdTable::modules},
+            {&DataPackage::source_host, &DataPackage::mutable_source_host, &DataPackage::clear_source_host,
+                &DataPackage::source_host_id, &DataPackage::set_source_host_id, &RoutingIdTable::hosts},
+            {&DataPackage::target_host, &DataPackage::mutable_target_host, &DataPackage::clear_target_host,
+                &DataPackage::target_host_id, &DataPackage::set_target_host_id, &RoutingIdTable::hosts},
+        };
+    }
+
+    void RoutingIdTable::compact(DataPackage& package) const
+    {
+        for(const RoutedField& field : ROUTED_FIELDS)
+        {
+            const StringInternTable& table = this->*field.table;
+            uint32_t id = (package.*field.id)();
+            if(id == StringInternTable::INVALID_ID)
+            {
+                const std::string& name = (package.*field.name)();
+                if(name.empty() || (id = table.lookupId(name)) == StringInternTable::INVALID_ID)
+                {
+                    continue;
+                }
+                (package.*field.setId)(id);
+                (package.*field.clearName)();
+            }
+            else if(!(package.*field.name)().empty() && table.contains(id))
+            {
+                (package.*field.clearName)();
+            }
+        }
+    }
+
+    bool RoutingIdTable::restoreNames(DataPackage& package) const
+    {
+        bool allKnown = true;
+        for(const RoutedField& field : ROUTED_FIELDS)
+        {
+            uint32_t id = (package.*field.id)();
+            if(id == StringInternTable::INVALID_ID || !(package.*field.name)().empty())
+            {
+                continue;
+            }
+            allKnown &= (this->*field.table).lookupName(id, *(package.*field.mutableName)());
+        }
+        return allKnown;
+    }
+
+    void RoutingIdTable::clearIds(DataPackage& package)
+    {
+        for(const RoutedField& field : ROUTED_FIELDS)
+        {
+            (package.*field.setId)(StringInternTable::INVALID_ID);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "dispatch/proto/claidservice.pb.h"
+
+namespace claid
+{
+    // Assigns 32-bit IDs (starting at 1) to strings.
+    // IDs are never reused or reassigned, hence an ID stays valid for the lifetime of the table,
+    // even if the name is not used anymore (e.g., after a Module was removed by a config reload).
+    class StringInternTable
+    {
+        public:
+            static constexpr uint32_t INVALID_ID = 0;
+
+            // Returns the ID of the name, assigning a new one if the name is not known yet.
+            // Empty names are not interned and yield INVALID_ID.
+            uint32_t intern(const std::string& name);
+
+            // Returns INVALID_ID if the name is unknown.
+            uint32_t lookupId(const std::string& name) const;
+
+            // Copies the name of the ID. Returns false if the ID is unknown.
+            bool lookupName(uint32_t id, std::string& name) const;
+
+            bool contains(uint32_t id) const;
+            size_t size() const;
+
+            // Assigns an ID received from another table (see RoutingIdTable::fromProto).
+            void assign(const std::string& name, uint32_t id);
+            void clear();
+
+            void toProto(google::protobuf::Map<std::string, uint32_t>& map) const;
+            void fromProto(const google::protobuf::Map<std::string, uint32_t>& map);
+
+        private:
+            mutable std::shared_mutex mutex;
+            std::unordered_map<std::string, uint32_t> ids;
+
+            // names[id - 1], empty if the ID was not assigned.
+            std::deque<std::string> names;
+    };
+
+    // Interned names of the channels, Modules and hosts known to the local Middleware.
+    // The Middleware assigns the IDs and sends a snapshot of its table to a Runtime in response to its CTRL_RUNTIME_PING,
+    // if the Runtime requested it. Afterward, both sides only send the IDs of the names contained in the snapshot.
+    // Names are restored from the IDs where they are needed (logging, user code, hops to other hosts).
+    class RoutingIdTable
+    {
+        public:
+            StringInternTable channels;
+            StringInternTable modules;
+            StringInternTable hosts;
+
+            void toProto(claidservice::RoutingIds& routingIds) const;
+            void fromProto(const claidservice::RoutingIds& routingIds);
+            void clear();
+
+            // Sets the ID of every name of the package known to this table, and clears the names whose ID is known.
+            void compact(claidservice::DataPackage& package) const;
+
+            // Restores the names of all fields which carry an ID but no name.
+            // Returns false if an ID is unknown, the corresponding name is left empty.
+            bool restoreNames(claidservice::DataPackage& package) const;
+
+            // IDs are only valid on the current host and have to be cleared when a package is sent to another host.
+            static void clearIds(claidservice::DataPackage& package);
+
+            // Combines two IDs into one key, e.g., for lookups by (channel, Module).
+            static uint64_t makeKey(uint32_t first, uint32_t second)
+            {
+                return (static_cast<uint64_t>(first) << 32) | second;
+            }
+    };
+}
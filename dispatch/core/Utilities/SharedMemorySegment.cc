@@ -0,0 +1,300 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/core/Utilities/SharedMemorySegment.hh"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef MFD_CLOEXEC
+#include <linux/memfd.h>
+#endif
+#endif
+
+namespace claid
+{
+    // Stored at the beginning of every segment, the payload follows directly afterward.
+    struct SharedMemorySegmentHeader
+    {
+        uint64_t magic;
+        uint64_t segmentId;
+        uint64_t payloadSize;
+    };
+
+    static const uint64_t SHARED_MEMORY_SEGMENT_MAGIC = 0x434c4149445348ULL; // "CLAIDSH"
+
+    static uint64_t makeSegmentId()
+    {
+        static std::atomic<uint64_t> nextSegmentId{1};
+        return nextSegmentId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+#ifdef __linux__
+    // Bionic only provides the memfd_create wrapper from API level 30 on, hence the system call is used directly.
+    // It fails with ENOSYS on kernels older than 3.17, which some older Android devices still run.
+    static int createMemoryFile()
+    {
+#ifdef SYS_memfd_create
+        return static_cast<int>(syscall(SYS_memfd_create, "claid_payload", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    bool SharedMemorySegment::isSupported()
+    {
+        static const bool supported = []()
+        {
+            int fd = createMemoryFile();
+            if(fd < 0)
+            {
+                return false;
+            }
+            close(fd);
+            return true;
+        }();
+        return supported;
+    }
+
+    SharedMemorySegment::SharedMemorySegment(int fd, uint64_t segmentId, size_t size) : 
+        fd(fd), segmentId(segmentId), payloadSize(size)
+    {
+    }
+
+    SharedMemorySegment::~SharedMemorySegment()
+    {
+        close(this->fd);
+    }
+
+    absl::Status SharedMemorySegment::create(const void* data, size_t size, std::shared_ptr<SharedMemorySegment>& segment)
+    {
+        int fd = createMemoryFile();
+        if(fd < 0)
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to create shared memory segment: ", strerror(errno)));
+        }
+
+        const size_t totalSize = sizeof(SharedMemorySegmentHeader) + size;
+        if(ftruncate(fd, totalSize) != 0)
+        {
+            close(fd);
+            return absl::ResourceExhaustedError(absl::StrCat("Failed to allocate shared memory segment of ", totalSize, " bytes: ", strerror(errno)));
+        }
+
+        void* address = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(address == MAP_FAILED)
+        {
+            close(fd);
+            return absl::UnavailableError(absl::StrCat("Failed to map shared memory segment: ", strerror(errno)));
+        }
+
+        SharedMemorySegmentHeader header;
+        header.magic = SHARED_MEMORY_SEGMENT_MAGIC;
+        header.segmentId = makeSegmentId();
+        header.payloadSize = size;
+        std::memcpy(address, &header, sizeof(header));
+        std::memcpy(static_cast<char*>(address) + sizeof(header), data, size);
+        munmap(address, totalSize);
+
+        // Writable mappings have to be gone before F_SEAL_WRITE can be applied.
+        if(fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+        {
+            close(fd);
+            return absl::UnavailableError(absl::StrCat("Failed to seal shared memory segment: ", strerror(errno)));
+        }
+
+        segment = std::shared_ptr<SharedMemorySegment>(new SharedMemorySegment(fd, header.segmentId, size));
+        return absl::OkStatus();
+    }
+
+    claidservice::SharedMemoryHandle SharedMemorySegment::getHandle() const
+    {
+        claidservice::SharedMemoryHandle handle;
+        handle.set_pid(getpid());
+        handle.set_fd(this->fd);
+        handle.set_segment_id(this->segmentId);
+        handle.set_size(this->payloadSize);
+        return handle;
+    }
+
+    size_t SharedMemorySegment::size() const
+    {
+        return this->payloadSize;
+    }
+
+    // Opens the file of the segment referred to by the handle and checks that it still is the same segment.
+    static absl::Status openSegmentFile(const claidservice::SharedMemoryHandle& handle, int& fd)
+    {
+        // Opening the segment via /proc works for the creating process as well as for other processes of the same user.
+        const std::string path = absl::StrCat("/proc/", handle.pid(), "/fd/", handle.fd());
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            return absl::NotFoundError(absl::StrCat("Failed to open shared memory segment ", handle.segment_id(), " at \"", path, "\": ", strerror(errno), 
+                ". The segment might have been released by its creator already."));
+        }
+
+        // If the file descriptor was reused for a smaller file, accessing a mapping beyond its end would raise SIGBUS.
+        const size_t totalSize = sizeof(SharedMemorySegmentHeader) + handle.size();
+        struct stat fileStatus;
+        if(fstat(fd, &fileStatus) != 0 || fileStatus.st_size < 0 || static_cast<size_t>(fileStatus.st_size) < totalSize)
+        {
+            close(fd);
+            return absl::NotFoundError(absl::StrCat("Shared memory segment ", handle.segment_id(), " does not exist anymore, ",
+                "the file at \"", path, "\" is smaller than the segment."));
+        }
+
+        // The file descriptor might have been reused for another segment (or file) after the creator released the segment.
+        SharedMemorySegmentHeader header;
+        if(pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || 
+            header.magic != SHARED_MEMORY_SEGMENT_MAGIC || header.segmentId != handle.segment_id() || header.payloadSize != handle.size())
+        {
+            close(fd);
+            return absl::NotFoundError(absl::StrCat("Shared memory segment ", handle.segment_id(), " does not exist anymore, it has been released by its creator."));
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status SharedMemorySegment::open(const claidservice::SharedMemoryHandle& handle, std::unique_ptr<SharedMemorySegment>& segment)
+    {
+        int fd;
+        absl::Status status = openSegmentFile(handle, fd);
+        if(!status.ok())
+        {
+            return status;
+        }
+        segment = std::unique_ptr<SharedMemorySegment>(new SharedMemorySegment(fd, handle.segment_id(), handle.size()));
+        return absl::OkStatus();
+    }
+
+    SharedMemoryMapping::SharedMemoryMapping(void* address, size_t mappedSize, size_t payloadSize) :
+        address(address), mappedSize(mappedSize), payloadSize(payloadSize)
+    {
+    }
+
+    SharedMemoryMapping::~SharedMemoryMapping()
+    {
+        munmap(this->address, this->mappedSize);
+    }
+
+    absl::Status SharedMemoryMapping::map(const claidservice::SharedMemoryHandle& handle, std::unique_ptr<SharedMemoryMapping>& mapping)
+    {
+        int fd;
+        absl::Status status = openSegmentFile(handle, fd);
+        if(!status.ok())
+        {
+            return status;
+        }
+
+        // The segment is sealed, its header cannot have changed since it was checked.
+        const size_t totalSize = sizeof(SharedMemorySegmentHeader) + handle.size();
+        void* address = mmap(nullptr, totalSize, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping keeps the segment alive, the file descriptor is not needed anymore.
+        close(fd);
+        if(address == MAP_FAILED)
+        {
+            return absl::UnavailableError(absl::StrCat("Failed to map shared memory segment ", handle.segment_id(), ": ", strerror(errno)));
+        }
+
+        mapping = std::unique_ptr<SharedMemoryMapping>(new SharedMemoryMapping(address, totalSize, handle.size()));
+        return absl::OkStatus();
+    }
+
+    const char* SharedMemoryMapping::data() const
+    {
+        return static_cast<const char*>(this->address) + sizeof(SharedMemorySegmentHeader);
+    }
+
+    size_t SharedMemoryMapping::size() const
+    {
+        return this->payloadSize;
+    }
+#else
+    bool SharedMemorySegment::isSupported()
+    {
+        return false;
+    }
+
+    SharedMemorySegment::SharedMemorySegment(int fd, uint64_t segmentId, size_t size) : 
+        fd(fd), segmentId(segmentId), payloadSize(size)
+    {
+    }
+
+    SharedMemorySegment::~SharedMemorySegment()
+    {
+    }
+
+    absl::Status SharedMemorySegment::create(const void* data, size_t size, std::shared_ptr<SharedMemorySegment>& segment)
+    {
+        return absl::UnimplementedError("Shared memory segments are only supported on Linux.");
+    }
+
+    absl::Status SharedMemorySegment::open(const claidservice::SharedMemoryHandle& handle, std::unique_ptr<SharedMemorySegment>& segment)
+    {
+        return absl::UnimplementedError("Shared memory segments are only supported on Linux.");
+    }
+
+    claidservice::SharedMemoryHandle SharedMemorySegment::getHandle() const
+    {
+        return claidservice::SharedMemoryHandle();
+    }
+
+    size_t SharedMemorySegment::size() const
+    {
+        return this->payloadSize;
+    }
+
+    SharedMemoryMapping::SharedMemoryMapping(void* address, size_t mappedSize, size_t payloadSize) :
+        address(address), mappedSize(mappedSize), payloadSize(payloadSize)
+    {
+    }
+
+    SharedMemoryMapping::~SharedMemoryMapping()
+    {
+    }
+
+    absl::Status SharedMemoryMapping::map(const claidservice::SharedMemoryHandle& handle, std::unique_ptr<SharedMemoryMapping>& mapping)
+    {
+        return absl::UnimplementedError("Shared memory segments are only supported on Linux.");
+    }
+
+    const char* SharedMemoryMapping::data() const
+    {
+        return nullptr;
+    }
+
+    size_t SharedMemoryMapping::size() const
+    {
+        return this->payloadSize;
+    }
+#endif
+}
@@ -0,0 +1,87 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "dispatch/proto/claidservice.pb.h"
+
+namespace claid
+{
+    // A sealed, read-only shared memory segment (memfd) holding the payload of a DataPackage.
+    // Segments are created and filled once; afterward, writing, growing and shrinking are prohibited by file seals,
+    // hence receivers can safely map them read-only. Other processes on the same host open the segment
+    // via /proc/<pid>/fd/<fd>. Only supported on Linux (and Android).
+    class SharedMemorySegment
+    {
+        public:
+            ~SharedMemorySegment();
+
+            SharedMemorySegment(const SharedMemorySegment&) = delete;
+            SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+            // Creates a new segment containing a copy of the given bytes.
+            static absl::Status create(const void* data, size_t size, std::shared_ptr<SharedMemorySegment>& segment);
+
+            // Opens a segment created by this or another process. The returned segment refers to its own file descriptor,
+            // hence its handle stays valid even if the creator releases the segment in the meantime.
+            static absl::Status open(const claidservice::SharedMemoryHandle& handle, std::unique_ptr<SharedMemorySegment>& segment);
+
+            static bool isSupported();
+
+            claidservice::SharedMemoryHandle getHandle() const;
+            size_t size() const;
+
+        private:
+            SharedMemorySegment(int fd, uint64_t segmentId, size_t size);
+
+            int fd;
+            uint64_t segmentId;
+            size_t payloadSize;
+    };
+
+    // Read-only mapping of a SharedMemorySegment, possibly created by another process.
+    // The mapping stays valid even if the creator releases the segment in the meantime.
+    class SharedMemoryMapping
+    {
+        public:
+            ~SharedMemoryMapping();
+
+            SharedMemoryMapping(const SharedMemoryMapping&) = delete;
+            SharedMemoryMapping& operator=(const SharedMemoryMapping&) = delete;
+
+            static absl::Status map(const claidservice::SharedMemoryHandle& handle, std::unique_ptr<SharedMemoryMapping>& mapping);
+
+            const char* data() const;
+            size_t size() const;
+
+        private:
+            SharedMemoryMapping(void* address, size_t mappedSize, size_t payloadSize);
+
+            void* address;
+            size_t mappedSize;
+            size_t payloadSize;
+    };
+}
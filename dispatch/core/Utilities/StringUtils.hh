@@ -61,5 +61,14 @@ namespace claid
             }
             return false;
         }
+
+        static bool endsWith(const std::string& a, const std::string& b)
+        {
+            if(a.size() >= b.size() && a.compare(a.size() - b.size(), b.size(), b) == 0)
+            {
+                return true;
+            }
+            return false;
+        }
     }
 }
\ No newline at end of file
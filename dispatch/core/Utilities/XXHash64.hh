@@ -0,0 +1,235 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace claid
+{
+    // Streaming implementation of the 64 bit xxHash algorithm (XXH64).
+    // Used to detect changed or corrupted files, not suitable for cryptographic purposes.
+    class XXHash64
+    {
+        private:
+            static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+            static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+            static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+            static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+            static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+            uint64_t state[4];
+            unsigned char buffer[32];
+            size_t bufferSize = 0;
+            uint64_t totalLength = 0;
+            uint64_t seed;
+
+            static uint64_t rotateLeft(uint64_t value, int bits)
+            {
+                return (value << bits) | (value >> (64 - bits));
+            }
+
+            static uint64_t read64(const unsigned char* data)
+            {
+                uint64_t value = 0;
+                for(int i = 7; i >= 0; i--)
+                {
+                    value = (value << 8) | data[i];
+                }
+                return value;
+            }
+
+            static uint32_t read32(const unsigned char* data)
+            {
+                return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+                    (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+            }
+
+            static uint64_t round(uint64_t accumulator, uint64_t input)
+            {
+                accumulator += input * PRIME_2;
+                accumulator = rotateLeft(accumulator, 31);
+                return accumulator * PRIME_1;
+            }
+
+            static uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+            {
+                accumulator ^= round(0, value);
+                return accumulator * PRIME_1 + PRIME_4;
+            }
+
+            void processStripe(const unsigned char* data)
+            {
+                state[0] = round(state[0], read64(data));
+                state[1] = round(state[1], read64(data + 8));
+                state[2] = round(state[2], read64(data + 16));
+                state[3] = round(state[3], read64(data + 24));
+            }
+
+        public:
+
+            XXHash64(uint64_t seed = 0) 
+            {
+                reset(seed);
+            }
+
+            void reset(uint64_t seed = 0)
+            {
+                this->seed = seed;
+                state[0] = seed + PRIME_1 + PRIME_2;
+                state[1] = seed + PRIME_2;
+                state[2] = seed;
+                state[3] = seed - PRIME_1;
+                bufferSize = 0;
+                totalLength = 0;
+            }
+
+            void update(const void* input, size_t length)
+            {
+                const unsigned char* data = static_cast<const unsigned char*>(input);
+                totalLength += length;
+
+                if(bufferSize + length < 32)
+                {
+                    if(length > 0)
+                    {
+                        memcpy(buffer + bufferSize, data, length);
+                    }
+                    bufferSize += length;
+                    return;
+                }
+
+                if(bufferSize > 0)
+                {
+                    size_t missing = 32 - bufferSize;
+                    memcpy(buffer + bufferSize, data, missing);
+                    processStripe(buffer);
+                    data += missing;
+                    length -= missing;
+                    bufferSize = 0;
+                }
+
+                while(length >= 32)
+                {
+                    processStripe(data);
+                    data += 32;
+                    length -= 32;
+                }
+
+                if(length > 0)
+                {
+                    memcpy(buffer, data, length);
+                    bufferSize = length;
+                }
+            }
+
+            uint64_t digest() const
+            {
+                uint64_t hash;
+                if(totalLength >= 32)
+                {
+                    hash = rotateLeft(state[0], 1) + rotateLeft(state[1], 7) + rotateLeft(state[2], 12) + rotateLeft(state[3], 18);
+                    hash = mergeRound(hash, state[0]);
+                    hash = mergeRound(hash, state[1]);
+                    hash = mergeRound(hash, state[2]);
+                    hash = mergeRound(hash, state[3]);
+                }
+                else
+                {
+                    hash = seed + PRIME_5;
+                }
+
+                hash += totalLength;
+
+                const unsigned char* data = buffer;
+                size_t remaining = bufferSize;
+                while(remaining >= 8)
+                {
+                    hash ^= round(0, read64(data));
+                    hash = rotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+                    data += 8;
+                    remaining -= 8;
+                }
+
+                if(remaining >= 4)
+                {
+                    hash ^= static_cast<uint64_t>(read32(data)) * PRIME_1;
+                    hash = rotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+                    data += 4;
+                    remaining -= 4;
+                }
+
+                while(remaining > 0)
+                {
+                    hash ^= (*data) * PRIME_5;
+                    hash = rotateLeft(hash, 11) * PRIME_1;
+                    data++;
+                    remaining--;
+                }
+
+                hash ^= hash >> 33;
+                hash *= PRIME_2;
+                hash ^= hash >> 29;
+                hash *= PRIME_3;
+                hash ^= hash >> 32;
+                return hash;
+            }
+
+            static uint64_t hash(const void* data, size_t length, uint64_t seed = 0)
+            {
+                XXHash64 hasher(seed);
+                hasher.update(data, length);
+                return hasher.digest();
+            }
+
+            // Hashes the file in blocks, so that memory usage does not depend on the size of the file.
+            static bool hashFile(const std::string& path, uint64_t& hash)
+            {
+                std::ifstream file(path, std::ios::in | std::ios::binary);
+                if(!file.is_open())
+                {
+                    return false;
+                }
+
+                XXHash64 hasher;
+                char block[64 * 1024];
+                while(file)
+                {
+                    file.read(block, sizeof(block));
+                    std::streamsize numBytes = file.gcount();
+                    if(numBytes > 0)
+                    {
+                        hasher.update(block, static_cast<size_t>(numBytes));
+                    }
+                }
+
+                if(file.bad())
+                {
+                    return false;
+                }
+                hash = hasher.digest();
+                return true;
+            }
+    };
+}
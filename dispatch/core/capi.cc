@@ -260,6 +260,86 @@ void disable_designer_mode(void* handle)
     middleWare->disableDesignerMode();
 }
 
+// Default size of each ring buffer of an in-process transport.
+static const size_t DEFAULT_IN_PROCESS_RING_CAPACITY = 4 * 1024 * 1024;
+
+static_assert(CLAID_TRANSPORT_TIMEOUT == claid::RingChannel::TIMEOUT, "Return codes of capi.h and RingChannel have to match.");
+static_assert(CLAID_TRANSPORT_CLOSED == claid::RingChannel::CLOSED, "Return codes of capi.h and RingChannel have to match.");
+
+__attribute__((visibility("default"))) __attribute__((used))
+void* attach_in_process_runtime(void* handle, int runtime, size_t ring_capacity)
+{
+    if(!handle)
+    {
+        claid::Logger::logError("Cannot attach in-process runtime, handle is null.");
+        return nullptr;
+    }
+    if(!claidservice::Runtime_IsValid(runtime))
+    {
+        claid::Logger::logError("Cannot attach in-process runtime, invalid runtime %d.", runtime);
+        return nullptr;
+    }
+
+    auto middleWare = reinterpret_cast<claid::MiddleWare*>(handle);
+    std::shared_ptr<claid::InProcessTransport> transport = middleWare->attachInProcessRuntime(
+        static_cast<claidservice::Runtime>(runtime), ring_capacity == 0 ? DEFAULT_IN_PROCESS_RING_CAPACITY : ring_capacity);
+    if(transport == nullptr)
+    {
+        return nullptr;
+    }
+    // Keeps the transport alive until detach_in_process_runtime, even if the Middleware released it before.
+    return new std::shared_ptr<claid::InProcessTransport>(transport);
+}
+
+__attribute__((visibility("default"))) __attribute__((used))
+void detach_in_process_runtime(void* handle, void* transport)
+{
+    if(!transport)
+    {
+        return;
+    }
+    auto transportPtr = reinterpret_cast<std::shared_ptr<claid::InProcessTransport>*>(transport);
+    if(handle)
+    {
+        auto middleWare = reinterpret_cast<claid::MiddleWare*>(handle);
+        middleWare->detachInProcessRuntime((*transportPtr)->getRuntime());
+    }
+    delete transportPtr;
+}
+
+__attribute__((visibility("default"))) __attribute__((used))
+long long in_process_runtime_send(void* transport, const void* data, size_t size, int timeout_ms)
+{
+    if(!transport)
+    {
+        return CLAID_TRANSPORT_CLOSED;
+    }
+    auto& transportPtr = *reinterpret_cast<std::shared_ptr<claid::InProcessTransport>*>(transport);
+    return transportPtr->fromRuntime().push(data, size, timeout_ms);
+}
+
+__attribute__((visibility("default"))) __attribute__((used))
+long long in_process_runtime_wait(void* transport, int timeout_ms)
+{
+    if(!transport)
+    {
+        return CLAID_TRANSPORT_CLOSED;
+    }
+    auto& transportPtr = *reinterpret_cast<std::shared_ptr<claid::InProcessTransport>*>(transport);
+    return transportPtr->toRuntime().waitForMessage(timeout_ms);
+}
+
+__attribute__((visibility("default"))) __attribute__((used))
+long long in_process_runtime_receive(void* transport, void* buffer, size_t buffer_size)
+{
+    if(!transport)
+    {
+        return CLAID_TRANSPORT_CLOSED;
+    }
+    auto& transportPtr = *reinterpret_cast<std::shared_ptr<claid::InProcessTransport>*>(transport);
+    return transportPtr->toRuntime().tryPop(buffer, buffer_size);
+}
+
 int get_log_sink_severity_level(void* handle)
 {
     if(!handle)
@@ -22,6 +22,7 @@
 #ifndef CAPI_H_
 #define CAPI_H_
 #include <stdbool.h>  // for 'bool'
+#include <stddef.h>   // for 'size_t'
 
 #ifdef __cplusplus
 extern "C"
@@ -52,6 +53,35 @@ extern "C"
     void enable_designer_mode(void* handle);
     void disable_designer_mode(void* handle);
 
+    // In-process transport for Runtimes which load the CLAID library into the same process as the Middleware
+    // (the Python Runtime via ctypes, see module_dispatcher.py, and the Java Runtime via JNI, see InProcessTransport.java).
+    // DataPackages are exchanged as serialized bytes through a pair of lock-free ring buffers instead of the gRPC package stream (SendReceivePackages).
+    // GetModuleList and InitRuntime are still called via gRPC; afterward, the Runtime calls attach_in_process_runtime
+    // instead of opening the package stream. If it returns NULL, the Runtime falls back to gRPC.
+    //
+    // Each direction is a single-producer/single-consumer ring and the functions below do not synchronize callers:
+    // in_process_runtime_send must only be called by one thread at a time, and in_process_runtime_wait and 
+    // in_process_runtime_receive only by one (other) thread at a time (e.g., a dedicated writer and reader thread).
+    // Packages larger than the ring are passed outside of it, in order with all other packages.
+    #define CLAID_TRANSPORT_TIMEOUT -1
+    #define CLAID_TRANSPORT_CLOSED -2
+
+    // runtime is the value of claidservice.Runtime. ring_capacity is in bytes per direction, 0 selects the default.
+    void* attach_in_process_runtime(void* handle, int runtime, size_t ring_capacity);
+    void detach_in_process_runtime(void* handle, void* transport);
+
+    // Sends a serialized DataPackage to the Middleware. Blocks while the ring is full (negative timeout waits indefinitely).
+    // Returns the number of bytes sent or one of the CLAID_TRANSPORT_* codes.
+    long long in_process_runtime_send(void* transport, const void* data, size_t size, int timeout_ms);
+
+    // Waits for the next serialized DataPackage from the Middleware and returns its size (without removing it),
+    // or CLAID_TRANSPORT_TIMEOUT / CLAID_TRANSPORT_CLOSED.
+    long long in_process_runtime_wait(void* transport, int timeout_ms);
+
+    // Copies the next DataPackage into buffer and removes it. Does not block.
+    // Returns its size, or CLAID_TRANSPORT_TIMEOUT if no package is available or the buffer is too small.
+    long long in_process_runtime_receive(void* transport, void* buffer, size_t buffer_size);
+
 #ifdef __cplusplus
 }
 #endif
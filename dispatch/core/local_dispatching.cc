@@ -22,6 +22,7 @@
 #include "dispatch/core/local_dispatching.hh"
 #include "dispatch/core/Logger/Logger.hh"
 #include "dispatch/core/proto_util.hh"
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
 
 #include <grpcpp/server_builder.h>
 #include <grpcpp/create_channel.h>
@@ -51,8 +52,9 @@ static bool validCtrlRuntimePingPkt(const DataPackage& pkt) {
 
 RuntimeDispatcher::RuntimeDispatcher(SharedQueue<DataPackage>& inQueue,
                                      SharedQueue<DataPackage>& outQueue,
-                                     const ModuleTable& modTable) :
-        incomingQueue(inQueue), outgoingQueue(outQueue), moduleTable(modTable)
+                                     const ModuleTable& modTable,
+                                     Runtime runtime) :
+        incomingQueue(inQueue), outgoingQueue(outQueue), moduleTable(modTable), runtime(runtime)
 {
     Logger::logInfo("constr incoming queue ptr: %lu", &incomingQueue);
     Logger::logInfo("const outgoing queue ptr: %lu", &outgoingQueue);
@@ -80,6 +82,19 @@ Status RuntimeDispatcher::startWriterThread(ServerReaderWriter<DataPackage, Data
     return Status::OK;
 }
 
+Status RuntimeDispatcher::startWriterThread(shared_ptr<InProcessTransport> transport) {
+    lock_guard<mutex> lock(wtMutex);
+    if (writeThread) {
+        return Status(grpc::INVALID_ARGUMENT, "Thread already running.");
+    }
+    this->running = true;
+    this->inProcessTransport = transport;
+    writeThread = make_unique<thread>([this, transport]() {
+        processWriting(*transport);
+    });
+    return Status::OK;
+}
+
 void RuntimeDispatcher::shutdownWriterThread() {
     {  // only lock for checking the writer thread.
         lock_guard<mutex> lock(wtMutex);
@@ -90,6 +105,10 @@ void RuntimeDispatcher::shutdownWriterThread() {
     this->running = false;
     // Cause the writer thread to terminate and wait for it.
     outgoingQueue.interruptOnce();
+    if (inProcessTransport) {
+        // Unblocks a writer waiting for space in the ring.
+        inProcessTransport->close();
+    }
     Logger::logInfo("Waiting for writer thread to be done.");
     writeThread->join();
     writeThread = nullptr;
@@ -115,6 +134,9 @@ void RuntimeDispatcher::processWriting(ServerReaderWriter<DataPackage, DataPacka
             }
         }
         Logger::logInfo("RuntimeDispatcher writing package");
+        if (!prepareForWriting(pkt)) {
+            continue;
+        }
 
         if (!stream->Write(*pkt)) {
             outgoingQueue.push_front(pkt);
@@ -125,6 +147,73 @@ void RuntimeDispatcher::processWriting(ServerReaderWriter<DataPackage, DataPacka
     }
 }
 
+void RuntimeDispatcher::processWriting(InProcessTransport& transport) {
+    while(this->running) {
+        auto pkt = outgoingQueue.interruptable_pop_front();
+        if (!pkt) {
+            if(outgoingQueue.is_closed())
+            {
+                break;
+            }
+            continue;
+        }
+        if (!prepareForWriting(pkt)) {
+            continue;
+        }
+
+        if (!transport.sendToRuntime(*pkt)) {
+            outgoingQueue.push_front(pkt);
+            break;
+        }
+    }
+}
+
+void RuntimeDispatcher::setRoutingIdsOfRuntime(const RoutingIds& routingIds) {
+    routingIdsOfRuntime = make_unique<RoutingIdTable>();
+    routingIdsOfRuntime->fromProto(routingIds);
+}
+
+// Only the C++ runtime is able to map payloads offloaded to shared memory by the LargePayloadStore.
+// Other runtimes receive them inline.
+bool RuntimeDispatcher::prepareForWriting(shared_ptr<DataPackage>& pkt) {
+    if (!pkt->has_control_val()) {
+        if (routingIdsOfRuntime) {
+            // The package might be shared with other queues.
+            if (pkt.use_count() > 1) {
+                pkt = make_shared<DataPackage>(*pkt);
+            }
+            routingIdsOfRuntime->compact(*pkt);
+        } else {
+            // Package might have been compacted for a previous connection of the Runtime.
+            moduleTable.getRoutingIds().restoreNames(*pkt);
+        }
+    }
+
+    if (runtime == Runtime::RUNTIME_CPP) {
+        return true;
+    }
+    absl::Status status = LargePayloadStore::inlineSharedMemoryCopy(pkt);
+    if (!status.ok()) {
+        Logger::logError("Dropping package for channel \"%s\" to Runtime %s: %s", pkt->channel().c_str(),
+            Runtime_Name(runtime).c_str(), std::string(status.message()).c_str());
+        return false;
+    }
+    return true;
+}
+
+Status RuntimeDispatcher::processReading(InProcessTransport& transport) {
+    DataPackage inPkt;
+    Status status;
+    while(transport.receiveFromRuntime(inPkt)) {
+        processPacket(inPkt, status);
+        if (!status.ok()) {
+            Logger::logWarning("Local RuntimeDispatcher::processReading got invalid status, stopping reading: %s", status.error_message().c_str());
+            return status;
+        }
+    }
+    return Status::OK;
+}
+
 Status RuntimeDispatcher::processReading(ServerReaderWriter<DataPackage, DataPackage>* stream) {
     DataPackage inPkt;
     Status status;
@@ -150,8 +239,17 @@ void RuntimeDispatcher::processPacket(DataPackage& pkt, Status& status) {
         Logger::logInfo("RunTimeDispatcher processPacket 2");
         ChannelInfo chanInfo;
 
+        // Runtimes which requested routing IDs in the handshake only send the IDs of names they know.
+        if (!moduleTable.getRoutingIds().restoreNames(pkt)) {
+            status = Status(grpc::INVALID_ARGUMENT, absl::StrCat("Received package with unknown routing IDs (channel ", pkt.channel_id(),
+                            ", source Module ", pkt.source_module_id(), ", target Module ", pkt.target_module_id(), ")."));
+            Logger::logError("%s", status.error_message().c_str());
+            return;
+        }
+
         std::string connectionName;
-        if(!moduleTable.lookupOutputConnectionForChannelOfModule(pkt.source_module(), pkt.channel(), connectionName))
+        uint32_t connectionId;
+        if(!moduleTable.lookupOutputConnectionForChannelOfModule(pkt, connectionName, connectionId))
         {
             status = Status(grpc::NOT_FOUND, absl::StrCat("Could not find channel of Module \"", pkt.source_module(), "\" which connects to connection \"", 
                             pkt.channel(), "\"."));
@@ -160,6 +258,7 @@ void RuntimeDispatcher::processPacket(DataPackage& pkt, Status& status) {
         }
 
         pkt.set_channel(connectionName);
+        pkt.set_channel_id(connectionId);
     
 
         auto chanEntry = moduleTable.isValidChannel(pkt);
@@ -173,6 +272,14 @@ void RuntimeDispatcher::processPacket(DataPackage& pkt, Status& status) {
         }    
         Logger::logInfo("RunTimeDispatcher processPacket 4");
 
+        // Held until all copies forwarded below are released, regardless of how long they are queued.
+        std::shared_ptr<SharedMemorySegment> payloadSegment;
+        absl::Status payloadStatus = LargePayloadStore::getInstance()->takeDelivery(pkt, payloadSegment);
+        if (!payloadStatus.ok()) {
+            Logger::logError("Dropping package for channel \"%s\" of Module \"%s\": %s", pkt.channel().c_str(),
+                pkt.source_module().c_str(), std::string(payloadStatus.message()).c_str());
+            return;
+        }
 
         moduleTable.forwardPackageToAllSubscribers(pkt, chanEntry, incomingQueue);
         moduleTable.forwardPackageOfModuleToAllLooseDirectSubscribers(pkt, incomingQueue);
@@ -285,9 +392,12 @@ Status ServiceImpl::InitRuntime(ServerContext* context, const InitRuntimeRequest
             return Status(grpc::INVALID_ARGUMENT, absl::StrCat("Module \"", moduleId, "\" was registered at Runtime ", Runtime_Name(classRt),
             "but now was requested to be loaded by Runtime ", Runtime_Name(rt), ". Runtime of Module does not equal the Runtime it was originally registered at."));
         }
-        moduleTable.moduleRuntimeMap[moduleId] = classRt;
-        if (!moduleTable.runtimeQueueMap[classRt]) {
-            moduleTable.runtimeQueueMap[classRt] = make_shared<SharedQueue<DataPackage>>();
+        {
+            unique_lock<shared_mutex> lock(moduleTable.runtimeMapsMutex);
+            moduleTable.setModuleRuntime(moduleId, classRt);
+            if (!moduleTable.runtimeQueueMap[classRt]) {
+                moduleTable.runtimeQueueMap[classRt] = make_shared<SharedQueue<DataPackage>>();
+            }
         }
         Logger::logInfo("InitRuntime num channel pakets for module %s: %d", moduleId.c_str(), modChanIt.channel_packets().size());
 
@@ -354,6 +464,13 @@ Status ServiceImpl::SendReceivePackages(ServerContext* context,
 
     // Confirm that we are getting ready to write.
     DataPackage outPkt(inPkt);
+    if (inPkt.control_val().has_routing_ids()) {
+        RoutingIds* routingIds = outPkt.mutable_control_val()->mutable_routing_ids();
+        moduleTable.getRoutingIds().toProto(*routingIds);
+        rtDispatcher->setRoutingIdsOfRuntime(*routingIds);
+        claid::Logger::logInfo("Runtime %s requested routing IDs, sending %d channels, %d Modules and %d hosts.",
+            Runtime_Name(rtDispatcher->runtime).c_str(), routingIds->channels_size(), routingIds->modules_size(), routingIds->hosts_size());
+    }
     claid::Logger::logInfo("Sent registration package");
     stream->Write(outPkt);
 
@@ -372,10 +489,68 @@ Status ServiceImpl::SendReceivePackages(ServerContext* context,
     return status;
 }
 
+Status ServiceImpl::connectInProcessRuntime(shared_ptr<InProcessTransport> transport) {
+    Status status;
+    const Runtime rt = transport->getRuntime();
+
+    DataPackage pingPkt;
+    pingPkt.mutable_control_val()->set_ctrl_type(CTRL_RUNTIME_PING);
+    pingPkt.mutable_control_val()->set_runtime(rt);
+
+    lock_guard<mutex> ipLock(ipMutex);
+    RuntimeDispatcher* rtDispatcher = addRuntimeDispatcher(pingPkt, status);
+    if (!status.ok()) {
+        return status;
+    }
+    if (rtDispatcher->alreadyRunning() || inProcessRuntimes.find(rt) != inProcessRuntimes.end()) {
+        return Status(grpc::ALREADY_EXISTS, absl::StrCat("Runtime ", Runtime_Name(rt), " is already connected."));
+    }
+
+    rtDispatcher->startWriterThread(transport);
+
+    // Counterpart of SendReceivePackages, which runs on a gRPC thread.
+    auto readerThread = make_unique<thread>([this, rtDispatcher, transport, rt]() {
+        rtDispatcher->processReading(*transport);
+        rtDispatcher->shutdownWriterThread();
+        removeRuntimeDispatcher(rt);
+    });
+    inProcessRuntimes[rt] = make_pair(transport, std::move(readerThread));
+    Logger::logInfo("Connected Runtime %s via in-process transport.", Runtime_Name(rt).c_str());
+    return Status::OK;
+}
+
+void ServiceImpl::disconnectInProcessRuntime(Runtime rt) {
+    std::pair<std::shared_ptr<InProcessTransport>, std::unique_ptr<std::thread>> entry;
+    {
+        lock_guard<mutex> lock(ipMutex);
+        auto it = inProcessRuntimes.find(rt);
+        if (it == inProcessRuntimes.end()) {
+            return;
+        }
+        entry = std::move(it->second);
+        inProcessRuntimes.erase(it);
+    }
+    entry.first->close();
+    entry.second->join();
+}
+
 void ServiceImpl::shutdown() {
-    lock_guard<mutex> lock(adMutex);
-    for(auto& it : activeDispatchers) {
-        it.second->shutdownWriterThread();
+    {
+        lock_guard<mutex> lock(adMutex);
+        for(auto& it : activeDispatchers) {
+            it.second->shutdownWriterThread();
+        }
+    }
+
+    std::vector<Runtime> inProcessRts;
+    {
+        lock_guard<mutex> lock(ipMutex);
+        for(auto& it : inProcessRuntimes) {
+            inProcessRts.push_back(it.first);
+        }
+    }
+    for(Runtime rt : inProcessRts) {
+        disconnectInProcessRuntime(rt);
     }
 }
 
@@ -421,7 +596,7 @@ RuntimeDispatcher* ServiceImpl::addRuntimeDispatcher(DataPackage& pkt, Status& s
     }
 
     Logger::logInfo("Rtq ptr: %lu", rtq.get());
-    auto ret = new RuntimeDispatcher(moduleTable.inputQueue(), *rtq.get(), moduleTable);
+    auto ret = new RuntimeDispatcher(moduleTable.inputQueue(), *rtq.get(), moduleTable, runTime);
     activeDispatchers[runTime] = unique_ptr<RuntimeDispatcher>(ret);
     return ret;
 }
@@ -461,6 +636,14 @@ bool DispatcherServer::start() {
     return bool(server);
 }
 
+Status DispatcherServer::connectInProcessRuntime(shared_ptr<InProcessTransport> transport) {
+    return serviceImpl.connectInProcessRuntime(transport);
+}
+
+void DispatcherServer::disconnectInProcessRuntime(Runtime rt) {
+    serviceImpl.disconnectInProcessRuntime(rt);
+}
+
 void DispatcherServer::shutdown() {
     if (!server) {
         return;
@@ -571,16 +754,25 @@ unique_ptr<ModuleListResponse> DispatcherClient::getModuleList() {
 void makeControlRuntimePing(ControlPackage& pkt) {
     pkt.set_ctrl_type(CtrlType::CTRL_RUNTIME_PING);
     pkt.set_runtime(Runtime::RUNTIME_CPP);
+    // Requests the interned routing IDs of the Middleware.
+    pkt.mutable_routing_ids();
+}
+
+Status DispatcherClient::initRuntime(const InitRuntimeRequest& req) {
+    ClientContext context;
+    Empty empty;
+    Status status = stub->InitRuntime(&context,req, &empty);
+    if (!status.ok()) {
+        claid::Logger::logInfo("Could not init request: %s", status.error_message().c_str());
+    }
+    return status;
 }
 
 Status DispatcherClient::startRuntime(const InitRuntimeRequest& req) {
     // Initialize the runtime
     {
-        ClientContext context;
-        Empty empty;
-        Status status = stub->InitRuntime(&context,req, &empty);
+        Status status = initRuntime(req);
         if (!status.ok()) {
-            claid::Logger::logInfo("Could not init request: %s", status.error_message().c_str());
             return status;
         }
     }
@@ -610,6 +802,14 @@ Status DispatcherClient::startRuntime(const InitRuntimeRequest& req) {
     if (pingReq.control_val().ctrl_type() != CtrlType::CTRL_RUNTIME_PING) {
         return Status(grpc::INVALID_ARGUMENT, "Response to ping package was no CTRL_RUNTIME_PING.");
     }
+
+    // Middlewares without support for routing IDs echo the ping without them.
+    routingIdsReceived = pingResp.control_val().has_routing_ids();
+    if (routingIdsReceived) {
+        routingIds.fromProto(pingResp.control_val().routing_ids());
+    } else {
+        routingIds.clear();
+    }
     this->running = true;
 
     // Start the threads to service the input/output queues.
@@ -621,7 +821,19 @@ Status DispatcherClient::startRuntime(const InitRuntimeRequest& req) {
 void DispatcherClient::processReading() {
     DataPackage dp;
     while(stream->Read(&dp)) {
-        incomingQueue.push_back(make_shared<DataPackage>(dp));
+        if (routingIdsReceived && !dp.has_control_val() && !routingIds.restoreNames(dp)) {
+            claid::Logger::logWarning("Client: Received package on channel %u with unknown routing IDs.", dp.channel_id());
+        }
+        auto pkt = make_shared<DataPackage>(dp);
+
+        // Held by the package until it was passed to all Subscribers, regardless of how long it is queued.
+        absl::Status payloadStatus = LargePayloadStore::getInstance()->takeDelivery(pkt);
+        if (!payloadStatus.ok()) {
+            claid::Logger::logError("Client: Dropping package for channel \"%s\": %s", pkt->channel().c_str(), 
+                std::string(payloadStatus.message()).c_str());
+            continue;
+        }
+        incomingQueue.push_back(pkt);
     }
 }
 
@@ -635,6 +847,19 @@ void DispatcherClient::processWriting() {
                 break;
             }
         } else {
+            LargePayloadStore* largePayloadStore = LargePayloadStore::getInstance();
+            const bool compactRoutingIds = routingIdsReceived && !pkt->has_control_val();
+
+            // Both steps below modify the package, which might still be referenced by the Module which posted it.
+            if ((compactRoutingIds || largePayloadStore->isLarge(*pkt)) && pkt.use_count() > 1) {
+                pkt = make_shared<DataPackage>(*pkt);
+            }
+
+            // Large payloads are passed to the Middleware (and other local runtimes) via shared memory.
+            largePayloadStore->offloadIfLarge(*pkt);
+            if (compactRoutingIds) {
+                routingIds.compact(*pkt);
+            }
             if (!stream->Write(*pkt)) {
                 claid::Logger::logInfo("Client: Error writing packet");
                 break;
@@ -34,6 +34,8 @@
 #include "dispatch/core/shared_queue.hh"
 #include "dispatch/core/module_table.hh"
 #include "dispatch/core/DeviceScheduler/GlobalDeviceScheduler.hh"
+#include "dispatch/core/InProcessDispatching/InProcessTransport.hh"
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
 using claidservice::ModuleAnnotation;
 
 namespace claid {
@@ -42,20 +44,34 @@ class RuntimeDispatcher {
   public:
     explicit RuntimeDispatcher(SharedQueue<claidservice::DataPackage>& inQueue,
                                SharedQueue<claidservice::DataPackage>& outQueue,
-                               const ModuleTable& moduleMap);
+                               const ModuleTable& moduleMap,
+                               claidservice::Runtime runtime);
     void shutdownWriterThread();
     bool alreadyRunning();
     grpc::Status startWriterThread(grpc::ServerReaderWriter<claidservice::DataPackage, claidservice::DataPackage>* stream);
     grpc::Status processReading(grpc::ServerReaderWriter<claidservice::DataPackage, claidservice::DataPackage>* stream);
+
+    // Same as above, but for a Runtime running in the same process, which is connected via an InProcessTransport.
+    grpc::Status startWriterThread(std::shared_ptr<InProcessTransport> transport);
+    grpc::Status processReading(InProcessTransport& transport);
   private:
     void processWriting(grpc::ServerReaderWriter<claidservice::DataPackage, claidservice::DataPackage>* stream);
+    void processWriting(InProcessTransport& transport);
     void processPacket(claidservice::DataPackage& pkt, grpc::Status& status);
+    bool prepareForWriting(std::shared_ptr<claidservice::DataPackage>& pkt);
+    void setRoutingIdsOfRuntime(const claidservice::RoutingIds& routingIds);
   private:
     SharedQueue<claidservice::DataPackage>& incomingQueue;
     SharedQueue<claidservice::DataPackage>& outgoingQueue;
     const claid::ModuleTable& moduleTable;
+    const claidservice::Runtime runtime;
     std::mutex wtMutex; // protects the write thread
     std::unique_ptr<std::thread> writeThread;
+    std::shared_ptr<InProcessTransport> inProcessTransport;
+
+    // The routing IDs sent to the Runtime in the handshake, if it requested them.
+    // Only names contained in this snapshot are replaced by their IDs.
+    std::unique_ptr<RoutingIdTable> routingIdsOfRuntime;
 
     bool running;
 
@@ -82,6 +98,11 @@ class ServiceImpl final : public claidservice::ClaidService::Service {
     grpc::Status SendReceivePackages(grpc::ServerContext* context,
         grpc::ServerReaderWriter<claidservice::DataPackage, claidservice::DataPackage>* stream) override;
 
+    // Connects a Runtime running in the same process as the Middleware. Packages are exchanged via the
+    // InProcessTransport instead of a SendReceivePackages stream; GetModuleList and InitRuntime are unchanged.
+    grpc::Status connectInProcessRuntime(std::shared_ptr<InProcessTransport> transport);
+    void disconnectInProcessRuntime(claidservice::Runtime rt);
+
     void shutdown();
 
   // private methods
@@ -96,6 +117,9 @@ class ServiceImpl final : public claidservice::ClaidService::Service {
     std::shared_ptr<GlobalDeviceScheduler> globalDeviceScheduler;
     std::mutex adMutex;    // protects activeDispatchers
     std::map<claidservice::Runtime, std::unique_ptr<RuntimeDispatcher>> activeDispatchers;
+
+    std::mutex ipMutex;    // protects inProcessRuntimes
+    std::map<claidservice::Runtime, std::pair<std::shared_ptr<InProcessTransport>, std::unique_ptr<std::thread>>> inProcessRuntimes;
 };     // class ServiceImpl
 
 class DispatcherServer {
@@ -105,6 +129,9 @@ class DispatcherServer {
     bool start();
     void shutdown();
 
+    grpc::Status connectInProcessRuntime(std::shared_ptr<InProcessTransport> transport);
+    void disconnectInProcessRuntime(claidservice::Runtime rt);
+
   private:
     void buildAndStartServer();
 
@@ -131,6 +158,15 @@ class DispatcherClient {
     virtual ~DispatcherClient() { shutdown(); };
     std::unique_ptr<claidservice::ModuleListResponse> getModuleList();
     grpc::Status startRuntime(const claidservice::InitRuntimeRequest& req);
+
+    // Registers additional Modules of an already running runtime (e.g., after a partial config reload),
+    // without starting a new package stream.
+    grpc::Status initRuntime(const claidservice::InitRuntimeRequest& req);
+
+    // Routing IDs received from the Middleware in the handshake of startRuntime.
+    // Not available if the Middleware does not support interned routing IDs.
+    bool hasRoutingIds() const { return routingIdsReceived; }
+    const RoutingIdTable& getRoutingIds() const { return routingIds; }
   private:
     void processReading();
     void processWriting();
@@ -147,6 +183,9 @@ class DispatcherClient {
     std::unique_ptr<std::thread> readThread;
     std::unique_ptr<std::thread> writeThread;
 
+    RoutingIdTable routingIds;
+    bool routingIdsReceived = false;
+
     bool running = false;
 };
 
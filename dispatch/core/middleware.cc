@@ -21,6 +21,7 @@
 
 #include "dispatch/core/middleware.hh"
 #include "dispatch/core/Configuration/Configuration.hh"
+#include "dispatch/core/Configuration/ConfigDiff.hh"
 #include "dispatch/core/CLAID.hh"
 #include "dispatch/core/Logger/Logger.hh"
 #include "dispatch/core/Router/RoutingTreeParser.hh"
@@ -28,6 +29,7 @@
 #include "dispatch/core/Utilities/FileUtils.hh"
 #include "absl/strings/str_split.h"
 #include <stdexcept>
+#include <chrono>
 
 using namespace claid;
 using namespace std;
@@ -236,8 +238,20 @@ absl::Status MiddleWare::startRemoteDispatcherServer(const std::string& currentH
         ));
     }
 
+    const claidservice::ClientQueueLimits& clientQueueLimits = hostDescription.getClientQueueLimits();
+    if(clientQueueLimits.overflow_policy() == claidservice::ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK &&
+        clientQueueLimits.spill_path().empty())
+    {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Cannot start RemoteDispatcherServer on host \"", currentHost, "\".\n",
+            "The client queue overflow policy is CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK, but no spill_path was specified."
+        ));
+    }
+    this->hostUserTable.setClientQueueLimits(clientQueueLimits);
+
     Logger::logInfo("Starting RemoteDispatcherServer, listening on address %s", address.c_str());
-    this->remoteDispatcherServer = make_unique<RemoteDispatcherServer>(address, this->hostUserTable);
+    this->remoteDispatcherServer = make_unique<RemoteDispatcherServer>(address, this->hostUserTable, 
+        hostDescription.getServerThreadingModel(), hostDescription.getNumAsyncServerThreads());
 
     if(hostDescription.hasTLSServerSettings())
     {
@@ -312,6 +326,8 @@ absl::Status MiddleWare::startRemoteDispatcherClient(const std::string& currentH
 
     Logger::logInfo("Starting RemoteDispatcherClient, connecting to address %s", address.c_str());
     this->remoteDispatcherClient = std::make_unique<RemoteDispatcherClient>(address, currentHost, currentUser, currentDeviceId, this->clientTable);
+    this->remoteDispatcherClient->setReconnectBackoff(
+        hostDescription.getInitialReconnectBackoff(), hostDescription.getMaxReconnectBackoff());
     absl::Status status;
     
     
@@ -372,6 +388,23 @@ absl::Status MiddleWare::startRouter(const std::string& currentHost, const HostD
 
     this->masterRouter = std::make_unique<MasterRouter>(currentHost, userId, deviceId, hostDescriptions, moduleDescriptions, this->masterInputQueue, localRouter, clientRouter, serverRouter);
 
+    // Hosts are interned alongside the channels and Modules of the ModuleTable, which are sent to the Runtimes when they connect.
+    status = masterRouter->setRoutingIdTable(this->moduleTable.getSharedRoutingIds());
+    if(!status.ok())
+    {
+        return status;
+    }
+
+    auto hostIt = hostDescriptions.find(currentHost);
+    if(hostIt != hostDescriptions.end())
+    {
+        status = masterRouter->setNumShards(hostIt->second.getNumRouterShards());
+        if(!status.ok())
+        {
+            return status;
+        }
+    }
+
     status = masterRouter->start();
     if(!status.ok())
     {
@@ -608,26 +641,19 @@ void MiddleWare::handleControlPackage(std::shared_ptr<DataPackage> controlPackag
         case CtrlType::CTRL_UNLOAD_MODULES_DONE:
         {
             Logger::logInfo("Received CTRL_UNLOAD_MODULES_DONE from Runtime %s", Runtime_Name(controlPackage->control_val().runtime()).c_str());
+            std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
             this->numberOfRuntimesThatUnloadedModules++;
-
-            Logger::logInfo("1");
-            if(this->numberOfRuntimesThatUnloadedModules == this->moduleTable.getNumberOfRunningRuntimes())
-            {
-                Logger::logInfo("2");
-                this->waitingForAllRuntimesToUnloadModules = false;
-                Logger::logInfo("3");
-            }
+            this->runtimeAcknowledgementsCondition.notify_all();
             break;
         }
         case CtrlType::CTRL_RESTART_RUNTIME_DONE:
+        case CtrlType::CTRL_LOAD_MODULES_DONE:
         {
-            Logger::logInfo("Received CTRL_RESTART_RUNTIME_DONE from Runtime %s", Runtime_Name(controlPackage->control_val().runtime()).c_str());
+            Logger::logInfo("Received %s from Runtime %s", CtrlType_Name(controlPackage->control_val().ctrl_type()).c_str(), 
+                Runtime_Name(controlPackage->control_val().runtime()).c_str());
+            std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
             this->numberOfRuntimesThatRestarted++;
-
-            if(this->numberOfRuntimesThatRestarted == this->moduleTable.getNumberOfRunningRuntimes())
-            {
-                this->waitingForAllRuntimesToRestart = false;
-            }  
+            this->runtimeAcknowledgementsCondition.notify_all();
             break;
         }
         case CtrlType::CTRL_REQUEST_MODULE_ANNOTATIONS:
@@ -760,6 +786,19 @@ void MiddleWare::handleControlPackage(std::shared_ptr<DataPackage> controlPackag
                     handleRPCModuleNotFoundError(controlPackage);
                     return;
                 }
+
+                // Only the C++ runtime executes batched calls. For Modules of other Runtimes, 
+                // the batch is forwarded as individual calls, each of which is answered separately.
+                Runtime targetRuntime;
+                if(rpcRequest.batched_calls_size() > 0 && this->moduleTable.lookupModuleRuntime(targetModule, targetRuntime) &&
+                    targetRuntime != Runtime::RUNTIME_CPP)
+                {
+                    for(std::shared_ptr<DataPackage>& request : RemoteFunctionHandler::splitBatchedRequest(*controlPackage))
+                    {
+                        queue->push_back(request);
+                    }
+                    return;
+                }
                 queue->push_back(controlPackage);
 
             }
@@ -890,37 +929,88 @@ void MiddleWare::forwardControlPackageToSpecificRuntime(std::shared_ptr<DataPack
 
 
 
-absl::Status MiddleWare::unloadAllModulesInAllLocalRuntimes()
+// The C++ Runtime can unload and load single Modules. All other Runtimes are restarted
+// as a whole if any of their Modules is affected by a new config.
+static bool supportsPartialReload(Runtime runtime)
 {
-    if(this->waitingForAllRuntimesToUnloadModules)
+    return runtime == Runtime::RUNTIME_CPP;
+}
+
+void MiddleWare::getRuntimesAffectedByConfigDiff(const ConfigDiff& diff,
+    const ModuleDescriptionMap& oldModuleDescriptions, const ModuleDescriptionMap& newModuleDescriptions,
+    std::map<Runtime, std::set<std::string>>& affectedRuntimes)
+{
+    std::vector<Runtime> runningRuntimes = this->moduleTable.getRunningRuntimes();
+    std::set<Runtime> running(runningRuntimes.begin(), runningRuntimes.end());
+
+    std::set<std::string> affectedModules = diff.getAffectedModulesOfHost(this->hostId, oldModuleDescriptions, newModuleDescriptions);
+    for(const std::string& moduleId : affectedModules)
     {
-        return absl::UnavailableError("Cannot load a new config. We are currently waiting for all local Runtimes "
-        "to unload their Modules (i.e., loadNewConfig() was called before but has not finished yet).");
+        // A changed Module might have moved to another Runtime, hence we check the Runtime of the old and the new class.
+        for(const ModuleDescriptionMap* descriptions : {&oldModuleDescriptions, &newModuleDescriptions})
+        {
+            auto it = descriptions->find(moduleId);
+            if(it == descriptions->end() || it->second.host != this->hostId)
+            {
+                continue;
+            }
+
+            Runtime runtime;
+            if(!this->moduleTable.lookupRuntimeOfModuleClass(it->second.moduleClass, runtime))
+            {
+                Logger::logWarning("Cannot determine the Runtime of Module \"%s\" (class \"%s\"), no connected Runtime provides this class.",
+                    moduleId.c_str(), it->second.moduleClass.c_str());
+                continue;
+            }
+
+            if(running.find(runtime) == running.end())
+            {
+                continue;
+            }
+            affectedRuntimes[runtime].insert(moduleId);
+        }
+    }
+}
+
+absl::Status MiddleWare::unloadModulesInLocalRuntimes(const std::map<Runtime, std::set<std::string>>& affectedRuntimes)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
+        this->numberOfRuntimesThatUnloadedModules = 0;
     }
 
-    this->waitingForAllRuntimesToUnloadModules = true;
-    this->numberOfRuntimesThatUnloadedModules = 0;
-    this->modulesUnloaded = false;
+    for(const auto& entry : affectedRuntimes)
+    {
+        std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+        ControlPackage& ctrlPackage = *package->mutable_control_val();
 
+        ctrlPackage.set_ctrl_type(CtrlType::CTRL_UNLOAD_MODULES);
+        ctrlPackage.set_runtime(entry.first);
+        if(supportsPartialReload(entry.first))
+        {
+            for(const std::string& moduleId : entry.second)
+            {
+                ctrlPackage.add_module_ids(moduleId);
+            }
+        }
+        package->set_source_host(this->hostId);
+        package->set_target_host(this->hostId);
+        Logger::logInfo("Forwarding CTRL_UNLOAD_MODULES package to Runtime %s", Runtime_Name(entry.first).c_str());
+        this->forwardControlPackageToSpecificRuntime(package, entry.first);
+    }
 
-    std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
-    ControlPackage& ctrlPackage = *package->mutable_control_val();
-    
-    ctrlPackage.set_ctrl_type(CtrlType::CTRL_UNLOAD_MODULES);
-    package->set_source_host(this->hostId);
-    package->set_target_host(this->hostId);
-    Logger::logInfo("Forwarding CTRL_UNLOAD_MODULES package to all local runtimes");
-    this->forwardControlPackageToAllRuntimes(package);
-            Logger::logInfo("4");
+    std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
+    bool acknowledged = this->runtimeAcknowledgementsCondition.wait_for(lock, this->runtimeAcknowledgementsTimeout, [&]{
+        return this->numberOfRuntimesThatUnloadedModules >= affectedRuntimes.size();
+    });
 
-    while(this->waitingForAllRuntimesToUnloadModules)
+    if(!acknowledged)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return absl::DeadlineExceededError(absl::StrCat(
+            "Failed to load new config. Only ", this->numberOfRuntimesThatUnloadedModules, " of ", affectedRuntimes.size(),
+            " local Runtimes acknowledged unloading their Modules within ", this->runtimeAcknowledgementsTimeout.count(), " seconds."));
     }
-            Logger::logInfo("5");
 
-    this->modulesUnloaded = true;
-            Logger::logInfo("6");
     return absl::OkStatus();
 }
 
@@ -953,42 +1043,8 @@ absl::Status MiddleWare::getHostModuleAndChannelDescriptions(const std::string&
 }
     
 
-absl::Status MiddleWare::loadNewConfigIntoModuleTableAndRouter(const Configuration& config)
+absl::Status MiddleWare::validateHostsUnchanged(const HostDescriptionMap& oldHostDescriptions, const HostDescriptionMap& hostDescriptions) const
 {
-    // This is ONLY safe to do, if all Modules in all Runtimes have been unloaded!!
-    if(!this->modulesUnloaded)
-    {
-        return absl::UnavailableError("Cannot restart runtimes, have to unload Modules first!");
-    }
-
-
-    HostDescriptionMap hostDescriptions;
-
-    // All Modules specified in the configuration file.
-    // Needed by the Router.
-    ModuleDescriptionMap allModuleDescriptions;
-
-    // Subset of allModuleDescriptions. Contains only the Modules running on the current host.
-    // Needed to populate the ModuleTable.
-    ModuleDescriptionMap hostModuleDescriptions;
-
-    ChannelDescriptionMap channelDescriptions;
-
-    absl::Status status; 
-    status = getHostModuleAndChannelDescriptions(hostId, config, hostDescriptions, allModuleDescriptions, hostModuleDescriptions, channelDescriptions);
-    if (!status.ok()) {
-        return status;
-    }
-   
-
-    HostDescriptionMap oldHostDescriptions;
-    status = this->currentConfiguration.getHostDescriptions(oldHostDescriptions);
-    if(!status.ok())
-    {
-        return status;
-    }
-
-    
     if(hostDescriptions.size() != oldHostDescriptions.size())
     {
         return absl::Status(absl::InvalidArgumentError(absl::StrCat(
@@ -1038,54 +1094,73 @@ absl::Status MiddleWare::loadNewConfigIntoModuleTableAndRouter(const Configurati
                 "Changing the internal configuration of hosts when reloading configs is not supported. You can only change the Modules per host.")));
         }
     }
-        
-    Logger::logInfo("Stopping Router.");
-    status = this->masterRouter->stop();
-    if(!status.ok())
+    return absl::OkStatus();
+}
+
+absl::Status MiddleWare::loadNewConfigIntoModuleTableAndRouter(
+    const ModuleDescriptionMap& allModuleDescriptions,
+    const ModuleDescriptionMap& hostModuleDescriptions,
+    const ChannelDescriptionMap& channelDescriptions,
+    const std::set<std::string>& modulesToReload)
+{
+    // Collected before changing anything, so that the reload can be aborted without leaving a partially updated ModuleTable.
+    ModuleDescriptionMap reloadedHostModuleDescriptions;
+    for(const auto& entry : hostModuleDescriptions)
     {
-        return status;
+        if(modulesToReload.find(entry.first) != modulesToReload.end())
+        {
+            absl::Status status = reloadedHostModuleDescriptions.insert(entry);
+            if(!status.ok())
+            {
+                return status;
+            }
+        }
     }
+
+    // The Router keeps running, packages of unchanged Modules are routed with the new descriptions right away.
     Logger::logInfo("Updating Router.");
-    status = this->masterRouter->updateHostAndModuleDescriptions(hostDescriptions, allModuleDescriptions);
-    if(!status.ok())
+    this->masterRouter->updateModuleDescriptions(allModuleDescriptions);
+
+    // This is ONLY safe for Modules which have been unloaded (or which are not running on this host).
+    // Entries of all other Modules, including the types of the channels they have registered, are kept.
+    this->moduleTable.removeModules(modulesToReload);
+
+    return populateModuleTable(allModuleDescriptions, reloadedHostModuleDescriptions, channelDescriptions, moduleTable);
+}
+
+absl::Status MiddleWare::restartRuntimesWithNewConfig(const std::map<Runtime, std::set<std::string>>& affectedRuntimes)
+{
     {
-        return status;
+        std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
+        this->numberOfRuntimesThatRestarted = 0;
     }
-    Logger::logInfo("Starting router");
-    status = this->masterRouter->start();
-    if(!status.ok())
+
+    for(const auto& entry : affectedRuntimes)
     {
-        return status;
-    }
+        std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+        ControlPackage& ctrlPackage = *package->mutable_control_val();
 
-    this->currentConfiguration = config;
-    
-    this->moduleTable.clearLookupTables();
-    status = populateModuleTable(allModuleDescriptions, hostModuleDescriptions, channelDescriptions, moduleTable);
-    if (!status.ok()) {
-        return status;
+        // Runtimes which have unloaded single Modules only load the Modules they are missing,
+        // all other Runtimes are restarted and request the full list of Modules again.
+        ctrlPackage.set_ctrl_type(supportsPartialReload(entry.first) ? CtrlType::CTRL_LOAD_MODULES : CtrlType::CTRL_RESTART_RUNTIME);
+        ctrlPackage.set_runtime(entry.first);
+        package->set_source_host(this->hostId);
+        package->set_target_host(this->hostId);
+        Logger::logInfo("Forwarding %s package to Runtime %s", 
+            CtrlType_Name(ctrlPackage.ctrl_type()).c_str(), Runtime_Name(entry.first).c_str());
+        this->forwardControlPackageToSpecificRuntime(package, entry.first);
     }
-    return absl::OkStatus();
-}
-
 
-absl::Status MiddleWare::restartRuntimesWithNewConfig()
-{
-    this->waitingForAllRuntimesToRestart = true;
-    this->numberOfRuntimesThatRestarted = 0;
-
-    std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
-    ControlPackage& ctrlPackage = *package->mutable_control_val();
-    
-    ctrlPackage.set_ctrl_type(CtrlType::CTRL_RESTART_RUNTIME);
-    package->set_source_host(this->hostId);
-    package->set_target_host(this->hostId);
-    this->forwardControlPackageToAllRuntimes(package);
-    Logger::logInfo("Forwarding CTRL_RESTART_RUNTIME package to all local runtimes");
+    std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
+    bool acknowledged = this->runtimeAcknowledgementsCondition.wait_for(lock, this->runtimeAcknowledgementsTimeout, [&]{
+        return this->numberOfRuntimesThatRestarted >= affectedRuntimes.size();
+    });
 
-    while(this->waitingForAllRuntimesToUnloadModules)
+    if(!acknowledged)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return absl::DeadlineExceededError(absl::StrCat(
+            "Failed to load new config. Only ", this->numberOfRuntimesThatRestarted, " of ", affectedRuntimes.size(),
+            " local Runtimes acknowledged loading their Modules within ", this->runtimeAcknowledgementsTimeout.count(), " seconds."));
     }
     Logger::logInfo("Restarting runtimes done");
 
@@ -1109,43 +1184,113 @@ absl::Status MiddleWare::loadNewConfig(const std::string& configurationPath)
 
 absl::Status MiddleWare::loadNewConfig(const Configuration& config)
 {
-    Logger::logInfo("Unloading all Modules in all local runtimes.");
-
-    // Loading a new config works as follows:
-    // 1. All Runtimes stop and delete all Modules (= unloading them), and acknowledge it.
-    // 2. Once all Runtimes have acknowledged that the Modules have been unloaded, we can clear
-    // the lookup tables inside the ModuleTable and populate it again from the new config.
-    // 3. Afterward, all Runtimes will restart and automatically receive the new configuration from the Middleware.
-    // Loading a new config means all Modules will be stopped and deleted! It is not possible for information to persist 
-    // between two configs (i.e., if there are two Modules with the same id before and after, they will still be completely restarted).
-   
+    // Loading a new config works incrementally:
+    // 1. The new config is compared to the current one. Only Modules which were added, removed or changed 
+    // (class, host, properties or channel mappings) are affected, all other Modules keep running and do not lose any data.
+    // 2. The Runtimes hosting affected Modules unload them and acknowledge it. The C++ Runtime only unloads the affected Modules,
+    // all other Runtimes unload all of their Modules.
+    // 3. The Router switches to the new Module descriptions while running, and the entries of the unloaded Modules
+    // in the ModuleTable are replaced by the ones from the new config.
+    // 4. The affected Runtimes load the missing Modules (C++) or restart and receive the new configuration from the Middleware (all others).
+    // Modules that are reloaded do not keep any state between two configs.
+    {
+        std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
+        if(this->reloadingConfig)
+        {
+            return absl::UnavailableError("Cannot load a new config. We are currently waiting for local Runtimes "
+            "to reload their Modules (i.e., loadNewConfig() was called before but has not finished yet).");
+        }
+        this->reloadingConfig = true;
+    }
+    // reloadConfig returns on every path (the waits for the Runtimes time out), hence reloadingConfig is always reset,
+    // also if the reload failed. Otherwise, no further config could ever be loaded.
+    absl::Status status = this->reloadConfig(config);
+
+    std::unique_lock<std::mutex> lock(this->runtimeAcknowledgementsMutex);
+    this->reloadingConfig = false;
+    return status;
+}
+
+absl::Status MiddleWare::reloadConfig(const Configuration& config)
+{
     this->setupLogSink();
 
-    absl::Status status;
-    status = this->unloadAllModulesInAllLocalRuntimes();
+    auto startTime = std::chrono::steady_clock::now();
+
+    HostDescriptionMap hostDescriptions;
+    ModuleDescriptionMap allModuleDescriptions;
+    ModuleDescriptionMap hostModuleDescriptions;
+    ChannelDescriptionMap channelDescriptions;
+
+    absl::Status status; 
+    status = getHostModuleAndChannelDescriptions(hostId, config, hostDescriptions, allModuleDescriptions, hostModuleDescriptions, channelDescriptions);
+    if (!status.ok()) {
+        return status;
+    }
+
+    HostDescriptionMap oldHostDescriptions;
+    ModuleDescriptionMap oldAllModuleDescriptions;
+    ModuleDescriptionMap oldHostModuleDescriptions;
+    ChannelDescriptionMap oldChannelDescriptions;
+    status = getHostModuleAndChannelDescriptions(hostId, this->currentConfiguration, oldHostDescriptions, 
+        oldAllModuleDescriptions, oldHostModuleDescriptions, oldChannelDescriptions);
+    if (!status.ok()) {
+        return status;
+    }
+
+    status = validateHostsUnchanged(oldHostDescriptions, hostDescriptions);
     if(!status.ok())
     {
         return status;
     }
 
-    Logger::logInfo("Done unloading all Modules in all local runtimes.");
-    
+    ConfigDiff diff = ConfigDiff::compute(oldAllModuleDescriptions, oldChannelDescriptions, allModuleDescriptions, channelDescriptions);
+    if(diff.empty())
+    {
+        Logger::logInfo("New config does not change any Modules or channels, no Runtime has to be restarted.");
+        this->currentConfiguration = config;
+        return absl::OkStatus();
+    }
+    Logger::logInfo("Loading new config:\n%s", diff.toString().c_str());
+
+    std::map<Runtime, std::set<std::string>> affectedRuntimes;
+    getRuntimesAffectedByConfigDiff(diff, oldAllModuleDescriptions, allModuleDescriptions, affectedRuntimes);
+
+    // Affected Modules of all hosts (their channel mappings might have changed), 
+    // and all Modules of local Runtimes which are restarted completely.
+    std::set<std::string> modulesToReload = diff.getAffectedModules();
+    for(const auto& entry : affectedRuntimes)
+    {
+        if(!supportsPartialReload(entry.first))
+        {
+            std::set<std::string> modulesOfRuntime = this->moduleTable.getModulesOfRuntime(entry.first);
+            modulesToReload.insert(modulesOfRuntime.begin(), modulesOfRuntime.end());
+        }
+    }
 
-    status = this->loadNewConfigIntoModuleTableAndRouter(config);
+    Logger::logInfo("Unloading affected Modules in %d local runtimes.", affectedRuntimes.size());
+    status = this->unloadModulesInLocalRuntimes(affectedRuntimes);
     if(!status.ok())
     {
         return status;
     }
 
-    status = this->restartRuntimesWithNewConfig();
+    status = this->loadNewConfigIntoModuleTableAndRouter(allModuleDescriptions, hostModuleDescriptions, channelDescriptions, modulesToReload);
     if(!status.ok())
     {
         return status;
     }
+    this->currentConfiguration = config;
 
+    status = this->restartRuntimesWithNewConfig(affectedRuntimes);
+    if(!status.ok())
+    {
+        return status;
+    }
 
-        
-
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    Logger::logInfo("Loaded new config in %d ms, reloaded %d Modules in %d local Runtimes.", 
+        static_cast<int>(duration.count()), static_cast<int>(modulesToReload.size()), static_cast<int>(affectedRuntimes.size()));
 
     // if(config.isDesignerModeEnabled())
     // {
@@ -1159,7 +1304,6 @@ absl::Status MiddleWare::loadNewConfig(const Configuration& config)
     return absl::OkStatus();
 }
 
-
 void MiddleWare::readLocalLogMessages()
 {
     while(this->running)
@@ -1355,6 +1499,32 @@ std::shared_ptr<EventTracker> MiddleWare::getEventTracker()
     return this->eventTracker;
 }
 
+std::shared_ptr<InProcessTransport> MiddleWare::attachInProcessRuntime(Runtime runtime, size_t ringCapacity)
+{
+    if(this->localDispatcher == nullptr)
+    {
+        Logger::logError("Cannot attach Runtime %s in-process, the local dispatcher is not running.", Runtime_Name(runtime).c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<InProcessTransport> transport = std::make_shared<InProcessTransport>(runtime, ringCapacity);
+    grpc::Status status = this->localDispatcher->connectInProcessRuntime(transport);
+    if(!status.ok())
+    {
+        Logger::logError("Failed to attach Runtime %s in-process: %s", Runtime_Name(runtime).c_str(), status.error_message().c_str());
+        return nullptr;
+    }
+    return transport;
+}
+
+void MiddleWare::detachInProcessRuntime(Runtime runtime)
+{
+    if(this->localDispatcher != nullptr)
+    {
+        this->localDispatcher->disconnectInProcessRuntime(runtime);
+    }
+}
+
 void MiddleWare::handleRPCModuleNotFoundError(std::shared_ptr<DataPackage> rpcRequestPackage)
 {
     const RemoteFunctionRequest& rpcRequest = rpcRequestPackage->control_val().remote_function_request();
@@ -1371,8 +1541,17 @@ void MiddleWare::handleRPCModuleNotFoundError(std::shared_ptr<DataPackage> rpcRe
     RemoteFunctionReturn* remoteFunctionReturn = ctrlPackage->mutable_remote_function_return();
     remoteFunctionReturn->set_execution_status(RemoteFunctionStatus::FAILED_MODULE_NOT_FOUND);
     remoteFunctionReturn->set_remote_future_identifier(rpcRequest.remote_future_identifier());
+    remoteFunctionReturn->set_remote_future_id(rpcRequest.remote_future_id());
     *remoteFunctionReturn->mutable_remote_function_identifier() = rpcRequest.remote_function_identifier();
 
+    // Fail every call of a batched request individually, as each call has its own future.
+    for(const RemoteFunctionBatchedCall& call : rpcRequest.batched_calls())
+    {
+        RemoteFunctionBatchedReturn* batchedReturn = remoteFunctionReturn->add_batched_returns();
+        batchedReturn->set_remote_future_id(call.remote_future_id());
+        batchedReturn->set_execution_status(RemoteFunctionStatus::FAILED_MODULE_NOT_FOUND);
+    }
+
     ctrlPackage->set_ctrl_type(CtrlType::CTRL_REMOTE_FUNCTION_RESPONSE);
     
     ctrlPackage->set_runtime(rpcRequestPackage->control_val().runtime());
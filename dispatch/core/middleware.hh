@@ -25,11 +25,14 @@
 #include <string>
 #include <memory>
 #include <thread>
+#include <condition_variable>
+#include <chrono>
 
 #include "absl/status/status.h"
 #include "dispatch/core/module_table.hh"
 #include "dispatch/core/local_dispatching.hh"
 #include "dispatch/core/Configuration/Configuration.hh"
+#include "dispatch/core/Configuration/ConfigDiff.hh"
 
 #include "dispatch/core/RemoteDispatching/RemoteDispatcherClient.hh"
 #include "dispatch/core/RemoteDispatching/RemoteDispatcherServer.hh"
@@ -97,6 +100,12 @@ namespace claid
 
             std::shared_ptr<EventTracker> getEventTracker();
 
+            // Connects a Runtime running in the same process (e.g., Python via ctypes) through a pair of ring buffers
+            // instead of the gRPC package stream. Returns nullptr if the Runtime could not be connected, in which case it
+            // has to fall back to gRPC.
+            std::shared_ptr<InProcessTransport> attachInProcessRuntime(Runtime runtime, size_t ringCapacity);
+            void detachInProcessRuntime(Runtime runtime);
+
             virtual ~MiddleWare();
 
             // RPCs
@@ -109,12 +118,14 @@ namespace claid
 
             bool running = false;
 
-            bool waitingForAllRuntimesToUnloadModules = false;
+            // Counts the acknowledgements of the Runtimes affected by a config reload.
+            std::mutex runtimeAcknowledgementsMutex;
+            std::condition_variable runtimeAcknowledgementsCondition;
+            bool reloadingConfig = false;
             size_t numberOfRuntimesThatUnloadedModules = 0;
-            bool modulesUnloaded = false;
-
-            bool waitingForAllRuntimesToRestart = false;
             size_t numberOfRuntimesThatRestarted = 0;
+            // Maximum time to wait for the acknowledgements of the Runtimes, e.g., if a Runtime hangs or disconnects while reloading.
+            const std::chrono::seconds runtimeAcknowledgementsTimeout = std::chrono::seconds(30);
 
             // Path to specify where additional payload data is stored when a control message
             // of type UPLOAD_CONFIG_AND_DATA is received. Requires designerMode to be activated in the configuration file.
@@ -203,9 +214,18 @@ namespace claid
             void setupLogSink();
             void assertAllModulesLoaded();
 
-            absl::Status unloadAllModulesInAllLocalRuntimes();
-            absl::Status loadNewConfigIntoModuleTableAndRouter(const Configuration& config);
-            absl::Status restartRuntimesWithNewConfig();
+            absl::Status reloadConfig(const Configuration& config);
+            absl::Status validateHostsUnchanged(const HostDescriptionMap& oldHostDescriptions, const HostDescriptionMap& hostDescriptions) const;
+            void getRuntimesAffectedByConfigDiff(const ConfigDiff& diff,
+                const ModuleDescriptionMap& oldModuleDescriptions, const ModuleDescriptionMap& newModuleDescriptions,
+                std::map<Runtime, std::set<std::string>>& affectedRuntimes);
+            absl::Status unloadModulesInLocalRuntimes(const std::map<Runtime, std::set<std::string>>& affectedRuntimes);
+            absl::Status loadNewConfigIntoModuleTableAndRouter(
+                const ModuleDescriptionMap& allModuleDescriptions,
+                const ModuleDescriptionMap& hostModuleDescriptions,
+                const ChannelDescriptionMap& channelDescriptions,
+                const std::set<std::string>& modulesToReload);
+            absl::Status restartRuntimesWithNewConfig(const std::map<Runtime, std::set<std::string>>& affectedRuntimes);
 
             void readControlPackages();
             void handleControlPackage(std::shared_ptr<DataPackage> controlPackage);
@@ -22,6 +22,7 @@
 #include "dispatch/core/module_table.hh"
 #include "dispatch/core/proto_util.hh"
 #include "dispatch/core/Logger/Logger.hh"
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
 #include <stdexcept>
 #include "absl/status/status.h"
 // #include <google/protobuf/text_format.h>
@@ -79,29 +80,62 @@ bool claid::validPacketType(const DataPackage& ref)
 }
 
 SharedQueue<DataPackage>* ModuleTable::lookupOutputQueue(const string& moduleId) {
-    for(auto& entry : moduleRuntimeMap)
-    {
-        Logger::logInfo("%s %d", entry.first.c_str(), entry.second);
+    // Called for every package routed by the LocalRouter, possibly from multiple router shards concurrently.
+    // Hence, only use find() here (operator[] would insert) and do not log.
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
+    auto rtIt = moduleRuntimeMap.find(moduleId);
+    if (rtIt == moduleRuntimeMap.end() || rtIt->second == Runtime::RUNTIME_UNSPECIFIED) {
+        return nullptr;
     }
-    auto rt = moduleRuntimeMap[moduleId];
-    if (rt != Runtime::RUNTIME_UNSPECIFIED) {
-        auto outQueue = runtimeQueueMap[rt];
-            Logger::logWarning("Output queue size: %d", outQueue->size());
 
-        if (outQueue) {
-            return outQueue.get();
-        }
+    auto queueIt = runtimeQueueMap.find(rtIt->second);
+    if (queueIt == runtimeQueueMap.end() || !queueIt->second) {
+        return nullptr;
     }
-    else
-    {
-        //Logger::logError("ModuleTable::lookupOutputQueue runtime is unspecified");
+    return queueIt->second.get();
+}
+
+bool ModuleTable::lookupModuleRuntime(const string& moduleId, Runtime& runtime) const {
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
+    auto rtIt = moduleRuntimeMap.find(moduleId);
+    if (rtIt == moduleRuntimeMap.end() || rtIt->second == Runtime::RUNTIME_UNSPECIFIED) {
+        return false;
+    }
+    runtime = rtIt->second;
+    return true;
+}
+
+SharedQueue<DataPackage>* ModuleTable::lookupOutputQueue(uint32_t moduleId) {
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
+    if (moduleId == StringInternTable::INVALID_ID || moduleId > moduleRuntimeById.size()) {
+        return nullptr;
+    }
+    Runtime rt = moduleRuntimeById[moduleId - 1];
+    if (rt == Runtime::RUNTIME_UNSPECIFIED) {
+        return nullptr;
+    }
+
+    auto queueIt = runtimeQueueMap.find(rt);
+    if (queueIt == runtimeQueueMap.end() || !queueIt->second) {
+        return nullptr;
+    }
+    return queueIt->second.get();
+}
+
+void ModuleTable::setModuleRuntime(const std::string& moduleId, Runtime runtime) {
+    moduleRuntimeMap[moduleId] = runtime;
+
+    uint32_t id = routingIds->modules.intern(moduleId);
+    if (id > moduleRuntimeById.size()) {
+        moduleRuntimeById.resize(id, Runtime::RUNTIME_UNSPECIFIED);
     }
-    return nullptr;
+    moduleRuntimeById[id - 1] = runtime;
 }
 
 std::vector<std::shared_ptr<SharedQueue<claidservice::DataPackage>>> ModuleTable::getRuntimeQueues()
 {
     std::vector<std::shared_ptr<SharedQueue<claidservice::DataPackage>>> queues;
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
     for(auto& entry : runtimeQueueMap)
     {
         queues.push_back(entry.second);
@@ -119,6 +153,7 @@ void ModuleTable::setNeededModule(const string& moduleId, const string& moduleCl
     // TODO: verify no module is registered incorreclty multiple times
     moduleToClassMap[moduleId] = moduleClass;
     moduleProperties[moduleId] = properties;
+    routingIds->modules.intern(moduleId);
 }
 
 void ModuleTable::setModuleChannelToConnectionMappings(const std::string& moduleId,
@@ -127,6 +162,22 @@ void ModuleTable::setModuleChannelToConnectionMappings(const std::string& module
 {
     moduleInputChannelsToConnectionMap[moduleId] = inputChannelToConnectionMappping;
     moduleOutputChannelsToConnectionMap[moduleId] = outputChannelToConnectionMapping;
+
+    uint32_t moduleRoutingId = routingIds->modules.intern(moduleId);
+    for(const auto& entry : inputChannelToConnectionMappping)
+    {
+        routingIds->channels.intern(entry.first);
+        routingIds->channels.intern(entry.second);
+    }
+    for(const auto& entry : outputChannelToConnectionMapping)
+    {
+        uint32_t channelRoutingId = routingIds->channels.intern(entry.first);
+        uint32_t connectionRoutingId = routingIds->channels.intern(entry.second);
+        if(channelRoutingId != StringInternTable::INVALID_ID && connectionRoutingId != StringInternTable::INVALID_ID)
+        {
+            moduleOutputChannelIdsToConnectionIdMap[RoutingIdTable::makeKey(moduleRoutingId, channelRoutingId)] = connectionRoutingId;
+        }
+    }
 }
 
 void ModuleTable::setExpectedChannel(const string& channelId, const string& source, const string& target) {
@@ -134,8 +185,128 @@ void ModuleTable::setExpectedChannel(const string& channelId, const string& sour
 
     // TODO: Check whether the input doesn't conflict with
     // assumptions and previous additons of channels.
-    chanMap[channelId].sources[source] = false;
-    chanMap[channelId].targets[target] = false;
+    ChannelEntry& entry = chanMap[channelId];
+
+    // Pointers to the entries of a map stay valid until the entry is erased.
+    uint32_t channelRoutingId = routingIds->channels.intern(channelId);
+    if(channelRoutingId > chanEntriesById.size())
+    {
+        chanEntriesById.resize(channelRoutingId, nullptr);
+    }
+    chanEntriesById[channelRoutingId - 1] = &entry;
+
+    entry.sources.emplace(source, false);
+    entry.targets.emplace(target, false);
+
+    // An empty target marks a channel without subscriber, which is no longer the case.
+    if(!target.empty())
+    {
+        entry.targets.erase("");
+    }
+}
+
+void ModuleTable::removeModules(const std::set<std::string>& moduleIds)
+{
+    unique_lock<shared_mutex> lock(chanMapMutex);
+    unique_lock<shared_mutex> lock2(loadedModulesSetMutex);
+    unique_lock<shared_mutex> lock3(runtimeMapsMutex);
+
+    for(const std::string& moduleId : moduleIds)
+    {
+        moduleToClassMap.erase(moduleId);
+        moduleProperties.erase(moduleId);
+        moduleInputChannelsToConnectionMap.erase(moduleId);
+        moduleOutputChannelsToConnectionMap.erase(moduleId);
+        moduleRuntimeMap.erase(moduleId);
+        loadedModules.erase(moduleId);
+
+        uint32_t moduleRoutingId = routingIds->modules.lookupId(moduleId);
+        if(moduleRoutingId != StringInternTable::INVALID_ID && moduleRoutingId <= moduleRuntimeById.size())
+        {
+            moduleRuntimeById[moduleRoutingId - 1] = Runtime::RUNTIME_UNSPECIFIED;
+        }
+        for(auto it = moduleOutputChannelIdsToConnectionIdMap.begin(); it != moduleOutputChannelIdsToConnectionIdMap.end();)
+        {
+            it = (it->first >> 32) == moduleRoutingId ? moduleOutputChannelIdsToConnectionIdMap.erase(it) : std::next(it);
+        }
+    }
+
+    for(auto it = chanMap.begin(); it != chanMap.end();)
+    {
+        ChannelEntry& entry = it->second;
+        for(const std::string& moduleId : moduleIds)
+        {
+            entry.sources.erase(moduleId);
+            entry.targets.erase(moduleId);
+        }
+
+        bool hasSources = !entry.sources.empty();
+        bool hasTargets = !entry.targets.empty() && !(entry.targets.size() == 1 && entry.targets.count("") == 1);
+        if(!hasSources && !hasTargets)
+        {
+            uint32_t channelRoutingId = routingIds->channels.lookupId(it->first);
+            if(channelRoutingId != StringInternTable::INVALID_ID && channelRoutingId <= chanEntriesById.size())
+            {
+                chanEntriesById[channelRoutingId - 1] = nullptr;
+            }
+            it = chanMap.erase(it);
+            continue;
+        }
+
+        // If no remaining Module has registered the channel yet, the payload type will be set again
+        // by the next Module registering it (which might use a different type with the new config).
+        bool anyMatched = false;
+        for(const auto& source : entry.sources)
+        {
+            anyMatched |= source.second;
+        }
+        for(const auto& target : entry.targets)
+        {
+            anyMatched |= target.second;
+        }
+        if(!anyMatched)
+        {
+            entry.clearPayloadType();
+        }
+        ++it;
+    }
+}
+
+bool ModuleTable::lookupRuntimeOfModuleClass(const std::string& moduleClass, claidservice::Runtime& runtime) const
+{
+    auto it = moduleClassRuntimeMap.find(moduleClass);
+    if(it == moduleClassRuntimeMap.end() || it->second == Runtime::RUNTIME_UNSPECIFIED)
+    {
+        return false;
+    }
+    runtime = it->second;
+    return true;
+}
+
+std::set<std::string> ModuleTable::getModulesOfRuntime(claidservice::Runtime runtime) const
+{
+    std::set<std::string> modules;
+
+    // Same locking order as removeModules.
+    unique_lock<shared_mutex> lock(loadedModulesSetMutex);
+    shared_lock<shared_mutex> lock2(runtimeMapsMutex);
+    for(const auto& entry : moduleToClassMap)
+    {
+        auto runtimeIt = moduleClassRuntimeMap.find(entry.second);
+        if(runtimeIt != moduleClassRuntimeMap.end() && runtimeIt->second == runtime)
+        {
+            modules.insert(entry.first);
+        }
+    }
+
+    for(const auto& entry : moduleRuntimeMap)
+    {
+        if(entry.second == runtime)
+        {
+            modules.insert(entry.first);
+        }
+    }
+    return modules;
 }
 
 absl::Status ModuleTable::setChannelTypes(const string& moduleId,
@@ -287,13 +458,22 @@ void ModuleTable::setModuleUnloaded(const std::string& moduleId)
 
 void ModuleTable::setAllModulesOfRuntimeUnloaded(Runtime rt)
 {
-    for(const auto& entry : this->moduleRuntimeMap)
+    std::vector<std::string> modulesOfRuntime;
     {
-        if(entry.second == rt)
+        shared_lock<shared_mutex> lock(runtimeMapsMutex);
+        for(const auto& entry : this->moduleRuntimeMap)
         {
-            setModuleUnloaded(entry.first);
+            if(entry.second == rt)
+            {
+                modulesOfRuntime.push_back(entry.first);
+            }
         }
     }
+
+    for(const std::string& moduleId : modulesOfRuntime)
+    {
+        setModuleUnloaded(moduleId);
+    }
 }
 
 bool ModuleTable::allModulesLoaded() const
@@ -328,7 +508,13 @@ const ChannelEntry* ModuleTable::isValidChannel(const DataPackage& pkt, bool ign
 
     shared_lock<shared_mutex> lock(const_cast<shared_mutex&>(chanMapMutex));
 
-    auto entry = (const_cast<ModuleTable*>(this))->findChannel(pkt.channel());
+    ChannelEntry* entry = nullptr;
+    uint32_t channelRoutingId = pkt.channel_id();
+    if (channelRoutingId != StringInternTable::INVALID_ID && channelRoutingId <= chanEntriesById.size()) {
+        entry = chanEntriesById[channelRoutingId - 1];
+    } else {
+        entry = (const_cast<ModuleTable*>(this))->findChannel(pkt.channel());
+    }
     if (!entry) {
         Logger::logError("Could not find channel \"%s\" in ModuleTable", pkt.channel().c_str());
         return nullptr;
@@ -359,6 +545,9 @@ void ModuleTable::forwardPackageToAllSubscribers(const claidservice::DataPackage
     // Make a copy of the incoming packet and augment it.
     auto cpPkt = pkt;
     augmentFieldValues(cpPkt);
+    if (cpPkt.source_module_id() == StringInternTable::INVALID_ID) {
+        cpPkt.set_source_module_id(routingIds->modules.lookupId(cpPkt.source_module()));
+    }
     for(auto& it : chanEntry->targets) 
     {
         const std::string& targetModuleName = it.first;
@@ -385,7 +574,10 @@ void ModuleTable::forwardPackageToAllSubscribers(const claidservice::DataPackage
                 outPkt->set_target_module(targetModuleName);
 
                 outPkt->set_channel(entry.first); // Set channel name to the channel name of the module (which maps to the connection).
+                outPkt->set_target_module_id(routingIds->modules.lookupId(targetModuleName));
+                outPkt->set_channel_id(routingIds->channels.lookupId(entry.first));
                 Logger::logInfo("ModuleTable debug Received package from %s %s %s", pkt.source_module().c_str(), entry.first.c_str(), entry.second.c_str());
+                LargePayloadStore::getInstance()->holdSharedMemory(outPkt);
                 queue.push_back(outPkt);
             }            
         }
@@ -420,6 +612,7 @@ void ModuleTable::forwardPackageOfModuleToAllLooseDirectSubscribers(
                     controlVal->set_ctrl_type(CtrlType::CTRL_DIRECT_SUBSCRIPTION_DATA);
                     (*controlVal->mutable_loose_direct_subscription()) = subscription;
                     controlVal->set_runtime(subscription.subscriber_runtime());
+                    LargePayloadStore::getInstance()->holdSharedMemory(newPackage);
                     queue.push_back(newPackage);
                 }
             }
@@ -480,6 +673,7 @@ const string ModuleTable::toString() const {
 
 void ModuleTable::addRuntimeIfNotExists(const claidservice::Runtime& runtime)
 {
+    unique_lock<shared_mutex> lock(runtimeMapsMutex);
     auto it = runtimeQueueMap.find(runtime);
     if(it == runtimeQueueMap.end())
     {
@@ -489,6 +683,7 @@ void ModuleTable::addRuntimeIfNotExists(const claidservice::Runtime& runtime)
 
 std::shared_ptr<SharedQueue<claidservice::DataPackage>> ModuleTable::getOutputQueueOfRuntime(const claidservice::Runtime& runtime)
 {
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
     auto it = runtimeQueueMap.find(runtime);
     if(it == runtimeQueueMap.end())
     {
@@ -501,7 +696,8 @@ std::shared_ptr<SharedQueue<claidservice::DataPackage>> ModuleTable::getOutputQu
 // ONLY FOR TESTING REMOVE LATER
 void ModuleTable::addModuleToRuntime(const std::string& moduleID, claidservice::Runtime runtime)
 {
-    moduleRuntimeMap[moduleID] = runtime;
+    unique_lock<shared_mutex> lock(runtimeMapsMutex);
+    setModuleRuntime(moduleID, runtime);
     auto outQueue = runtimeQueueMap[runtime];
     if(!outQueue)
     {
@@ -555,14 +751,27 @@ void ModuleTable::getRunningModules(std::vector<std::string>& moduleIDs) const
 
 size_t ModuleTable::getNumberOfRunningRuntimes()
 {
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
     return this->runtimeQueueMap.size();
 }
 
+std::vector<claidservice::Runtime> ModuleTable::getRunningRuntimes()
+{
+    std::vector<claidservice::Runtime> runtimes;
+    shared_lock<shared_mutex> lock(runtimeMapsMutex);
+    for(const auto& entry : runtimeQueueMap)
+    {
+        runtimes.push_back(entry.first);
+    }
+    return runtimes;
+}
+
 void ModuleTable::clearLookupTables()
 {
     unique_lock<shared_mutex> lock(chanMapMutex);
     unique_lock<shared_mutex> lock2(loadedModulesSetMutex);
     unique_lock<shared_mutex> lock3(runtimeInitializingMapMutex);
+    unique_lock<shared_mutex> lock4(runtimeMapsMutex);
 
     moduleClassRuntimeMap.clear();
     // Not necessary
@@ -576,6 +785,9 @@ void ModuleTable::clearLookupTables()
     moduleOutputChannelsToConnectionMap.clear();
     loadedModules.clear();
     isRuntimeInitializingMap.clear();
+    moduleRuntimeById.clear();
+    chanEntriesById.clear();
+    moduleOutputChannelIdsToConnectionIdMap.clear();
 }
 
 bool ModuleTable::lookupOutputConnectionForChannelOfModule(const std::string& sourceModule, const std::string& channelName, std::string& connectionName) const
@@ -598,6 +810,24 @@ bool ModuleTable::lookupOutputConnectionForChannelOfModule(const std::string& so
     return true;
 }
 
+bool ModuleTable::lookupOutputConnectionForChannelOfModule(const DataPackage& pkt, std::string& connectionName, uint32_t& connectionId) const
+{
+    connectionId = StringInternTable::INVALID_ID;
+    if(pkt.source_module_id() == StringInternTable::INVALID_ID || pkt.channel_id() == StringInternTable::INVALID_ID)
+    {
+        return lookupOutputConnectionForChannelOfModule(pkt.source_module(), pkt.channel(), connectionName);
+    }
+
+    auto it = this->moduleOutputChannelIdsToConnectionIdMap.find(RoutingIdTable::makeKey(pkt.source_module_id(), pkt.channel_id()));
+    if(it == this->moduleOutputChannelIdsToConnectionIdMap.end() || !routingIds->channels.lookupName(it->second, connectionName))
+    {
+        return false;
+    }
+
+    connectionId = it->second;
+    return true;
+}
+
 bool ModuleTable::getTypeOfModuleWithId(const std::string& moduleId, std::string& moduleType)
 {
     unique_lock<shared_mutex> lock(chanMapMutex);
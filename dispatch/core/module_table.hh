@@ -27,9 +27,12 @@
 #include <shared_mutex>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 #include "dispatch/proto/claidservice.pb.h"
 #include "dispatch/core/shared_queue.hh"
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
 
 namespace claid {
 
@@ -72,6 +75,12 @@ struct ChannelEntry {
     return this->payloadTypeSet;
   }
 
+  void clearPayloadType()
+  {
+    this->payloadType = "";
+    this->payloadTypeSet = false;
+  }
+
   private:
     std::string payloadType = "";
     bool payloadTypeSet = false;
@@ -84,7 +93,11 @@ class ModuleTable {
     virtual ~ModuleTable() {}
     inline SharedQueue<claidservice::DataPackage>& inputQueue() {return fromModuleQueue;}
     SharedQueue<claidservice::DataPackage>* lookupOutputQueue(const std::string& moduleId);
+    // Same as above, but using the interned ID of the Module (see getRoutingIds).
+    SharedQueue<claidservice::DataPackage>* lookupOutputQueue(uint32_t moduleId);
     std::vector<std::shared_ptr<SharedQueue<claidservice::DataPackage>>> getRuntimeQueues();
+    // Looks up the Runtime hosting the given Module. Returns false if the Module is not loaded by any Runtime.
+    bool lookupModuleRuntime(const std::string& moduleId, claidservice::Runtime& runtime) const;
 
     inline SharedQueue<claidservice::DataPackage>& controlPackagesQueue() {return receivedControlPackagesQueue;}
 
@@ -102,9 +115,21 @@ class ModuleTable {
 
     // Sets a channel that will be defined and used by the connecting runtimes.
     // Usually this is information extracted from a config file. This happens before
-    // any runtimes connect.
+    // any runtimes connect, or when reloading a config. Sources and targets which are already
+    // known (and possibly matched by a running Module) are kept as they are.
     void setExpectedChannel(const std::string& channelId, const std::string& source, const std::string& target);
 
+    // Removes all lookup entries of the given Modules (class, properties, channel mappings, runtime, loaded state)
+    // and removes them as source or target from all channels. Used to reload a config incrementally,
+    // entries of all other Modules are kept.
+    void removeModules(const std::set<std::string>& moduleIds);
+
+    // Looks up the Runtime providing the given Module class. Returns false if no Runtime has registered the class (yet).
+    bool lookupRuntimeOfModuleClass(const std::string& moduleClass, claidservice::Runtime& runtime) const;
+
+    // Returns all needed or loaded Modules which are provided by the given Runtime.
+    std::set<std::string> getModulesOfRuntime(claidservice::Runtime runtime) const;
+
     // Marks a module (identified by it's id) as loaded
     void setModuleLoaded(const std::string& moduleId);
     void setModuleUnloaded(const std::string& moduleId);
@@ -152,11 +177,22 @@ class ModuleTable {
     void getRunningModules(std::vector<std::string>& moduleIDs) const;
 
     size_t getNumberOfRunningRuntimes();
+    std::vector<claidservice::Runtime> getRunningRuntimes();
 
     void clearLookupTables();
 
     bool lookupOutputConnectionForChannelOfModule(const std::string& sourceModule, const std::string& channelName, std::string& connectionName) const;
 
+    // Same as above, but for a package posted by a Module. If the package carries the interned IDs of the source Module and channel,
+    // they are used for the lookup and connectionId is set, otherwise connectionId is StringInternTable::INVALID_ID.
+    bool lookupOutputConnectionForChannelOfModule(const claidservice::DataPackage& pkt, std::string& connectionName, uint32_t& connectionId) const;
+
+    // Names of the channels (connections and channels of Modules), Modules and hosts interned by the Middleware.
+    // Names are added as the config is loaded and are never removed, hence IDs stay valid across config reloads.
+    inline RoutingIdTable& getRoutingIds() {return *routingIds;}
+    inline const RoutingIdTable& getRoutingIds() const {return *routingIds;}
+    inline std::shared_ptr<RoutingIdTable> getSharedRoutingIds() {return routingIds;}
+
     bool getTypeOfModuleWithId(const std::string& moduleId, std::string& moduleType);
 
     const std::map<std::string, std::string>& getModuleToClassMap();
@@ -177,6 +213,8 @@ class ModuleTable {
   private:
     void augmentFieldValues(claidservice::DataPackage& pkt) const;
     ChannelEntry* findChannel(const std::string& channelId);
+    // Callers have to hold runtimeMapsMutex.
+    void setModuleRuntime(const std::string& moduleId, claidservice::Runtime runtime);
 
   private:
     SharedQueue<claidservice::DataPackage> fromModuleQueue;
@@ -221,6 +259,9 @@ class ModuleTable {
     // map<module_id, runtime>
     std::map<std::string, claidservice::Runtime>  moduleRuntimeMap;
 
+    // Same as moduleRuntimeMap, indexed by the interned ID of the Module. Protected by runtimeMapsMutex.
+    std::vector<claidservice::Runtime> moduleRuntimeById;
+
     // Contains the properties that are shared across all modules managed by this module table,
     // e.g. user_id, device_id etc. These are used to populate the fields of client runtime implemenations.
     ModuleTableProperties props;
@@ -234,6 +275,9 @@ class ModuleTable {
     // Mutex to protect isRuntimeInitializingMap.
     mutable std::shared_mutex runtimeInitializingMapMutex;
 
+    // Mutex to protect moduleRuntimeMap and runtimeQueueMap, which are read by the (possibly sharded) MasterRouter.
+    mutable std::shared_mutex runtimeMapsMutex;
+
 
     // TODO: rewrite doc
 
@@ -248,6 +292,16 @@ class ModuleTable {
 
     std::map<std::string, ChannelEntry> chanMap;
 
+    // Entries of chanMap, indexed by the interned ID of the channel (nullptr if the channel was removed).
+    // Protected by chanMapMutex.
+    std::vector<ChannelEntry*> chanEntriesById;
+
+    // Interned counterpart of moduleOutputChannelsToConnectionMap.
+    // map<makeKey(module_id, channel_id), connection_id>
+    std::unordered_map<uint64_t, uint32_t> moduleOutputChannelIdsToConnectionIdMap;
+
+    std::shared_ptr<RoutingIdTable> routingIds = std::make_shared<RoutingIdTable>();
+
     std::map<std::string, claidservice::ModuleAnnotation> moduleAnnotations;
 
     // Allows non-module entities to (temporarily) subscribe to Channels of a certain Module.
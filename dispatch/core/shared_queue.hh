@@ -24,6 +24,7 @@
 
 
 #include <condition_variable>
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -41,6 +42,55 @@ class SharedQueue
 		std::condition_variable cv;
 		bool closed;
 
+		// Optional callback invoked after an element was pushed to the queue (outside of the lock).
+		// Allows consumers that must not block in pop_front (e.g., completion queue driven gRPC handlers)
+		// to get notified about new elements.
+		std::function<void()> pushListener;
+
+		// Optional callback invoked after an element was popped from the queue (outside of the lock).
+		// Allows producers to find out when a consumer caught up (e.g., to refill packages spilled to disk).
+		std::function<void()> popListener;
+
+		// Optional function to determine the size of an element (e.g., in bytes).
+		// If set, the accumulated size of all queued elements is available via elements_size().
+		std::function<size_t(const T&)> elementSizeFunction;
+		size_t elementsSize = 0;
+
+		size_t sizeOf(const std::shared_ptr<T>& val) const
+		{
+			return (elementSizeFunction && val) ? elementSizeFunction(*val) : 0;
+		}
+
+		// Has to be called while holding the lock, releases the lock.
+		void onPushed(std::unique_lock<std::mutex>& lock)
+		{
+			cv.notify_one();
+			std::function<void()> listener = pushListener;
+			lock.unlock();
+
+			if(listener)
+			{
+				listener();
+			}
+		}
+
+		// Has to be called while holding the lock and if the queue is not empty, releases the lock.
+		std::shared_ptr<T> takeFront(std::unique_lock<std::mutex>& lock)
+		{
+			std::shared_ptr<T> out = queue.front();
+			queue.pop_front();
+			elementsSize -= sizeOf(out);
+
+			std::function<void()> listener = popListener;
+			lock.unlock();
+
+			if(listener)
+			{
+				listener();
+			}
+			return out;
+		}
+
 	public:
 		SharedQueue() : closed(false)
 		{ 
@@ -72,8 +122,9 @@ class SharedQueue
 				throw std::logic_error("put to closed channel");
 
 			queue.push_front(val);
+			elementsSize += sizeOf(val);
 
-			cv.notify_one();
+			onPushed(lock);
         }
 
         void push_back(std::shared_ptr<T> val) // adds at the end 
@@ -83,8 +134,9 @@ class SharedQueue
 				throw std::logic_error("put to closed channel");
 
 			queue.push_back(val);
+			elementsSize += sizeOf(val);
 
-			cv.notify_one();
+			onPushed(lock);
         }
         
         std::shared_ptr<T> pop_front()  // returns null_ptr if empty 
@@ -97,10 +149,7 @@ class SharedQueue
 			if (queue.empty())
 				return nullptr;
 
-			std::shared_ptr<T> out = queue.front();
-			queue.pop_front();
-
-            return out;
+            return takeFront(lock);
         }
 
 		std::shared_ptr<T> interruptable_pop_front()  // returns null_ptr if empty 
@@ -117,12 +166,37 @@ class SharedQueue
 			if (queue.empty() || closed)
 				return nullptr;
 
-			std::shared_ptr<T> out = queue.front();
-			this->queue.pop_front();
-
-            return out;
+            return takeFront(lock);
         }
 
+		std::shared_ptr<T> try_pop_front()  // never blocks, returns null_ptr if empty
+		{
+			std::unique_lock<std::mutex> lock(m);
+			if (queue.empty())
+				return nullptr;
+
+			return takeFront(lock);
+		}
+
+		void setPushListener(std::function<void()> listener)
+		{
+			std::unique_lock<std::mutex> lock(m);
+			pushListener = listener;
+		}
+
+		void setPopListener(std::function<void()> listener)
+		{
+			std::unique_lock<std::mutex> lock(m);
+			popListener = listener;
+		}
+
+		// Has to be set before elements are added to the queue.
+		void setElementSizeFunction(std::function<size_t(const T&)> function)
+		{
+			std::unique_lock<std::mutex> lock(m);
+			elementSizeFunction = function;
+		}
+
 		void interruptOnce()
 		{
 			cv.notify_one();
@@ -133,6 +207,13 @@ class SharedQueue
 			std::unique_lock<std::mutex> lock(m);
 			return queue.size();
 		}
+
+		// Accumulated size of all queued elements according to the element size function (0 if not set).
+		size_t elements_size()
+		{
+			std::unique_lock<std::mutex> lock(m);
+			return elementsSize;
+		}
 };
 
 }  // namespace claid  
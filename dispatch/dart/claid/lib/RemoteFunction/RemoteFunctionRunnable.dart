@@ -127,6 +127,7 @@ class RemoteFunctionRunnable<T>
     remoteFunctionReturn.remoteFunctionIdentifier = remoteFunctionIdentifier;
     remoteFunctionReturn.remoteFutureIdentifier =
         executionRequest.remoteFutureIdentifier;
+    remoteFunctionReturn.remoteFutureId = executionRequest.remoteFutureId;
 
     return remoteFunctionReturn;
   }
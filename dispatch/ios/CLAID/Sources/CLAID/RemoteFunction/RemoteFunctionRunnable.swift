@@ -106,6 +106,8 @@ public final class RemoteFunctionRunnable<ReturnType: Sendable, each Parameter:
             remoteFunctionReturn.executionStatus = result.getStatus()
             remoteFunctionReturn.remoteFunctionIdentifier = executionRequest.remoteFunctionIdentifier
             remoteFunctionReturn.remoteFutureIdentifier = executionRequest.remoteFutureIdentifier
+            // The C++ runtime only sets the compact identifier of the future.
+            remoteFunctionReturn.remoteFutureID = executionRequest.remoteFutureID
             
             return remoteFunctionReturn
         }
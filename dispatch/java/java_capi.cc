@@ -195,4 +195,45 @@ extern "C"
         void* nativeHandle = reinterpret_cast<void*>(handle);
         return get_log_sink_severity_level(nativeHandle);
     }
+
+    // In-process transport of the Java Runtime (see InProcessTransport.java and capi.h).
+    JNIEXPORT jlong JNICALL Java_adamma_c4dhi_claid_LocalDispatching_InProcessTransport_nativeAttach
+    (JNIEnv *env, jclass transportClass, jlong handle, jint runtime, jlong ringCapacity)
+    {
+        void* nativeHandle = reinterpret_cast<void*>(handle);
+        return reinterpret_cast<jlong>(attach_in_process_runtime(nativeHandle, runtime, static_cast<size_t>(ringCapacity)));
+    }
+
+    JNIEXPORT void JNICALL Java_adamma_c4dhi_claid_LocalDispatching_InProcessTransport_nativeDetach
+    (JNIEnv *env, jclass transportClass, jlong handle, jlong transport)
+    {
+        detach_in_process_runtime(reinterpret_cast<void*>(handle), reinterpret_cast<void*>(transport));
+    }
+
+    JNIEXPORT jlong JNICALL Java_adamma_c4dhi_claid_LocalDispatching_InProcessTransport_nativeSend
+    (JNIEnv *env, jclass transportClass, jlong transport, jbyteArray data, jint timeoutMs)
+    {
+        jsize size = env->GetArrayLength(data);
+        jbyte* bytes = env->GetByteArrayElements(data, nullptr);
+        long long result = in_process_runtime_send(reinterpret_cast<void*>(transport), bytes, static_cast<size_t>(size), timeoutMs);
+        env->ReleaseByteArrayElements(data, bytes, JNI_ABORT);
+        return static_cast<jlong>(result);
+    }
+
+    JNIEXPORT jlong JNICALL Java_adamma_c4dhi_claid_LocalDispatching_InProcessTransport_nativeWait
+    (JNIEnv *env, jclass transportClass, jlong transport, jint timeoutMs)
+    {
+        return static_cast<jlong>(in_process_runtime_wait(reinterpret_cast<void*>(transport), timeoutMs));
+    }
+
+    JNIEXPORT jlong JNICALL Java_adamma_c4dhi_claid_LocalDispatching_InProcessTransport_nativeReceive
+    (JNIEnv *env, jclass transportClass, jlong transport, jbyteArray buffer)
+    {
+        jsize size = env->GetArrayLength(buffer);
+        jbyte* bytes = env->GetByteArrayElements(buffer, nullptr);
+        long long result = in_process_runtime_receive(reinterpret_cast<void*>(transport), bytes, static_cast<size_t>(size));
+        // Copies the received bytes back into the Java array (if the elements were a copy), unless nothing was received.
+        env->ReleaseByteArrayElements(buffer, bytes, result >= 0 ? 0 : JNI_ABORT);
+        return static_cast<jlong>(result);
+    }
 }
@@ -110,7 +110,7 @@ public abstract class JavaCLAIDBase
             return false;
         }
 
-        if(!attachJavaRuntimeInternal(socketPath, moduleFactory))
+        if(!attachJavaRuntimeInternal(socketPath, handle, moduleFactory))
         {
             return false;
         }
@@ -135,6 +135,12 @@ public abstract class JavaCLAIDBase
     // Assumes that the middleware is started in another language (e.g., C++ or Dart).
     // HAS to be called AFTER start is called in ANOTHER language.
     protected static boolean attachJavaRuntimeInternal(final String socketPath, ModuleFactory factory)
+    {
+        return attachJavaRuntimeInternal(socketPath, 0, factory);
+    }
+
+    // If middlewareHandle is not 0, the Middleware runs in the same process and packages are exchanged via the in-process transport.
+    private static boolean attachJavaRuntimeInternal(final String socketPath, long middlewareHandle, ModuleFactory factory)
     {
         if(started)
         {
@@ -142,7 +148,7 @@ public abstract class JavaCLAIDBase
             return false;
         }
 
-        moduleDispatcher = new ModuleDispatcher(socketPath);
+        moduleDispatcher = new ModuleDispatcher(socketPath, middlewareHandle);
         moduleManager = new ModuleManager(moduleDispatcher, factory);
 
         if(moduleManagerThread == null)
@@ -167,7 +173,7 @@ public abstract class JavaCLAIDBase
     protected static boolean attachJavaRuntimeInternal(long handle, ModuleFactory factory)
     {
         String socketPath = getSocketPath();
-        return attachJavaRuntimeInternal(socketPath, factory);
+        return attachJavaRuntimeInternal(socketPath, handle, factory);
     }
 
     public static boolean loadNewConfig(String config)
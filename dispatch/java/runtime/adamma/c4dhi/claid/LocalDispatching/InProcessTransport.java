@@ -0,0 +1,181 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+
+package adamma.c4dhi.claid.LocalDispatching;
+
+import adamma.c4dhi.claid.DataPackage;
+import adamma.c4dhi.claid.Runtime;
+import adamma.c4dhi.claid.Logger.Logger;
+
+import com.google.protobuf.CodedInputStream;
+
+import java.io.IOException;
+import java.util.function.Consumer;
+
+// Exchanges DataPackages with the Middleware running in the same process through the in-process transport of the CLAID library (see capi.h),
+// instead of the gRPC package stream. Used by the ModuleDispatcher, which falls back to gRPC if the transport cannot be attached.
+// The transport is single-producer/single-consumer in each direction: send() is synchronized, and packages are received by a single reader thread.
+public class InProcessTransport
+{
+    // Return codes of the in_process_runtime_* functions (see capi.h).
+    private static final long CLAID_TRANSPORT_TIMEOUT = -1;
+    private static final long CLAID_TRANSPORT_CLOSED = -2;
+
+    // Timeout for waiting for packages or free space in the ring, after which the transport checks whether it was cancelled.
+    private static final int WAIT_TIMEOUT_MS = 100;
+
+    private static native long nativeAttach(long middlewareHandle, int runtime, long ringCapacity);
+    private static native void nativeDetach(long middlewareHandle, long transport);
+    private static native long nativeSend(long transport, byte[] data, int timeoutMs);
+    private static native long nativeWait(long transport, int timeoutMs);
+    private static native long nativeReceive(long transport, byte[] buffer);
+
+    private final long middlewareHandle;
+    private volatile long transport;
+    private volatile boolean cancelled = false;
+    private Thread readerThread = null;
+
+    private InProcessTransport(long middlewareHandle, long transport)
+    {
+        this.middlewareHandle = middlewareHandle;
+        this.transport = transport;
+    }
+
+    // Returns null if the Middleware could not attach the Runtime.
+    public static InProcessTransport attach(long middlewareHandle, Runtime runtime)
+    {
+        long transport = 0;
+        try
+        {
+            transport = nativeAttach(middlewareHandle, runtime.getNumber(), 0);
+        }
+        catch(UnsatisfiedLinkError e)
+        {
+            Logger.logWarning("The loaded CLAID library does not provide the in-process transport: " + e.getMessage());
+            return null;
+        }
+
+        if(transport == 0)
+        {
+            return null;
+        }
+        return new InProcessTransport(middlewareHandle, transport);
+    }
+
+    public synchronized boolean send(DataPackage dataPackage)
+    {
+        byte[] data = dataPackage.toByteArray();
+        while(!this.cancelled && this.transport != 0)
+        {
+            long result = nativeSend(this.transport, data, WAIT_TIMEOUT_MS);
+            if(result != CLAID_TRANSPORT_TIMEOUT)
+            {
+                return result >= 0;
+            }
+        }
+        return false;
+    }
+
+    // Starts the reader thread, which passes received packages to the consumer until the transport is cancelled or closed.
+    public void startReceiving(Consumer<DataPackage> consumer)
+    {
+        this.readerThread = new Thread(() -> receivePackages(consumer));
+        this.readerThread.start();
+    }
+
+    private void receivePackages(Consumer<DataPackage> consumer)
+    {
+        byte[] buffer = new byte[64 * 1024];
+        while(!this.cancelled)
+        {
+            long size = nativeWait(this.transport, WAIT_TIMEOUT_MS);
+            if(size == CLAID_TRANSPORT_TIMEOUT)
+            {
+                continue;
+            }
+            if(size < 0)
+            {
+                return;
+            }
+
+            if(size > buffer.length)
+            {
+                buffer = new byte[(int) size];
+            }
+
+            long result = nativeReceive(this.transport, buffer);
+            if(result < 0)
+            {
+                continue;
+            }
+
+            DataPackage dataPackage;
+            try
+            {
+                dataPackage = DataPackage.parseFrom(CodedInputStream.newInstance(buffer, 0, (int) result));
+            }
+            catch(IOException e)
+            {
+                Logger.logError("InProcessTransport received invalid package from the Middleware: " + e.getMessage());
+                continue;
+            }
+            consumer.accept(dataPackage);
+        }
+    }
+
+    // Stops the reader thread and pending sends, like cancelling the gRPC stream.
+    public void cancel()
+    {
+        this.cancelled = true;
+    }
+
+    // Cancels the transport, waits for the reader thread (unless called by it) and closes the transport.
+    public void detach()
+    {
+        cancel();
+
+        if(this.readerThread != null && this.readerThread != Thread.currentThread())
+        {
+            try
+            {
+                this.readerThread.join();
+            }
+            catch(InterruptedException e)
+            {
+                // The reader might still be waiting for packages, hence the transport must not be closed.
+                Logger.logError("InProcessTransport interrupted while waiting for the reader thread, not detaching: " + e.getMessage());
+                Thread.currentThread().interrupt();
+                return;
+            }
+        }
+
+        synchronized(this)
+        {
+            if(this.transport == 0)
+            {
+                return;
+            }
+            nativeDetach(this.middlewareHandle, this.transport);
+            this.transport = 0;
+        }
+    }
+}
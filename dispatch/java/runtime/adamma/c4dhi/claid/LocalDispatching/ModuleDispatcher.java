@@ -78,6 +78,13 @@ public class ModuleDispatcher
 
     private boolean waitForInputStreamCancelled = false;
     private boolean inputStreamCancelled = false;
+
+    // Handle of the Middleware, if it runs in the same process (0 otherwise).
+    private long middlewareHandle = 0;
+
+    // Used instead of the gRPC package stream, if attaching in-process succeeded.
+    private volatile InProcessTransport inProcessTransport = null;
+
     // Is this safe?
     private boolean isAndroid() {
         try {
@@ -89,8 +96,16 @@ public class ModuleDispatcher
     }
 
     public ModuleDispatcher(final String socketPath)
+    {
+        this(socketPath, 0);
+    }
+
+    // If middlewareHandle is not 0, packages are exchanged via the in-process transport of the CLAID library instead of the gRPC stream.
+    // GetModuleList and InitRuntime are still called via gRPC.
+    public ModuleDispatcher(final String socketPath, long middlewareHandle)
     {
         this.socketPath = socketPath;
+        this.middlewareHandle = middlewareHandle;
 
         // If android and socket path prefix is unix://
         if (socketPath != null && socketPath.startsWith("unix://") && isAndroid()) {
@@ -233,6 +248,11 @@ public class ModuleDispatcher
             Logger.logFatal("Invalid argument in ModuleDispatcher::sendReceivePackages. Provided consumer is null.");
             return false;
         }
+
+        if(attachInProcess())
+        {
+            return true;
+        }
      
         this.waitForInputStreamCancelled = false;
         this.inputStreamCancelled = false;
@@ -282,6 +302,29 @@ public class ModuleDispatcher
 
     }
 
+    private boolean attachInProcess()
+    {
+        if(this.middlewareHandle == 0)
+        {
+            return false;
+        }
+
+        InProcessTransport transport = InProcessTransport.attach(this.middlewareHandle, Runtime.RUNTIME_JAVA);
+        if(transport == null)
+        {
+            Logger.logWarning("Failed to attach Java Runtime to the Middleware in-process, falling back to gRPC.");
+            return false;
+        }
+
+        // The Middleware registers the Runtime when attaching, hence no ping package is exchanged.
+        this.waitForInputStreamCancelled = false;
+        this.inputStreamCancelled = false;
+        this.inProcessTransport = transport;
+        transport.startReceiving(dataPackage -> onMiddlewareStreamPackageReceived(dataPackage));
+        Logger.logInfo("Java Runtime attached to the Middleware in-process.");
+        return true;
+    }
+
     private void awaitPingPackage()
     {
         while(this.waitingForPingResponse)
@@ -358,6 +401,17 @@ public class ModuleDispatcher
 
     boolean postPackage(DataPackage packet)
     {
+        InProcessTransport transport = this.inProcessTransport;
+        if(transport != null)
+        {
+            if(!transport.send(packet))
+            {
+                Logger.logError("Failed to send package to the Middleware, in-process transport was closed.");
+                return false;
+            }
+            return true;
+        }
+
         this.outStream.onNext(packet);
         return false;
     }
@@ -370,6 +424,15 @@ public class ModuleDispatcher
     void shutdown()
     {
        
+        if(this.inProcessTransport != null)
+        {
+            // Waits for the reader thread, so the transport is not closed while packages are received.
+            this.inProcessTransport.detach();
+            this.inProcessTransport = null;
+            this.inputStreamCancelled = true;
+            return;
+        }
+
         // See: https://github.com/grpc/grpc-java/issues/3095#issuecomment-338724284
         Logger.logInfo("Cancel 1");
 
@@ -183,6 +183,7 @@ public class RemoteFunctionRunnable
         remoteFunctionReturn.setExecutionStatus(result.getStatus());
         remoteFunctionReturn.setRemoteFunctionIdentifier(remoteFunctionIdentifier);
         remoteFunctionReturn.setRemoteFutureIdentifier(executionRequest.getRemoteFutureIdentifier());
+        remoteFunctionReturn.setRemoteFutureId(executionRequest.getRemoteFutureId());
 
 
         return remoteFunctionReturn.build();
@@ -27,6 +27,7 @@ from module.module_factory import ModuleFactory
 from logger.logger import Logger
 
 from local_dispatching.module_dispatcher import ModuleDispatcher
+from local_dispatching.in_process_transport import InProcessTransport
 from local_dispatching.module_manager import ModuleManager
 from module.module_factory import ModuleFactory
 from module.thread_safe_channel import ThreadSafeChannel
@@ -114,6 +115,8 @@ class CLAID():
 
             CLAID.claid_c_lib.get_log_sink_severity_level.argtypes = [ctypes.c_void_p]
             CLAID.claid_c_lib.get_log_sink_severity_level.restype = ctypes.c_int
+
+            InProcessTransport.declare_c_functions(CLAID.claid_c_lib)
         CLAID.claid_c_lib_loaded = True
     
         print("CLAID c lib loaded")
@@ -202,7 +205,8 @@ class CLAID():
 
     def attach_python_runtime(self, socket_path, module_factory):
 
-        self.__module_dispatcher = ModuleDispatcher(socket_path)
+        # The Middleware runs in this process, hence the Python Runtime exchanges packages with it in-process.
+        self.__module_dispatcher = ModuleDispatcher(socket_path, CLAID.claid_c_lib, self.__handle)
 
         self.__module_manager = ModuleManager(self.__module_dispatcher, module_factory, self.__main_thread_queue)
         print("starting Python runtime")
@@ -0,0 +1,132 @@
+###########################################################################
+# Copyright (C) 2023 ETH Zurich
+# CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+# Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+# Centre for Digital Health Interventions (c4dhi.org)
+# 
+# Authors: Patrick Langer
+# 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+#         http://www.apache.org/licenses/LICENSE-2.0
+# 
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##########################################################################
+
+from dispatch.proto.claidservice_pb2 import DataPackage
+
+from logger.logger import Logger
+
+import ctypes
+import threading
+
+# Return codes of the in_process_runtime_* functions (see capi.h).
+CLAID_TRANSPORT_TIMEOUT = -1
+CLAID_TRANSPORT_CLOSED = -2
+
+# Exchanges DataPackages with the Middleware running in the same process through the in-process transport of the CLAID library,
+# instead of the gRPC package stream. Used by the ModuleDispatcher, which falls back to gRPC if the transport cannot be attached.
+# The transport is single-producer/single-consumer in each direction: send() must only be called by one thread,
+# and only one thread may iterate over the received packages.
+class InProcessTransport:
+
+    # Timeout for waiting for packages, after which the reader checks whether it was cancelled.
+    WAIT_TIMEOUT_MS = 100
+
+    @staticmethod
+    def declare_c_functions(claid_c_lib):
+        claid_c_lib.attach_in_process_runtime.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_size_t]
+        claid_c_lib.attach_in_process_runtime.restype = ctypes.c_void_p
+
+        claid_c_lib.detach_in_process_runtime.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+        claid_c_lib.detach_in_process_runtime.restype = None
+
+        claid_c_lib.in_process_runtime_send.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_int]
+        claid_c_lib.in_process_runtime_send.restype = ctypes.c_longlong
+
+        claid_c_lib.in_process_runtime_wait.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        claid_c_lib.in_process_runtime_wait.restype = ctypes.c_longlong
+
+        claid_c_lib.in_process_runtime_receive.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+        claid_c_lib.in_process_runtime_receive.restype = ctypes.c_longlong
+
+    # Returns None if the Middleware could not attach the Runtime.
+    @staticmethod
+    def attach(claid_c_lib, middleware_handle, runtime, ring_capacity = 0):
+        transport = claid_c_lib.attach_in_process_runtime(middleware_handle, runtime, ring_capacity)
+        if not transport:
+            return None
+        return InProcessTransport(claid_c_lib, middleware_handle, transport)
+
+    def __init__(self, claid_c_lib, middleware_handle, transport):
+        self.__claid_c_lib = claid_c_lib
+        self.__middleware_handle = middleware_handle
+        self.__transport = transport
+        self.__cancelled = False
+        self.__buffer = ctypes.create_string_buffer(64 * 1024)
+
+        # Thread currently iterating over the received packages, detach() waits for it to finish.
+        self.__reader_finished = threading.Condition()
+        self.__reader_thread = None
+
+    def send(self, package):
+        data = package.SerializeToString()
+        result = self.__claid_c_lib.in_process_runtime_send(self.__transport, data, len(data), -1)
+        return result >= 0
+
+    # Received packages, same as the response iterator of the gRPC stream.
+    def __iter__(self):
+        with self.__reader_finished:
+            self.__reader_thread = threading.current_thread()
+        try:
+            yield from self.__receive_packages()
+        finally:
+            with self.__reader_finished:
+                self.__reader_thread = None
+                self.__reader_finished.notify_all()
+
+    def __receive_packages(self):
+        while not self.__cancelled and self.__transport is not None:
+            size = self.__claid_c_lib.in_process_runtime_wait(self.__transport, InProcessTransport.WAIT_TIMEOUT_MS)
+            if size == CLAID_TRANSPORT_TIMEOUT:
+                continue
+            if size < 0:
+                return
+
+            if size > len(self.__buffer):
+                self.__buffer = ctypes.create_string_buffer(size)
+
+            result = self.__claid_c_lib.in_process_runtime_receive(self.__transport, self.__buffer, len(self.__buffer))
+            if result < 0:
+                continue
+
+            package = DataPackage()
+            try:
+                package.ParseFromString(self.__buffer.raw[:result])
+            except Exception as e:
+                Logger.log_error(f"InProcessTransport received invalid package from the Middleware: {e}")
+                continue
+            yield package
+
+    # Stops the iteration over received packages, like cancel() of the gRPC stream.
+    def cancel(self):
+        self.__cancelled = True
+
+    # Closes the transport. Must not be called while packages are sent.
+    # Cancels the reader and waits until it stopped waiting for packages, unless called by the reader itself.
+    def detach(self):
+        if self.__transport is None:
+            return
+
+        self.cancel()
+        with self.__reader_finished:
+            while self.__reader_thread is not None and self.__reader_thread is not threading.current_thread():
+                self.__reader_finished.wait()
+        self.__claid_c_lib.detach_in_process_runtime(self.__middleware_handle, self.__transport)
+        self.__transport = None
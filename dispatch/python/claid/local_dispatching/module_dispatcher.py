@@ -30,10 +30,19 @@ import grpc
 from timeit import time
 
 from module.thread_safe_channel import ThreadSafeChannel
+from local_dispatching.in_process_transport import InProcessTransport
+
+import threading
 
 class ModuleDispatcher:
-    def __init__(self, socket_path):
+    # If the Middleware runs in the same process (claid_c_lib and middleware_handle are set), packages are exchanged 
+    # via the in-process transport of the CLAID library. Otherwise, or if attaching fails, the gRPC stream is used.
+    def __init__(self, socket_path, claid_c_lib = None, middleware_handle = None):
         self.socket_path = socket_path
+        self.__claid_c_lib = claid_c_lib
+        self.__middleware_handle = middleware_handle
+        self.__in_process_transport = None
+        self.__in_process_sender_thread = None
   
         self.grpc_channel = grpc.insecure_channel(socket_path)
 
@@ -133,7 +142,38 @@ class ModuleDispatcher:
                     self.__ping_package_ready = False
 
 
+    def attach_in_process(self):
+        if self.__claid_c_lib is None or not self.__middleware_handle:
+            return False
+
+        transport = InProcessTransport.attach(self.__claid_c_lib, self.__middleware_handle, Runtime.RUNTIME_PYTHON)
+        if transport is None:
+            Logger.log_warning("Failed to attach Python Runtime to the Middleware in-process, falling back to gRPC.")
+            return False
+
+        # The Middleware registers the Runtime when attaching, hence no ping package is exchanged.
+        self.__in_process_transport = transport
+        self.__from_middleware_queue = transport
+        self.__running = True
+        self.__in_process_sender_thread = threading.Thread(target=self.send_in_process)
+        self.__in_process_sender_thread.start()
+        Logger.log_info("Python Runtime attached to the Middleware in-process.")
+        return True
+
+    # Only thread sending via the in-process transport (single producer).
+    def send_in_process(self):
+        while self.__running:
+            data = self.__to_middleware_queue.get()
+            if data is None:
+                continue
+            if not self.__in_process_transport.send(data):
+                Logger.log_error("Failed to send package to the Middleware, in-process transport was closed.")
+                return
+
     def send_receive_packages(self):
+        if self.attach_in_process():
+            return True
+
         self.__ping_package_ready = False
         self.__ping_package_acknowledged = False
         self.__ping_package = None
@@ -172,6 +212,14 @@ class ModuleDispatcher:
     def shutdown(self):
         self.__running = False
         self.__to_middleware_queue.put(None)
+
+        if self.__in_process_transport is not None:
+            # The sender thread is joined here, detach() waits for the reader thread of the ModuleManager.
+            self.__in_process_transport.cancel()
+            self.__in_process_sender_thread.join()
+            self.__in_process_transport.detach()
+            self.__in_process_transport = None
+            self.__in_process_sender_thread = None
        
     # def on_middleware_stream_package_received(self, packet):
     #     Logger.log_info(f"Java Runtime received message from middleware: {packet}")
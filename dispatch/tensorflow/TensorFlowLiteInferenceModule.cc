@@ -0,0 +1,246 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/tensorflow/TensorFlowLiteInferenceModule.hh"
+
+#include <cstring>
+
+namespace claid
+{
+    void TensorFlowLiteInferenceModule::initialize(Properties properties)
+    {
+        std::string modelPath;
+        std::string dataOrder;
+        int numThreads;
+        bool useXNNPack;
+        int statisticsIntervalSeconds;
+
+        properties.getStringProperty("modelPath", modelPath);
+        properties.getStringProperty("dataOrder", dataOrder, "NHWC");
+        properties.getNumberProperty("numThreads", numThreads, 1);
+        properties.getBoolProperty("useXNNPack", useXNNPack, false);
+        properties.getNumberProperty("maxBatchSize", this->maxBatchSize, 1);
+        properties.getNumberProperty("maxBatchDelayMs", this->maxBatchDelayMs, 5);
+        properties.getNumberProperty("statisticsIntervalSeconds", statisticsIntervalSeconds, 60);
+
+        if(properties.wasAnyPropertyUnknown())
+        {
+            std::string unknownProperties;
+            properties.unknownPropertiesToString(unknownProperties);
+
+            this->moduleFatal(absl::StrCat("Missing properties: [", unknownProperties, "]. Please sepcify the properties in the configuration file."));
+            return;
+        }
+
+        LayerDataOrder layerDataOrder;
+        if(!LayerDataOrder_Parse(dataOrder, &layerDataOrder))
+        {
+            this->moduleFatal(absl::StrCat("Invalid dataOrder \"", dataOrder, "\"."));
+            return;
+        }
+
+        if(this->maxBatchSize < 1 || this->maxBatchDelayMs < 0)
+        {
+            this->moduleFatal(absl::StrCat("Invalid batching configuration: maxBatchSize ", this->maxBatchSize, 
+                ", maxBatchDelayMs ", this->maxBatchDelayMs, ". maxBatchSize has to be at least 1, maxBatchDelayMs must not be negative."));
+            return;
+        }
+
+        TensorFlowLiteNNInstance::InstanceSettings instanceSettings;
+        instanceSettings.numThreads = numThreads;
+        instanceSettings.useXNNPack = useXNNPack;
+
+        if(!this->nnInstance.setupModelFromFile(modelPath, layerDataOrder, instanceSettings))
+        {
+            this->moduleFatal(absl::StrCat("Failed to load model \"", modelPath, "\": ", this->nnInstance.getLastErrorString()));
+            return;
+        }
+
+        if(this->nnInstance.getInterpreterPtr()->inputs().size() != 1)
+        {
+            this->moduleFatal(absl::StrCat("Model \"", modelPath, "\" has ", this->nnInstance.getInterpreterPtr()->inputs().size(), 
+                " inputs, but only models with a single input are supported."));
+            return;
+        }
+
+        // The batch dimension is resized only once, partial batches use the first rows of the input tensor.
+        std::vector<int64_t> inputDimensions;
+        this->nnInstance.getInputDimensions(0, inputDimensions);
+        if(inputDimensions.empty() || inputDimensions[0] != this->maxBatchSize)
+        {
+            if(!this->nnInstance.resizeInputBatchDimension(this->maxBatchSize))
+            {
+                this->moduleFatal(absl::StrCat("Failed to resize the batch dimension of model \"", modelPath, "\" to ", this->maxBatchSize, ": ", 
+                    this->nnInstance.getLastErrorString()));
+                return;
+            }
+        }
+
+        if(!this->nnInstance.getInputTensorView(0, this->inputTensor))
+        {
+            this->moduleFatal(absl::StrCat("Unsupported input of model \"", modelPath, "\": ", this->nnInstance.getLastErrorString()));
+            return;
+        }
+        this->inputSampleNumBytes = this->inputTensor.numBytes / this->maxBatchSize;
+
+        const size_t numOutputs = this->nnInstance.getInterpreterPtr()->outputs().size();
+        this->outputSampleNumBytes.resize(numOutputs);
+        this->outputTensors.resize(numOutputs);
+        for(size_t i = 0; i < numOutputs; i++)
+        {
+            std::vector<int64_t> outputDimensions;
+            ConstTensorView outputTensor;
+            if(!this->nnInstance.getOutputDimensions(i, outputDimensions) || !this->nnInstance.getOutputTensorView(i, outputTensor))
+            {
+                this->moduleFatal(absl::StrCat("Unsupported output ", i, " of model \"", modelPath, "\": ", this->nnInstance.getLastErrorString()));
+                return;
+            }
+
+            if(outputDimensions.empty() || outputDimensions[0] != this->maxBatchSize)
+            {
+                this->moduleFatal(absl::StrCat("Output ", i, " of model \"", modelPath, "\" has no batch dimension."));
+                return;
+            }
+            this->outputSampleNumBytes[i] = outputTensor.numBytes / this->maxBatchSize;
+
+            // Everything but the data is the same for all published samples.
+            outputDimensions[0] = 1;
+            LayerData* layerData = this->outputSample.add_layers();
+            layerData->set_layer_name(this->nnInstance.getInterpreterPtr()->GetOutputName(i));
+            TensorFlowLiteNNInstance::layerDimensionFromDimensions(outputDimensions, *layerData->mutable_layer_dimension());
+            layerData->set_data_type(outputTensor.dataType);
+            layerData->set_data_order(layerDataOrder);
+        }
+
+        this->pendingSamples.reserve(this->maxBatchSize);
+
+        this->inputChannel = this->subscribe<LayerData>("InputData", &TensorFlowLiteInferenceModule::onInputData, this);
+        this->outputChannel = this->publish<LayerDataVector>("OutputData");
+
+        this->statisticsStartTime = std::chrono::steady_clock::now();
+        if(statisticsIntervalSeconds > 0)
+        {
+            this->registerPeriodicFunction("LogStatistics", &TensorFlowLiteInferenceModule::logStatistics, this, Duration::seconds(statisticsIntervalSeconds));
+        }
+    }
+
+    void TensorFlowLiteInferenceModule::onInputData(ChannelData<LayerData> data)
+    {
+        const LayerData& layerData = data.getData();
+        if(layerData.data().size() != this->inputSampleNumBytes)
+        {
+            this->moduleError(absl::StrCat("Dropping input sample of ", layerData.data().size(), " bytes, expected ", this->inputSampleNumBytes, 
+                " bytes (one sample without batch dimension)."));
+            return;
+        }
+
+        const size_t index = this->pendingSamples.size();
+        memcpy(this->inputTensor.data + index * this->inputSampleNumBytes, layerData.data().data(), this->inputSampleNumBytes);
+        this->pendingSamples.push_back(PendingSample{data.getTimestamp(), std::chrono::steady_clock::now()});
+
+        if(this->pendingSamples.size() >= static_cast<size_t>(this->maxBatchSize) || this->maxBatchDelayMs == 0)
+        {
+            this->processBatch();
+            return;
+        }
+
+        // First sample of a new batch: make sure the batch is processed after maxBatchDelayMs, even if it is not full by then.
+        if(index == 0)
+        {
+            const uint64_t batchId = this->currentBatchId;
+            this->registerScheduledFunction("ProcessBatch", Time::now() + Duration::milliseconds(this->maxBatchDelayMs), [this, batchId]()
+            {
+                // The batch might have been processed already because it became full.
+                if(batchId == this->currentBatchId && !this->pendingSamples.empty())
+                {
+                    this->processBatch();
+                }
+            });
+        }
+    }
+
+    void TensorFlowLiteInferenceModule::processBatch()
+    {
+        const size_t batchSize = this->pendingSamples.size();
+        this->currentBatchId++;
+
+        const auto inferenceStart = std::chrono::steady_clock::now();
+        if(!this->nnInstance.runInference())
+        {
+            this->moduleError(absl::StrCat("Failed to run inference on batch of ", batchSize, " samples: ", this->nnInstance.getLastErrorString()));
+            this->pendingSamples.clear();
+            return;
+        }
+        this->totalInferenceTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - inferenceStart);
+
+        for(size_t i = 0; i < this->outputTensors.size(); i++)
+        {
+            this->nnInstance.getOutputTensorView(i, this->outputTensors[i]);
+        }
+
+        for(size_t sample = 0; sample < batchSize; sample++)
+        {
+            for(size_t i = 0; i < this->outputTensors.size(); i++)
+            {
+                const size_t numBytes = this->outputSampleNumBytes[i];
+                this->outputSample.mutable_layers(i)->mutable_data()->assign(
+                    reinterpret_cast<const char*>(this->outputTensors[i].data + sample * numBytes), numBytes);
+            }
+            this->outputChannel.post(this->outputSample, this->pendingSamples[sample].timestamp);
+
+            const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - this->pendingSamples[sample].receptionTime);
+            this->totalSampleLatency += latency;
+            this->maxSampleLatency = std::max(this->maxSampleLatency, latency);
+        }
+
+        this->numProcessedSamples += batchSize;
+        this->numProcessedBatches++;
+        this->pendingSamples.clear();
+    }
+
+    void TensorFlowLiteInferenceModule::logStatistics()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsedSeconds = std::chrono::duration<double>(now - this->statisticsStartTime).count();
+
+        if(this->numProcessedBatches > 0)
+        {
+            Logger::logInfo("TensorFlowLiteInferenceModule %s: %.1f samples/s, average batch size %.2f, average inference time %.3f ms, "
+                "average latency %.3f ms, max latency %.3f ms.", 
+                this->getId().c_str(), 
+                this->numProcessedSamples / elapsedSeconds, 
+                static_cast<double>(this->numProcessedSamples) / this->numProcessedBatches,
+                this->totalInferenceTime.count() / 1000.0 / this->numProcessedBatches,
+                this->totalSampleLatency.count() / 1000.0 / this->numProcessedSamples,
+                this->maxSampleLatency.count() / 1000.0);
+        }
+
+        this->numProcessedSamples = 0;
+        this->numProcessedBatches = 0;
+        this->totalSampleLatency = std::chrono::microseconds(0);
+        this->maxSampleLatency = std::chrono::microseconds(0);
+        this->totalInferenceTime = std::chrono::microseconds(0);
+        this->statisticsStartTime = now;
+    }
+}
+
+REGISTER_MODULE(TensorFlowLiteInferenceModule, claid::TensorFlowLiteInferenceModule)
@@ -0,0 +1,95 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "dispatch/core/Module/Module.hh"
+#include "dispatch/proto/layerdata.pb.h"
+#include "dispatch/tensorflow/TensorFlowLiteNNInstance.hh"
+
+namespace claid
+{
+    class TensorFlowLiteInferenceModule : public claid::Module
+    {
+        public:
+            static void annotateModule(ModuleAnnotator& annotator)
+            {
+                annotator.setModuleCategory("MachineLearning");
+                annotator.setModuleDescription(absl::StrCat(
+                    "The TensorFlowLiteInferenceModule runs a tensorflow lite model on data arriving on the InputData channel and publishes the output of the model on the OutputData channel.\n",
+                    "Samples queued while the model is busy are combined into micro batches of up to maxBatchSize samples, ",
+                    "which are processed with a single inference. A batch is processed once it is full, or at most maxBatchDelayMs milliseconds after its first sample arrived.\n",
+                    "The model is expected to have a single input, whose first dimension is the batch dimension. The output is published per sample."
+                ));
+
+                annotator.describeProperty("modelPath", "Path to the .tflite model file.", annotator.makePathProperty());
+                annotator.describeProperty("dataOrder", "Data order of the layers of the model.", annotator.makeEnumProperty({"NHWC", "NCHW", "HWC", "CHW", "NW"}));
+                annotator.describeProperty("numThreads", "Number of threads used for a single inference.", annotator.makeIntegerProperty(1, 64));
+                annotator.describeProperty("useXNNPack", "If set to \"true\", the XNNPACK delegate is used (Linux/desktop only).", annotator.makeEnumProperty({"false", "true"}));
+                annotator.describeProperty("maxBatchSize", "Maximum number of samples processed by a single inference.", annotator.makeIntegerProperty(1, 4096));
+                annotator.describeProperty("maxBatchDelayMs", "Maximum time in milliseconds a sample waits for further samples to fill its batch.", annotator.makeIntegerProperty(0, 60000));
+                annotator.describeProperty("statisticsIntervalSeconds", "Interval for logging throughput and latency statistics. 0 disables the statistics.", annotator.makeIntegerProperty(0, 86400));
+
+                annotator.describeSubscribeChannel<LayerData>("InputData", "Input samples of the model (one sample without batch dimension per LayerData).");
+                annotator.describePublishChannel<LayerDataVector>("OutputData", "Output of the model for every input sample.");
+            }
+
+        private:
+            struct PendingSample
+            {
+                Time timestamp;
+                std::chrono::steady_clock::time_point receptionTime;
+            };
+
+            TensorFlowLiteNNInstance nnInstance;
+            Channel<LayerData> inputChannel;
+            Channel<LayerDataVector> outputChannel;
+
+            int maxBatchSize;
+            int maxBatchDelayMs;
+
+            // Input samples are written directly into the input tensor, which holds maxBatchSize samples.
+            TensorView inputTensor;
+            size_t inputSampleNumBytes;
+            std::vector<PendingSample> pendingSamples;
+            uint64_t currentBatchId = 0;
+
+            std::vector<size_t> outputSampleNumBytes;
+            std::vector<ConstTensorView> outputTensors;
+            LayerDataVector outputSample;
+
+            uint64_t numProcessedSamples = 0;
+            uint64_t numProcessedBatches = 0;
+            std::chrono::microseconds totalSampleLatency{0};
+            std::chrono::microseconds maxSampleLatency{0};
+            std::chrono::microseconds totalInferenceTime{0};
+            std::chrono::steady_clock::time_point statisticsStartTime;
+
+            void initialize(Properties properties);
+
+            void onInputData(ChannelData<LayerData> data);
+            void processBatch();
+            void logStatistics();
+    };
+}
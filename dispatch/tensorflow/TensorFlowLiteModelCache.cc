@@ -0,0 +1,79 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/tensorflow/TensorFlowLiteModelCache.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+namespace claid
+{
+    TensorFlowLiteModelCache* TensorFlowLiteModelCache::getInstance()
+    {
+        // Instances of TensorFlowLiteNNInstance might be set up concurrently by different Modules.
+        static TensorFlowLiteModelCache instance;
+        return &instance;
+    }
+
+    std::shared_ptr<tflite::FlatBufferModel> TensorFlowLiteModelCache::getModel(const std::string& modelFile)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        auto it = this->models.find(modelFile);
+        if(it != this->models.end())
+        {
+            std::shared_ptr<tflite::FlatBufferModel> model = it->second.lock();
+            if(model != nullptr)
+            {
+                return model;
+            }
+        }
+
+        std::shared_ptr<tflite::FlatBufferModel> model(tflite::FlatBufferModel::BuildFromFile(modelFile.c_str()));
+        if(model == nullptr)
+        {
+            Logger::logError("TensorFlowLiteModelCache: Failed to load model from file \"%s\".", modelFile.c_str());
+            return nullptr;
+        }
+
+        Logger::logInfo("TensorFlowLiteModelCache: Loaded model \"%s\".", modelFile.c_str());
+        this->models[modelFile] = model;
+        return model;
+    }
+
+    size_t TensorFlowLiteModelCache::getNumCachedModels()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        size_t numModels = 0;
+        for(auto it = this->models.begin(); it != this->models.end(); )
+        {
+            if(it->second.expired())
+            {
+                it = this->models.erase(it);
+            }
+            else
+            {
+                numModels++;
+                it++;
+            }
+        }
+        return numModels;
+    }
+}
@@ -0,0 +1,58 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "tensorflow/lite/model.h"
+
+namespace claid
+{
+    /**
+     * Process-wide cache of tensorflow lite models loaded from files.
+     * 
+     * FlatBufferModel::BuildFromFile memory-maps the model file. Models are immutable and
+     * can be shared by any number of interpreters, hence every file is mapped only once,
+     * no matter how many TensorFlowLiteNNInstances use it. A model is unmapped as soon as
+     * the last instance using it is destroyed.
+     */
+    class TensorFlowLiteModelCache
+    {
+        public:
+            static TensorFlowLiteModelCache* getInstance();
+
+            // Returns the cached model of the given file, or loads it if it is not cached (anymore).
+            // Returns nullptr if the model could not be loaded.
+            std::shared_ptr<tflite::FlatBufferModel> getModel(const std::string& modelFile);
+
+            size_t getNumCachedModels();
+
+        private:
+            TensorFlowLiteModelCache() = default;
+
+            std::mutex mutex;
+            std::map<std::string, std::weak_ptr<tflite::FlatBufferModel>> models;
+    };
+}
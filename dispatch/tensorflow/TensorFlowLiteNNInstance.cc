@@ -70,15 +70,34 @@ claid::TensorFlowLiteNNInstance::
  * model file does not exist or is invalid).
  */
 bool claid::TensorFlowLiteNNInstance::setupModelFromFile(const std::string& modelFile, LayerDataOrder networkLayerDataOrder, const int numThreads)
+{
+	InstanceSettings instanceSettings;
+	instanceSettings.numThreads = numThreads;
+	return this->setupModelFromFile(modelFile, networkLayerDataOrder, instanceSettings);
+}
+
+/**
+ * @brief Parses a tensorflow lite model file and
+ * instantiates a tensorflowlite interpreter using the given settings (threads, delegates).
+ * The model is memory-mapped only once per process and shared with
+ * all other instances using the same file (see TensorFlowLiteModelCache).
+ * 
+ * @param modelFile Path to a tensorflow lite model file.
+ * @param networkLayerDataOrder Data order of the network, e.g. NCHW or HWC
+ * @param instanceSettings Number of threads and delegates to use for inference.
+ * @return true if network was loaded and instantiated successfully, false otherwise (e.g.
+ * model file does not exist or is invalid).
+ */
+bool claid::TensorFlowLiteNNInstance::setupModelFromFile(const std::string& modelFile, LayerDataOrder networkLayerDataOrder, const InstanceSettings& instanceSettings)
 {
 	this->networkLayerDataOrder = networkLayerDataOrder;
+	this->instanceSettings = instanceSettings;
+	const int numThreads = instanceSettings.numThreads;
     claid::Logger::logInfo("Checking if file exists");
 	if(fileExists(modelFile))
 	{
         claid::Logger::logInfo("Building model");
-		this->model =
-				tflite::FlatBufferModel::BuildFromFile(modelFile.c_str(),
-						NULL);
+		this->model = TensorFlowLiteModelCache::getInstance()->getModel(modelFile);
 
 
 		if (this->model)
@@ -112,8 +131,31 @@ bool claid::TensorFlowLiteNNInstance::setupModelFromFile(const std::string& mode
 						claid::Logger::logInfo("GPU support enabled.");
 					}
 				#endif
+				#if __TFNN_USE_XNNPACK == 1
+					if(this->instanceSettings.useXNNPack)
+					{
+						// The previous interpreter (if any) has been replaced above, hence its delegate is not used anymore.
+						if(this->xnnpackDelegate != nullptr)
+						{
+							TfLiteXNNPackDelegateDelete(this->xnnpackDelegate);
+						}
+						TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+						options.num_threads = numThreads;
+						this->xnnpackDelegate = TfLiteXNNPackDelegateCreate(&options);
+
+						if (this->tfLiteInterpreter->ModifyGraphWithDelegate(this->xnnpackDelegate) != kTfLiteOk)
+						{
+							claid::Logger::logInfo("Failed to ModifyGraphWithDelegate, cannot use XNNPACK.");
+							this->lastError = TensorFlowLiteNNInstance::ErrorType::
+									ERROR_MODIFY_GRAPH_WITH_DELEGATE_XNNPACK;
+							return false;
+						}
+						claid::Logger::logInfo("XNNPACK delegate enabled with %d threads.", numThreads);
+					}
+				#endif
 				if (this->tfLiteInterpreter->AllocateTensors() == kTfLiteOk)
 				{
+					this->updateTensorInfos();
                     claid::Logger::logInfo("tensors size: %d", this->tfLiteInterpreter->tensors_size());
                     claid::Logger::logInfo("nodes size: %d", this->tfLiteInterpreter->nodes_size());
                     claid::Logger::logInfo("inputs: %d", this->tfLiteInterpreter->inputs().size());
@@ -173,6 +215,7 @@ bool claid::
 				AAssetManager* const assetManager, const std::string& modelFile, LayerDataOrder networkLayerDataOrder, const int numThreads)
 {
 	this->networkLayerDataOrder = networkLayerDataOrder;
+	this->instanceSettings.numThreads = numThreads;
 
     // Workaround for testing.
     //return this->setupModelFromFile();
@@ -256,6 +299,7 @@ bool claid::
 			if (this->tfLiteInterpreter->AllocateTensors() == kTfLiteOk)
 			{
 				claid::Logger::logInfo("Tensors allocated.");
+				this->updateTensorInfos();
 				claid::Logger::logInfo("tensors size: %d", this->tfLiteInterpreter->tensors_size());
 				claid::Logger::logInfo("nodes size: %d", this->tfLiteInterpreter->nodes_size());
 				claid::Logger::logInfo("inputs: %d", this->tfLiteInterpreter->inputs().size());
@@ -301,35 +345,32 @@ bool claid::
  */
 bool claid::TensorFlowLiteNNInstance::applyInput(const size_t inputID, const void* data, const size_t numBytes)
 {
-
-	// get input dimension from the input tensor metadata
-	// assuming one input only
-
-	int input = this->tfLiteInterpreter->inputs()[inputID];
-	TfLiteTensor* inputTensor = this->tfLiteInterpreter->tensor(input);
-
-	TfLiteIntArray* dims = inputTensor->dims;
-
-	size_t expectedNumBytes;
-	if(!this->getLayerDataTypeNumBytesFromTensor(inputTensor, expectedNumBytes))
+	if(inputID >= this->inputTensorInfos.size())
 	{
-		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_DATA_TYPE;
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_INVALID_LAYER_ID;
 		return false;
 	}
 
-	for(int i = 0; i < dims->size; i++)
+	const TensorInfo& tensorInfo = this->inputTensorInfos[inputID];
+	if(!tensorInfo.knownNumBytes)
 	{
-		expectedNumBytes *= dims->data[i];
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_DATA_TYPE;
+		return false;
 	}
 
-	if(numBytes != expectedNumBytes)
+	if(numBytes != tensorInfo.numBytes)
 	{
 		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_APPLY_INPUT_BYTE_MISMATCH;
 		return false;
 	}
 
-	void* inputArray = inputTensor->data.data;
-	memcpy(inputArray, data, numBytes);
+	void* inputArray = this->tfLiteInterpreter->tensor(tensorInfo.tensorIndex)->data.raw;
+
+	// The data might have been written to the tensor directly (see getInputTensorView).
+	if(inputArray != data)
+	{
+		memcpy(inputArray, data, numBytes);
+	}
 
 	return true;
 }
@@ -377,97 +418,281 @@ bool claid::TensorFlowLiteNNInstance::runInference()
  * Copies data from the output layer(s) into a vector of LayerData objects.
  * An object is inserted into the vector for each output layer, containing the
  * data of the layer as well as a description of the layer (name, dimension, etc.).
+ * LayerData objects already contained in the vector are reused, hence no memory
+ * is allocated if the same vector is passed for every inference.
  * 
  * @param layerDataVector Output layer data vector. 
  * @return true if data was copied successfully, false otherwise.
  */
 bool claid::TensorFlowLiteNNInstance::getOutputLayerData(LayerDataVector& layerDataVector)
 {
-	layerDataVector.Clear();
-
-	size_t outputLayers = this->tfLiteInterpreter->outputs().size();
+	const int outputLayers = static_cast<int>(this->outputTensorInfos.size());
 
-	for(size_t i = 0; i < outputLayers; i++)
+	while(layerDataVector.layers_size() > outputLayers)
 	{
-		const int tfliteIDOfOutputLayer = this->tfLiteInterpreter->outputs()[i];
-		TfLiteTensor* outputTensor = this->tfLiteInterpreter->tensor(tfliteIDOfOutputLayer);
+		layerDataVector.mutable_layers()->RemoveLast();
+	}
+	while(layerDataVector.layers_size() < outputLayers)
+	{
+		layerDataVector.add_layers();
+	}
 
-		LayerDataType layerDataType;
+	for(int i = 0; i < outputLayers; i++)
+	{
+		const TensorInfo& tensorInfo = this->outputTensorInfos[i];
 
-		if(!this->layerDataTypeFromTensor(outputTensor, layerDataType))
+		if(!tensorInfo.supportedDataType)
 		{
 			this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_OUTPUT_TYPE;
 			return false;
 		}
 
-		std::vector<int64_t> dimensions;
-		this->getDimensionVectorFromTensor(outputTensor, dimensions);
-		
-		size_t numBytes;
-		if(!this->getLayerDataTypeNumBytesFromTensor(outputTensor, numBytes))
+		if(!tensorInfo.knownNumBytes)
 		{
 			this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_DATA_TYPE;
 			return false;
 		}
 
+		const TfLiteTensor* outputTensor = this->tfLiteInterpreter->tensor(tensorInfo.tensorIndex);
+
+		// Assigning to the existing fields reuses their buffers.
+		LayerData& layerData = *layerDataVector.mutable_layers(i);
+		*layerData.mutable_layer_dimension() = tensorInfo.layerDimension;
+		if(layerData.layer_name() != tensorInfo.layerName)
+		{
+			layerData.set_layer_name(tensorInfo.layerName);
+		}
+		layerData.set_data_order(this->networkLayerDataOrder);
+		layerData.mutable_data()->assign(outputTensor->data.raw, tensorInfo.numBytes);
+		layerData.set_data_type(tensorInfo.dataType);
+	}
+	return true;
+}
+
+/**
+ * Retrieves a view of the buffer of the input tensor with the given id.
+ * Data written to the view is used as input of the network by the next call of runInference(),
+ * hence calling applyInput(...) is not necessary.
+ * 
+ * @param inputID Input layer ID.
+ * @param view Output view of the tensor buffer. Valid until the tensors are allocated again.
+ * @return true if the view was retrieved successfully, false otherwise (e.g. invalid layer id or unsupported data type).
+ */
+bool claid::TensorFlowLiteNNInstance::getInputTensorView(const size_t inputID, TensorView& view)
+{
+	if(inputID >= this->inputTensorInfos.size())
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_INVALID_LAYER_ID;
+		return false;
+	}
+
+	const TensorInfo& tensorInfo = this->inputTensorInfos[inputID];
+	if(!tensorInfo.supportedDataType || !tensorInfo.knownNumBytes)
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_INPUT_TYPE;
+		return false;
+	}
+
+	view.data = reinterpret_cast<uint8_t*>(this->tfLiteInterpreter->tensor(tensorInfo.tensorIndex)->data.raw);
+	view.numBytes = tensorInfo.numBytes;
+	view.dataType = tensorInfo.dataType;
+	return true;
+}
+
+/**
+ * Retrieves a read-only view of the buffer of the output tensor with the given id, 
+ * allowing to read the output of the network without copying it.
+ * The view reflects the result of the latest call of runInference().
+ * 
+ * @param outputID Output layer ID.
+ * @param view Output view of the tensor buffer. Valid until the tensors are allocated again.
+ * @return true if the view was retrieved successfully, false otherwise (e.g. invalid layer id or unsupported data type).
+ */
+bool claid::TensorFlowLiteNNInstance::getOutputTensorView(const size_t outputID, ConstTensorView& view)
+{
+	if(outputID >= this->outputTensorInfos.size())
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_INVALID_LAYER_ID;
+		return false;
+	}
+
+	const TensorInfo& tensorInfo = this->outputTensorInfos[outputID];
+	if(!tensorInfo.supportedDataType || !tensorInfo.knownNumBytes)
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_OUTPUT_TYPE;
+		return false;
+	}
+
+	view.data = reinterpret_cast<const uint8_t*>(this->tfLiteInterpreter->tensor(tensorInfo.tensorIndex)->data.raw);
+	view.numBytes = tensorInfo.numBytes;
+	view.dataType = tensorInfo.dataType;
+	return true;
+}
+
+/**
+ * Determines the information (name, data type, dimension and size) of all input and output tensors.
+ * Has to be called whenever the tensors have been allocated.
+ */
+void claid::TensorFlowLiteNNInstance::updateTensorInfos()
+{
+	const size_t numInputs = this->tfLiteInterpreter->inputs().size();
+	this->inputTensorInfos.resize(numInputs);
+	for(size_t i = 0; i < numInputs; i++)
+	{
+		this->getTensorInfo(this->tfLiteInterpreter->inputs()[i], this->tfLiteInterpreter->GetInputName(i), this->inputTensorInfos[i]);
+	}
+
+	const size_t numOutputs = this->tfLiteInterpreter->outputs().size();
+	this->outputTensorInfos.resize(numOutputs);
+	for(size_t i = 0; i < numOutputs; i++)
+	{
+		this->getTensorInfo(this->tfLiteInterpreter->outputs()[i], this->tfLiteInterpreter->GetOutputName(i), this->outputTensorInfos[i]);
+	}
+}
+
+void claid::TensorFlowLiteNNInstance::getTensorInfo(int tensorIndex, const char* layerName, TensorInfo& tensorInfo)
+{
+	TfLiteTensor* tensor = this->tfLiteInterpreter->tensor(tensorIndex);
+
+	tensorInfo.tensorIndex = tensorIndex;
+	tensorInfo.layerName = layerName;
+	tensorInfo.supportedDataType = this->layerDataTypeFromTensor(tensor, tensorInfo.dataType);
+	tensorInfo.knownNumBytes = this->getLayerDataTypeNumBytesFromTensor(tensor, tensorInfo.numBytes);
+
+	std::vector<int64_t> dimensions;
+	this->getDimensionVectorFromTensor(tensor, dimensions);
+
+	if(tensorInfo.knownNumBytes)
+	{
 		for(size_t i = 0; i < dimensions.size(); i++)
 		{
-			numBytes *= dimensions[i];
+			tensorInfo.numBytes *= dimensions[i];
 		}
-		LayerData* layerData = layerDataVector.add_layers();
-		LayerDimension* layerDimensionPtr = layerData->mutable_layer_dimension();
-		LayerDimension& layerDimension = *layerDimensionPtr;
+	}
 
-		switch(dimensions.size())
+	layerDimensionFromDimensions(dimensions, tensorInfo.layerDimension);
+}
+
+/**
+ * Converts the dimensions of a tensor to a LayerDimension.
+ * Tensors with less than 4 dimensions are assumed to have a batch size of 1.
+ * 
+ * @param dimensions Dimensions of a tensor, e.g. (N, H, W, C).
+ * @param layerDimension Output LayerDimension.
+ */
+void claid::TensorFlowLiteNNInstance::layerDimensionFromDimensions(const std::vector<int64_t>& dimensions, LayerDimension& layerDimension)
+{
+	layerDimension.Clear();
+	switch(dimensions.size())
+	{
+		case 4:
 		{
-			case 4:
-			{
-				layerDimension.set_numbatches(dimensions[0]);
-				layerDimension.set_height(dimensions[1]);
-				layerDimension.set_width(dimensions[2]);
-				layerDimension.set_channels(dimensions[3]);
-			}
-			break;
-			case 3:
-			{
-				layerDimension.set_numbatches(1);
-				layerDimension.set_height(dimensions[0]);
-				layerDimension.set_width(dimensions[1]);
-				layerDimension.set_channels(dimensions[2]);
-			}
-			break;
-			case 2:
-			{
-				layerDimension.set_numbatches(1);
-				layerDimension.set_height(1);
-				layerDimension.set_width(dimensions[0]);
-				layerDimension.set_channels(dimensions[1]);
-			}
-			break;
-			case 1:
-			{
-				layerDimension.set_numbatches(1);
-				layerDimension.set_height(1);
-				layerDimension.set_width(1);
-				layerDimension.set_channels(dimensions[0]);
-			}
-			break;
+			layerDimension.set_numbatches(dimensions[0]);
+			layerDimension.set_height(dimensions[1]);
+			layerDimension.set_width(dimensions[2]);
+			layerDimension.set_channels(dimensions[3]);
+		}
+		break;
+		case 3:
+		{
+			layerDimension.set_numbatches(1);
+			layerDimension.set_height(dimensions[0]);
+			layerDimension.set_width(dimensions[1]);
+			layerDimension.set_channels(dimensions[2]);
 		}
+		break;
+		case 2:
+		{
+			layerDimension.set_numbatches(1);
+			layerDimension.set_height(1);
+			layerDimension.set_width(dimensions[0]);
+			layerDimension.set_channels(dimensions[1]);
+		}
+		break;
+		case 1:
+		{
+			layerDimension.set_numbatches(1);
+			layerDimension.set_height(1);
+			layerDimension.set_width(1);
+			layerDimension.set_channels(dimensions[0]);
+		}
+		break;
+	}
+}
+
 
-		const std::string layerName = this->tfLiteInterpreter->GetOutputName(i);
+/**
+ * Retrieves the dimensions of the input tensor with the given id.
+ * 
+ * @param inputID Input layer ID.
+ * @param dimensions Output dimensions of the tensor.
+ * @return true if the layer ID is valid, false otherwise.
+ */
+bool claid::TensorFlowLiteNNInstance::getInputDimensions(const size_t inputID, std::vector<int64_t>& dimensions)
+{
+	if(inputID >= this->inputTensorInfos.size())
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_INVALID_LAYER_ID;
+		return false;
+	}
+	this->getDimensionVectorFromTensor(this->tfLiteInterpreter->tensor(this->inputTensorInfos[inputID].tensorIndex), dimensions);
+	return true;
+}
 
+/**
+ * Retrieves the dimensions of the output tensor with the given id.
+ * 
+ * @param outputID Output layer ID.
+ * @param dimensions Output dimensions of the tensor.
+ * @return true if the layer ID is valid, false otherwise.
+ */
+bool claid::TensorFlowLiteNNInstance::getOutputDimensions(const size_t outputID, std::vector<int64_t>& dimensions)
+{
+	if(outputID >= this->outputTensorInfos.size())
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_INVALID_LAYER_ID;
+		return false;
+	}
+	this->getDimensionVectorFromTensor(this->tfLiteInterpreter->tensor(this->outputTensorInfos[outputID].tensorIndex), dimensions);
+	return true;
+}
 
+/**
+ * Sets the first (batch) dimension of all input tensors, which allows to run inference 
+ * on multiple samples at once. The tensors are reallocated, the output dimensions
+ * are determined by the interpreter accordingly.
+ * 
+ * @param batchSize New size of the first dimension of all input tensors.
+ * @return true if the tensors were resized and reallocated successfully, false otherwise.
+ */
+bool claid::TensorFlowLiteNNInstance::resizeInputBatchDimension(const int batchSize)
+{
+	for(size_t i = 0; i < this->inputTensorInfos.size(); i++)
+	{
+		std::vector<int64_t> dimensions;
+		this->getInputDimensions(i, dimensions);
+		if(dimensions.empty())
+		{
+			this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_UNSUPPORTED_INPUT_TYPE;
+			return false;
+		}
 
-		void* data = outputTensor->data.f;
-		// LayerDimension is set via mutable_layer_dimension above.
-		// layerData->set_layer_dimension(layerDimension);
-		layerData->set_layer_name(layerName);
-		layerData->set_data_order(this->networkLayerDataOrder);
-		layerData->set_data(data, numBytes);
-		layerData->set_data_type(layerDataType);
+		std::vector<int> newDimensions(dimensions.begin(), dimensions.end());
+		newDimensions[0] = batchSize;
+		if(this->tfLiteInterpreter->ResizeInputTensor(this->inputTensorInfos[i].tensorIndex, newDimensions) != kTfLiteOk)
+		{
+			this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_FAILED_TO_ALLOCATE_TENSORS;
+			return false;
+		}
+	}
 
- 		
+	if(this->tfLiteInterpreter->AllocateTensors() != kTfLiteOk)
+	{
+		this->lastError = TensorFlowLiteNNInstance::ErrorType::ERROR_NN_FAILED_TO_ALLOCATE_TENSORS;
+		return false;
 	}
+
+	this->updateTensorInfos();
 	return true;
 }
 
@@ -502,9 +727,13 @@ std::string claid::TensorFlowLiteNNInstance::getLastErrorString() const
 	"ERROR_NN_INVOKE_FAILED",
 	"ERROR_APPLY_INPUT_BYTE_MISMATCH",
 	"ERROR_CANNOT_FIND_INPUT_LAYER_ID_BY_NAME",
+	"ERROR_INVALID_LAYER_ID",
 	#if __TFNN_USE_GPU == 1
 	"ERROR_MODIFY_GRAPH_WITH_DELEGATE_GPU",
 	#endif
+	#if __TFNN_USE_XNNPACK == 1
+	"ERROR_MODIFY_GRAPH_WITH_DELEGATE_XNNPACK",
+	#endif
 	"ERROR_TFNN_CLASSIFIER_INVALID_LABELS_FILE",
 
 	#ifdef __ANDROID__
@@ -871,6 +1100,10 @@ size_t claid::TensorFlowLiteNNInstance::getLayerDataNumBytes(const LayerData& la
  */
 claid::TensorFlowLiteNNInstance::~TensorFlowLiteNNInstance()
 {
+	// The interpreter has to be destroyed before the delegates and the model it uses.
+	this->tfLiteInterpreter.reset();
+	this->model = nullptr;
+
     #ifdef __ANDROID__
         delete[] this->flatBuffersBuffer;
     #endif
@@ -881,7 +1114,12 @@ claid::TensorFlowLiteNNInstance::~TensorFlowLiteNNInstance()
 			TfLiteGpuDelegateDelete(this->gpuDelegate);
 		}
 	#endif
-	
-	this->tfLiteInterpreter.release();
+
+	#if __TFNN_USE_XNNPACK == 1
+		if(this->xnnpackDelegate != nullptr)
+		{
+			TfLiteXNNPackDelegateDelete(this->xnnpackDelegate);
+		}
+	#endif
 }
 
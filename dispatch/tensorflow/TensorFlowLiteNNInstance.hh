@@ -28,6 +28,7 @@
 #include <cstdint>
 
 #include <string>
+#include <vector>
 
 
 
@@ -39,6 +40,7 @@
 #include "tensorflow/lite/string_util.h"
 
 #include "dispatch/proto/layerdata.pb.h"
+#include "dispatch/tensorflow/TensorFlowLiteModelCache.hh"
 
 using namespace claid;
 
@@ -56,6 +58,11 @@ using namespace claid;
 	#define TFLITE_USE_GPU_DELEGATE 1
 #endif
 
+// Defined for Linux/desktop builds (see BUILD.bazel).
+#if __TFNN_USE_XNNPACK == 1
+	#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#endif
+
 
 
 namespace claid
@@ -79,6 +86,34 @@ namespace claid
      * unsupported types, etc.).
      * 
      */
+    /**
+     * Non-owning view of the buffer of an input or output tensor of a TensorFlowLiteNNInstance.
+     * Views stay valid until the tensors of the instance are (re)allocated, e.g. by setting up
+     * the model again. Writing to the view of an input tensor directly sets the input of the network.
+     */
+    template<typename ByteType>
+    struct BasicTensorView
+    {
+        ByteType* data = nullptr;
+        size_t numBytes = 0;
+        LayerDataType dataType = LayerDataType::FLOAT32;
+
+        template<typename T>
+        T* as() const
+        {
+            return reinterpret_cast<T*>(data);
+        }
+
+        template<typename T>
+        size_t numElements() const
+        {
+            return numBytes / sizeof(T);
+        }
+    };
+
+    typedef BasicTensorView<uint8_t> TensorView;
+    typedef BasicTensorView<const uint8_t> ConstTensorView;
+
     class TensorFlowLiteNNInstance
     {
 
@@ -118,10 +153,16 @@ namespace claid
                 // If a name for an input layer was given that we don't know (e.g. in getInputIDFromLayerName(...)).
                 ERROR_CANNOT_FIND_INPUT_LAYER_ID_BY_NAME,
 
+                // If an input or output layer ID is out of range.
+                ERROR_INVALID_LAYER_ID,
+
                 // If ModifyGraphWithDelegate() failed
                 #if __TFNN_USE_GPU == 1
                 ERROR_MODIFY_GRAPH_WITH_DELEGATE_GPU,
                 #endif
+                #if __TFNN_USE_XNNPACK == 1
+                ERROR_MODIFY_GRAPH_WITH_DELEGATE_XNNPACK,
+                #endif
                 // ====== TensorflowNNIntegrationClassifier ====== //
 
                 // If the specified labels file does not exist
@@ -135,6 +176,15 @@ namespace claid
                 #endif
             };
 
+            struct InstanceSettings
+            {
+                // Number of threads used by the interpreter (or delegate) for a single inference.
+                int numThreads = 1;
+                bool useGPU = false;
+                // Only available on Linux/desktop builds, ignored otherwise.
+                bool useXNNPack = false;
+            };
+
         private:
 
             uint8_t* inputVector;
@@ -144,20 +194,50 @@ namespace claid
             #endif
 
         protected:
-            std::unique_ptr<tflite::FlatBufferModel> model;
+            // Models loaded from files are shared with other instances via the TensorFlowLiteModelCache.
+            std::shared_ptr<tflite::FlatBufferModel> model;
             std::unique_ptr<tflite::Interpreter> tfLiteInterpreter;
-            tflite::ops::builtin::BuiltinOpResolver resolver;
+
+            #if __TFNN_USE_XNNPACK == 1
+                // Delegates are applied explicitly according to the InstanceSettings.
+                tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+                TfLiteDelegate* xnnpackDelegate = nullptr;
+            #else
+                tflite::ops::builtin::BuiltinOpResolver resolver;
+            #endif
 
             #if __TFNN_USE_GPU == 1
                 TfLiteDelegate* gpuDelegate;
             #endif
 
+            InstanceSettings instanceSettings;
+
             LayerDataOrder networkLayerDataOrder;
 
             ErrorType lastError;
 
+            // Information about the input and output tensors, determined once after the tensors have been allocated,
+            // so that inference does not have to query names and dimensions from the interpreter every time.
+            struct TensorInfo
+            {
+                int tensorIndex;
+                std::string layerName;
+                // Whether the data type can be represented as LayerDataType.
+                bool supportedDataType;
+                LayerDataType dataType;
+                LayerDimension layerDimension;
+                // Whether the size of the data type is known, i.e. numBytes is valid.
+                bool knownNumBytes;
+                size_t numBytes;
+            };
+            std::vector<TensorInfo> inputTensorInfos;
+            std::vector<TensorInfo> outputTensorInfos;
+
             bool fileExists(const std::string& name);
 
+            void updateTensorInfos();
+            void getTensorInfo(int tensorIndex, const char* layerName, TensorInfo& tensorInfo);
+
 
 
 
@@ -168,6 +248,7 @@ namespace claid
 
 
             bool setupModelFromFile(const std::string& modelFile, LayerDataOrder networkLayerDataOrder, const int numThreads = 1);
+            bool setupModelFromFile(const std::string& modelFile, LayerDataOrder networkLayerDataOrder, const InstanceSettings& instanceSettings);
 
             #ifdef __ANDROID__
                 bool setupModelFromAssets(AAssetManager* const assetManager, const std::string& modelFile, LayerDataOrder networkLayerDataOrder, const int numThreads = 1);
@@ -189,6 +270,18 @@ namespace claid
             bool getLayerDataTypeNumBytesFromTensor(TfLiteTensor* tensor, size_t& numBytes);
             bool getOutputLayerData(LayerDataVector& layerDataVector);
 
+            bool getInputTensorView(const size_t inputID, TensorView& view);
+            bool getOutputTensorView(const size_t outputID, ConstTensorView& view);
+
+            bool getInputDimensions(const size_t inputID, std::vector<int64_t>& dimensions);
+            bool getOutputDimensions(const size_t outputID, std::vector<int64_t>& dimensions);
+
+            // Sets the first (batch) dimension of all input tensors and reallocates the tensors.
+            // Invalidates all TensorViews.
+            bool resizeInputBatchDimension(const int batchSize);
+
+            static void layerDimensionFromDimensions(const std::vector<int64_t>& dimensions, LayerDimension& layerDimension);
+
             bool getInputLayerNumBytes(const size_t inputID, size_t& dimensions);
             bool getOutputLayerNumBytes(const size_t inputID, size_t& dimensions);
 
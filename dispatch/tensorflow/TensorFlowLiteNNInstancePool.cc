@@ -0,0 +1,133 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "dispatch/tensorflow/TensorFlowLiteNNInstancePool.hh"
+
+namespace claid
+{
+    TensorFlowLiteNNInstancePool::Lease::Lease(TensorFlowLiteNNInstancePool* pool, TensorFlowLiteNNInstance* instance) : 
+        pool(pool), instance(instance)
+    {
+    }
+
+    TensorFlowLiteNNInstancePool::Lease::Lease(Lease&& other) : pool(other.pool), instance(other.instance)
+    {
+        other.instance = nullptr;
+    }
+
+    TensorFlowLiteNNInstancePool::Lease::~Lease()
+    {
+        if(this->instance != nullptr)
+        {
+            this->pool->release(this->instance);
+        }
+    }
+
+    bool TensorFlowLiteNNInstancePool::setupModelFromFile(const std::string& modelFile, LayerDataOrder networkLayerDataOrder, 
+        size_t poolSize, const TensorFlowLiteNNInstance::InstanceSettings& instanceSettings)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if(this->availableInstances.size() != this->instances.size())
+        {
+            this->lastErrorString = "Cannot set up TensorFlowLiteNNInstancePool while instances are in use.";
+            return false;
+        }
+
+        this->instances.clear();
+        this->availableInstances.clear();
+
+        if(poolSize == 0)
+        {
+            this->lastErrorString = "Cannot set up TensorFlowLiteNNInstancePool with a pool size of 0.";
+            return false;
+        }
+
+        for(size_t i = 0; i < poolSize; i++)
+        {
+            std::unique_ptr<TensorFlowLiteNNInstance> instance(new TensorFlowLiteNNInstance());
+            if(!instance->setupModelFromFile(modelFile, networkLayerDataOrder, instanceSettings))
+            {
+                this->lastErrorString = instance->getLastErrorString();
+                Logger::logError("TensorFlowLiteNNInstancePool: Failed to set up instance %zu of model \"%s\": %s", 
+                    i, modelFile.c_str(), this->lastErrorString.c_str());
+                this->instances.clear();
+                this->availableInstances.clear();
+                return false;
+            }
+            this->availableInstances.push_back(instance.get());
+            this->instances.push_back(std::move(instance));
+        }
+        return true;
+    }
+
+    TensorFlowLiteNNInstancePool::Lease TensorFlowLiteNNInstancePool::acquire()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(this->instances.empty())
+        {
+            Logger::logError("TensorFlowLiteNNInstancePool: Cannot acquire an instance, the pool has no instances. Was setupModelFromFile successful?");
+            return Lease(this, nullptr);
+        }
+        this->instanceAvailable.wait(lock, [this]{ return !this->availableInstances.empty(); });
+
+        TensorFlowLiteNNInstance* instance = this->availableInstances.back();
+        this->availableInstances.pop_back();
+        return Lease(this, instance);
+    }
+
+    void TensorFlowLiteNNInstancePool::release(TensorFlowLiteNNInstance* instance)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->availableInstances.push_back(instance);
+        }
+        this->instanceAvailable.notify_one();
+    }
+
+    bool TensorFlowLiteNNInstancePool::runInference(const LayerDataVector& input, LayerDataVector& output)
+    {
+        Lease instance = this->acquire();
+        if(!instance.isValid())
+        {
+            return false;
+        }
+
+        for(const LayerData& layerData : input.layers())
+        {
+            if(!instance->applyInput(layerData))
+            {
+                return false;
+            }
+        }
+
+        return instance->runInference() && instance->getOutputLayerData(output);
+    }
+
+    size_t TensorFlowLiteNNInstancePool::size() const
+    {
+        return this->instances.size();
+    }
+
+    std::string TensorFlowLiteNNInstancePool::getLastErrorString() const
+    {
+        return this->lastErrorString;
+    }
+}
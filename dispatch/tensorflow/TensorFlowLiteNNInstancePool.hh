@@ -0,0 +1,101 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dispatch/tensorflow/TensorFlowLiteNNInstance.hh"
+
+namespace claid
+{
+    /**
+     * Pool of TensorFlowLiteNNInstances of the same model, which allows to run inference
+     * from multiple threads (e.g., multiple Modules or RemoteFunction callers) in parallel.
+     * A single tflite interpreter is not thread-safe, hence each caller acquires an instance
+     * exclusively for the duration of an inference. All instances share the same memory-mapped model.
+     */
+    class TensorFlowLiteNNInstancePool
+    {
+        public:
+
+            // Exclusive access to an instance of the pool, which is returned to the pool when the Lease is destroyed.
+            class Lease
+            {
+                public:
+                    Lease(TensorFlowLiteNNInstancePool* pool, TensorFlowLiteNNInstance* instance);
+                    Lease(Lease&& other);
+                    ~Lease();
+
+                    Lease(const Lease&) = delete;
+                    Lease& operator=(const Lease&) = delete;
+
+                    TensorFlowLiteNNInstance* operator->() const
+                    {
+                        return this->instance;
+                    }
+
+                    TensorFlowLiteNNInstance& operator*() const
+                    {
+                        return *this->instance;
+                    }
+
+                    // False if the pool has no instances (e.g., because the setup failed).
+                    bool isValid() const
+                    {
+                        return this->instance != nullptr;
+                    }
+
+                private:
+                    TensorFlowLiteNNInstancePool* pool;
+                    TensorFlowLiteNNInstance* instance;
+            };
+
+            // Creates poolSize instances of the model. Returns false if any of them could not be set up.
+            bool setupModelFromFile(const std::string& modelFile, LayerDataOrder networkLayerDataOrder, 
+                size_t poolSize, const TensorFlowLiteNNInstance::InstanceSettings& instanceSettings);
+
+            // Blocks until an instance is available.
+            // Returns an invalid Lease immediately if the pool has no instances, as none would ever become available.
+            Lease acquire();
+
+            // Convenience function which applies the input, runs inference and retrieves the output on an instance of the pool.
+            bool runInference(const LayerDataVector& input, LayerDataVector& output);
+
+            size_t size() const;
+            std::string getLastErrorString() const;
+
+        private:
+            void release(TensorFlowLiteNNInstance* instance);
+
+            std::vector<std::unique_ptr<TensorFlowLiteNNInstance>> instances;
+
+            std::mutex mutex;
+            std::condition_variable instanceAvailable;
+            std::vector<TensorFlowLiteNNInstance*> availableInstances;
+
+            std::string lastErrorString;
+    };
+}
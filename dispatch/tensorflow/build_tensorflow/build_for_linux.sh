@@ -11,7 +11,7 @@ compile_host_architecture()
    path=libs/${architecture}
    mkdir -p ${current_path}/${path}
 
-   bazel build //tensorflow/lite:tensorflowlite 
+   bazel build //tensorflow/lite:tensorflowlite --define tflite_with_xnnpack=true
    
    rm  -f ${current_path}/${path}/libtensorflowlite.so
    cp bazel-bin/tensorflow/lite/libtensorflowlite.so ${current_path}/${path}/libtensorflowlite.so
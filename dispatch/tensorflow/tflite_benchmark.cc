@@ -0,0 +1,177 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+// Measures latency and throughput of a tensorflow lite model on the CPU for different configurations
+// (plain CPU and XNNPACK with different numbers of threads, and interpreter pools run by concurrent callers).
+// Usage: ./tflite_benchmark model path/to/model.tflite [iterations 200] [threads 4] [pool_size 4]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "dispatch/core/Utilities/ArgumentParser.hh"
+#include "dispatch/tensorflow/TensorFlowLiteNNInstancePool.hh"
+
+using namespace claid;
+
+struct BenchmarkConfiguration
+{
+    std::string name;
+    TensorFlowLiteNNInstance::InstanceSettings instanceSettings;
+    // Number of interpreters, each used by its own calling thread.
+    size_t poolSize;
+};
+
+static bool fillInputs(TensorFlowLiteNNInstance& instance)
+{
+    for(size_t i = 0; i < instance.getInterpreterPtr()->inputs().size(); i++)
+    {
+        TensorView view;
+        if(!instance.getInputTensorView(i, view))
+        {
+            return false;
+        }
+        memset(view.data, 0, view.numBytes);
+    }
+    return true;
+}
+
+static void runBenchmark(const std::string& modelFile, const BenchmarkConfiguration& configuration, int iterations)
+{
+    TensorFlowLiteNNInstancePool pool;
+    if(!pool.setupModelFromFile(modelFile, LayerDataOrder::NHWC, configuration.poolSize, configuration.instanceSettings))
+    {
+        printf("%-24s failed to set up: %s\n", configuration.name.c_str(), pool.getLastErrorString().c_str());
+        return;
+    }
+
+    // Warm up (first inference of XNNPACK packs the weights).
+    for(size_t i = 0; i < pool.size(); i++)
+    {
+        TensorFlowLiteNNInstancePool::Lease instance = pool.acquire();
+        if(!fillInputs(*instance) || !instance->runInference())
+        {
+            printf("%-24s failed to run inference: %s\n", configuration.name.c_str(), instance->getLastErrorString().c_str());
+            return;
+        }
+    }
+
+    std::vector<std::vector<double>> latencies(configuration.poolSize);
+    std::vector<std::thread> callers;
+
+    const auto start = std::chrono::steady_clock::now();
+    for(size_t caller = 0; caller < configuration.poolSize; caller++)
+    {
+        callers.emplace_back([&pool, &latencies, caller, iterations]()
+        {
+            for(int i = 0; i < iterations; i++)
+            {
+                const auto inferenceStart = std::chrono::steady_clock::now();
+                TensorFlowLiteNNInstancePool::Lease instance = pool.acquire();
+                instance->runInference();
+                const auto inferenceEnd = std::chrono::steady_clock::now();
+                latencies[caller].push_back(std::chrono::duration<double, std::milli>(inferenceEnd - inferenceStart).count());
+            }
+        });
+    }
+    for(std::thread& caller : callers)
+    {
+        caller.join();
+    }
+    const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> allLatencies;
+    for(const std::vector<double>& callerLatencies : latencies)
+    {
+        allLatencies.insert(allLatencies.end(), callerLatencies.begin(), callerLatencies.end());
+    }
+    std::sort(allLatencies.begin(), allLatencies.end());
+
+    const double median = allLatencies[allLatencies.size() / 2];
+    const double p99 = allLatencies[std::min(allLatencies.size() - 1, allLatencies.size() * 99 / 100)];
+    printf("%-24s latency p50 %8.3f ms, p99 %8.3f ms, throughput %9.1f inferences/s\n", 
+        configuration.name.c_str(), median, p99, allLatencies.size() / totalSeconds);
+}
+
+int main(int argc, char** argv)
+{
+    ArgumentParser parser(argc, argv);
+
+    std::string modelFile;
+    int iterations;
+    int numThreads;
+    int poolSize;
+    parser.add_argument<std::string>("model", modelFile, "", "Path to the .tflite model.");
+    parser.add_argument<int>("iterations", iterations, 200, "Number of inferences per caller.");
+    parser.add_argument<int>("threads", numThreads, 4, "Number of threads for the multi-threaded configurations.");
+    parser.add_argument<int>("pool_size", poolSize, 4, "Number of interpreters (and concurrent callers) for the pool configurations.");
+
+    if(modelFile == "")
+    {
+        parser.printHelpIfInvalidArgumentFound();
+        printf("Error, no model specified.\n"
+        "Please use ./tflite_benchmark model path/to/model.tflite.\n");
+        return 1;
+    }
+
+    std::vector<BenchmarkConfiguration> configurations;
+
+    BenchmarkConfiguration configuration;
+    configuration.poolSize = 1;
+    configuration.name = "cpu, 1 thread";
+    configuration.instanceSettings.numThreads = 1;
+    configurations.push_back(configuration);
+
+    configuration.name = "cpu, " + std::to_string(numThreads) + " threads";
+    configuration.instanceSettings.numThreads = numThreads;
+    configurations.push_back(configuration);
+
+#if __TFNN_USE_XNNPACK == 1
+    configuration.instanceSettings.useXNNPack = true;
+    configuration.name = "xnnpack, 1 thread";
+    configuration.instanceSettings.numThreads = 1;
+    configurations.push_back(configuration);
+
+    configuration.name = "xnnpack, " + std::to_string(numThreads) + " threads";
+    configuration.instanceSettings.numThreads = numThreads;
+    configurations.push_back(configuration);
+
+    configuration.name = "xnnpack, pool of " + std::to_string(poolSize);
+    configuration.instanceSettings.numThreads = 1;
+    configuration.poolSize = poolSize;
+    configurations.push_back(configuration);
+    configuration.instanceSettings.useXNNPack = false;
+#endif
+
+    configuration.name = "cpu, pool of " + std::to_string(poolSize);
+    configuration.instanceSettings.numThreads = 1;
+    configuration.poolSize = poolSize;
+    configurations.push_back(configuration);
+
+    printf("Benchmarking \"%s\", %d inferences per caller.\n", modelFile.c_str(), iterations);
+    for(const BenchmarkConfiguration& benchmarkConfiguration : configurations)
+    {
+        runBenchmark(modelFile, benchmarkConfiguration, iterations);
+    }
+    return 0;
+}
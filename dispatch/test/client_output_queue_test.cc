@@ -0,0 +1,246 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/RemoteDispatching/ClientOutputQueue.hh"
+#include "dispatch/core/RemoteDispatching/HostUserTable.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+
+#include <thread>
+
+using namespace claid;
+using claidservice::ClientQueueLimits;
+using claidservice::ClientQueueOverflowPolicy;
+
+static const std::string SPILL_PATH = "client_output_queue_test_spill";
+
+static std::shared_ptr<DataPackage> makePackage(int index)
+{
+    std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+    package->set_source_module(std::to_string(index));
+    return package;
+}
+
+static int indexOf(const std::shared_ptr<DataPackage>& package)
+{
+    return std::stoi(package->source_module());
+}
+
+TEST(ClientOutputQueueTestSuite, DropOldestTest)  
+{
+    ClientQueueLimits limits;
+    limits.set_max_packages(10);
+    limits.set_max_bytes(1024 * 1024);
+    limits.set_overflow_policy(ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_DROP_OLDEST);
+
+    std::shared_ptr<ClientOutputQueue> queue = ClientOutputQueue::create("phone", "user1", limits, nullptr, nullptr);
+    for(int i = 0; i < 25; i++)
+    {
+        queue->push(makePackage(i));
+    }
+
+    ClientQueueMetrics metrics = queue->getMetrics();
+    ASSERT_EQ(metrics.numQueuedPackages, 10);
+    ASSERT_EQ(metrics.numDroppedPackages, 15);
+    ASSERT_GT(metrics.numQueuedBytes, 0);
+
+    // Only the newest packages are kept.
+    for(int i = 15; i < 25; i++)
+    {
+        ASSERT_EQ(indexOf(queue->getQueue()->try_pop_front()), i);
+    }
+    ASSERT_EQ(queue->getQueue()->try_pop_front(), nullptr);
+    ASSERT_EQ(queue->getMetrics().numQueuedBytes, 0);
+}
+
+TEST(ClientOutputQueueTestSuite, SpillToDiskTest)  
+{
+    FileUtils::removeDirectoryRecursively(SPILL_PATH);
+
+    ClientQueueLimits limits;
+    limits.set_max_packages(10);
+    limits.set_overflow_policy(ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK);
+    limits.set_spill_path(SPILL_PATH);
+
+    std::shared_ptr<ClientOutputQueueRefiller> refiller = std::make_shared<ClientOutputQueueRefiller>();
+    std::shared_ptr<ClientOutputQueue> queue = ClientOutputQueue::create("phone", "user1", limits, refiller, nullptr);
+
+    const int NUM_PACKAGES = 500;
+    for(int i = 0; i < NUM_PACKAGES / 2; i++)
+    {
+        queue->push(makePackage(i));
+    }
+    ClientQueueMetrics metrics = queue->getMetrics();
+    ASSERT_EQ(metrics.numQueuedPackages, 10);
+    ASSERT_EQ(metrics.numSpilledPackages, NUM_PACKAGES / 2 - 10);
+    ASSERT_EQ(metrics.numDroppedPackages, 0);
+
+    // The client catches up while new packages are still arriving, all packages are received in order.
+    std::thread producer([&]()
+    {
+        for(int i = NUM_PACKAGES / 2; i < NUM_PACKAGES; i++)
+        {
+            queue->push(makePackage(i));
+        }
+    });
+
+    for(int i = 0; i < NUM_PACKAGES; i++)
+    {
+        std::shared_ptr<DataPackage> package = queue->getQueue()->pop_front();
+        ASSERT_NE(package, nullptr);
+        ASSERT_EQ(indexOf(package), i);
+    }
+    producer.join();
+
+    metrics = queue->getMetrics();
+    ASSERT_EQ(metrics.numQueuedPackages, 0);
+    ASSERT_EQ(metrics.numSpilledPackages, 0);
+}
+
+TEST(ClientOutputQueueTestSuite, SpilledPackagesSurviveReconnectTest)  
+{
+    FileUtils::removeDirectoryRecursively(SPILL_PATH);
+
+    ClientQueueLimits limits;
+    limits.set_max_packages(10);
+    limits.set_overflow_policy(ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK);
+    limits.set_spill_path(SPILL_PATH);
+
+    std::shared_ptr<ClientOutputQueueRefiller> refiller = std::make_shared<ClientOutputQueueRefiller>();
+    std::shared_ptr<ClientOutputQueue> queue = ClientOutputQueue::create("phone", "user1", limits, refiller, nullptr);
+    for(int i = 0; i < 30; i++)
+    {
+        queue->push(makePackage(i));
+    }
+
+    // The client disconnects, packages in memory are spilled in front of the ones on disk,
+    // and packages pushed after the disconnect are spilled as well.
+    queue->close();
+    ASSERT_EQ(queue->getMetrics().numQueuedPackages, 0);
+    queue->push(makePackage(30));
+
+    // All packages are delivered in order after reconnecting.
+    queue = ClientOutputQueue::create("phone", "user1", limits, refiller, nullptr);
+    ASSERT_EQ(queue->getMetrics().numQueuedPackages + queue->getMetrics().numSpilledPackages, 31);
+    for(int i = 0; i < 31; i++)
+    {
+        std::shared_ptr<DataPackage> package = queue->getQueue()->pop_front();
+        ASSERT_NE(package, nullptr);
+        ASSERT_EQ(indexOf(package), i);
+    }
+    FileUtils::removeDirectoryRecursively(SPILL_PATH);
+}
+
+TEST(ClientOutputQueueTestSuite, ReconnectViaHostUserTableTest)  
+{
+    FileUtils::removeDirectoryRecursively(SPILL_PATH);
+
+    ClientQueueLimits limits;
+    limits.set_max_packages(10);
+    limits.set_overflow_policy(ClientQueueOverflowPolicy::CLIENT_QUEUE_OVERFLOW_SPILL_TO_DISK);
+    limits.set_spill_path(SPILL_PATH);
+    limits.set_metrics_log_interval_seconds(-1);
+
+    HostUserTable table;
+    table.setClientQueueLimits(limits);
+    ASSERT_TRUE(table.addRemoteClient("phone", "user1", "device").ok());
+
+    std::shared_ptr<ClientOutputQueue> queue;
+    ASSERT_TRUE(table.lookupClientOutputQueue("phone", "user1", queue).ok());
+    for(int i = 0; i < 5; i++)
+    {
+        queue->push(makePackage(i));
+    }
+    // The client received the first package before it disconnected.
+    ASSERT_EQ(indexOf(queue->getQueue()->pop_front()), 0);
+
+    // Packages not received by the client are neither lost when it disconnects, nor when it reconnects.
+    ASSERT_TRUE(table.removeRemoteClient("phone", "user1", "device").ok());
+    ASSERT_TRUE(table.addRemoteClient("phone", "user1", "device").ok());
+    ASSERT_TRUE(table.lookupClientOutputQueue("phone", "user1", queue).ok());
+    for(int i = 1; i < 5; i++)
+    {
+        std::shared_ptr<DataPackage> package = queue->getQueue()->pop_front();
+        ASSERT_NE(package, nullptr);
+        ASSERT_EQ(indexOf(package), i);
+    }
+    FileUtils::removeDirectoryRecursively(SPILL_PATH);
+}
+
+TEST(ClientOutputQueueTestSuite, DisconnectAfterOverflowTest)  
+{
+    ClientQueueLimits limits;
+    limits.set_max_packages(2);
+    limits.set_disconnect_after_overflow_seconds(1);
+
+    int numDisconnects = 0;
+    std::shared_ptr<ClientOutputQueue> queue = ClientOutputQueue::create("phone", "user1", limits, nullptr, 
+        [&](const std::string& host, const std::string& userToken) 
+        {
+            ASSERT_EQ(host, "phone");
+            ASSERT_EQ(userToken, "user1");
+            numDisconnects++;
+        });
+
+    for(int i = 0; i < 5; i++)
+    {
+        queue->push(makePackage(i));
+    }
+    ASSERT_EQ(numDisconnects, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT_GE(queue->getMetrics().overflowDurationMs, 1000);
+
+    // The client is disconnected only once per overflow.
+    queue->push(makePackage(5));
+    queue->push(makePackage(6));
+    ASSERT_EQ(numDisconnects, 1);
+}
+
+TEST(ClientOutputQueueTestSuite, WorstClientQueuesTest)  
+{
+    ClientQueueLimits limits;
+    limits.set_max_packages(100);
+
+    HostUserTable table;
+    table.setClientQueueLimits(limits);
+    for(int user = 0; user < 5; user++)
+    {
+        const std::string userToken = "user" + std::to_string(user);
+        ASSERT_TRUE(table.addRemoteClient("phone", userToken, "device").ok());
+
+        std::shared_ptr<ClientOutputQueue> queue;
+        ASSERT_TRUE(table.lookupClientOutputQueue("phone", userToken, queue).ok());
+        for(int i = 0; i < user * 10; i++)
+        {
+            queue->push(makePackage(i));
+        }
+    }
+
+    std::vector<ClientQueueMetrics> worst = table.getWorstClientQueues(2);
+    ASSERT_EQ(worst.size(), 2);
+    ASSERT_EQ(worst[0].userToken, "user4");
+    ASSERT_EQ(worst[0].numQueuedPackages, 40);
+    ASSERT_EQ(worst[1].userToken, "user3");
+    ASSERT_EQ(table.getWorstClientQueues(10).size(), 5);
+    table.logWorstClientQueues(5);
+}
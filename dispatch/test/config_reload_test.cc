@@ -32,6 +32,9 @@ bool testModule2Started = false;
 bool testModule3Started = false;
 bool testModule4Started = false;
 
+// Counts how often TestModule3 was (re-)initialized, to verify that unchanged Modules keep running.
+int testModule3Initializations = 0;
+
 class TestModule1 : public Module
 {
     void initialize(Properties properties)
@@ -72,6 +75,7 @@ class TestModule3 : public Module
     {
         std::string prop;
         Logger::logInfo("TestModule 3 initialize");
+        testModule3Initializations++;
         properties.getStringProperty("TestModule3Data", prop);
 
         if(prop == "420")
@@ -124,7 +128,10 @@ TEST(ConfigReloadTestTestSuite, ConfigReloadTest)
     ASSERT_TRUE(testModule1Started) << "TestModule1 did not start as expected";
     ASSERT_TRUE(testModule2Started) << "TestModule2 did not start as expected";
 
+    auto reloadStart = std::chrono::steady_clock::now();
     ASSERT_TRUE(claid.loadNewConfig("dispatch/test/config_reload_test_2.json").ok());
+    auto reloadDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - reloadStart);
+    Logger::logInfo("Reloading config with all Modules changed took %d us", static_cast<int>(reloadDuration.count()));
     std::this_thread::sleep_for(std::chrono::milliseconds(200));
     testModule1Started = false;
     testModule2Started = false;
@@ -132,6 +139,24 @@ TEST(ConfigReloadTestTestSuite, ConfigReloadTest)
     ASSERT_FALSE(testModule2Started) << "TestModule2 was started but should not have been.";
     ASSERT_TRUE(testModule3Started) << "TestModule3 did not start as expected";
     ASSERT_TRUE(testModule4Started) << "TestModule4 did not start as expected";
+    ASSERT_EQ(testModule3Initializations, 1);
+
+    // TestModule3 is unchanged in the third config, TestModule4 is removed and TestModule1 is added.
+    // Only the affected Modules are reloaded, TestModule3 keeps running.
+    reloadStart = std::chrono::steady_clock::now();
+    ASSERT_TRUE(claid.loadNewConfig("dispatch/test/config_reload_test_3.json").ok());
+    reloadDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - reloadStart);
+    Logger::logInfo("Reloading config with one unchanged Module took %d us", static_cast<int>(reloadDuration.count()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_TRUE(testModule1Started) << "TestModule1 did not start as expected";
+    ASSERT_EQ(testModule3Initializations, 1) << "TestModule3 was restarted, although it did not change";
+
+    // Reloading the same config again does not restart any Module.
+    reloadStart = std::chrono::steady_clock::now();
+    ASSERT_TRUE(claid.loadNewConfig("dispatch/test/config_reload_test_3.json").ok());
+    reloadDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - reloadStart);
+    Logger::logInfo("Reloading an unchanged config took %d us", static_cast<int>(reloadDuration.count()));
+    ASSERT_EQ(testModule3Initializations, 1);
     std::this_thread::sleep_for(std::chrono::milliseconds(2000));
     claid.shutdown();
 }   
\ No newline at end of file
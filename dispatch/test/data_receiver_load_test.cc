@@ -0,0 +1,262 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/DataCollection/DataSyncer/DataReceiverShard.hh"
+#include "dispatch/core/DataCollection/DataSyncer/DataSyncManifest.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+#include "dispatch/core/Utilities/Path.hh"
+#include "dispatch/core/Utilities/XXHash64.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <atomic>
+#include <fstream>
+
+using namespace claid;
+
+// Load test for the DataReceiverModule, which simulates many devices syncing their files at the same time.
+// Each simulated device answers file requests of the DataReceiverShardPool with chunks, like a DataSyncModule would.
+// The number of devices and files can be adjusted to test the receiver under different loads.
+const std::string LOAD_TEST_SOURCE_FOLDER = "data_receiver_load_test_source";
+const std::string LOAD_TEST_TARGET_FOLDER = "data_receiver_load_test_target";
+const int NUM_DEVICES = 64;
+const int FILES_PER_DEVICE = 16;
+const size_t LOAD_TEST_CHUNK_SIZE = 16 * 1024;
+
+class SimulatedDevices
+{
+    private:
+        DataReceiverShardPool& receiver;
+
+        std::mutex mutex;
+        std::condition_variable conditionVariable;
+        std::deque<std::pair<DataSyncPackage, std::string>> packagesFromReceiver;
+        bool running = true;
+        std::thread thread;
+
+        std::map<std::string, uint64_t> manifestVersions;
+        std::atomic<int> numDevicesDone{0};
+
+        // gtest assertions do not abort the test if they fail on another thread, hence errors are collected
+        // and checked on the test thread.
+        std::vector<std::string> errors;
+
+        void sendChunks(const DataSyncFileDescriptor& request, const std::string& userId)
+        {
+            const std::string path = Path::join(LOAD_TEST_SOURCE_FOLDER, userId, request.relative_file_path());
+            uint64_t fileSize;
+            uint64_t hash;
+            if(!FileUtils::getFileSize(path, fileSize) || !XXHash64::hashFile(path, hash))
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->errors.push_back("Failed to read requested file \"" + path + "\".");
+                return;
+            }
+
+            std::ifstream file(path, std::ios::binary);
+            file.seekg(request.chunk_offset());
+            uint64_t offset = request.chunk_offset();
+            do
+            {
+                std::shared_ptr<DataSyncPackage> pkg = std::make_shared<DataSyncPackage>();
+                pkg->set_package_type(DataSyncPackageType::FILE_CHUNK);
+                DataSyncFileDescriptor* chunk = pkg->mutable_file_descriptors()->add_descriptors();
+                chunk->set_relative_file_path(request.relative_file_path());
+                chunk->set_file_size(fileSize);
+                chunk->set_hash(hash);
+                chunk->set_chunk_offset(offset);
+
+                size_t chunkSize = static_cast<size_t>(std::min<uint64_t>(LOAD_TEST_CHUNK_SIZE, fileSize - offset));
+                std::string* data = chunk->mutable_file_data();
+                data->resize(chunkSize);
+                file.read(&(*data)[0], chunkSize);
+                offset += chunkSize;
+                chunk->set_is_last_chunk(offset == fileSize);
+                this->receiver.enqueuePackage(pkg, userId);
+            } while(offset < fileSize);
+        }
+
+        void processPackagesFromReceiver()
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            while(this->running)
+            {
+                this->conditionVariable.wait(lock, [&]{return !this->running || !this->packagesFromReceiver.empty();});
+                while(!this->packagesFromReceiver.empty())
+                {
+                    std::pair<DataSyncPackage, std::string> entry = std::move(this->packagesFromReceiver.front());
+                    this->packagesFromReceiver.pop_front();
+                    lock.unlock();
+
+                    const DataSyncPackage& pkg = entry.first;
+                    const std::string& userId = entry.second;
+                    if(pkg.package_type() == DataSyncPackageType::REQUESTED_FILES_LIST)
+                    {
+                        for(const DataSyncFileDescriptor& request : pkg.file_descriptors().descriptors())
+                        {
+                            sendChunks(request, userId);
+                        }
+                    }
+                    else if(pkg.package_type() == DataSyncPackageType::MANIFEST_ACKNOWLEDGEMENT && 
+                        pkg.manifest_version() == this->manifestVersions[userId])
+                    {
+                        this->numDevicesDone++;
+                    }
+
+                    lock.lock();
+                }
+            }
+        }
+
+    public:
+        SimulatedDevices(DataReceiverShardPool& receiver) : receiver(receiver)
+        {
+            this->thread = std::thread(&SimulatedDevices::processPackagesFromReceiver, this);
+        }
+
+        ~SimulatedDevices()
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->running = false;
+            }
+            this->conditionVariable.notify_all();
+            this->thread.join();
+        }
+
+        // Called by the shards of the receiver.
+        void onPackageFromReceiver(const DataSyncPackage& pkg, const std::string& userId)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->packagesFromReceiver.push_back(std::make_pair(pkg, userId));
+            }
+            this->conditionVariable.notify_one();
+        }
+
+        void sendFileList(const std::string& userId)
+        {
+            DataSyncManifest manifest;
+            ASSERT_TRUE(manifest.initialize(Path::join(LOAD_TEST_SOURCE_FOLDER, userId)).ok());
+            ASSERT_TRUE(manifest.update().ok());
+
+            std::shared_ptr<DataSyncPackage> pkg = std::make_shared<DataSyncPackage>();
+            pkg->set_package_type(DataSyncPackageType::ALL_AVAILABLE_FILES_LIST);
+            manifest.getChangesSince(0, *pkg->mutable_file_descriptors());
+            pkg->set_manifest_version(manifest.getVersion());
+            pkg->set_base_manifest_version(0);
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->manifestVersions[userId] = manifest.getVersion();
+            }
+            this->receiver.enqueuePackage(pkg, userId);
+        }
+
+        int getNumDevicesDone() const
+        {
+            return this->numDevicesDone;
+        }
+
+        std::vector<std::string> getErrors()
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            return this->errors;
+        }
+};
+
+std::string getDeviceName(int device)
+{
+    return "device_" + std::to_string(device);
+}
+
+void generateDeviceFiles()
+{
+    FileUtils::removeDirectoryRecursively(LOAD_TEST_SOURCE_FOLDER);
+    ASSERT_TRUE(FileUtils::createDirectory(LOAD_TEST_SOURCE_FOLDER));
+
+    srand(42);
+    for(int device = 0; device < NUM_DEVICES; device++)
+    {
+        const std::string deviceFolder = Path::join(LOAD_TEST_SOURCE_FOLDER, getDeviceName(device));
+        ASSERT_TRUE(FileUtils::createDirectory(deviceFolder));
+        for(int i = 0; i < FILES_PER_DEVICE; i++)
+        {
+            // Between 1 KB and 64 KB, such that most files are sent in multiple chunks.
+            size_t fileSize = 1024 + rand() % (63 * 1024);
+            std::string content(fileSize, '\0');
+            for(char& c : content)
+            {
+                c = static_cast<char>(rand());
+            }
+            std::ofstream file(Path::join(deviceFolder, "file_" + std::to_string(i) + ".bin"), std::ios::binary);
+            file.write(content.data(), content.size());
+        }
+    }
+}
+
+TEST(DataReceiverLoadTestSuite, ManyDevicesSyncConcurrentlyTest)  
+{
+    generateDeviceFiles();
+    FileUtils::removeDirectoryRecursively(LOAD_TEST_TARGET_FOLDER);
+    ASSERT_TRUE(FileUtils::createDirectory(LOAD_TEST_TARGET_FOLDER));
+
+    DataReceiverShard::Config config;
+    config.storagePath = LOAD_TEST_TARGET_FOLDER;
+    config.maxConcurrentFilesPerUser = 4;
+    config.maxConcurrentFiles = 64;
+
+    DataReceiverShardPool receiver;
+    SimulatedDevices devices(receiver);
+    receiver.start(config, 4, std::bind(&SimulatedDevices::onPackageFromReceiver, &devices, std::placeholders::_1, std::placeholders::_2));
+
+    Time start = Time::now();
+    for(int device = 0; device < NUM_DEVICES; device++)
+    {
+        devices.sendFileList(getDeviceName(device));
+    }
+
+    Time deadline = start + std::chrono::seconds(60);
+    while(devices.getNumDevicesDone() < NUM_DEVICES && Time::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    uint64_t durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(Time::now() - start).count();
+    receiver.stop();
+
+    ASSERT_TRUE(devices.getErrors().empty()) << devices.getErrors().front();
+    ASSERT_EQ(devices.getNumDevicesDone(), NUM_DEVICES) << "Not all devices finished syncing within 60 seconds.";
+    Logger::logInfo("Synchronized %d files of %d devices in %lu ms.", NUM_DEVICES * FILES_PER_DEVICE, NUM_DEVICES, durationMs);
+
+    for(int device = 0; device < NUM_DEVICES; device++)
+    {
+        for(int i = 0; i < FILES_PER_DEVICE; i++)
+        {
+            const std::string fileName = "file_" + std::to_string(i) + ".bin";
+            uint64_t sourceHash;
+            uint64_t targetHash;
+            ASSERT_TRUE(XXHash64::hashFile(Path::join(LOAD_TEST_SOURCE_FOLDER, getDeviceName(device), fileName), sourceHash));
+            ASSERT_TRUE(XXHash64::hashFile(Path::join(LOAD_TEST_TARGET_FOLDER, getDeviceName(device), fileName), targetHash)) 
+                << "File " << fileName << " of " << getDeviceName(device) << " was not received.";
+            ASSERT_EQ(sourceHash, targetHash);
+        }
+    }
+}
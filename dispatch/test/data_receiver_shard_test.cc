@@ -0,0 +1,230 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/DataCollection/DataSyncer/DataReceiverShard.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+#include "dispatch/core/Utilities/Path.hh"
+#include "dispatch/core/Utilities/XXHash64.hh"
+
+#include <fstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using namespace claid;
+
+// Tests the DataReceiverShard without a worker thread, i.e., packages are processed on the test thread
+// and the packages sent to the user are collected instead of being sent to a DataSyncModule.
+const std::string SHARD_TEST_TARGET_FOLDER = "data_receiver_shard_test_target";
+const std::string SHARD_TEST_USER = "user";
+const std::string SHARD_TEST_FILE = "chunked.bin";
+const size_t SHARD_TEST_CHUNK_SIZE = 1024;
+const size_t SHARD_TEST_NUM_CHUNKS = 8;
+
+class DataReceiverShardTest : public ::testing::Test
+{
+    protected:
+        std::vector<DataSyncPackage> sentPackages;
+        std::string content;
+        uint64_t hash;
+
+        void SetUp() override
+        {
+            FileUtils::removeDirectoryRecursively(SHARD_TEST_TARGET_FOLDER);
+            ASSERT_TRUE(FileUtils::createDirectoriesRecursively(Path::join(SHARD_TEST_TARGET_FOLDER, SHARD_TEST_USER)));
+
+            this->content.resize(SHARD_TEST_CHUNK_SIZE * SHARD_TEST_NUM_CHUNKS);
+            for(size_t i = 0; i < this->content.size(); i++)
+            {
+                this->content[i] = static_cast<char>(i * 31 + 7);
+            }
+            this->hash = XXHash64::hash(this->content.data(), this->content.size());
+        }
+
+        DataReceiverShard::Config makeConfig() const
+        {
+            DataReceiverShard::Config config;
+            config.storagePath = SHARD_TEST_TARGET_FOLDER;
+            return config;
+        }
+
+        DataReceiverShard::SendFunction collectSentPackages()
+        {
+            return [this](const DataSyncPackage& pkg, const std::string&) { this->sentPackages.push_back(pkg); };
+        }
+
+        std::string getTargetPath() const
+        {
+            return Path::join(SHARD_TEST_TARGET_FOLDER, SHARD_TEST_USER, SHARD_TEST_FILE);
+        }
+
+        void sendFileList(DataReceiverShard& shard, uint64_t manifestVersion)
+        {
+            DataSyncPackage pkg;
+            pkg.set_package_type(DataSyncPackageType::ALL_AVAILABLE_FILES_LIST);
+            pkg.set_manifest_version(manifestVersion);
+            DataSyncFileDescriptor* descriptor = pkg.mutable_file_descriptors()->add_descriptors();
+            descriptor->set_relative_file_path(SHARD_TEST_FILE);
+            descriptor->set_file_size(this->content.size());
+            descriptor->set_hash(this->hash);
+            shard.processPackage(pkg, SHARD_TEST_USER);
+        }
+
+        void sendChunk(DataReceiverShard& shard, size_t chunkIndex)
+        {
+            DataSyncPackage pkg;
+            pkg.set_package_type(DataSyncPackageType::FILE_CHUNK);
+            DataSyncFileDescriptor* chunk = pkg.mutable_file_descriptors()->add_descriptors();
+            chunk->set_relative_file_path(SHARD_TEST_FILE);
+            chunk->set_file_size(this->content.size());
+            chunk->set_hash(this->hash);
+            chunk->set_chunk_offset(chunkIndex * SHARD_TEST_CHUNK_SIZE);
+            chunk->set_file_data(this->content.substr(chunkIndex * SHARD_TEST_CHUNK_SIZE, SHARD_TEST_CHUNK_SIZE));
+            chunk->set_is_last_chunk(chunkIndex + 1 == SHARD_TEST_NUM_CHUNKS);
+            shard.processPackage(pkg, SHARD_TEST_USER);
+        }
+
+        // Returns the offsets of all file requests sent since the last call.
+        std::vector<uint64_t> takeRequestedOffsets()
+        {
+            std::vector<uint64_t> offsets;
+            for(const DataSyncPackage& pkg : this->sentPackages)
+            {
+                if(pkg.package_type() == DataSyncPackageType::REQUESTED_FILES_LIST)
+                {
+                    for(const DataSyncFileDescriptor& descriptor : pkg.file_descriptors().descriptors())
+                    {
+                        offsets.push_back(descriptor.chunk_offset());
+                    }
+                }
+            }
+            this->sentPackages.clear();
+            return offsets;
+        }
+};
+
+TEST_F(DataReceiverShardTest, ChunkedTransferTest)
+{
+    DataReceiverShard shard(makeConfig(), collectSentPackages());
+    sendFileList(shard, 1);
+    ASSERT_EQ(takeRequestedOffsets(), std::vector<uint64_t>({0}));
+
+    for(size_t i = 0; i < SHARD_TEST_NUM_CHUNKS; i++)
+    {
+        sendChunk(shard, i);
+    }
+
+    uint64_t receivedHash;
+    ASSERT_TRUE(XXHash64::hashFile(getTargetPath(), receivedHash));
+    ASSERT_EQ(receivedHash, this->hash);
+    ASSERT_FALSE(FileUtils::fileExists(getTargetPath() + DataReceiverShard::PARTIAL_FILE_SUFFIX));
+    ASSERT_TRUE(takeRequestedOffsets().empty());
+}
+
+TEST_F(DataReceiverShardTest, ResumeFromPartialFileWithGapTest)
+{
+    const size_t numChunksOfPartialFile = 3;
+    {
+        std::ofstream partialFile(getTargetPath() + DataReceiverShard::PARTIAL_FILE_SUFFIX, std::ios::binary);
+        partialFile.write(this->content.data(), numChunksOfPartialFile * SHARD_TEST_CHUNK_SIZE);
+    }
+
+    DataReceiverShard::Config config = makeConfig();
+    config.resumeRequestRetryMilliseconds = 50;
+    DataReceiverShard shard(config, collectSentPackages());
+    sendFileList(shard, 1);
+    ASSERT_EQ(takeRequestedOffsets(), std::vector<uint64_t>({numChunksOfPartialFile * SHARD_TEST_CHUNK_SIZE}));
+
+    // The first chunk after the partial file gets lost.
+    sendChunk(shard, numChunksOfPartialFile + 1);
+    const uint64_t gapOffset = numChunksOfPartialFile * SHARD_TEST_CHUNK_SIZE;
+    ASSERT_EQ(takeRequestedOffsets(), std::vector<uint64_t>({gapOffset}));
+
+    // Chunks that were in flight before the DataSyncModule received the resume request do not trigger another request.
+    sendChunk(shard, numChunksOfPartialFile + 2);
+    ASSERT_TRUE(takeRequestedOffsets().empty());
+
+    // The resume request got lost, hence it is repeated.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sendChunk(shard, numChunksOfPartialFile + 3);
+    ASSERT_EQ(takeRequestedOffsets(), std::vector<uint64_t>({gapOffset}));
+
+    for(size_t i = numChunksOfPartialFile; i < SHARD_TEST_NUM_CHUNKS; i++)
+    {
+        sendChunk(shard, i);
+    }
+
+    uint64_t receivedHash;
+    ASSERT_TRUE(XXHash64::hashFile(getTargetPath(), receivedHash));
+    ASSERT_EQ(receivedHash, this->hash);
+
+    bool manifestAcknowledged = false;
+    for(const DataSyncPackage& pkg : this->sentPackages)
+    {
+        manifestAcknowledged |= pkg.package_type() == DataSyncPackageType::MANIFEST_ACKNOWLEDGEMENT && pkg.manifest_version() == 1;
+    }
+    ASSERT_TRUE(manifestAcknowledged);
+}
+
+TEST_F(DataReceiverShardTest, DeletedOrReplacedFilesAreRequestedAgainTest)
+{
+    DataReceiverShard shard(makeConfig(), collectSentPackages());
+    sendFileList(shard, 1);
+    for(size_t i = 0; i < SHARD_TEST_NUM_CHUNKS; i++)
+    {
+        sendChunk(shard, i);
+    }
+    takeRequestedOffsets();
+
+    // The file is known already.
+    sendFileList(shard, 2);
+    ASSERT_TRUE(takeRequestedOffsets().empty());
+
+    // Replaced by a file with the same size but different content.
+    {
+        std::ofstream file(getTargetPath(), std::ios::binary | std::ios::trunc);
+        file << std::string(this->content.size(), 'x');
+    }
+    uint64_t fileSize;
+    uint64_t modificationTime;
+    ASSERT_TRUE(FileUtils::getFileSizeAndModificationTime(getTargetPath(), fileSize, modificationTime));
+    struct timespec times[2];
+    times[0].tv_sec = modificationTime / 1000 + 2;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    ASSERT_EQ(utimensat(AT_FDCWD, getTargetPath().c_str(), times, 0), 0);
+
+    sendFileList(shard, 3);
+    ASSERT_EQ(takeRequestedOffsets(), std::vector<uint64_t>({0}));
+    for(size_t i = 0; i < SHARD_TEST_NUM_CHUNKS; i++)
+    {
+        sendChunk(shard, i);
+    }
+    takeRequestedOffsets();
+
+    // Deleted from the storage folder.
+    ASSERT_TRUE(FileUtils::removeFile(getTargetPath()));
+    sendFileList(shard, 4);
+    ASSERT_EQ(takeRequestedOffsets(), std::vector<uint64_t>({0}));
+}
@@ -0,0 +1,176 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/DataCollection/DataSyncer/DataSyncManifest.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
+#include "dispatch/core/Utilities/XXHash64.hh"
+
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using namespace claid;
+
+const std::string MANIFEST_TEST_FOLDER = "data_sync_manifest_test_files";
+
+void writeTestFile(const std::string& name, const std::string& content)
+{
+    std::ofstream file(MANIFEST_TEST_FOLDER + "/" + name, std::ios::out | std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+// Rewriting a file might not change its modification time, if the file system has a coarse timestamp granularity.
+void setModificationTime(const std::string& name, uint64_t modificationTimeMs)
+{
+    struct timespec times[2];
+    times[0].tv_sec = modificationTimeMs / 1000;
+    times[0].tv_nsec = (modificationTimeMs % 1000) * 1000000;
+    times[1] = times[0];
+    ASSERT_EQ(utimensat(AT_FDCWD, (MANIFEST_TEST_FOLDER + "/" + name).c_str(), times, 0), 0);
+}
+
+TEST(DataSyncManifestTestSuite, XXHash64Test)  
+{
+    // Reference values of XXH64 with seed 0.
+    ASSERT_EQ(XXHash64::hash("", 0), 0xEF46DB3751D8E999ULL);
+    ASSERT_EQ(XXHash64::hash("a", 1), 0xD24EC4F1A98C6E5BULL);
+
+    // Streaming in small blocks has to yield the same hash as hashing all at once.
+    std::string data(1000, 'x');
+    for(size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<char>(i * 31);
+    }
+    XXHash64 hasher;
+    for(size_t i = 0; i < data.size(); i += 7)
+    {
+        hasher.update(data.data() + i, std::min<size_t>(7, data.size() - i));
+    }
+    ASSERT_EQ(hasher.digest(), XXHash64::hash(data.data(), data.size()));
+}
+
+TEST(DataSyncManifestTestSuite, IncrementalUpdateTest)  
+{
+    FileUtils::removeDirectoryRecursively(MANIFEST_TEST_FOLDER);
+    ASSERT_TRUE(FileUtils::createDirectory(MANIFEST_TEST_FOLDER));
+    ASSERT_TRUE(FileUtils::createDirectory(MANIFEST_TEST_FOLDER + "/sub"));
+
+    writeTestFile("a.txt", "first file");
+    writeTestFile("sub/b.txt", "second file");
+
+    {
+        DataSyncManifest manifest;
+        ASSERT_TRUE(manifest.initialize(MANIFEST_TEST_FOLDER).ok());
+        ASSERT_TRUE(manifest.update().ok());
+        ASSERT_EQ(manifest.getVersion(), 1);
+        ASSERT_EQ(manifest.size(), 2);
+
+        claidservice::DataSyncFileDescriptorList list;
+        manifest.getChangesSince(0, list);
+        ASSERT_EQ(list.descriptors_size(), 2);
+
+        DataSyncManifest::Entry entry;
+        ASSERT_TRUE(manifest.getEntry("sub/b.txt", entry));
+        ASSERT_EQ(entry.fileSize, 11);
+        ASSERT_EQ(entry.hash, XXHash64::hash("second file", 11));
+
+        // Nothing changed, version stays the same.
+        ASSERT_TRUE(manifest.update().ok());
+        ASSERT_EQ(manifest.getVersion(), 1);
+
+        manifest.setAcknowledgedVersion(1);
+        ASSERT_TRUE(manifest.store().ok());
+
+        // Same size, different content and a new file.
+        ASSERT_TRUE(manifest.getEntry("a.txt", entry));
+        writeTestFile("a.txt", "FIRST FILE");
+        setModificationTime("a.txt", entry.modificationTime + 2000);
+        writeTestFile("sub/c.txt", "third file");
+        FileUtils::removeFile(MANIFEST_TEST_FOLDER + "/sub/b.txt");
+    }
+
+    // The manifest is loaded from disk, hence only the changes since version 1 are reported.
+    DataSyncManifest manifest;
+    ASSERT_TRUE(manifest.initialize(MANIFEST_TEST_FOLDER).ok());
+    ASSERT_EQ(manifest.getAcknowledgedVersion(), 1);
+    ASSERT_TRUE(manifest.update().ok());
+    ASSERT_EQ(manifest.getVersion(), 2);
+    ASSERT_EQ(manifest.size(), 2);
+
+    claidservice::DataSyncFileDescriptorList list;
+    manifest.getChangesSince(manifest.getAcknowledgedVersion(), list);
+    ASSERT_EQ(list.descriptors_size(), 2);
+    for(const claidservice::DataSyncFileDescriptor& descriptor : list.descriptors())
+    {
+        ASSERT_NE(descriptor.relative_file_path(), DataSyncManifest::MANIFEST_FILE_NAME);
+        ASSERT_NE(descriptor.hash(), 0);
+    }
+
+    DataSyncManifest::Entry entry;
+    ASSERT_TRUE(manifest.getEntry("a.txt", entry));
+    ASSERT_EQ(entry.hash, XXHash64::hash("FIRST FILE", 10));
+    ASSERT_FALSE(manifest.getEntry("sub/b.txt", entry));
+}
+
+TEST(DataSyncManifestTestSuite, CorruptManifestTest)  
+{
+    FileUtils::removeDirectoryRecursively(MANIFEST_TEST_FOLDER);
+    ASSERT_TRUE(FileUtils::createDirectory(MANIFEST_TEST_FOLDER));
+
+    writeTestFile("a.txt", "first file");
+    writeTestFile("b.txt", "second file");
+    {
+        DataSyncManifest manifest;
+        ASSERT_TRUE(manifest.initialize(MANIFEST_TEST_FOLDER).ok());
+        ASSERT_TRUE(manifest.update().ok());
+        manifest.setAcknowledgedVersion(1);
+        ASSERT_TRUE(manifest.store().ok());
+    }
+
+    // Truncated in the middle of an entry.
+    std::string content;
+    {
+        std::ifstream file(MANIFEST_TEST_FOLDER + "/" + DataSyncManifest::MANIFEST_FILE_NAME);
+        content = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+    writeTestFile(DataSyncManifest::MANIFEST_FILE_NAME, content.substr(0, content.size() - 4) + "x\n");
+
+    // The corrupt manifest is discarded, hence all files are reported again.
+    DataSyncManifest manifest;
+    ASSERT_TRUE(manifest.initialize(MANIFEST_TEST_FOLDER).ok());
+    ASSERT_EQ(manifest.getAcknowledgedVersion(), 0);
+    ASSERT_TRUE(manifest.update().ok());
+    ASSERT_EQ(manifest.size(), 2);
+
+    claidservice::DataSyncFileDescriptorList list;
+    manifest.getChangesSince(manifest.getAcknowledgedVersion(), list);
+    ASSERT_EQ(list.descriptors_size(), 2);
+
+    // Garbage instead of a header.
+    writeTestFile(DataSyncManifest::MANIFEST_FILE_NAME, "not\ta manifest\n");
+    DataSyncManifest manifestWithInvalidHeader;
+    ASSERT_TRUE(manifestWithInvalidHeader.initialize(MANIFEST_TEST_FOLDER).ok());
+    ASSERT_TRUE(manifestWithInvalidHeader.update().ok());
+    ASSERT_EQ(manifestWithInvalidHeader.size(), 2);
+}
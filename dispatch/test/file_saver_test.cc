@@ -23,6 +23,7 @@
 #include "gtest/gtest.h"
 
 #include "dispatch/core/DataCollection/DataSaver/FileSaver.hh"
+#include "dispatch/core/Utilities/FileUtils.hh"
 #include "dispatch/proto/sensor_data_types.pb.h"
 
 using namespace claid;
@@ -78,3 +79,45 @@ TEST(FileSaverTestSuite, FileSaverTest)
     ASSERT_TRUE(status.ok()) << status;
 
 }
+
+// Files are written to the tmp folder first and are moved to the storage folder once the next file is begun.
+// The manifest in the tmp folder allows to recover files that were left behind by a previous FileSaver.
+TEST(FileSaverTestSuite, FileSaverTmpFolderTest)  
+{
+    const std::string storagePath = "data_test_tmp_storage";
+    const std::string tmpStoragePath = "data_test_tmp_storage_tmp";
+    const std::string fileNameFormat = "test_%timestamp.json";
+
+    FileUtils::removeDirectoryRecursively(storagePath);
+    FileUtils::removeDirectoryRecursively(tmpStoragePath);
+
+    FileSaver fileSaver;
+    absl::Status status = fileSaver.initialize("test_data", storagePath, fileNameFormat, "json", false, "", tmpStoragePath);
+    ASSERT_TRUE(status.ok()) << status;
+
+    status = fileSaver.onNewData(std::static_pointer_cast<google::protobuf::Message>(getAccelerationData(1)), Time::fromUnixTimestampMilliseconds(1000));
+    ASSERT_TRUE(status.ok()) << status;
+    ASSERT_TRUE(FileUtils::fileExists(tmpStoragePath + "/test_1000.json"));
+    ASSERT_FALSE(FileUtils::fileExists(storagePath + "/test_1000.json"));
+
+    status = fileSaver.onNewData(std::static_pointer_cast<google::protobuf::Message>(getAccelerationData(2)), Time::fromUnixTimestampMilliseconds(2000));
+    ASSERT_TRUE(status.ok()) << status;
+    ASSERT_TRUE(FileUtils::fileExists(storagePath + "/test_1000.json"));
+    ASSERT_FALSE(FileUtils::fileExists(tmpStoragePath + "/test_1000.json"));
+    ASSERT_TRUE(FileUtils::fileExists(tmpStoragePath + "/test_2000.json"));
+
+    // Simulate a restart without calling endFileSaving(): the file left in the tmp folder
+    // has to be recovered from the manifest by the next FileSaver.
+    FileSaver recoveringFileSaver;
+    status = recoveringFileSaver.initialize("test_data", storagePath, fileNameFormat, "json", false, "", tmpStoragePath);
+    ASSERT_TRUE(status.ok()) << status;
+    ASSERT_TRUE(FileUtils::fileExists(storagePath + "/test_2000.json"));
+    ASSERT_FALSE(FileUtils::fileExists(tmpStoragePath + "/test_2000.json"));
+
+    status = recoveringFileSaver.onNewData(std::static_pointer_cast<google::protobuf::Message>(getAccelerationData(3)), Time::fromUnixTimestampMilliseconds(3000));
+    ASSERT_TRUE(status.ok()) << status;
+    status = recoveringFileSaver.endFileSaving();
+    ASSERT_TRUE(status.ok()) << status;
+    ASSERT_TRUE(FileUtils::fileExists(storagePath + "/test_3000.json"));
+    ASSERT_FALSE(FileUtils::fileExists(tmpStoragePath + "/test_3000.json"));
+}
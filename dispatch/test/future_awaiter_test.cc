@@ -0,0 +1,261 @@
+#include "gtest/gtest.h"
+
+#include "dispatch/core/RemoteFunction/FutureAwaiter.hh"
+#include "dispatch/core/RemoteFunction/FutureHandler.hh"
+#include "dispatch/core/Module/Module.hh"
+#include "dispatch/core/Module/TypeMapping/TypeMapping.hh"
+#include "dispatch/core/shared_queue.hh"
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace claid;
+
+static std::shared_ptr<DataPackage> makeIntResponse(int value)
+{
+    std::shared_ptr<DataPackage> response = std::make_shared<DataPackage>();
+    TypeMapping::getMutator<int>().setPackagePayload(*response, value);
+    return response;
+}
+
+TEST(FutureAwaiterTest, FinishedListenerTest)
+{
+    FutureHandler handler;
+    std::shared_ptr<Future<int>> future = handler.registerNewFuture<int>();
+
+    int numCalls = 0;
+    future->addFinishedListener([&]() { numCalls++; });
+    ASSERT_EQ(numCalls, 0);
+
+    future->setResponse(makeIntResponse(42));
+    ASSERT_EQ(numCalls, 1);
+    ASSERT_TRUE(future->isFinished());
+    ASSERT_EQ(future->await(), 42);
+
+    // Listeners added after the Future finished are called right away.
+    future->addFinishedListener([&]() { numCalls++; });
+    ASSERT_EQ(numCalls, 2);
+
+    // A Future only finishes once.
+    future->setFailed();
+    ASSERT_EQ(numCalls, 2);
+    ASSERT_TRUE(future->wasExecutedSuccessfully());
+}
+
+TEST(FutureAwaiterTest, CancelTest)
+{
+    FutureHandler handler;
+    std::shared_ptr<Future<int>> future = handler.registerNewFuture<int>();
+    ASSERT_EQ(handler.getNumOpenFutures(), 1);
+
+    bool listenerCalled = false;
+    future->addFinishedListener([&]() { listenerCalled = true; });
+
+    future->cancel();
+    ASSERT_TRUE(listenerCalled);
+    ASSERT_TRUE(future->wasCancelled());
+    ASSERT_FALSE(future->wasExecutedSuccessfully());
+    ASSERT_EQ(handler.getNumOpenFutures(), 0);
+    ASSERT_EQ(handler.lookupFuture(future->getUniqueIdentifier()), nullptr);
+
+    // A late response is discarded.
+    future->setResponse(makeIntResponse(42));
+    ASSERT_FALSE(future->wasExecutedSuccessfully());
+    ASSERT_EQ(future->await(), 0);
+}
+
+// Exposes awaitAsync and the thread of the Module to the tests.
+class AwaitingModule : public Module
+{
+    public:
+        std::thread::id moduleThreadId;
+
+        void initialize(Properties) override
+        {
+            moduleThreadId = std::this_thread::get_id();
+        }
+
+        void awaitSum(std::vector<std::shared_ptr<Future<int>>> futures, std::promise<int>& result)
+        {
+            awaitNext(futures, 0, 0, result);
+        }
+
+        // Awaits one Future after the other, like a coroutine would, without blocking the thread of the Module.
+        void awaitNext(std::vector<std::shared_ptr<Future<int>>> futures, size_t index, int sum, std::promise<int>& result)
+        {
+            if(index == futures.size())
+            {
+                result.set_value(sum);
+                return;
+            }
+
+            awaitAsync<int>(futures[index], [this, futures, index, sum, &result](std::shared_ptr<Future<int>> future)
+            {
+                if(std::this_thread::get_id() != moduleThreadId)
+                {
+                    result.set_value(-1);
+                    return;
+                }
+                awaitNext(futures, index + 1, sum + future->await(), result);
+            });
+        }
+
+        void awaitAndCount(std::shared_ptr<Future<int>> future, std::atomic<int>& numCalls)
+        {
+            awaitAsync<int>(future, [&numCalls](std::shared_ptr<Future<int>>) { numCalls++; });
+        }
+};
+
+class ModuleAwaitAsyncTest : public ::testing::Test
+{
+    protected:
+        SharedQueue<DataPackage> toModuleDispatcherQueue;
+        SharedQueue<DataPackage> toMiddlewareQueue;
+        ChannelSubscriberPublisher subscriberPublisher{toModuleDispatcherQueue};
+        RemoteFunctionHandler remoteFunctionHandler{toMiddlewareQueue};
+        FutureHandler futureHandler;
+
+        void startModule(AwaitingModule& module)
+        {
+            module.setId("AwaitingModule");
+            ASSERT_TRUE(module.start(&subscriberPublisher, &remoteFunctionHandler, Properties(google::protobuf::Struct())));
+        }
+};
+
+TEST_F(ModuleAwaitAsyncTest, ContinuationRunsOnModuleThreadTest)
+{
+    AwaitingModule module;
+    startModule(module);
+
+    std::vector<std::shared_ptr<Future<int>>> futures;
+    for(int i = 0; i < 10; i++)
+    {
+        futures.push_back(futureHandler.registerNewFuture<int>());
+    }
+
+    std::promise<int> result;
+    module.awaitSum(futures, result);
+
+    // Responses arrive on another thread while the Module is waiting.
+    std::thread responder([&]()
+    {
+        for(int i = 0; i < 10; i++)
+        {
+            futures[i]->setResponse(makeIntResponse(i));
+        }
+    });
+    responder.join();
+
+    std::future<int> sum = result.get_future();
+    ASSERT_EQ(sum.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    ASSERT_EQ(sum.get(), 45);
+
+    module.shutdown();
+}
+
+TEST_F(ModuleAwaitAsyncTest, FutureFinishesAfterShutdownTest)
+{
+    std::atomic<int> numCalls(0);
+    std::shared_ptr<Future<int>> finishedBeforeShutdown = futureHandler.registerNewFuture<int>();
+    std::shared_ptr<Future<int>> finishedAfterShutdown = futureHandler.registerNewFuture<int>();
+    std::shared_ptr<Future<int>> finishedAfterDestruction = futureHandler.registerNewFuture<int>();
+
+    {
+        AwaitingModule module;
+        startModule(module);
+        module.awaitAndCount(finishedBeforeShutdown, numCalls);
+        module.awaitAndCount(finishedAfterShutdown, numCalls);
+        module.awaitAndCount(finishedAfterDestruction, numCalls);
+
+        finishedBeforeShutdown->setResponse(makeIntResponse(1));
+        while(numCalls < 1)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        module.shutdown();
+        finishedAfterShutdown->setResponse(makeIntResponse(2));
+    }
+
+    // The Module does not exist anymore, the continuation has to be dropped.
+    finishedAfterDestruction->setResponse(makeIntResponse(3));
+    ASSERT_EQ(numCalls, 1);
+}
+
+#ifdef CLAID_COROUTINES_SUPPORTED
+
+// Resumes coroutines on a dedicated thread, like the RunnableDispatcher of a Module.
+class TestExecutor
+{
+    public:
+        SharedQueue<std::function<void()>> queue;
+        std::thread thread;
+
+        TestExecutor()
+        {
+            thread = std::thread([this]()
+            {
+                std::shared_ptr<std::function<void()>> function;
+                while((function = queue.pop_front()) != nullptr && *function != nullptr)
+                {
+                    (*function)();
+                }
+            });
+        }
+
+        ~TestExecutor()
+        {
+            queue.push_back(std::make_shared<std::function<void()>>(nullptr));
+            thread.join();
+        }
+
+        FutureContinuationExecutor getExecutor()
+        {
+            return [this](std::function<void()> function) { queue.push_back(std::make_shared<std::function<void()>>(function)); };
+        }
+};
+
+ModuleTask sumOfFutures(std::vector<std::shared_ptr<Future<int>>> futures, FutureContinuationExecutor executor, 
+    std::thread::id expectedThread, std::promise<int>& result)
+{
+    int sum = 0;
+    for(std::shared_ptr<Future<int>>& future : futures)
+    {
+        sum += co_await FutureAwaiter<int>(future, executor);
+        if(std::this_thread::get_id() != expectedThread)
+        {
+            sum = -1;
+            break;
+        }
+    }
+    result.set_value(sum);
+}
+
+TEST(FutureAwaiterTest, CoroutineTest)
+{
+    FutureHandler handler;
+    TestExecutor executor;
+
+    std::vector<std::shared_ptr<Future<int>>> futures;
+    for(int i = 0; i < 10; i++)
+    {
+        futures.push_back(handler.registerNewFuture<int>());
+    }
+
+    std::promise<int> result;
+    executor.queue.push_back(std::make_shared<std::function<void()>>([&]()
+    {
+        sumOfFutures(futures, executor.getExecutor(), executor.thread.get_id(), result);
+    }));
+
+    // Responses arrive on another thread while the coroutine is suspended.
+    for(int i = 0; i < 10; i++)
+    {
+        futures[i]->setResponse(makeIntResponse(i));
+    }
+
+    ASSERT_EQ(result.get_future().get(), 45);
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+
+#include "dispatch/core/RemoteFunction/FutureHandler.hh"
+
+#include <thread>
+#include <vector>
+
+using namespace claid;
+
+TEST(FuturesTableTest, FutureUniqueIdentifierTest)
+{
+    FutureUniqueIdentifier first = FutureUniqueIdentifier::makeUniqueIdentifier();
+    FutureUniqueIdentifier second = FutureUniqueIdentifier::makeUniqueIdentifier();
+
+    ASSERT_TRUE(first.isValid());
+    ASSERT_FALSE(first == second);
+    ASSERT_EQ(first.getRuntime(), Runtime::RUNTIME_CPP);
+
+    ASSERT_TRUE(FutureUniqueIdentifier::fromString(first.toString()) == first);
+    ASSERT_TRUE(FutureUniqueIdentifier::fromId(second.getId()) == second);
+    ASSERT_FALSE(FutureUniqueIdentifier::fromString("not_a_number").isValid());
+    ASSERT_FALSE(FutureUniqueIdentifier().isValid());
+}
+
+TEST(FuturesTableTest, AddLookupTakeTest)
+{
+    FuturesTable table;
+    std::vector<std::shared_ptr<Future<int>>> futures;
+
+    // Enough Futures to make every stripe grow several times.
+    for(int i = 0; i < 1000; i++)
+    {
+        futures.push_back(std::make_shared<Future<int>>(table, FutureUniqueIdentifier::makeUniqueIdentifier()));
+        table.addFuture(futures.back());
+    }
+    ASSERT_EQ(table.size(), 1000);
+
+    for(size_t i = 0; i < futures.size(); i += 2)
+    {
+        ASSERT_EQ(table.takeFuture(futures[i]->getUniqueIdentifier()), futures[i]);
+        ASSERT_EQ(table.takeFuture(futures[i]->getUniqueIdentifier()), nullptr);
+    }
+    ASSERT_EQ(table.size(), 500);
+
+    // Entries which were shifted during deletion must still be found.
+    for(size_t i = 1; i < futures.size(); i += 2)
+    {
+        ASSERT_EQ(table.lookupFuture(futures[i]->getUniqueIdentifier()), futures[i]);
+        ASSERT_TRUE(table.removeFuture(futures[i]->getUniqueIdentifier()));
+    }
+    ASSERT_EQ(table.size(), 0);
+    ASSERT_EQ(table.lookupFuture(FutureUniqueIdentifier()), nullptr);
+}
+
+TEST(FuturesTableTest, ConcurrentAccessTest)
+{
+    FutureHandler handler;
+    const int numThreads = 8;
+    const int numFuturesPerThread = 5000;
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            for(int i = 0; i < numFuturesPerThread; i++)
+            {
+                std::shared_ptr<Future<int>> future = handler.registerNewFuture<int>();
+                std::shared_ptr<AbstractFuture> lookedUp = handler.lookupFuture(future->getUniqueIdentifier());
+                ASSERT_EQ(lookedUp, future);
+
+                std::shared_ptr<AbstractFuture> taken = handler.takeFuture(future->getUniqueIdentifier());
+                ASSERT_EQ(taken, future);
+                taken->setResponse(std::make_shared<DataPackage>());
+                ASSERT_TRUE(future->wasExecutedSuccessfully());
+            }
+        });
+    }
+
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(handler.getNumOpenFutures(), 0);
+}
+
+TEST(FuturesTableTest, ExpiredFuturesAreFailedTest)
+{
+    FuturesTable table;
+
+    bool callbackCalled = false;
+    std::shared_ptr<Future<void>> expiring = std::make_shared<Future<void>>(table, FutureUniqueIdentifier::makeUniqueIdentifier());
+    expiring->then([&]() { callbackCalled = true; });
+    table.addFuture(expiring, 1);
+
+    std::shared_ptr<Future<void>> notExpiring = std::make_shared<Future<void>>(table, FutureUniqueIdentifier::makeUniqueIdentifier());
+    table.addFuture(notExpiring);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_EQ(table.evictExpiredFutures(), 1);
+    ASSERT_EQ(table.size(), 1);
+    ASSERT_TRUE(callbackCalled);
+    ASSERT_FALSE(expiring->wasExecutedSuccessfully());
+    ASSERT_EQ(table.lookupFuture(expiring->getUniqueIdentifier()), nullptr);
+
+    // A late response of an expired Future is ignored.
+    expiring->setResponse(std::make_shared<DataPackage>());
+    ASSERT_FALSE(expiring->wasExecutedSuccessfully());
+}
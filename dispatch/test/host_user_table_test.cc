@@ -0,0 +1,175 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/RemoteDispatching/HostUserTable.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace claid;
+
+TEST(HostUserTableTestSuite, AddLookupRemoveTest)  
+{
+    HostUserTable table;
+    ASSERT_TRUE(table.addRemoteClient("phone", "user1", "device1").ok());
+    ASSERT_TRUE(table.addRemoteClient("phone", "user2", "device2").ok());
+    ASSERT_TRUE(table.addRemoteClient("phone", "user3", "device3").ok());
+    ASSERT_TRUE(table.addRemoteClient("server", "user1", "device4").ok());
+    ASSERT_EQ(table.addRemoteClient("phone", "user2", "device2").code(), absl::StatusCode::kAlreadyExists);
+
+    std::shared_ptr<SharedQueue<DataPackage>> user1Queue;
+    std::shared_ptr<SharedQueue<DataPackage>> user3Queue;
+    ASSERT_TRUE(table.lookupOutputQueueForHostUser("phone", "user1", user1Queue).ok());
+    ASSERT_TRUE(table.lookupOutputQueueForHostUser("phone", "user3", user3Queue).ok());
+
+    HostOutputQueuesPtr queues;
+    ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queues).ok());
+    ASSERT_EQ(queues->queues.size(), 3);
+
+    // Removing a user in the middle moves the last user to its position, the previous snapshot stays untouched.
+    ASSERT_TRUE(table.removeRemoteClient("phone", "user1", "device1").ok());
+    ASSERT_EQ(queues->queues.size(), 3);
+    ASSERT_EQ(table.removeRemoteClient("phone", "user1", "device1").code(), absl::StatusCode::kNotFound);
+
+    ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queues).ok());
+    ASSERT_EQ(queues->queues.size(), 2);
+    ASSERT_EQ(queues->userTokens[0], "user3");
+    ASSERT_EQ(queues->queues[0]->getQueue(), user3Queue);
+
+    std::shared_ptr<SharedQueue<DataPackage>> queue;
+    ASSERT_EQ(table.lookupOutputQueueForHostUser("phone", "user1", queue).code(), absl::StatusCode::kNotFound);
+    ASSERT_TRUE(table.lookupOutputQueueForHostUser("server", "user1", queue).ok());
+
+    // The moved user can still be removed.
+    ASSERT_TRUE(table.removeRemoteClient("phone", "user3", "device3").ok());
+    ASSERT_TRUE(table.removeRemoteClient("phone", "user2", "device2").ok());
+
+    // The host stays known, even if no user is connected anymore.
+    std::vector<std::shared_ptr<SharedQueue<DataPackage>>> queueList;
+    ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queueList).ok());
+    ASSERT_TRUE(queueList.empty());
+    ASSERT_EQ(table.lookupOutputQueuesForHost("watch", queueList).code(), absl::StatusCode::kNotFound);
+}
+
+// Routes broadcasts to 1000 users of the same host from multiple router threads,
+// while users continuously disconnect and reconnect.
+TEST(HostUserTableTestSuite, BroadcastBenchmark)  
+{
+    const int NUM_USERS = 1000;
+    const int NUM_ROUTER_THREADS = 4;
+    const int BROADCASTS_PER_THREAD = 100;
+    const int LOOKUPS_PER_THREAD = 5000;
+
+    HostUserTable table;
+    for(int i = 0; i < NUM_USERS; i++)
+    {
+        ASSERT_TRUE(table.addRemoteClient("phone", "user" + std::to_string(i), "device").ok());
+    }
+
+    std::atomic<bool> churnRunning(true);
+    std::atomic<int> numReconnects(0);
+    std::thread churnThread([&]()
+    {
+        int user = 0;
+        while(churnRunning)
+        {
+            const std::string userToken = "user" + std::to_string(user);
+            table.removeRemoteClient("phone", userToken, "device").IgnoreError();
+            table.addRemoteClient("phone", userToken, "device").IgnoreError();
+            user = (user + 1) % NUM_USERS;
+            numReconnects++;
+        }
+    });
+
+    auto runRouterThreads = [&](std::function<void()> routerFunction)
+    {
+        std::vector<std::thread> routerThreads;
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < NUM_ROUTER_THREADS; i++)
+        {
+            routerThreads.emplace_back(routerFunction);
+        }
+        for(std::thread& thread : routerThreads)
+        {
+            thread.join();
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Broadcasting, i.e., pushing a package to the queue of every user.
+    std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+    std::atomic<size_t> numPushed(0);
+    long long broadcastMicroseconds = runRouterThreads([&]()
+    {
+        for(int i = 0; i < BROADCASTS_PER_THREAD; i++)
+        {
+            HostOutputQueuesPtr queues;
+            ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queues).ok());
+            // At most one user is disconnected at any time.
+            ASSERT_GE(queues->queues.size(), NUM_USERS - 1);
+            for(const std::shared_ptr<ClientOutputQueue>& queue : queues->queues)
+            {
+                queue->push(package);
+            }
+            numPushed += queues->queues.size();
+        }
+    });
+
+    // Lookups only, with and without copying the list of queues.
+    long long snapshotLookupMicroseconds = runRouterThreads([&]()
+    {
+        for(int i = 0; i < LOOKUPS_PER_THREAD; i++)
+        {
+            HostOutputQueuesPtr queues;
+            ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queues).ok());
+        }
+    });
+    long long copyLookupMicroseconds = runRouterThreads([&]()
+    {
+        std::vector<std::shared_ptr<SharedQueue<DataPackage>>> queues;
+        for(int i = 0; i < LOOKUPS_PER_THREAD; i++)
+        {
+            ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queues).ok());
+        }
+    });
+
+    churnRunning = false;
+    churnThread.join();
+
+    Logger::logInfo("HostUserTable with %d users: %d broadcasts (%zu packages) in %lld us, %d snapshot lookups in %lld us, "
+        "%d copying lookups in %lld us, %d reconnects in the meantime", 
+        NUM_USERS, NUM_ROUTER_THREADS * BROADCASTS_PER_THREAD, numPushed.load(), broadcastMicroseconds,
+        NUM_ROUTER_THREADS * LOOKUPS_PER_THREAD, snapshotLookupMicroseconds,
+        NUM_ROUTER_THREADS * LOOKUPS_PER_THREAD, copyLookupMicroseconds, numReconnects.load());
+
+    HostOutputQueuesPtr queues;
+    ASSERT_TRUE(table.lookupOutputQueuesForHost("phone", queues).ok());
+    ASSERT_EQ(queues->queues.size(), NUM_USERS);
+    for(int i = 0; i < NUM_USERS; i++)
+    {
+        std::shared_ptr<SharedQueue<DataPackage>> queue;
+        ASSERT_TRUE(table.lookupOutputQueueForHostUser("phone", "user" + std::to_string(i), queue).ok());
+    }
+}
@@ -0,0 +1,217 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+#include "dispatch/core/InProcessDispatching/ByteRing.hh"
+#include "dispatch/core/InProcessDispatching/InProcessTransport.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+using namespace claid;
+using namespace claidservice;
+
+TEST(InProcessTransportTestSuite, ByteRingWrapAroundTest)
+{
+    ByteRing ring(64);
+    ASSERT_EQ(ring.capacity(), 64);
+
+    std::string message;
+    // Messages of different sizes make the write position wrap at different offsets.
+    for(int i = 0; i < 1000; i++)
+    {
+        std::string data(1 + (i % 37), static_cast<char>('a' + (i % 26)));
+        ASSERT_TRUE(ring.tryPush(data.data(), data.size()));
+        ASSERT_EQ(ring.peekSize(), static_cast<int64_t>(data.size()));
+        ASSERT_TRUE(ring.tryPop(message));
+        ASSERT_EQ(message, data);
+    }
+    ASSERT_TRUE(ring.empty());
+
+    // Full ring and messages which can never fit.
+    std::string data(ring.maxMessageSize(), 'x');
+    ASSERT_FALSE(ring.tryPush(data.data(), data.size() + 1));
+    ASSERT_TRUE(ring.tryPush(data.data(), data.size()));
+    ASSERT_FALSE(ring.tryPush("y", 1));
+
+    char small[8];
+    ASSERT_EQ(ring.tryPop(small, sizeof(small)), -1);
+    ASSERT_TRUE(ring.tryPop(message));
+    ASSERT_EQ(message, data);
+}
+
+TEST(InProcessTransportTestSuite, RingChannelOrderAndBackpressureTest)
+{
+    // Small ring, so that the producer has to wait for the consumer frequently.
+    RingChannel channel(256);
+    const int numMessages = 100000;
+
+    std::thread producer([&]()
+    {
+        for(int i = 0; i < numMessages; i++)
+        {
+            ASSERT_EQ(channel.push(&i, sizeof(i), -1), static_cast<int64_t>(sizeof(i)));
+        }
+    });
+
+    for(int i = 0; i < numMessages; i++)
+    {
+        ASSERT_EQ(channel.waitForMessage(-1), static_cast<int64_t>(sizeof(int)));
+        int value;
+        ASSERT_EQ(channel.tryPop(&value, sizeof(value)), static_cast<int64_t>(sizeof(value)));
+        ASSERT_EQ(value, i);
+    }
+    producer.join();
+
+    ASSERT_EQ(channel.waitForMessage(10), RingChannel::TIMEOUT);
+}
+
+TEST(InProcessTransportTestSuite, RingChannelOversizedMessagesTest)
+{
+    RingChannel channel(256);
+    const int numMessages = 1000;
+
+    // Every third message is larger than the ring and has to be passed outside of it, without changing the order.
+    auto makeMessage = [](int i) { return std::string(i % 3 == 0 ? 1000 + i : 1 + i % 50, static_cast<char>('a' + (i % 26))); };
+
+    std::thread producer([&]()
+    {
+        for(int i = 0; i < numMessages; i++)
+        {
+            std::string message = makeMessage(i);
+            ASSERT_EQ(channel.push(message.data(), message.size(), -1), static_cast<int64_t>(message.size()));
+        }
+    });
+
+    std::string buffer(4096, '\0');
+    std::string message;
+    for(int i = 0; i < numMessages; i++)
+    {
+        std::string expected = makeMessage(i);
+        ASSERT_EQ(channel.waitForMessage(-1), static_cast<int64_t>(expected.size()));
+        if(i % 2 == 0)
+        {
+            // Too small buffers keep the message.
+            ASSERT_EQ(channel.tryPop(&buffer[0], expected.size() - 1), RingChannel::TIMEOUT);
+            ASSERT_EQ(channel.tryPop(&buffer[0], buffer.size()), static_cast<int64_t>(expected.size()));
+            ASSERT_EQ(buffer.substr(0, expected.size()), expected);
+        }
+        else
+        {
+            ASSERT_TRUE(channel.pop(message, -1));
+            ASSERT_EQ(message, expected);
+        }
+    }
+    producer.join();
+
+    // Oversized packages reach the Runtime as well.
+    InProcessTransport transport(Runtime::RUNTIME_PYTHON, 256);
+    DataPackage package;
+    package.set_channel(std::string(1000, 'c'));
+    ASSERT_TRUE(transport.sendToRuntime(package));
+
+    std::string serialized;
+    ASSERT_TRUE(transport.toRuntime().pop(serialized, 0));
+    DataPackage received;
+    ASSERT_TRUE(received.ParseFromString(serialized));
+    ASSERT_EQ(received.channel(), package.channel());
+}
+
+TEST(InProcessTransportTestSuite, CloseUnblocksBothSidesTest)
+{
+    InProcessTransport transport(Runtime::RUNTIME_PYTHON, 1024);
+
+    std::thread receiver([&]()
+    {
+        DataPackage package;
+        ASSERT_FALSE(transport.receiveFromRuntime(package));
+    });
+
+    // Fill the ring towards the Runtime, the next send blocks until the transport is closed.
+    DataPackage package;
+    package.set_channel(std::string(400, 'c'));
+    ASSERT_TRUE(transport.sendToRuntime(package));
+    ASSERT_TRUE(transport.sendToRuntime(package));
+    std::thread sender([&]()
+    {
+        ASSERT_FALSE(transport.sendToRuntime(package));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    transport.close();
+    receiver.join();
+    sender.join();
+
+    // Packages sent before closing can still be received by the Runtime.
+    ASSERT_GT(transport.toRuntime().waitForMessage(0), 0);
+}
+
+TEST(InProcessTransportTestSuite, InProcessTransportBenchmark)
+{
+    InProcessTransport transport(Runtime::RUNTIME_PYTHON, 4 * 1024 * 1024);
+    const int numPackages = 200000;
+
+    DataPackage package;
+    package.set_source_module("Producer");
+    package.set_target_module("Consumer");
+    package.set_channel("Data");
+    package.mutable_payload()->set_message_type("claidservice.NumberVal");
+    package.mutable_payload()->set_payload(std::string(128, 'p'));
+
+    // The Runtime echoes every package back, like a Module forwarding data.
+    std::thread runtime([&]()
+    {
+        std::string buffer(64 * 1024, '\0');
+        for(int i = 0; i < numPackages; i++)
+        {
+            if(transport.toRuntime().waitForMessage(-1) < 0)
+            {
+                return;
+            }
+            int64_t size = transport.toRuntime().tryPop(&buffer[0], buffer.size());
+            transport.fromRuntime().push(buffer.data(), size, -1);
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread writer([&]()
+    {
+        for(int i = 0; i < numPackages; i++)
+        {
+            ASSERT_TRUE(transport.sendToRuntime(package));
+        }
+    });
+
+    DataPackage received;
+    for(int i = 0; i < numPackages; i++)
+    {
+        ASSERT_TRUE(transport.receiveFromRuntime(received));
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    writer.join();
+    runtime.join();
+    ASSERT_EQ(received.channel(), "Data");
+
+    Logger::logInfo("InProcessTransport: %d packages (middleware -> runtime -> middleware) in %d us, %.0f packages/s", 
+        numPackages, static_cast<int>(duration.count()), numPackages / (duration.count() / 1e6));
+}
@@ -0,0 +1,315 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "dispatch/core/Utilities/LargePayloadStore.hh"
+#include "dispatch/core/Module/TypeMapping/TypeMapping.hh"
+#include "dispatch/core/Logger/Logger.hh"
+#include "dispatch/proto/sensor_data_types.pb.h"
+
+using namespace claid;
+using namespace claidservice;
+
+static std::string makeFrameBytes(size_t size, int seed)
+{
+    std::string data(size, '\0');
+    for(size_t i = 0; i < size; i++)
+    {
+        data[i] = static_cast<char>((i * 31 + seed) & 0xff);
+    }
+    return data;
+}
+
+static DataPackage makeImagePackage(const std::string& frameBytes)
+{
+    Image image;
+    image.set_data(frameBytes);
+    image.set_width(1920);
+    image.set_height(1080);
+
+    DataPackage package;
+    package.set_channel("CameraFrames");
+    TypeMapping::getMutator<Image>().setPackagePayload(package, image);
+    return package;
+}
+
+TEST(LargePayloadTestSuite, SharedMemorySegmentTest)
+{
+    if(!SharedMemorySegment::isSupported())
+    {
+        GTEST_SKIP() << "Shared memory segments are not supported on this platform.";
+    }
+
+    const std::string data = makeFrameBytes(1024 * 1024, 3);
+    std::shared_ptr<SharedMemorySegment> segment;
+    ASSERT_TRUE(SharedMemorySegment::create(data.data(), data.size(), segment).ok());
+    const SharedMemoryHandle handle = segment->getHandle();
+
+    std::unique_ptr<SharedMemoryMapping> mapping;
+    ASSERT_TRUE(SharedMemoryMapping::map(handle, mapping).ok());
+    ASSERT_EQ(mapping->size(), data.size());
+    ASSERT_EQ(std::string(mapping->data(), mapping->size()), data);
+
+    // Existing mappings stay valid after the creator released the segment, but new mappings fail.
+    segment = nullptr;
+    ASSERT_EQ(std::string(mapping->data(), mapping->size()), data);
+    std::unique_ptr<SharedMemoryMapping> lateMapping;
+    ASSERT_FALSE(SharedMemoryMapping::map(handle, lateMapping).ok());
+}
+
+TEST(LargePayloadTestSuite, SharedMemorySegmentReusedFileDescriptorTest)
+{
+    if(!SharedMemorySegment::isSupported())
+    {
+        GTEST_SKIP() << "Shared memory segments are not supported on this platform.";
+    }
+
+    // The file descriptor of a released segment was reused for a smaller file.
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fwrite("small", 1, 5, file), 5);
+    ASSERT_EQ(fflush(file), 0);
+
+    SharedMemoryHandle handle;
+    handle.set_pid(getpid());
+    handle.set_fd(fileno(file));
+    handle.set_segment_id(42);
+    handle.set_size(1024 * 1024);
+
+    std::unique_ptr<SharedMemoryMapping> mapping;
+    absl::Status status = SharedMemoryMapping::map(handle, mapping);
+    fclose(file);
+    ASSERT_FALSE(status.ok());
+    ASSERT_EQ(mapping, nullptr);
+}
+
+TEST(LargePayloadTestSuite, SharedMemorySegmentOtherProcessTest)
+{
+    if(!SharedMemorySegment::isSupported())
+    {
+        GTEST_SKIP() << "Shared memory segments are not supported on this platform.";
+    }
+
+    const std::string data = makeFrameBytes(512 * 1024, 7);
+    std::shared_ptr<SharedMemorySegment> segment;
+    ASSERT_TRUE(SharedMemorySegment::create(data.data(), data.size(), segment).ok());
+    const SharedMemoryHandle handle = segment->getHandle();
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if(child == 0)
+    {
+        // Maps the segment of the parent process via /proc/<pid>/fd.
+        std::unique_ptr<SharedMemoryMapping> mapping;
+        bool equal = SharedMemoryMapping::map(handle, mapping).ok() && 
+            std::string(mapping->data(), mapping->size()) == data;
+        _exit(equal ? 0 : 1);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(LargePayloadTestSuite, OffloadAndDecodeTest)
+{
+    LargePayloadStore* store = LargePayloadStore::getInstance();
+    if(store->getThreshold() == 0)
+    {
+        GTEST_SKIP() << "Large payloads are not supported on this platform.";
+    }
+
+    // Small payloads stay inline.
+    DataPackage smallPackage = makeImagePackage(makeFrameBytes(1024, 1));
+    ASSERT_FALSE(store->isLarge(smallPackage));
+    ASSERT_FALSE(store->offloadIfLarge(smallPackage));
+    ASSERT_FALSE(smallPackage.payload().has_shared_memory());
+
+    const std::string frameBytes = makeFrameBytes(1920 * 1080 * 3, 2);
+    DataPackage package = makeImagePackage(frameBytes);
+    const std::string messageType = package.payload().message_type();
+    ASSERT_TRUE(store->isLarge(package));
+    ASSERT_TRUE(store->offloadIfLarge(package));
+    ASSERT_TRUE(package.payload().has_shared_memory());
+    ASSERT_TRUE(package.payload().payload().empty());
+    ASSERT_EQ(package.payload().message_type(), messageType);
+    ASSERT_LT(package.ByteSizeLong(), 256);
+
+    // Already offloaded packages are not offloaded again.
+    ASSERT_FALSE(store->isLarge(package));
+    ASSERT_FALSE(store->offloadIfLarge(package));
+
+    Image image;
+    TypeMapping::getMutator<Image>().getPackagePayload(package, image);
+    ASSERT_EQ(image.data(), frameBytes);
+    ASSERT_EQ(image.width(), 1920);
+
+    AnyProtoType anyProto;
+    TypeMapping::getMutator<AnyProtoType>().getPackagePayload(package, anyProto);
+    ASSERT_NE(anyProto.getMessage(), nullptr);
+    ASSERT_EQ(static_cast<const Image&>(*anyProto.getMessage()).data(), frameBytes);
+
+    // Packages leaving the host (or going to other runtimes) are inlined, the original package stays unchanged.
+    std::shared_ptr<DataPackage> sharedPackage = std::make_shared<DataPackage>(package);
+    std::shared_ptr<DataPackage> original = sharedPackage;
+    ASSERT_TRUE(LargePayloadStore::inlineSharedMemoryCopy(sharedPackage).ok());
+    ASSERT_NE(sharedPackage, original);
+    ASSERT_FALSE(sharedPackage->payload().has_shared_memory());
+    ASSERT_TRUE(original->payload().has_shared_memory());
+
+    Image inlinedImage;
+    TypeMapping::getMutator<Image>().getPackagePayload(*sharedPackage, inlinedImage);
+    ASSERT_EQ(inlinedImage.data(), frameBytes);
+}
+
+TEST(LargePayloadTestSuite, LeaseExpirationTest)
+{
+    LargePayloadStore* store = LargePayloadStore::getInstance();
+    if(store->getThreshold() == 0)
+    {
+        GTEST_SKIP() << "Large payloads are not supported on this platform.";
+    }
+
+    store->setLeaseDuration(std::chrono::milliseconds(50));
+    const size_t numLeasedSegments = store->getNumLeasedSegments();
+    DataPackage package = makeImagePackage(makeFrameBytes(1024 * 1024, 4));
+    ASSERT_TRUE(store->offloadIfLarge(package));
+    ASSERT_EQ(store->getNumLeasedSegments(), numLeasedSegments + 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_LE(store->getNumLeasedSegments(), numLeasedSegments);
+
+    Image image;
+    ASSERT_FALSE(LargePayloadStore::parseBlobPayload(package.payload(), image));
+
+    // Payloads exceeding the budget of leased bytes are sent inline.
+    store->setLeaseDuration(std::chrono::milliseconds(5000));
+    store->setMaxLeasedBytes(512 * 1024);
+    DataPackage tooLarge = makeImagePackage(makeFrameBytes(1024 * 1024, 5));
+    ASSERT_FALSE(store->offloadIfLarge(tooLarge));
+    ASSERT_FALSE(tooLarge.payload().has_shared_memory());
+    store->setMaxLeasedBytes(LargePayloadStore::DEFAULT_MAX_LEASED_BYTES);
+}
+
+TEST(LargePayloadTestSuite, TakeDeliveryTest)
+{
+    LargePayloadStore* store = LargePayloadStore::getInstance();
+    if(store->getThreshold() == 0)
+    {
+        GTEST_SKIP() << "Large payloads are not supported on this platform.";
+    }
+
+    // Shorter than the time the package is queued below.
+    store->setLeaseDuration(std::chrono::milliseconds(50));
+    const std::string frameBytes = makeFrameBytes(1024 * 1024, 6);
+    DataPackage sentPackage = makeImagePackage(frameBytes);
+    ASSERT_TRUE(store->offloadIfLarge(sentPackage));
+
+    std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>(sentPackage);
+    ASSERT_TRUE(store->takeDelivery(package).ok());
+    ASSERT_NE(package->payload().shared_memory().fd(), sentPackage.payload().shared_memory().fd());
+
+    // A copy made while the package is queued, e.g. by the ModuleTable for every subscriber.
+    std::shared_ptr<DataPackage> copy = std::make_shared<DataPackage>(*package);
+    store->holdSharedMemory(copy);
+    package = nullptr;
+
+    // Expired leases are released lazily.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    store->getNumLeasedSegments();
+    Image image;
+    ASSERT_FALSE(LargePayloadStore::parseBlobPayload(sentPackage.payload(), image));
+    ASSERT_TRUE(LargePayloadStore::parseBlobPayload(copy->payload(), image));
+    ASSERT_EQ(image.data(), frameBytes);
+
+    // Released segments are leased, afterward they cannot be delivered anymore.
+    const SharedMemoryHandle deliveredHandle = copy->payload().shared_memory();
+    copy = nullptr;
+    std::unique_ptr<SharedMemoryMapping> mapping;
+    ASSERT_TRUE(SharedMemoryMapping::map(deliveredHandle, mapping).ok());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    store->getNumLeasedSegments();
+    ASSERT_FALSE(SharedMemoryMapping::map(deliveredHandle, mapping).ok());
+
+    std::shared_ptr<DataPackage> latePackage = std::make_shared<DataPackage>(sentPackage);
+    ASSERT_FALSE(store->takeDelivery(latePackage).ok());
+    store->setLeaseDuration(std::chrono::milliseconds(5000));
+}
+
+// Simulates a 30 fps camera pipeline in which every frame is received by a consumer in another runtime.
+// Inline, the frame is serialized into the gRPC stream and parsed again by every hop; offloaded, only the handle is.
+TEST(LargePayloadTestSuite, CameraPipelineBenchmark)
+{
+    LargePayloadStore* store = LargePayloadStore::getInstance();
+    if(store->getThreshold() == 0)
+    {
+        GTEST_SKIP() << "Large payloads are not supported on this platform.";
+    }
+
+    const int numFrames = 30;
+    const std::string frameBytes = makeFrameBytes(1920 * 1080 * 3, 6);
+
+    size_t inlineWireBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < numFrames; i++)
+    {
+        DataPackage package = makeImagePackage(frameBytes);
+        std::string wire = package.SerializeAsString();
+        inlineWireBytes += wire.size();
+
+        DataPackage received;
+        ASSERT_TRUE(received.ParseFromString(wire));
+        Image image;
+        TypeMapping::getMutator<Image>().getPackagePayload(received, image);
+        ASSERT_EQ(image.data().size(), frameBytes.size());
+    }
+    auto inlineDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    size_t offloadedWireBytes = 0;
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < numFrames; i++)
+    {
+        DataPackage package = makeImagePackage(frameBytes);
+        ASSERT_TRUE(store->offloadIfLarge(package));
+        std::string wire = package.SerializeAsString();
+        offloadedWireBytes += wire.size();
+
+        DataPackage received;
+        ASSERT_TRUE(received.ParseFromString(wire));
+        Image image;
+        TypeMapping::getMutator<Image>().getPackagePayload(received, image);
+        ASSERT_EQ(image.data().size(), frameBytes.size());
+    }
+    auto offloadedDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    Logger::logInfo("CameraPipelineBenchmark: %d frames of %zu bytes. Inline: %zu bytes on the wire, %lld us. Shared memory: %zu bytes on the wire, %lld us.",
+        numFrames, frameBytes.size(), inlineWireBytes, static_cast<long long>(inlineDuration.count()), 
+        offloadedWireBytes, static_cast<long long>(offloadedDuration.count()));
+
+    ASSERT_LT(offloadedWireBytes * 1000, inlineWireBytes);
+}
@@ -176,6 +176,9 @@ TEST(LocalDispatcherTestSuite, SocketBasedDispatcherTest) {
     Logger::logInfo("local_dispatching_test 5");
     ASSERT_EQ(gotPkt12->source_module(), mod1);
     ASSERT_EQ(gotPkt12->target_module(), mod2);
+    // The client restores the names, the routing IDs negotiated in the handshake are kept.
+    ASSERT_EQ(gotPkt12->target_module_id(), modTable.getRoutingIds().modules.lookupId(mod2));
+    RoutingIdTable::clearIds(*gotPkt12);
     diff = cmpMsg(*pkt12, *gotPkt12);
     Logger::logInfo("local_dispatching_test 6");
     ASSERT_TRUE(diff == "") << diff;
@@ -185,6 +188,9 @@ TEST(LocalDispatcherTestSuite, SocketBasedDispatcherTest) {
     Logger::logInfo("local_dispatching_test 8");
     ASSERT_EQ(gotPkt13->source_module(), mod1);
     ASSERT_EQ(gotPkt13->target_module(), mod3);
+    // The client restores the names, the routing IDs negotiated in the handshake are kept.
+    ASSERT_EQ(gotPkt13->target_module_id(), modTable.getRoutingIds().modules.lookupId(mod3));
+    RoutingIdTable::clearIds(*gotPkt13);
     diff = cmpMsg(*pkt13, *gotPkt13);
     ASSERT_TRUE(diff == "") << diff;
     Logger::logInfo("local_dispatching_test 9");
@@ -192,6 +198,9 @@ TEST(LocalDispatcherTestSuite, SocketBasedDispatcherTest) {
     auto gotPkt23 = inQueue.pop_front();
     ASSERT_EQ(gotPkt23->source_module(), mod2);
     ASSERT_EQ(gotPkt23->target_module(), mod3);
+    // The client restores the names, the routing IDs negotiated in the handshake are kept.
+    ASSERT_EQ(gotPkt23->target_module_id(), modTable.getRoutingIds().modules.lookupId(mod3));
+    RoutingIdTable::clearIds(*gotPkt23);
     diff = cmpMsg(*pkt23, *gotPkt23);
     ASSERT_TRUE(diff == "") << diff;
 
@@ -92,3 +92,56 @@ TEST(ModuleTableTestSuite, BasicModuleTableTest) {
     modTable.forwardPackageToAllSubscribers(*cpPkt, entry, outQueue);
     ASSERT_TRUE(outQueue.size() == 2);
 }
+
+// Removing Modules (as done when reloading a config) only affects the channel entries of those Modules.
+TEST(ModuleTableTestSuite, RemoveModulesTest) {
+    ModuleTable modTable;
+    for(auto& m : testModules) {
+        modTable.setNeededModule(m.modId, m.modClass, m.props);
+        modTable.setModuleChannelToConnectionMappings(m.modId, channelToConnectionMappings, channelToConnectionMappings);
+    }
+
+    map<string, vector<DataPackage>> pktsVecMap;
+    for(auto pkt : testChannels) {
+        modTable.setExpectedChannel(pkt->channel(), pkt->source_module(), pkt->target_module());
+
+        auto cpPkt = *pkt;
+        cpPkt.clear_target_module();
+        pktsVecMap[cpPkt.source_module()].push_back(cpPkt);
+
+        cpPkt = *pkt;
+        cpPkt.clear_source_module();
+        pktsVecMap[cpPkt.target_module()].push_back(cpPkt);
+    }
+
+    for(auto modIt : pktsVecMap) {
+        google::protobuf::RepeatedPtrField<claidservice::DataPackage> chanTypes(modIt.second.begin(), modIt.second.end());
+        ASSERT_TRUE(modTable.setChannelTypes(modIt.first, chanTypes).ok());
+    }
+    ASSERT_TRUE(modTable.ready());
+
+    modTable.removeModules({mod5});
+    ASSERT_TRUE(modTable.ready());
+
+    SharedQueue<claidservice::DataPackage> outQueue;
+    auto entry = modTable.isValidChannel(*chan14Pkt);
+    ASSERT_TRUE(entry != nullptr);
+    modTable.forwardPackageToAllSubscribers(*chan14Pkt, entry, outQueue);
+    ASSERT_EQ(outQueue.size(), 1);
+
+    // Adding the Module again keeps the registered types of the other Modules.
+    modTable.setModuleChannelToConnectionMappings(mod5, channelToConnectionMappings, channelToConnectionMappings);
+    modTable.setExpectedChannel(chan15Pkt->channel(), mod1, mod5);
+    modTable.setExpectedChannel(chan25Pkt->channel(), mod2, mod5);
+    ASSERT_FALSE(modTable.ready());
+
+    google::protobuf::RepeatedPtrField<claidservice::DataPackage> chanTypes(pktsVecMap[mod5].begin(), pktsVecMap[mod5].end());
+    ASSERT_TRUE(modTable.setChannelTypes(mod5, chanTypes).ok());
+    ASSERT_TRUE(modTable.ready());
+
+    while(outQueue.try_pop_front() != nullptr) {}
+    entry = modTable.isValidChannel(*chan14Pkt);
+    ASSERT_TRUE(entry != nullptr);
+    modTable.forwardPackageToAllSubscribers(*chan14Pkt, entry, outQueue);
+    ASSERT_EQ(outQueue.size(), 2);
+}
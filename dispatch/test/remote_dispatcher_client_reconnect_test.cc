@@ -0,0 +1,139 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/RemoteDispatching/RemoteDispatcherServer.hh"
+#include "dispatch/core/RemoteDispatching/RemoteDispatcherClient.hh"
+#include "dispatch/core/RemoteDispatching/ReconnectBackoff.hh"
+#include "dispatch/core/RemoteDispatching/HostUserTable.hh"
+#include "dispatch/core/RemoteDispatching/ClientTable.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <chrono>
+#include <thread>
+
+using namespace claid;
+using namespace claidservice;
+
+const std::string RECONNECT_TEST_ADDRESS = "unix:///tmp/remote_dispatcher_client_reconnect_test.sock";
+const int NUM_INJECTED_DISCONNECTS = 5;
+
+// Only guards against hangs, the time to the first package is measured and logged, but not asserted,
+// as it depends on the load of the machine running the test.
+const std::chrono::seconds MAX_TIME_TO_FIRST_PACKAGE(30);
+
+TEST(RemoteDispatcherClientReconnectTestSuite, ReconnectBackoffTest)
+{
+    ReconnectBackoff backoff(Duration::milliseconds(100), Duration::milliseconds(1000), 2.0, 0.2);
+
+    double expectedMs = 100;
+    for(int i = 0; i < 10; i++)
+    {
+        uint64_t delayMs = backoff.nextDelay().getMilliSeconds();
+        ASSERT_GE(delayMs, static_cast<uint64_t>(expectedMs * 0.8) - 1);
+        ASSERT_LE(delayMs, static_cast<uint64_t>(expectedMs * 1.2));
+        expectedMs = std::min(expectedMs * 2, 1000.0);
+    }
+    ASSERT_EQ(backoff.getNumAttempts(), 10);
+
+    backoff.reset();
+    ASSERT_EQ(backoff.getNumAttempts(), 0);
+    ASSERT_LE(backoff.nextDelay().getMilliSeconds(), 120);
+}
+
+// Restarts the server several times while the client keeps sending packages, 
+// and measures the time until the first package queued during the outage was delivered.
+TEST(RemoteDispatcherClientReconnectTestSuite, TimeToFirstPackageAfterDisconnectTest)
+{
+    HostUserTable hostUserTable;
+    RemoteDispatcherServer server(RECONNECT_TEST_ADDRESS, hostUserTable);
+    ASSERT_TRUE(server.start().ok());
+
+    ClientTable clientTable;
+    RemoteDispatcherClient client(RECONNECT_TEST_ADDRESS, "reconnect_test_device", "user", "device", clientTable);
+    client.setReconnectBackoff(Duration::milliseconds(50), Duration::milliseconds(500));
+    ASSERT_TRUE(client.start().ok());
+
+    SharedQueue<DataPackage>& serverInputQueue = *hostUserTable.inputQueue();
+    auto waitForPackage = [&](const std::string& channel)
+    {
+        auto deadline = std::chrono::steady_clock::now() + MAX_TIME_TO_FIRST_PACKAGE;
+        while(std::chrono::steady_clock::now() < deadline)
+        {
+            std::shared_ptr<DataPackage> package = serverInputQueue.try_pop_front();
+            if(package == nullptr)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if(package->channel() == channel)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto sendPackage = [&](const std::string& channel)
+    {
+        std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+        package->set_channel(channel);
+        clientTable.getToRemoteClientQueue().push_back(package);
+    };
+
+    sendPackage("initial");
+    ASSERT_TRUE(waitForPackage("initial"));
+
+    std::chrono::milliseconds totalTime(0);
+    for(int i = 0; i < NUM_INJECTED_DISCONNECTS; i++)
+    {
+        server.shutdown();
+
+        // A package written right before the client noticed the disconnect might be lost with the stream.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while(client.isConnected() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_FALSE(client.isConnected());
+
+        // Packages sent during the outage are kept and delivered after reconnecting.
+        const std::string channel = "after_disconnect_" + std::to_string(i);
+        sendPackage(channel);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        auto start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(server.start().ok());
+        ASSERT_TRUE(waitForPackage(channel)) << "Package queued during disconnect " << i << " was not delivered";
+        ASSERT_TRUE(client.isConnected());
+
+        std::chrono::milliseconds timeToFirstPackage = 
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        Logger::logInfo("Disconnect %d: first package delivered %lld ms after the server was available again", 
+            i, (long long) timeToFirstPackage.count());
+        totalTime += timeToFirstPackage;
+    }
+    Logger::logInfo("Average time to first package after reconnect: %lld ms", 
+        (long long) (totalTime.count() / NUM_INJECTED_DISCONNECTS));
+
+    client.shutdown();
+    server.shutdown();
+}
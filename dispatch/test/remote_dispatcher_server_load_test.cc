@@ -0,0 +1,215 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/RemoteDispatching/RemoteDispatcherServer.hh"
+#include "dispatch/core/RemoteDispatching/RemoteDispatcherClient.hh"
+#include "dispatch/core/RemoteDispatching/HostUserTable.hh"
+#include "dispatch/core/RemoteDispatching/ClientTable.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace claid;
+using namespace claidservice;
+
+// Load test for the RemoteDispatcherServer, which simulates many devices connected to the same server at the same time.
+// Each simulated device runs its own RemoteDispatcherClient in-process. Packages are sent from all devices to the server
+// and from the server to all devices. The test is run for both the synchronous and the asynchronous server.
+const int NUM_SIMULATED_DEVICES = 128;
+const int PACKAGES_PER_DEVICE = 50;
+const int NUM_ASYNC_SERVER_THREADS = 4;
+const std::string DEVICE_HOST = "load_test_device";
+const std::chrono::seconds LOAD_TEST_TIMEOUT(60);
+
+struct SimulatedDevice
+{
+    std::string userToken;
+    ClientTable clientTable;
+    std::unique_ptr<RemoteDispatcherClient> client;
+    int numReceivedPackages = 0;
+};
+
+template<typename Predicate>
+bool waitUntil(Predicate predicate)
+{
+    auto deadline = std::chrono::steady_clock::now() + LOAD_TEST_TIMEOUT;
+    while(!predicate())
+    {
+        if(std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+void runServerLoadTest(RemoteServerThreadingModel threadingModel, const std::string& address)
+{
+    HostUserTable hostUserTable;
+    RemoteDispatcherServer server(address, hostUserTable, threadingModel, NUM_ASYNC_SERVER_THREADS);
+    ASSERT_TRUE(server.start().ok());
+
+    std::vector<std::unique_ptr<SimulatedDevice>> devices;
+    for(int i = 0; i < NUM_SIMULATED_DEVICES; i++)
+    {
+        std::unique_ptr<SimulatedDevice> device = std::make_unique<SimulatedDevice>();
+        device->userToken = "user_" + std::to_string(i);
+        device->client = std::make_unique<RemoteDispatcherClient>(
+            address, DEVICE_HOST, device->userToken, "device_" + std::to_string(i), device->clientTable);
+        ASSERT_TRUE(device->client->start().ok());
+        devices.push_back(std::move(device));
+    }
+
+    auto allConnected = [&]()
+    {
+        for(const std::unique_ptr<SimulatedDevice>& device : devices)
+        {
+            if(!device->client->isConnected())
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    ASSERT_TRUE(waitUntil(allConnected)) << "Not all simulated devices connected to the server";
+
+    // Devices -> server.
+    auto start = std::chrono::steady_clock::now();
+    for(const std::unique_ptr<SimulatedDevice>& device : devices)
+    {
+        for(int i = 0; i < PACKAGES_PER_DEVICE; i++)
+        {
+            std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+            package->set_channel("LoadTestChannel");
+            package->set_source_host(DEVICE_HOST);
+            package->set_source_user_token(device->userToken);
+            package->mutable_payload()->set_payload(std::string(256, 'x'));
+            device->clientTable.getToRemoteClientQueue().push_back(package);
+        }
+    }
+
+    SharedQueue<DataPackage>& serverInputQueue = *hostUserTable.inputQueue();
+    std::map<std::string, int> packagesPerUser;
+    int numReceivedByServer = 0;
+    ASSERT_TRUE(waitUntil([&]()
+    {
+        std::shared_ptr<DataPackage> package;
+        while((package = serverInputQueue.try_pop_front()) != nullptr)
+        {
+            if(!package->has_control_val())
+            {
+                packagesPerUser[package->source_user_token()]++;
+                numReceivedByServer++;
+            }
+        }
+        return numReceivedByServer == NUM_SIMULATED_DEVICES * PACKAGES_PER_DEVICE;
+    })) << "Server received " << numReceivedByServer << " packages";
+
+    ASSERT_EQ(packagesPerUser.size(), NUM_SIMULATED_DEVICES);
+    for(const auto& entry : packagesPerUser)
+    {
+        ASSERT_EQ(entry.second, PACKAGES_PER_DEVICE) << entry.first;
+    }
+    auto upstreamDuration = std::chrono::steady_clock::now() - start;
+
+    // Server -> devices.
+    start = std::chrono::steady_clock::now();
+    for(const std::unique_ptr<SimulatedDevice>& device : devices)
+    {
+        std::shared_ptr<SharedQueue<DataPackage>> queue;
+        ASSERT_TRUE(hostUserTable.lookupOutputQueueForHostUser(DEVICE_HOST, device->userToken, queue).ok());
+        for(int i = 0; i < PACKAGES_PER_DEVICE; i++)
+        {
+            std::shared_ptr<DataPackage> package = std::make_shared<DataPackage>();
+            package->set_channel("LoadTestChannel");
+            package->set_target_host(DEVICE_HOST);
+            package->set_target_user_token(device->userToken);
+            package->mutable_payload()->set_payload(std::string(256, 'y'));
+            queue->push_back(package);
+        }
+    }
+
+    ASSERT_TRUE(waitUntil([&]()
+    {
+        bool done = true;
+        for(const std::unique_ptr<SimulatedDevice>& device : devices)
+        {
+            std::shared_ptr<DataPackage> package;
+            while((package = device->clientTable.getFromRemoteClientQueue().try_pop_front()) != nullptr)
+            {
+                if(!package->has_control_val())
+                {
+                    EXPECT_EQ(package->target_user_token(), device->userToken);
+                    device->numReceivedPackages++;
+                }
+            }
+            done &= device->numReceivedPackages == PACKAGES_PER_DEVICE;
+        }
+        return done;
+    })) << "Not all devices received their packages";
+    auto downstreamDuration = std::chrono::steady_clock::now() - start;
+
+    Logger::logInfo("%s server with %d devices: %d packages upstream in %lld ms, %d packages downstream in %lld ms",
+        RemoteServerThreadingModel_Name(threadingModel).c_str(), NUM_SIMULATED_DEVICES,
+        NUM_SIMULATED_DEVICES * PACKAGES_PER_DEVICE, 
+        (long long) std::chrono::duration_cast<std::chrono::milliseconds>(upstreamDuration).count(),
+        NUM_SIMULATED_DEVICES * PACKAGES_PER_DEVICE, 
+        (long long) std::chrono::duration_cast<std::chrono::milliseconds>(downstreamDuration).count());
+
+    // Disconnect all devices. RemoteDispatcherClient::shutdown() blocks until the stream was closed, hence in parallel.
+    std::vector<std::thread> shutdownThreads;
+    for(const std::unique_ptr<SimulatedDevice>& device : devices)
+    {
+        RemoteDispatcherClient* client = device->client.get();
+        shutdownThreads.emplace_back([client]() { client->shutdown(); });
+    }
+    for(std::thread& thread : shutdownThreads)
+    {
+        thread.join();
+    }
+
+    // The server has to forget about all clients once they disconnected.
+    ASSERT_TRUE(waitUntil([&]()
+    {
+        std::vector<std::shared_ptr<SharedQueue<DataPackage>>> queues;
+        hostUserTable.lookupOutputQueuesForHost(DEVICE_HOST, queues).IgnoreError();
+        return queues.empty();
+    })) << "Server did not unregister all disconnected clients";
+
+    server.shutdown();
+}
+
+TEST(RemoteDispatcherServerLoadTestSuite, AsyncServerLoadTest)
+{
+    runServerLoadTest(RemoteServerThreadingModel::REMOTE_SERVER_THREADING_ASYNC, 
+        "unix:///tmp/remote_dispatcher_server_load_test_async.sock");
+}
+
+TEST(RemoteDispatcherServerLoadTestSuite, SyncServerLoadTest)
+{
+    runServerLoadTest(RemoteServerThreadingModel::REMOTE_SERVER_THREADING_SYNC, 
+        "unix:///tmp/remote_dispatcher_server_load_test_sync.sock");
+}
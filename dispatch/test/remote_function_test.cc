@@ -4,12 +4,14 @@
 #include "dispatch/proto/claidservice.grpc.pb.h"
 #include "dispatch/core/RemoteFunction/RemoteFunction.hh"
 #include "dispatch/core/RemoteFunction/RemoteFunctionRunnableHandler.hh"
+#include "dispatch/core/RemoteFunction/RemoteFunctionHandler.hh"
 #include "dispatch/core/CLAID.hh"
 using claidservice::DataPackage;
 
 #include <string>
 #include <vector>
 #include <map>
+#include <thread>
 
 using namespace claid;
 
@@ -127,4 +129,202 @@ TEST(RemoteFunctionTestSuite, RemoteFunctionTest)
         std::cout << entry.first << "(" << entry.second << ")\n";
     }
 
-}
\ No newline at end of file
+}
+
+class BatchedTestClass
+{
+    public:
+        int numBatches = 0;
+
+        std::vector<std::string> testBatch(const std::vector<int>& batch)
+        {
+            numBatches++;
+            std::vector<std::string> results;
+            for(int value : batch)
+            {
+                results.push_back(std::to_string(value));
+            }
+            return results;
+        }
+
+        std::vector<int> sumBatch(const std::vector<std::tuple<int, int>>& batch)
+        {
+            numBatches++;
+            std::vector<int> results;
+            for(const std::tuple<int, int>& parameters : batch)
+            {
+                results.push_back(std::get<0>(parameters) + std::get<1>(parameters));
+            }
+            return results;
+        }
+
+        int sum(int a, int b)
+        {
+            return a + b;
+        }
+};
+
+// Forwards the requests of the caller to the callee and the responses back, as the middleware would.
+static void routeRemoteFunctionCalls(SharedQueue<DataPackage>& callerQueue, SharedQueue<DataPackage>& calleeQueue,
+    RemoteFunctionHandler& callerHandler, RemoteFunctionRunnableHandler& calleeHandler, int numRequests)
+{
+    for(int i = 0; i < numRequests; i++)
+    {
+        calleeHandler.executeRemoteFunctionRunnable(callerQueue.pop_front());
+        callerHandler.handleResponse(calleeQueue.pop_front());
+    }
+}
+
+TEST(RemoteFunctionTestSuite, BatchedRemoteFunctionTest)
+{
+    SharedQueue<DataPackage> callerQueue;
+    SharedQueue<DataPackage> calleeQueue;
+
+    RemoteFunctionHandler callerHandler(callerQueue);
+    RemoteFunctionRunnableHandler calleeHandler("Callee", calleeQueue);
+
+    BatchedTestClass testObject;
+    ASSERT_TRUE(calleeHandler.registerBatchedRunnable("testBatch", &BatchedTestClass::testBatch, &testObject));
+    ASSERT_TRUE(calleeHandler.registerBatchedRunnable("sumBatch", &BatchedTestClass::sumBatch, &testObject));
+    ASSERT_TRUE(calleeHandler.registerRunnable("sum", &BatchedTestClass::sum, &testObject));
+
+    // The whole batch is sent in one request and processed by a single call of the batched function.
+    RemoteFunction<std::string> testBatch = callerHandler.mapModuleFunction<std::string, int>("Callee", "testBatch");
+    std::vector<std::shared_ptr<Future<std::string>>> futures = testBatch.executeBatch(std::vector<int>{1, 2, 3, 4});
+    ASSERT_EQ(futures.size(), 4);
+    ASSERT_EQ(callerQueue.size(), 1);
+    routeRemoteFunctionCalls(callerQueue, calleeQueue, callerHandler, calleeHandler, 1);
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        ASSERT_EQ(futures[i]->await(), std::to_string(i + 1));
+    }
+    ASSERT_EQ(testObject.numBatches, 1);
+
+    // Single calls of a batched function are executed as batch of one.
+    std::shared_ptr<Future<std::string>> future = testBatch.execute(42);
+    routeRemoteFunctionCalls(callerQueue, calleeQueue, callerHandler, calleeHandler, 1);
+    ASSERT_EQ(future->await(), "42");
+    ASSERT_EQ(testObject.numBatches, 2);
+
+    // Functions with multiple parameters are batched as tuples, regular functions are called once per element.
+    std::vector<std::tuple<int, int>> batch = {{1, 2}, {3, 4}, {5, 6}};
+    for(const char* functionName : {"sumBatch", "sum"})
+    {
+        RemoteFunction<int> sum = callerHandler.mapModuleFunction<int, int, int>("Callee", functionName);
+        std::vector<std::shared_ptr<Future<int>>> sumFutures = sum.executeBatch(batch);
+        routeRemoteFunctionCalls(callerQueue, calleeQueue, callerHandler, calleeHandler, 1);
+
+        ASSERT_EQ(sumFutures.size(), 3);
+        ASSERT_EQ(sumFutures[0]->await(), 3);
+        ASSERT_EQ(sumFutures[1]->await(), 7);
+        ASSERT_EQ(sumFutures[2]->await(), 11);
+    }
+    ASSERT_EQ(testObject.numBatches, 3);
+
+    // Mismatching parameter types are rejected by the stub.
+    ASSERT_TRUE(testBatch.executeBatch(std::vector<std::string>{"1"}).empty());
+}
+
+// The middleware splits batches for Modules of Runtimes without batch support (e.g., Java) into single calls.
+TEST(RemoteFunctionTestSuite, SplitBatchedRequestTest)
+{
+    SharedQueue<DataPackage> callerQueue;
+    SharedQueue<DataPackage> calleeQueue;
+
+    RemoteFunctionHandler callerHandler(callerQueue);
+    RemoteFunctionRunnableHandler calleeHandler("Callee", calleeQueue);
+
+    BatchedTestClass testObject;
+    ASSERT_TRUE(calleeHandler.registerRunnable("sum", &BatchedTestClass::sum, &testObject));
+
+    RemoteFunction<int> sum = callerHandler.mapModuleFunction<int, int, int>("Callee", "sum");
+    std::vector<std::shared_ptr<Future<int>>> futures = sum.executeBatch(std::vector<std::tuple<int, int>>{{1, 2}, {3, 4}, {5, 6}});
+    ASSERT_EQ(futures.size(), 3);
+
+    std::vector<std::shared_ptr<DataPackage>> requests = RemoteFunctionHandler::splitBatchedRequest(*callerQueue.pop_front());
+    ASSERT_EQ(requests.size(), 3);
+
+    for(size_t i = 0; i < requests.size(); i++)
+    {
+        const RemoteFunctionRequest& request = requests[i]->control_val().remote_function_request();
+        ASSERT_EQ(request.batched_calls_size(), 0);
+        ASSERT_EQ(request.parameter_payloads_size(), 2);
+        ASSERT_EQ(request.remote_function_identifier().module_id(), "Callee");
+        ASSERT_EQ(requests[i]->target_module(), "Callee");
+
+        calleeHandler.executeRemoteFunctionRunnable(requests[i]);
+        std::shared_ptr<DataPackage> response = calleeQueue.pop_front();
+        ASSERT_EQ(response->control_val().remote_function_return().batched_returns_size(), 0);
+
+        // Runtimes which do not copy the numeric identifier only return the string identifier.
+        if(i == 0)
+        {
+            response->mutable_control_val()->mutable_remote_function_return()->clear_remote_future_id();
+        }
+        callerHandler.handleResponse(response);
+    }
+
+    ASSERT_EQ(futures[0]->await(), 3);
+    ASSERT_EQ(futures[1]->await(), 7);
+    ASSERT_EQ(futures[2]->await(), 11);
+}
+
+// Measures the call rate of RemoteFunctions between two Modules. The routing of the middleware is done by
+// a separate thread, so the benchmark covers the RPC stub, the runnable and the handling of the response.
+TEST(RemoteFunctionTestSuite, RemoteFunctionCallRateBenchmark)
+{
+    const int NUM_CALLS = 20000;
+
+    SharedQueue<DataPackage> callerQueue;
+    SharedQueue<DataPackage> calleeQueue;
+
+    RemoteFunctionHandler callerHandler(callerQueue);
+    RemoteFunctionRunnableHandler calleeHandler("Callee", calleeQueue);
+
+    TestClass testObject;
+    ASSERT_TRUE(calleeHandler.registerRunnable("test", &TestClass::test, &testObject));
+    RemoteFunction<std::string> function = callerHandler.mapModuleFunction<std::string, int>("Callee", "test");
+
+    std::thread routerThread(routeRemoteFunctionCalls, 
+        std::ref(callerQueue), std::ref(calleeQueue), std::ref(callerHandler), std::ref(calleeHandler), NUM_CALLS);
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < NUM_CALLS; i++)
+    {
+        std::string result = function.execute(i)->await();
+        ASSERT_EQ(result, std::to_string(i));
+    }
+    auto end = std::chrono::steady_clock::now();
+    routerThread.join();
+
+    long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    Logger::logInfo("%d RemoteFunction calls in %lld us (%.0f calls/s)", 
+        NUM_CALLS, microseconds, NUM_CALLS * 1e6 / std::max(microseconds, 1LL));
+
+    // Same number of calls, sent as batches.
+    const int BATCH_SIZE = 100;
+    std::vector<int> batch(BATCH_SIZE);
+    routerThread = std::thread(routeRemoteFunctionCalls, 
+        std::ref(callerQueue), std::ref(calleeQueue), std::ref(callerHandler), std::ref(calleeHandler), NUM_CALLS / BATCH_SIZE);
+
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < NUM_CALLS; i += BATCH_SIZE)
+    {
+        for(int j = 0; j < BATCH_SIZE; j++)
+        {
+            batch[j] = i + j;
+        }
+
+        std::vector<std::shared_ptr<Future<std::string>>> futures = function.executeBatch(batch);
+        for(int j = 0; j < BATCH_SIZE; j++)
+        {
+            ASSERT_EQ(futures[j]->await(), std::to_string(i + j));
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    routerThread.join();
+
+    microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    Logger::logInfo("%d RemoteFunction calls in batches of %d in %lld us (%.0f calls/s)", 
+        NUM_CALLS, BATCH_SIZE, microseconds, NUM_CALLS * 1e6 / std::max(microseconds, 1LL));
+}
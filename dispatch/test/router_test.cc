@@ -33,6 +33,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <chrono>
 
 using namespace claid;
 using namespace claidservice;
@@ -335,4 +336,114 @@ TEST(RouterTestSuite, MasterRouterTest)
     status = masterRouter.stopAfterQueueFinished();
     ASSERT_TRUE(status.ok());
     assertQueues(outputQueue1, outputQueue2, outputQueue3);
-}
\ No newline at end of file
+}
+
+// Sets up a ModuleTable with numModules Modules, distributed over the runtimes, and a MasterRouter with a LocalRouter on top of it.
+// Creates numChannels channels sending from Module i to Module i + 1, packagesPerChannel packages per channel.
+// Packages only have source and target Module set, hence the MasterRouter has to resolve the hosts.
+struct ShardedMasterRouterFixture
+{
+    const std::vector<claidservice::Runtime> runtimes = {
+        claidservice::Runtime::RUNTIME_CPP, claidservice::Runtime::RUNTIME_DART,
+        claidservice::Runtime::RUNTIME_JAVA, claidservice::Runtime::RUNTIME_PYTHON};
+
+    ModuleTable table;
+    SharedQueue<DataPackage> queue;
+    HostDescriptionMap hostDescriptions;
+    ModuleDescriptionMap moduleDescriptions;
+    std::vector<std::shared_ptr<DataPackage>> channelPackages;
+
+    ShardedMasterRouterFixture(size_t numModules, size_t numChannels, size_t packagesPerChannel)
+    {
+        hostDescriptions[test_host] = makeHostDescription(test_host, "", "");
+        for(size_t i = 0; i < numModules; i++)
+        {
+            const std::string module = "Module" + std::to_string(i);
+            table.setNeededModule(module, "ModClass", {});
+            table.addModuleToRuntime(module, runtimes[i % runtimes.size()]);
+            moduleDescriptions[module] = ModuleDescription(module, "ModClass", test_host, {});
+        }
+
+        for(size_t seq = 0; seq < packagesPerChannel; seq++)
+        {
+            for(size_t channel = 0; channel < numChannels; channel++)
+            {
+                const std::string channelName = "Channel" + std::to_string(channel);
+                channelPackages.push_back(makePkt(channelName, 
+                    "Module" + std::to_string(channel % numModules), "Module" + std::to_string((channel + 1) % numModules), 
+                    [&](auto& p) { setStringVal(p, channelName + ":" + std::to_string(seq)); }));
+            }
+        }
+    }
+
+    // Returns the number of packages routed per second.
+    double routeAll(size_t numShards)
+    {
+        std::shared_ptr<LocalRouter> localRouter = std::make_shared<LocalRouter>(test_host, table);
+        MasterRouter masterRouter(test_host, "test_user", "test_device", hostDescriptions, moduleDescriptions, queue, localRouter);
+        EXPECT_TRUE(masterRouter.setNumShards(numShards).ok());
+
+        auto start = std::chrono::steady_clock::now();
+        absl::Status status = masterRouter.start();
+        EXPECT_TRUE(status.ok()) << status;
+
+        for(const std::shared_ptr<DataPackage>& package : channelPackages)
+        {
+            queue.push_back(package);
+        }
+        status = masterRouter.stopAfterQueueFinished();
+        EXPECT_TRUE(status.ok()) << status;
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return channelPackages.size() / seconds;
+    }
+
+    // Pops all packages from the runtime queues and returns the total number of packages.
+    size_t drainAndVerifyChannelOrder()
+    {
+        size_t numPackages = 0;
+        std::map<std::string, int> lastSequenceOfChannel;
+        for(claidservice::Runtime runtime : runtimes)
+        {
+            std::shared_ptr<SharedQueue<DataPackage>> outputQueue = table.getOutputQueueOfRuntime(runtime);
+            std::shared_ptr<DataPackage> package;
+            while((package = outputQueue->try_pop_front()) != nullptr)
+            {
+                numPackages++;
+                const std::string value = claidtest::getStringVal(*package);
+                const std::string channel = value.substr(0, value.find(':'));
+                int sequence = std::stoi(value.substr(value.find(':') + 1));
+
+                auto it = lastSequenceOfChannel.find(channel);
+                int expectedSequence = it == lastSequenceOfChannel.end() ? 0 : it->second + 1;
+                EXPECT_EQ(sequence, expectedSequence) << "Packages on channel " << channel << " were reordered";
+                lastSequenceOfChannel[channel] = sequence;
+            }
+        }
+        return numPackages;
+    }
+};
+
+TEST(RouterTestSuite, ShardedMasterRouterPreservesChannelOrderTest)
+{
+    ShardedMasterRouterFixture fixture(8, 32, 200);
+
+    for(size_t numShards : {1, 4})
+    {
+        fixture.routeAll(numShards);
+        ASSERT_EQ(fixture.drainAndVerifyChannelOrder(), fixture.channelPackages.size());
+    }
+}
+
+TEST(RouterTestSuite, ShardedMasterRouterBenchmark)
+{
+    ShardedMasterRouterFixture fixture(64, 256, 400);
+
+    for(size_t numShards : {1, 2, 4, 8})
+    {
+        double packagesPerSecond = fixture.routeAll(numShards);
+        ASSERT_EQ(fixture.drainAndVerifyChannelOrder(), fixture.channelPackages.size());
+        Logger::logInfo("ShardedMasterRouterBenchmark: %zu shard(s) routed %zu packages, %.0f packages/s.", 
+            numShards, fixture.channelPackages.size(), packagesPerSecond);
+    }
+}
@@ -0,0 +1,317 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dispatch/core/module_table.hh"
+#include "dispatch/core/Utilities/RoutingIdTable.hh"
+#include "dispatch/test/test_helpers.hh"
+
+using namespace claid;
+using namespace claidservice;
+using namespace claidtest;
+
+static void setUpModuleTable(ModuleTable& modTable)
+{
+    for(auto& m : testModules)
+    {
+        modTable.setNeededModule(m.modId, m.modClass, m.props);
+        modTable.setModuleChannelToConnectionMappings(m.modId, channelToConnectionMappings, channelToConnectionMappings);
+    }
+
+    std::map<std::string, std::vector<DataPackage>> pktsVecMap;
+    for(auto pkt : testChannels)
+    {
+        modTable.setExpectedChannel(pkt->channel(), pkt->source_module(), pkt->target_module());
+
+        auto cpPkt = *pkt;
+        cpPkt.clear_target_module();
+        pktsVecMap[cpPkt.source_module()].push_back(cpPkt);
+
+        cpPkt = *pkt;
+        cpPkt.clear_source_module();
+        pktsVecMap[cpPkt.target_module()].push_back(cpPkt);
+    }
+
+    for(auto modIt : pktsVecMap)
+    {
+        google::protobuf::RepeatedPtrField<DataPackage> chanTypes(modIt.second.begin(), modIt.second.end());
+        ASSERT_TRUE(modTable.setChannelTypes(modIt.first, chanTypes).ok());
+    }
+}
+
+TEST(RoutingIdsTestSuite, StringInternTableTest)
+{
+    StringInternTable table;
+    ASSERT_EQ(table.intern(""), StringInternTable::INVALID_ID);
+    ASSERT_EQ(table.intern("AccelerationData"), 1);
+    ASSERT_EQ(table.intern("GyroscopeData"), 2);
+    ASSERT_EQ(table.intern("AccelerationData"), 1);
+    ASSERT_EQ(table.lookupId("GyroscopeData"), 2);
+    ASSERT_EQ(table.lookupId("Unknown"), StringInternTable::INVALID_ID);
+    ASSERT_EQ(table.size(), 2);
+
+    std::string name;
+    ASSERT_TRUE(table.lookupName(2, name));
+    ASSERT_EQ(name, "GyroscopeData");
+    ASSERT_FALSE(table.lookupName(3, name));
+    ASSERT_FALSE(table.lookupName(StringInternTable::INVALID_ID, name));
+
+    RoutingIds proto;
+    table.toProto(*proto.mutable_channels());
+    StringInternTable received;
+    received.fromProto(proto.channels());
+    ASSERT_EQ(received.lookupId("AccelerationData"), 1);
+    ASSERT_EQ(received.lookupId("GyroscopeData"), 2);
+    ASSERT_TRUE(received.contains(2));
+    ASSERT_FALSE(received.contains(3));
+}
+
+TEST(RoutingIdsTestSuite, CompactAndRestoreTest)
+{
+    RoutingIdTable table;
+    table.channels.intern("AccelerationData");
+    table.modules.intern("AccelerometerCollector");
+    table.modules.intern("DataSaverModule");
+    table.hosts.intern("smartphone");
+
+    DataPackage original;
+    original.set_channel("AccelerationData");
+    original.set_source_module("AccelerometerCollector");
+    original.set_target_module("DataSaverModule");
+    original.set_source_host("smartphone");
+    // Unknown names are kept.
+    original.set_target_host("server");
+    original.set_source_user_token("user");
+
+    DataPackage package = original;
+    table.compact(package);
+    ASSERT_TRUE(package.channel().empty());
+    ASSERT_TRUE(package.source_module().empty());
+    ASSERT_TRUE(package.target_module().empty());
+    ASSERT_TRUE(package.source_host().empty());
+    ASSERT_EQ(package.target_host(), "server");
+    ASSERT_EQ(package.source_user_token(), "user");
+    ASSERT_EQ(package.channel_id(), table.channels.lookupId("AccelerationData"));
+    ASSERT_EQ(package.target_module_id(), table.modules.lookupId("DataSaverModule"));
+    ASSERT_EQ(package.target_host_id(), StringInternTable::INVALID_ID);
+    ASSERT_LT(package.ByteSizeLong(), original.ByteSizeLong());
+
+    ASSERT_TRUE(table.restoreNames(package));
+    RoutingIdTable::clearIds(package);
+    ASSERT_EQ(cmpMsg(package, original), "");
+
+    DataPackage unknown;
+    unknown.set_channel_id(42);
+    ASSERT_FALSE(table.restoreNames(unknown));
+    ASSERT_TRUE(unknown.channel().empty());
+}
+
+// Names interned after the snapshot was sent to a Runtime are only sent as strings to that Runtime.
+TEST(RoutingIdsTestSuite, SnapshotTest)
+{
+    RoutingIdTable middleware;
+    middleware.channels.intern("AccelerationData");
+    middleware.modules.intern("DataSaverModule");
+
+    RoutingIds proto;
+    middleware.toProto(proto);
+    RoutingIdTable runtime;
+    runtime.fromProto(proto);
+
+    // E.g., added by a config reload.
+    uint32_t newChannelId = middleware.channels.intern("GyroscopeData");
+
+    DataPackage package;
+    package.set_channel("GyroscopeData");
+    package.set_channel_id(newChannelId);
+    package.set_target_module("DataSaverModule");
+    package.set_target_module_id(middleware.modules.lookupId("DataSaverModule"));
+
+    runtime.compact(package);
+    ASSERT_EQ(package.channel(), "GyroscopeData");
+    ASSERT_TRUE(package.target_module().empty());
+
+    ASSERT_TRUE(runtime.restoreNames(package));
+    ASSERT_EQ(package.target_module(), "DataSaverModule");
+    ASSERT_EQ(package.channel_id(), newChannelId);
+}
+
+TEST(RoutingIdsTestSuite, ModuleTableRoutingIdsTest)
+{
+    ModuleTable modTable;
+    setUpModuleTable(modTable);
+    for(auto& m : testModules)
+    {
+        modTable.addModuleToRuntime(m.modId, Runtime::RUNTIME_CPP);
+    }
+
+    const RoutingIdTable& routingIds = modTable.getRoutingIds();
+    RoutingIds proto;
+    routingIds.toProto(proto);
+    RoutingIdTable runtime;
+    runtime.fromProto(proto);
+
+    // Package as sent by a Runtime which received the routing IDs.
+    DataPackage pkt = *chan14Pkt;
+    pkt.clear_target_module();
+    runtime.compact(pkt);
+    ASSERT_TRUE(pkt.channel().empty());
+    ASSERT_TRUE(pkt.source_module().empty());
+
+    ASSERT_TRUE(routingIds.restoreNames(pkt));
+    std::string connectionName;
+    uint32_t connectionId;
+    ASSERT_TRUE(modTable.lookupOutputConnectionForChannelOfModule(pkt, connectionName, connectionId));
+    ASSERT_EQ(connectionName, chan12To45);
+    ASSERT_EQ(connectionId, routingIds.channels.lookupId(chan12To45));
+    pkt.set_channel(connectionName);
+    pkt.set_channel_id(connectionId);
+
+    const ChannelEntry* entry = modTable.isValidChannel(pkt);
+    ASSERT_TRUE(entry != nullptr);
+    ASSERT_EQ(entry, modTable.isValidChannel(*chan14Pkt));
+
+    SharedQueue<DataPackage> outQueue;
+    modTable.forwardPackageToAllSubscribers(pkt, entry, outQueue);
+    ASSERT_EQ(outQueue.size(), 2);
+    while(outQueue.size() > 0)
+    {
+        auto outPkt = outQueue.pop_front();
+        ASSERT_EQ(outPkt->target_module_id(), routingIds.modules.lookupId(outPkt->target_module()));
+        ASSERT_EQ(outPkt->source_module_id(), routingIds.modules.lookupId(mod1));
+        ASSERT_EQ(outPkt->channel_id(), routingIds.channels.lookupId(outPkt->channel()));
+        ASSERT_EQ(modTable.lookupOutputQueue(outPkt->target_module_id()), modTable.lookupOutputQueue(outPkt->target_module()));
+        ASSERT_TRUE(modTable.lookupOutputQueue(outPkt->target_module_id()) != nullptr);
+    }
+
+    // IDs stay valid when Modules are removed, but no longer resolve to a Runtime.
+    uint32_t mod5Id = routingIds.modules.lookupId(mod5);
+    modTable.removeModules({mod5});
+    ASSERT_EQ(routingIds.modules.lookupId(mod5), mod5Id);
+    ASSERT_TRUE(modTable.lookupOutputQueue(mod5Id) == nullptr);
+}
+
+template<typename Function>
+static double measureNanoseconds(int numIterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < numIterations; i++)
+    {
+        function(i);
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(duration.count()) / numIterations;
+}
+
+// Compares the size of the routing header and the lookups done for each package by the RuntimeDispatcher and LocalRouter,
+// using names vs. routing IDs.
+TEST(RoutingIdsTestSuite, RoutingIdsBenchmark)
+{
+    DataPackage package;
+    package.set_channel("AccelerationData");
+    package.set_source_module("AccelerometerCollector");
+    package.set_target_module("DataSaverModule");
+    package.set_source_host("smartphone");
+    package.set_target_host("smartphone");
+    setIntVal(package, 42);
+
+    RoutingIdTable routingIds;
+    DataPackage compacted = package;
+    routingIds.compact(compacted);
+    routingIds.channels.intern(package.channel());
+    routingIds.modules.intern(package.source_module());
+    routingIds.modules.intern(package.target_module());
+    routingIds.hosts.intern(package.source_host());
+    routingIds.compact(compacted);
+
+    const size_t payloadSize = package.payload().ByteSizeLong();
+    Logger::logInfo("Routing header: %zu bytes with names, %zu bytes with routing IDs (payload %zu bytes)",
+        package.ByteSizeLong() - payloadSize, compacted.ByteSizeLong() - payloadSize, payloadSize);
+    ASSERT_LT(compacted.ByteSizeLong(), package.ByteSizeLong());
+
+    // Table of a host with many Modules and channels.
+    const int numModules = 200;
+    const int numChannelsPerModule = 4;
+    ModuleTable modTable;
+    std::vector<DataPackage> namedPackages;
+    for(int m = 0; m < numModules; m++)
+    {
+        const std::string moduleId = "DataCollectionModule_" + std::to_string(m);
+        std::map<std::string, std::string> outputs;
+        for(int c = 0; c < numChannelsPerModule; c++)
+        {
+            outputs["OutputChannel_" + std::to_string(c)] = moduleId + "_SensorStream_" + std::to_string(c);
+        }
+        modTable.setNeededModule(moduleId, "DataCollectionModule", google::protobuf::Struct());
+        modTable.setModuleChannelToConnectionMappings(moduleId, {}, outputs);
+        modTable.addModuleToRuntime(moduleId, Runtime::RUNTIME_CPP);
+        for(const auto& output : outputs)
+        {
+            modTable.setExpectedChannel(output.second, moduleId, "");
+            DataPackage pkt;
+            pkt.set_source_module(moduleId);
+            pkt.set_target_module(moduleId);
+            pkt.set_channel(output.first);
+            namedPackages.push_back(pkt);
+        }
+    }
+
+    std::vector<DataPackage> internedPackages = namedPackages;
+    for(DataPackage& pkt : internedPackages)
+    {
+        modTable.getRoutingIds().compact(pkt);
+    }
+
+    const int numIterations = 200000;
+    size_t numPackages = namedPackages.size();
+    size_t found = 0;
+    double byName = measureNanoseconds(numIterations, [&](int i) {
+        DataPackage& pkt = namedPackages[(i * 7919) % numPackages];
+        std::string connectionName;
+        modTable.lookupOutputConnectionForChannelOfModule(pkt.source_module(), pkt.channel(), connectionName);
+        DataPackage routed;
+        routed.set_channel(connectionName);
+        routed.set_source_module(pkt.source_module());
+        found += modTable.isValidChannel(routed, true) != nullptr;
+        found += modTable.lookupOutputQueue(pkt.target_module()) != nullptr;
+    });
+
+    double byId = measureNanoseconds(numIterations, [&](int i) {
+        DataPackage& pkt = internedPackages[(i * 7919) % numPackages];
+        std::string connectionName;
+        uint32_t connectionId;
+        modTable.lookupOutputConnectionForChannelOfModule(pkt, connectionName, connectionId);
+        DataPackage routed;
+        routed.set_channel_id(connectionId);
+        routed.set_source_module(namedPackages[(i * 7919) % numPackages].source_module());
+        found += modTable.isValidChannel(routed, true) != nullptr;
+        found += modTable.lookupOutputQueue(pkt.target_module_id()) != nullptr;
+    });
+
+    ASSERT_EQ(found, 4 * numIterations);
+    Logger::logInfo("Per-hop lookups for %zu channels: %.1f ns with names, %.1f ns with routing IDs", numPackages, byName, byId);
+}
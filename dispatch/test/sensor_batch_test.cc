@@ -0,0 +1,198 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "dispatch/core/Module/TypeMapping/TypeMapping.hh"
+#include "dispatch/core/Module/TypeMapping/SensorBatchConversion.hh"
+#include "dispatch/core/Logger/Logger.hh"
+#include "dispatch/proto/sensor_data_types.pb.h"
+
+using namespace claid;
+using namespace claidservice;
+
+static const uint64_t FIRST_TIMESTAMP = 1700000000000ull;
+
+static AccelerationData makeAccelerationData(int numSamples)
+{
+    AccelerationData data;
+    for(int i = 0; i < numSamples; i++)
+    {
+        AccelerationSample* sample = data.add_samples();
+        sample->set_acceleration_x(std::sin(i * 0.01));
+        sample->set_acceleration_y(std::cos(i * 0.01));
+        sample->set_acceleration_z(9.81 + 0.001 * i);
+        // 50 Hz with occasional jitter.
+        sample->set_unix_timestamp_in_ms(FIRST_TIMESTAMP + i * 20 + (i % 7 == 3 ? 1 : 0));
+        sample->set_sensor_body_location("left wrist");
+        sample->set_effective_time_frame("20 ms");
+    }
+    return data;
+}
+
+template<typename Value>
+static AccelerationColumns<Value> makeAccelerationColumns(int numSamples)
+{
+    AccelerationColumns<Value> columns;
+    for(int i = 0; i < numSamples; i++)
+    {
+        columns.x.push_back(static_cast<Value>(std::sin(i * 0.01)));
+        columns.y.push_back(static_cast<Value>(std::cos(i * 0.01)));
+        columns.z.push_back(static_cast<Value>(9.81 + 0.001 * i));
+        columns.unixTimestampsInMs.push_back(FIRST_TIMESTAMP + i * 20 + (i % 7 == 3 ? 1 : 0));
+    }
+    columns.sensorBodyLocation = "left wrist";
+    columns.effectiveTimeFrame = "20 ms";
+    return columns;
+}
+
+TEST(SensorBatchTestSuite, ConversionRoundTripTest)
+{
+    AccelerationData data = makeAccelerationData(500);
+
+    AccelerationBatch batch;
+    ASSERT_TRUE(SensorBatchConversion::toBatch(data, batch).ok());
+    ASSERT_EQ(batch.x_size(), 500);
+    ASSERT_EQ(batch.first_unix_timestamp_in_ms(), FIRST_TIMESTAMP);
+    ASSERT_EQ(batch.sensor_body_location(), "left wrist");
+
+    AccelerationData restored;
+    SensorBatchConversion::fromBatch(batch, restored);
+    ASSERT_EQ(restored.SerializeAsString(), data.SerializeAsString());
+
+    // Empty data converts to an empty batch.
+    ASSERT_TRUE(SensorBatchConversion::toBatch(AccelerationData(), batch).ok());
+    ASSERT_EQ(batch.x_size(), 0);
+}
+
+TEST(SensorBatchTestSuite, GyroscopeConversionRoundTripTest)
+{
+    GyroscopeData data;
+    for(int i = 0; i < 100; i++)
+    {
+        GyroscopeSample* sample = data.add_samples();
+        sample->set_gyroscope_x(i);
+        sample->set_gyroscope_y(-i);
+        sample->set_gyroscope_z(0.5 * i);
+        sample->set_unix_timestamp_in_ms(FIRST_TIMESTAMP + i * 10);
+    }
+
+    GyroscopeBatch batch;
+    ASSERT_TRUE(SensorBatchConversion::toBatch(data, batch).ok());
+
+    GyroscopeData restored;
+    SensorBatchConversion::fromBatch(batch, restored);
+    ASSERT_EQ(restored.SerializeAsString(), data.SerializeAsString());
+}
+
+TEST(SensorBatchTestSuite, MixedBodyLocationTest)
+{
+    AccelerationData data = makeAccelerationData(10);
+    data.mutable_samples(5)->set_sensor_body_location("right wrist");
+
+    AccelerationBatch batch;
+    absl::Status status = SensorBatchConversion::toBatch(data, batch);
+    ASSERT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST(SensorBatchTestSuite, ColumnsMutatorTest)
+{
+    AccelerationColumns<double> columns = makeAccelerationColumns<double>(1000);
+
+    Mutator<AccelerationColumns<double>> mutator = TypeMapping::getMutator<AccelerationColumns<double>>();
+    DataPackage package;
+    mutator.setPackagePayload(package, columns);
+    ASSERT_EQ(package.payload().message_type(), AccelerationBatch().GetDescriptor()->full_name());
+
+    AccelerationColumns<double> restored;
+    mutator.getPackagePayload(package, restored);
+    ASSERT_EQ(restored.x, columns.x);
+    ASSERT_EQ(restored.y, columns.y);
+    ASSERT_EQ(restored.z, columns.z);
+    ASSERT_EQ(restored.unixTimestampsInMs, columns.unixTimestampsInMs);
+    ASSERT_EQ(restored.sensorBodyLocation, columns.sensorBodyLocation);
+    ASSERT_EQ(restored.effectiveTimeFrame, columns.effectiveTimeFrame);
+
+    // Columns of floats are sent as the same message and can be received as doubles, and vice versa.
+    AccelerationColumns<float> floatColumns = makeAccelerationColumns<float>(1000);
+    DataPackage floatPackage;
+    TypeMapping::getMutator<AccelerationColumns<float>>().setPackagePayload(floatPackage, floatColumns);
+    ASSERT_EQ(floatPackage.payload().message_type(), package.payload().message_type());
+
+    AccelerationColumns<float> restoredFloats;
+    TypeMapping::getMutator<AccelerationColumns<float>>().getPackagePayload(floatPackage, restoredFloats);
+    ASSERT_EQ(restoredFloats.x, floatColumns.x);
+    ASSERT_EQ(restoredFloats.z, floatColumns.z);
+
+    GyroscopeColumns<float> gyroscopeColumns;
+    gyroscopeColumns.x = {1.0f, 2.0f};
+    gyroscopeColumns.y = {3.0f, 4.0f};
+    gyroscopeColumns.z = {5.0f, 6.0f};
+    gyroscopeColumns.unixTimestampsInMs = {FIRST_TIMESTAMP, FIRST_TIMESTAMP + 10};
+    DataPackage gyroscopePackage;
+    TypeMapping::getMutator<GyroscopeColumns<float>>().setPackagePayload(gyroscopePackage, gyroscopeColumns);
+    ASSERT_EQ(gyroscopePackage.payload().message_type(), GyroscopeBatch().GetDescriptor()->full_name());
+}
+
+// Compares the serialized size and decoding time of one window of samples 
+// sent as AccelerationData (one message per sample) and as AccelerationBatch (packed columns).
+TEST(SensorBatchTestSuite, PayloadSizeAndDecodeBenchmark)
+{
+    const int numSamples = 3000; // One minute at 50 Hz.
+    const int numIterations = 200;
+
+    AccelerationData data = makeAccelerationData(numSamples);
+    AccelerationBatch batch;
+    ASSERT_TRUE(SensorBatchConversion::toBatch(data, batch).ok());
+
+    std::string serializedData = data.SerializeAsString();
+    std::string serializedBatch = batch.SerializeAsString();
+    ASSERT_LT(serializedBatch.size(), serializedData.size());
+
+    auto start = std::chrono::steady_clock::now();
+    double checksum = 0;
+    for(int i = 0; i < numIterations; i++)
+    {
+        AccelerationData decoded;
+        decoded.ParseFromString(serializedData);
+        checksum += decoded.samples(numSamples - 1).acceleration_x();
+    }
+    auto dataDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < numIterations; i++)
+    {
+        AccelerationBatch decoded;
+        decoded.ParseFromString(serializedBatch);
+        checksum += decoded.x(numSamples - 1);
+    }
+    auto batchDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    ASSERT_TRUE(std::isfinite(checksum));
+
+    Logger::logInfo("AccelerationData:  %zu bytes, %.2f us per decode", 
+        serializedData.size(), static_cast<double>(dataDuration.count()) / numIterations);
+    Logger::logInfo("AccelerationBatch: %zu bytes, %.2f us per decode", 
+        serializedBatch.size(), static_cast<double>(batchDuration.count()) / numIterations);
+}
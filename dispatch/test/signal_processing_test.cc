@@ -0,0 +1,298 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "dispatch/core/SignalProcessing/SensorWindowAdaptor.hh"
+#include "dispatch/core/SignalProcessing/SensorWindowFeatureExtractor.hh"
+#include "dispatch/core/SignalProcessing/SignalKernels.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+using namespace claid;
+
+static const uint64_t FIRST_TIMESTAMP = 1700000000000ull;
+
+static void addAccelerationSample(AccelerationData& data, double x, double y, double z, uint64_t timestamp)
+{
+    AccelerationSample* sample = data.add_samples();
+    sample->set_acceleration_x(x);
+    sample->set_acceleration_y(y);
+    sample->set_acceleration_z(z);
+    sample->set_unix_timestamp_in_ms(timestamp);
+    sample->set_sensor_body_location("left wrist");
+}
+
+TEST(SignalProcessingTestSuite, KernelTest)
+{
+    std::vector<double> values;
+    for(int i = 0; i < 1003; i++)
+    {
+        values.push_back(std::sin(i * 0.1) + 0.5);
+    }
+
+    double sum = 0, sumOfSquares = 0;
+    for(double value : values)
+    {
+        sum += value;
+        sumOfSquares += value * value;
+    }
+    const double mean = sum / values.size();
+    double variance = 0;
+    for(double value : values)
+    {
+        variance += (value - mean) * (value - mean);
+    }
+    variance /= values.size();
+
+    ASSERT_NEAR(SignalKernels::mean(values.data(), values.size()), mean, 1e-12);
+    ASSERT_NEAR(SignalKernels::energy(values.data(), values.size()), sumOfSquares, 1e-9);
+    ASSERT_NEAR(SignalKernels::variance(values.data(), values.size(), mean), variance, 1e-12);
+    ASSERT_EQ(SignalKernels::mean(values.data(), 0), 0.0);
+}
+
+TEST(SignalProcessingTestSuite, FFTTest)
+{
+    // 5 Hz sine sampled at 64 Hz, 100 samples (zero-padded to 128).
+    const double samplingRate = 64.0;
+    std::vector<float> values;
+    for(int i = 0; i < 100; i++)
+    {
+        values.push_back(static_cast<float>(2.0 + std::sin(2 * M_PI * 5.0 * i / samplingRate)));
+    }
+
+    SignalKernels::FFT fft(values.size());
+    ASSERT_EQ(fft.getSize(), 128u);
+    ASSERT_EQ(fft.getNumBins(), 65u);
+
+    std::vector<double> magnitude(fft.getNumBins());
+    fft.magnitude(values.data(), values.size(), SignalKernels::mean(values.data(), values.size()), magnitude.data());
+
+    size_t dominantBin = 1;
+    for(size_t i = 1; i < magnitude.size(); i++)
+    {
+        if(magnitude[i] > magnitude[dominantBin])
+        {
+            dominantBin = i;
+        }
+    }
+    ASSERT_NEAR(dominantBin * samplingRate / fft.getSize(), 5.0, samplingRate / fft.getSize());
+    ASSERT_NEAR(magnitude[0], 0.0, 1e-3);
+
+    // Impulse has a flat spectrum.
+    std::vector<double> impulse(128, 0.0);
+    impulse[0] = 1.0;
+    fft.magnitude(impulse.data(), impulse.size(), 0.0, magnitude.data());
+    for(double value : magnitude)
+    {
+        ASSERT_NEAR(value, 1.0, 1e-12);
+    }
+}
+
+TEST(SignalProcessingTestSuite, SlidingWindowTest)
+{
+    SensorWindowBuffer<AccelerationBatch> buffer;
+    std::vector<std::vector<uint64_t>> windows;
+    const double* windowData = nullptr;
+    ASSERT_TRUE(buffer.configure(4, 2, [&](const SensorWindowBuffer<AccelerationBatch>::Window& window)
+    {
+        windows.push_back(window.unixTimestampsInMs);
+        for(size_t i = 0; i < window.size(); i++)
+        {
+            ASSERT_EQ(window.x[i], static_cast<double>(window.unixTimestampsInMs[i]));
+        }
+
+        // The window is reused.
+        if(windowData != nullptr)
+        {
+            ASSERT_EQ(window.x.data(), windowData);
+        }
+        windowData = window.x.data();
+    }).ok());
+
+    // Append 0..10 in chunks of varying size, wrapping around the ring multiple times.
+    std::vector<double> values;
+    std::vector<uint64_t> timestamps;
+    for(int i = 0; i < 11; i++)
+    {
+        values.push_back(i);
+        timestamps.push_back(i);
+    }
+    buffer.append(values.data(), values.data(), values.data(), timestamps.data(), 3);
+    buffer.append(values.data() + 3, values.data() + 3, values.data() + 3, timestamps.data() + 3, 1);
+    buffer.append(values.data() + 4, values.data() + 4, values.data() + 4, timestamps.data() + 4, 7);
+
+    std::vector<std::vector<uint64_t>> expected = {{0, 1, 2, 3}, {2, 3, 4, 5}, {4, 5, 6, 7}, {6, 7, 8, 9}};
+    ASSERT_EQ(windows, expected);
+    ASSERT_EQ(buffer.getNumBufferedSamples(), 4u);
+
+    // Tumbling windows.
+    windows.clear();
+    windowData = nullptr;
+    ASSERT_TRUE(buffer.configure(3, 3, [&](const SensorWindowBuffer<AccelerationBatch>::Window& window)
+    {
+        windows.push_back(window.unixTimestampsInMs);
+    }).ok());
+    buffer.append(values.data(), values.data(), values.data(), timestamps.data(), 11);
+    expected = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}};
+    ASSERT_EQ(windows, expected);
+
+    ASSERT_FALSE(buffer.configure(0, 1, nullptr).ok());
+}
+
+TEST(SignalProcessingTestSuite, ResamplingAdaptorTest)
+{
+    // Irregularly sampled linear signals are resampled exactly by linear interpolation.
+    SensorWindowAdaptor<AccelerationData> adaptor;
+    SensorWindowSettings settings;
+    settings.windowSize = 10;
+    settings.hopSize = 10;
+    settings.resamplingRateHz = 100.0;
+
+    std::vector<uint64_t> windowTimestamps;
+    int numWindows = 0;
+    ASSERT_TRUE(adaptor.configure(settings, [&](const SensorWindowAdaptor<AccelerationData>::Window& window)
+    {
+        ASSERT_EQ(window.size(), 10u);
+        ASSERT_EQ(window.sensorBodyLocation, "left wrist");
+        for(size_t i = 0; i < window.size(); i++)
+        {
+            const double t = static_cast<double>(window.unixTimestampsInMs[i] - FIRST_TIMESTAMP);
+            ASSERT_NEAR(window.x[i], 2.0 * t, 1e-9);
+            ASSERT_NEAR(window.y[i], -t, 1e-9);
+            ASSERT_NEAR(window.z[i], 1.0, 1e-9);
+        }
+        windowTimestamps.insert(windowTimestamps.end(), window.unixTimestampsInMs.begin(), window.unixTimestampsInMs.end());
+        numWindows++;
+    }).ok());
+
+    // Samples with jittering intervals of 7 to 13 ms, split into messages of varying size.
+    uint64_t offset = 0;
+    int sampleIndex = 0;
+    for(int message = 0; message < 20; message++)
+    {
+        AccelerationData data;
+        for(int i = 0; i < 1 + message % 4; i++)
+        {
+            addAccelerationSample(data, 2.0 * offset, -1.0 * offset, 1.0, FIRST_TIMESTAMP + offset);
+            offset += 7 + (sampleIndex * 5) % 7;
+            sampleIndex++;
+        }
+        adaptor.onData(ChannelData<AccelerationData>::fromCopy(data, Time::now(), ""));
+    }
+
+    ASSERT_GT(numWindows, 0);
+    for(size_t i = 0; i < windowTimestamps.size(); i++)
+    {
+        ASSERT_EQ(windowTimestamps[i], FIRST_TIMESTAMP + 10 * i);
+    }
+}
+
+TEST(SignalProcessingTestSuite, BatchInputAndFeaturesTest)
+{
+    // 2 Hz sine on x, 8 Hz sine on y at 50 Hz, sent as GyroscopeBatch.
+    SensorWindowAdaptor<GyroscopeData> adaptor;
+    SensorWindowSettings settings;
+    settings.windowSize = 128;
+    settings.hopSize = 64;
+
+    SensorWindowFeatureExtractor extractor;
+    extractor.configure(settings.windowSize, true);
+    ThreeAxisWindowFeatures features;
+    int numWindows = 0;
+    ASSERT_TRUE(adaptor.configure(settings, [&](const SensorWindowAdaptor<GyroscopeData>::Window& window)
+    {
+        extractor.extract(window, 0.0, features);
+        numWindows++;
+    }).ok());
+
+    GyroscopeBatch batch;
+    batch.set_first_unix_timestamp_in_ms(FIRST_TIMESTAMP);
+    for(int i = 0; i < 256; i++)
+    {
+        batch.add_x(std::sin(2 * M_PI * 2.0 * i / 50.0));
+        batch.add_y(3.0 + std::sin(2 * M_PI * 8.0 * i / 50.0));
+        batch.add_z(0.0);
+        batch.add_timestamp_deltas_in_ms(i == 0 ? 0 : 20);
+    }
+    adaptor.addBatch(batch);
+
+    ASSERT_EQ(numWindows, 3);
+    ASSERT_EQ(features.num_samples(), 128u);
+    ASSERT_NEAR(features.sampling_rate_hz(), 50.0, 1e-9);
+    ASSERT_EQ(features.window_start_unix_timestamp_in_ms(), FIRST_TIMESTAMP + 128 * 20);
+    ASSERT_EQ(features.window_end_unix_timestamp_in_ms(), FIRST_TIMESTAMP + 255 * 20);
+    ASSERT_NEAR(features.y().mean(), 3.0, 0.05);
+    ASSERT_NEAR(features.x().variance(), 0.5, 0.05);
+    ASSERT_EQ(features.x().fft_magnitude_size(), 65);
+    ASSERT_NEAR(features.x().dominant_frequency_hz(), 2.0, 50.0 / 128);
+    ASSERT_NEAR(features.y().dominant_frequency_hz(), 8.0, 50.0 / 128);
+    ASSERT_EQ(features.z().energy(), 0.0);
+}
+
+// Measures the throughput of windowing 50 Hz acceleration data with features and spectrum.
+TEST(SignalProcessingTestSuite, WindowingBenchmark)
+{
+    const int numMessages = 2000;
+    const int samplesPerMessage = 50;
+
+    SensorWindowAdaptor<AccelerationData> adaptor;
+    SensorWindowSettings settings;
+    settings.windowSize = 256;
+    settings.hopSize = 128;
+    settings.resamplingRateHz = 50.0;
+
+    SensorWindowFeatureExtractor extractor;
+    extractor.configure(settings.windowSize, true);
+    ThreeAxisWindowFeatures features;
+    int numWindows = 0;
+    ASSERT_TRUE(adaptor.configure(settings, [&](const SensorWindowAdaptor<AccelerationData>::Window& window)
+    {
+        extractor.extract(window, settings.resamplingRateHz, features);
+        numWindows++;
+    }).ok());
+
+    std::vector<AccelerationData> messages(numMessages);
+    for(int message = 0; message < numMessages; message++)
+    {
+        for(int i = 0; i < samplesPerMessage; i++)
+        {
+            const int index = message * samplesPerMessage + i;
+            addAccelerationSample(messages[message], std::sin(index * 0.1), std::cos(index * 0.1), 9.81, 
+                FIRST_TIMESTAMP + index * 20 + index % 3);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(const AccelerationData& message : messages)
+    {
+        adaptor.addSamples(message);
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    ASSERT_GT(numWindows, 0);
+    Logger::logInfo("SensorWindowAdaptor: %d samples, %d windows in %lld us (%.3f us per sample)", 
+        numMessages * samplesPerMessage, numWindows, static_cast<long long>(duration.count()), 
+        static_cast<double>(duration.count()) / (numMessages * samplesPerMessage));
+}
@@ -0,0 +1,392 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dispatch/core/Module/TypeMapping/TypeMapping.hh"
+#include "dispatch/core/Logger/Logger.hh"
+
+using namespace claid;
+using namespace claidservice;
+
+template<typename T>
+static T roundTrip(const T& value)
+{
+    Mutator<T> mutator = TypeMapping::getMutator<T>();
+    DataPackage package;
+    mutator.setPackagePayload(package, value);
+
+    T result;
+    mutator.getPackagePayload(package, result);
+    return result;
+}
+
+template<typename Value>
+static std::vector<Value> makeNumbers(size_t size)
+{
+    std::vector<Value> values(size);
+    for(size_t i = 0; i < size; i++)
+    {
+        values[i] = static_cast<Value>((i * 7919) % 1000) - static_cast<Value>(std::is_signed<Value>::value ? 500 : 0);
+    }
+    return values;
+}
+
+template<typename Value = double>
+static std::map<std::string, Value> makeNumberMap(size_t size)
+{
+    std::map<std::string, Value> map;
+    for(size_t i = 0; i < size; i++)
+    {
+        map["feature_" + std::to_string(i)] = static_cast<Value>(i * 0.25);
+    }
+    return map;
+}
+
+static std::vector<std::string> makeStrings(size_t size)
+{
+    std::vector<std::string> strings(size);
+    for(size_t i = 0; i < size; i++)
+    {
+        strings[i] = "value_" + std::to_string(i * 31);
+    }
+    return strings;
+}
+
+static std::map<std::string, std::string> makeStringMap(size_t size)
+{
+    std::map<std::string, std::string> map;
+    for(size_t i = 0; i < size; i++)
+    {
+        map["key_" + std::to_string(i)] = "value_" + std::to_string(i * 31);
+    }
+    return map;
+}
+
+// Payloads have to be compatible with the other runtimes, which use the regular protobuf serialization.
+TEST(TypeMappingBulkTestSuite, WireCompatibilityTest)
+{
+    std::vector<double> doubles = makeNumbers<double>(1000);
+    DataPackage package;
+    TypeMapping::getMutator<std::vector<double>>().setPackagePayload(package, doubles);
+
+    NumberArray numberArray;
+    for(double value : doubles)
+    {
+        numberArray.add_val(value);
+    }
+    ASSERT_EQ(package.payload().payload(), numberArray.SerializeAsString());
+    ASSERT_EQ(package.payload().message_type(), "claidservice.NumberArray");
+    ASSERT_EQ(package.payload().codec(), Codec::CODEC_PROTO);
+
+    std::vector<float> floats = makeNumbers<float>(100);
+    TypeMapping::getMutator<std::vector<float>>().setPackagePayload(package, floats);
+    NumberArray parsedArray;
+    ASSERT_TRUE(parsedArray.ParseFromString(package.payload().payload()));
+    ASSERT_EQ(parsedArray.val_size(), 100);
+    for(int i = 0; i < parsedArray.val_size(); i++)
+    {
+        ASSERT_EQ(parsedArray.val(i), static_cast<double>(floats[i]));
+    }
+
+    std::map<std::string, double> numberMap = makeNumberMap(50);
+    TypeMapping::getMutator<std::map<std::string, double>>().setPackagePayload(package, numberMap);
+    NumberMap parsedNumberMap;
+    ASSERT_TRUE(parsedNumberMap.ParseFromString(package.payload().payload()));
+    ASSERT_EQ(parsedNumberMap.val_size(), 50);
+    for(const auto& pair : numberMap)
+    {
+        ASSERT_EQ(parsedNumberMap.val().at(pair.first), pair.second);
+    }
+
+    std::map<std::string, std::string> stringMap = makeStringMap(50);
+    TypeMapping::getMutator<std::map<std::string, std::string>>().setPackagePayload(package, stringMap);
+    StringMap parsedStringMap;
+    ASSERT_TRUE(parsedStringMap.ParseFromString(package.payload().payload()));
+    ASSERT_EQ(parsedStringMap.val_size(), 50);
+    for(const auto& pair : stringMap)
+    {
+        ASSERT_EQ(parsedStringMap.val().at(pair.first), pair.second);
+    }
+}
+
+TEST(TypeMappingBulkTestSuite, RoundTripTest)
+{
+    ASSERT_EQ(roundTrip(makeNumbers<double>(1000)), makeNumbers<double>(1000));
+    ASSERT_EQ(roundTrip(makeNumbers<float>(1000)), makeNumbers<float>(1000));
+    ASSERT_EQ(roundTrip(makeNumbers<int32_t>(1000)), makeNumbers<int32_t>(1000));
+    ASSERT_EQ(roundTrip(makeNumbers<uint16_t>(1000)), makeNumbers<uint16_t>(1000));
+    ASSERT_EQ(roundTrip(makeNumbers<int64_t>(1000)), makeNumbers<int64_t>(1000));
+    ASSERT_EQ(roundTrip(std::vector<double>()), std::vector<double>());
+    ASSERT_EQ(roundTrip(makeNumberMap(100)), makeNumberMap(100));
+    ASSERT_EQ(roundTrip(makeStringMap(100)), makeStringMap(100));
+    ASSERT_EQ(roundTrip(std::map<std::string, std::string>()), (std::map<std::string, std::string>()));
+
+    std::map<std::string, int> intMap = {{"a", 1}, {"b", -2}};
+    ASSERT_EQ(roundTrip(intMap), intMap);
+
+    std::vector<std::string> strings = {"a", "", "abcdefghijklmnopqrstuvwxyz"};
+    ASSERT_EQ(roundTrip(strings), strings);
+}
+
+// Payloads that are not canonically encoded (e.g., unpacked doubles or map entries without key) are parsed by protobuf.
+TEST(TypeMappingBulkTestSuite, FallbackTest)
+{
+    DataPackage package;
+    Blob& blob = *package.mutable_payload();
+    blob.set_codec(Codec::CODEC_PROTO);
+    blob.set_message_type("claidservice.NumberArray");
+
+    // Two unpacked values (field 1, wire type 1) and one packed chunk.
+    std::string payload;
+    const double first = 1.5, second = -2.0, third = 3.25;
+    payload += static_cast<char>(0x09);
+    payload.append(reinterpret_cast<const char*>(&first), sizeof(double));
+    payload += static_cast<char>(0x09);
+    payload.append(reinterpret_cast<const char*>(&second), sizeof(double));
+    payload += static_cast<char>(0x0A);
+    payload += static_cast<char>(sizeof(double));
+    payload.append(reinterpret_cast<const char*>(&third), sizeof(double));
+    blob.set_payload(payload);
+
+    std::vector<float> values;
+    TypeMapping::getMutator<std::vector<float>>().getPackagePayload(package, values);
+    ASSERT_EQ(values, std::vector<float>({1.5f, -2.0f, 3.25f}));
+
+    NumberMap numberMap;
+    (*numberMap.mutable_val())[""] = 4.0;
+    (*numberMap.mutable_val())["x"] = 0.0;
+    blob.set_message_type("claidservice.NumberMap");
+    blob.set_payload(numberMap.SerializeAsString());
+    std::map<std::string, double> map = {{"stale", 1.0}};
+    TypeMapping::getMutator<std::map<std::string, double>>().getPackagePayload(package, map);
+    ASSERT_EQ(map, (std::map<std::string, double>({{"", 4.0}, {"x", 0.0}})));
+}
+
+// Decoding into a previously used value reuses its memory and does not leave stale entries.
+TEST(TypeMappingBulkTestSuite, DecodeBufferReuseTest)
+{
+    Mutator<std::vector<double>> arrayMutator = TypeMapping::getMutator<std::vector<double>>();
+    DataPackage largePackage, smallPackage;
+    arrayMutator.setPackagePayload(largePackage, makeNumbers<double>(1000));
+    arrayMutator.setPackagePayload(smallPackage, makeNumbers<double>(10));
+
+    std::vector<double> values;
+    arrayMutator.getPackagePayload(largePackage, values);
+    const double* data = values.data();
+    arrayMutator.getPackagePayload(smallPackage, values);
+    ASSERT_EQ(values, makeNumbers<double>(10));
+    arrayMutator.getPackagePayload(largePackage, values);
+    ASSERT_EQ(values.data(), data);
+
+    Mutator<std::map<std::string, double>> mapMutator = TypeMapping::getMutator<std::map<std::string, double>>();
+    std::map<std::string, double> first = makeNumberMap(20);
+    std::map<std::string, double> second = makeNumberMap(20);
+    for(auto& pair : second)
+    {
+        pair.second += 1.0;
+    }
+    DataPackage firstPackage, secondPackage, subsetPackage;
+    mapMutator.setPackagePayload(firstPackage, first);
+    mapMutator.setPackagePayload(secondPackage, second);
+    mapMutator.setPackagePayload(subsetPackage, makeNumberMap(5));
+
+    std::map<std::string, double> map;
+    mapMutator.getPackagePayload(firstPackage, map);
+    const double* firstValue = &map.begin()->second;
+    mapMutator.getPackagePayload(secondPackage, map);
+    ASSERT_EQ(map, second);
+    // Same keys, the nodes were updated in place.
+    ASSERT_EQ(&map.begin()->second, firstValue);
+
+    mapMutator.getPackagePayload(subsetPackage, map);
+    ASSERT_EQ(map, makeNumberMap(5));
+
+    // A key repeated on the wire (the last entry wins) must not count as a match of the other keys.
+    DataPackage duplicatePackage;
+    mapMutator.setPackagePayload(duplicatePackage, {{"a", 1.0}});
+    DataPackage lastPackage;
+    mapMutator.setPackagePayload(lastPackage, {{"a", 2.0}});
+    duplicatePackage.mutable_payload()->mutable_payload()->append(lastPackage.payload().payload());
+
+    map = {{"a", 0.0}, {"b", 0.0}};
+    mapMutator.getPackagePayload(duplicatePackage, map);
+    ASSERT_EQ(map, (std::map<std::string, double>({{"a", 2.0}})));
+
+    NumberMap parsedMap;
+    ASSERT_TRUE(parsedMap.ParseFromString(duplicatePackage.payload().payload()));
+    ASSERT_EQ(parsedMap.val_size(), 1);
+    ASSERT_EQ(parsedMap.val().at("a"), 2.0);
+}
+
+// Reference implementation of the element-wise encoding used before the bulk paths, for comparison.
+template<typename T>
+static void encodeElementWise(DataPackage& package, const std::vector<T>& values)
+{
+    NumberArray numberArray;
+    for(auto number : values)
+    {
+        numberArray.add_val(number);
+    }
+    package.mutable_payload()->set_payload(numberArray.SerializeAsString());
+}
+
+template<typename T>
+static void decodeElementWise(const DataPackage& package, std::vector<T>& values)
+{
+    NumberArray numberArray;
+    numberArray.ParseFromString(package.payload().payload());
+    values = std::vector<T>(numberArray.val_size());
+    for(int i = 0; i < numberArray.val_size(); i++)
+    {
+        values[i] = numberArray.val(i);
+    }
+}
+
+static void encodeElementWise(DataPackage& package, const std::vector<std::string>& values)
+{
+    StringArray stringArray;
+    for(const std::string& value : values)
+    {
+        stringArray.add_val(value);
+    }
+    package.mutable_payload()->set_payload(stringArray.SerializeAsString());
+}
+
+static void decodeElementWise(const DataPackage& package, std::vector<std::string>& values)
+{
+    StringArray stringArray;
+    stringArray.ParseFromString(package.payload().payload());
+    values = std::vector<std::string>(stringArray.val_size());
+    for(int i = 0; i < stringArray.val_size(); i++)
+    {
+        values[i] = stringArray.val(i);
+    }
+}
+
+template<typename T>
+static void encodeElementWise(DataPackage& package, const std::map<std::string, T>& map)
+{
+    typedef typename std::conditional<std::is_arithmetic<T>::value, NumberMap, StringMap>::type ProtoMap;
+    ProtoMap protoMap;
+    for(const auto& pair : map)
+    {
+        (*protoMap.mutable_val())[pair.first] = pair.second;
+    }
+    package.mutable_payload()->set_payload(protoMap.SerializeAsString());
+}
+
+template<typename T>
+static void decodeElementWise(const DataPackage& package, std::map<std::string, T>& map)
+{
+    typedef typename std::conditional<std::is_arithmetic<T>::value, NumberMap, StringMap>::type ProtoMap;
+    ProtoMap protoMap;
+    protoMap.ParseFromString(package.payload().payload());
+    map.clear();
+    for(const auto& pair : protoMap.val())
+    {
+        map[pair.first] = pair.second;
+    }
+}
+
+template<typename Function>
+static double measureMicroseconds(int numIterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < numIterations; i++)
+    {
+        function();
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return duration.count() / 1000.0 / numIterations;
+}
+
+template<typename T>
+static void benchmarkType(const std::string& typeName, const T& value, int numIterations)
+{
+    Mutator<T> mutator = TypeMapping::getMutator<T>();
+
+    DataPackage package;
+    double bulkEncode = measureMicroseconds(numIterations, [&]() { DataPackage encoded; mutator.setPackagePayload(encoded, value); });
+    mutator.setPackagePayload(package, value);
+
+    T decoded;
+    double bulkDecode = measureMicroseconds(numIterations, [&]() { mutator.getPackagePayload(package, decoded); });
+    ASSERT_EQ(decoded, value);
+
+    DataPackage referencePackage;
+    double referenceEncode = measureMicroseconds(numIterations, [&]() { DataPackage encoded; encodeElementWise(encoded, value); });
+    encodeElementWise(referencePackage, value);
+
+    T referenceDecoded;
+    double referenceDecode = measureMicroseconds(numIterations, [&]() { decodeElementWise(referencePackage, referenceDecoded); });
+
+    Logger::logInfo("%-28s %6zu elements: encode %9.2f us (element-wise %9.2f us), decode %9.2f us (element-wise %9.2f us)", 
+        typeName.c_str(), value.size(), bulkEncode, referenceEncode, bulkDecode, referenceDecode);
+}
+
+// Scalars are not bulk encoded, the benchmark measures the cost per package of sending the given number of values.
+template<typename T>
+static void benchmarkScalar(const std::string& typeName, const T& value, size_t numPackages)
+{
+    Mutator<T> mutator = TypeMapping::getMutator<T>();
+
+    std::vector<DataPackage> packages(numPackages);
+    size_t index = 0;
+    double encode = measureMicroseconds(static_cast<int>(numPackages), [&]() { mutator.setPackagePayload(packages[index++], value); });
+
+    T decoded;
+    index = 0;
+    double decode = measureMicroseconds(static_cast<int>(numPackages), [&]() { mutator.getPackagePayload(packages[index++], decoded); });
+    ASSERT_EQ(decoded, value);
+
+    Logger::logInfo("%-28s %6zu packages: encode %9.3f us, decode %9.3f us per package", 
+        typeName.c_str(), numPackages, encode, decode);
+}
+
+TEST(TypeMappingBulkTestSuite, BulkPayloadBenchmark)
+{
+    for(size_t size : {1000, 100000})
+    {
+        const int numIterations = size > 1000 ? 5 : 100;
+        benchmarkType("vector<double>", makeNumbers<double>(size), numIterations);
+        benchmarkType("vector<float>", makeNumbers<float>(size), numIterations);
+        benchmarkType("vector<int32_t>", makeNumbers<int32_t>(size), numIterations);
+        benchmarkType("vector<int64_t>", makeNumbers<int64_t>(size), numIterations);
+        benchmarkType("vector<string>", makeStrings(size), numIterations);
+        benchmarkType("map<string, double>", makeNumberMap<double>(size), numIterations);
+        benchmarkType("map<string, float>", makeNumberMap<float>(size), numIterations);
+        benchmarkType("map<string, int>", makeNumberMap<int>(size), numIterations);
+        benchmarkType("map<string, string>", makeStringMap(size), numIterations);
+
+        benchmarkScalar("int", 42, size);
+        benchmarkScalar("int64_t", static_cast<int64_t>(-42), size);
+        benchmarkScalar("float", 1.5f, size);
+        benchmarkScalar("double", 2.25, size);
+        benchmarkScalar("bool", true, size);
+        benchmarkScalar("string", std::string("value"), size);
+    }
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+* Copyright (C) 2023 ETH Zurich
+* CLAID: Closing the Loop on AI & Data Collection (https://claid.ethz.ch)
+* Core AI & Digital Biomarker, Acoustic and Inflammatory Biomarkers (ADAMMA)
+* Centre for Digital Health Interventions (c4dhi.org)
+* 
+* Authors: Patrick Langer, Stephan Altmüller
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* 
+*         http://www.apache.org/licenses/LICENSE-2.0
+* 
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+***************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "dispatch/core/Module/RunnableDispatcherThread/RunnableDispatcher.hh"
+#include "dispatch/core/Module/RunnableDispatcherThread/WakeCoordinator.hh"
+#include "dispatch/core/Module/RunnableDispatcherThread/FunctionRunnable.hh"
+#include "dispatch/core/Module/RunnableDispatcherThread/ScheduleDescription/ScheduleOnce.hh"
+
+#include <atomic>
+
+using namespace claid;
+
+TEST(WakeCoordinatorTestSuite, EdgeTriggeredTest)  
+{
+    WakeCoordinator coordinator(Duration::milliseconds(20));
+    coordinator.start();
+    uint64_t dispatcher1 = coordinator.registerDispatcher();
+    uint64_t dispatcher2 = coordinator.registerDispatcher();
+
+    // First dispatcher becoming busy acquires the wake lock.
+    coordinator.onDispatcherBusy(dispatcher1);
+    ASSERT_TRUE(coordinator.isWakeLockHeld());
+    ASSERT_EQ(coordinator.getNumControlMessages(), 1);
+
+    // Further dispatchers becoming busy or idle do not change the aggregate state.
+    coordinator.onDispatcherBusy(dispatcher2);
+    coordinator.onDispatcherIdle(dispatcher1, Time::eternity());
+    ASSERT_TRUE(coordinator.isWakeLockHeld());
+    ASSERT_EQ(coordinator.getNumControlMessages(), 1);
+
+    // Once the last dispatcher is idle for longer than the hysteresis,
+    // a wakeup for the earliest deadline is scheduled and the wake lock is released.
+    Time deadline = Time::now() + Duration::seconds(60);
+    coordinator.onDispatcherIdle(dispatcher2, deadline);
+    ASSERT_TRUE(coordinator.isWakeLockHeld());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_FALSE(coordinator.isWakeLockHeld());
+    ASSERT_EQ(coordinator.getNumControlMessages(), 3);
+
+    // Reporting the same deadline again does not schedule another wakeup.
+    coordinator.onDispatcherIdle(dispatcher2, deadline);
+    coordinator.onDispatcherIdle(dispatcher1, Time::eternity());
+    ASSERT_EQ(coordinator.getNumControlMessages(), 3);
+
+    // An earlier deadline does.
+    coordinator.onDispatcherIdle(dispatcher1, deadline - std::chrono::seconds(10));
+    ASSERT_EQ(coordinator.getNumControlMessages(), 4);
+}
+
+TEST(WakeCoordinatorTestSuite, HysteresisTest)  
+{
+    WakeCoordinator coordinator(Duration::milliseconds(100));
+    coordinator.start();
+    uint64_t dispatcher = coordinator.registerDispatcher();
+
+    // Becoming busy again shortly after becoming idle does not release the wake lock.
+    coordinator.onDispatcherBusy(dispatcher);
+    coordinator.onDispatcherIdle(dispatcher, Time::eternity());
+    coordinator.onDispatcherBusy(dispatcher);
+    ASSERT_EQ(coordinator.getNumControlMessages(), 1);
+
+    // Next Runnable is due shortly after the hysteresis, hence the wake lock is kept.
+    coordinator.onDispatcherIdle(dispatcher, Time::now() + Duration::milliseconds(10000));
+    coordinator.onDispatcherIdle(dispatcher, Time::now() + Duration::milliseconds(180));
+    std::this_thread::sleep_for(std::chrono::milliseconds(130));
+    ASSERT_TRUE(coordinator.isWakeLockHeld());
+    coordinator.onDispatcherBusy(dispatcher);
+    ASSERT_EQ(coordinator.getNumControlMessages(), 1);
+
+    // Unregistering the last busy dispatcher releases the wake lock.
+    coordinator.unregisterDispatcher(dispatcher);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_FALSE(coordinator.isWakeLockHeld());
+}
+
+TEST(WakeCoordinatorTestSuite, PastDeadlineTest)  
+{
+    WakeCoordinator coordinator(Duration::milliseconds(20));
+    coordinator.start();
+    uint64_t dispatcher = coordinator.registerDispatcher();
+
+    // An overdue deadline neither keeps the wake lock nor schedules a device wakeup.
+    coordinator.onDispatcherBusy(dispatcher);
+    coordinator.onDispatcherIdle(dispatcher, Time::now() - Duration::seconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_FALSE(coordinator.isWakeLockHeld());
+    ASSERT_EQ(coordinator.getNumControlMessages(), 2);
+}
+
+// Records the calls to the middleware, which are made from the release thread as well.
+class RecordingWakeCoordinator : public WakeCoordinator
+{
+    public:
+        std::atomic<int> numReleases{0};
+
+        RecordingWakeCoordinator() : WakeCoordinator(Duration::milliseconds(10))
+        {
+
+        }
+
+        ~RecordingWakeCoordinator()
+        {
+            this->stop();
+        }
+
+    protected:
+        void middlewareReleaseWakeLock() override
+        {
+            this->numReleases++;
+        }
+};
+
+TEST(WakeCoordinatorTestSuite, DerivedCoordinatorTest)  
+{
+    RecordingWakeCoordinator coordinator;
+    coordinator.start();
+    uint64_t dispatcher = coordinator.registerDispatcher();
+    coordinator.onDispatcherBusy(dispatcher);
+    coordinator.onDispatcherIdle(dispatcher, Time::eternity());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_EQ(coordinator.numReleases, 1);
+}
+
+// Compares the number of control messages sent to the GlobalDeviceScheduler with the number the RunnableDispatchers
+// would have sent without the WakeCoordinator (acquire, release and schedule for each iteration of the scheduling loop).
+TEST(WakeCoordinatorTestSuite, ControlPlaneMessageRateBenchmark)  
+{
+    const int NUM_DISPATCHERS = 8;
+    const int RUNNABLES_PER_DISPATCHER = 2000;
+
+    std::shared_ptr<WakeCoordinator> coordinator = std::make_shared<WakeCoordinator>(Duration::milliseconds(1000));
+    coordinator->start();
+    std::vector<std::unique_ptr<RunnableDispatcher>> dispatchers;
+    std::atomic<int> numExecuted{0};
+
+    for(int i = 0; i < NUM_DISPATCHERS; i++)
+    {
+        dispatchers.push_back(std::make_unique<RunnableDispatcher>());
+        dispatchers.back()->setWakeCoordinator(coordinator);
+        ASSERT_TRUE(dispatchers.back()->start());
+    }
+
+    Time start = Time::now();
+    for(int j = 0; j < RUNNABLES_PER_DISPATCHER; j++)
+    {
+        for(std::unique_ptr<RunnableDispatcher>& dispatcher : dispatchers)
+        {
+            std::shared_ptr<FunctionRunnable<void>> runnable(new FunctionRunnable<void>([&numExecuted]{ numExecuted++; }));
+            dispatcher->addRunnable(ScheduledRunnable(std::static_pointer_cast<Runnable>(runnable), ScheduleOnce(Time::now())));
+        }
+        if(j % 100 == 0)
+        {
+            // Gives the dispatchers the chance to become idle in between, like on a host delivering messages in bursts.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    while(numExecuted < NUM_DISPATCHERS * RUNNABLES_PER_DISPATCHER && Time::now() < start + Duration::seconds(30))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    uint64_t durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(Time::now() - start).count();
+    for(std::unique_ptr<RunnableDispatcher>& dispatcher : dispatchers)
+    {
+        dispatcher->stop();
+    }
+    ASSERT_EQ(numExecuted, NUM_DISPATCHERS * RUNNABLES_PER_DISPATCHER);
+
+    // Each iteration of the scheduling loop reports busy and idle once.
+    const uint64_t numLoopIterations = coordinator->getNumStateUpdates() / 2;
+    const uint64_t numLegacyControlMessages = 3 * numLoopIterations;
+    const uint64_t numControlMessages = coordinator->getNumControlMessages();
+
+    Logger::logInfo("WakeCoordinator benchmark: %lu scheduling loop iterations in %lu ms. "
+        "Control messages without coordinator: %lu (%.1f/s), with coordinator: %lu (%.1f/s).",
+        numLoopIterations, durationMs, 
+        numLegacyControlMessages, numLegacyControlMessages * 1000.0 / std::max<uint64_t>(1, durationMs),
+        numControlMessages, numControlMessages * 1000.0 / std::max<uint64_t>(1, durationMs));
+
+    ASSERT_LT(numControlMessages * 10, numLegacyControlMessages);
+}